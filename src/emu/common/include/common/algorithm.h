@@ -341,6 +341,11 @@ namespace eka2l1 {
          */
         int count_leading_zero(const std::uint32_t v);
 
+        /**
+         * \brief Count the number of trailing zero bits. Returns 32 if the value is zero.
+         */
+        int count_trailing_zero(const std::uint32_t v);
+
         /**
          * \brief Get the most significant set bit.
          */
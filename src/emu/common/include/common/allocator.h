@@ -26,6 +26,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1::common {
@@ -79,6 +80,107 @@ namespace eka2l1::common {
         }
     };
 
+    /**
+     * \brief Usage statistics of an allocator's space.
+     */
+    struct allocator_stats {
+        std::size_t total_size{ 0 }; ///< Size of the space currently managed.
+        std::size_t used_size{ 0 }; ///< Bytes handed out, alignment padding included.
+        std::size_t free_size{ 0 }; ///< Bytes free.
+        std::size_t largest_free_block{ 0 }; ///< Biggest single allocation that can succeed without expanding.
+        std::size_t free_block_count{ 0 };
+        std::size_t used_block_count{ 0 };
+
+        /**
+         * \brief Get how fragmented the free space is.
+         *
+         * \returns 0 when all free space is one block, approaching 1 as it gets split into small holes.
+         */
+        double fragmentation() const {
+            if (free_size == 0) {
+                return 0.0;
+            }
+
+            return 1.0 - static_cast<double>(largest_free_block) / static_cast<double>(free_size);
+        }
+    };
+
+    /**
+     * \brief Two-level segregated fit allocator over a contiguous space.
+     *
+     * Free blocks are kept in lists segregated by size: the first level by power of two, the second
+     * splitting each power of two linearly. Two bitmaps tell which lists are not empty, so finding a
+     * fitting block and freeing one are both constant time. Freed blocks are merged with their free
+     * neighbours right away, and requests are only rounded to the alignment.
+     *
+     * Block headers are kept on the host, out of the space itself, since the space is usually guest
+     * memory shared with clients.
+     */
+    class tlsf_allocator : public space_based_allocator {
+    public:
+        static constexpr std::uint32_t ALIGN_LOG2 = 3;
+        static constexpr std::uint32_t ALIGN_SIZE = 1 << ALIGN_LOG2;
+        static constexpr std::uint32_t SL_INDEX_COUNT_LOG2 = 5;
+        static constexpr std::uint32_t SL_INDEX_COUNT = 1 << SL_INDEX_COUNT_LOG2;
+        static constexpr std::uint32_t FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + ALIGN_LOG2;
+        static constexpr std::uint32_t FL_INDEX_MAX = 32;
+        static constexpr std::uint32_t FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+        static constexpr std::uint32_t SMALL_BLOCK_SIZE = 1 << FL_INDEX_SHIFT;
+
+    private:
+        static constexpr std::uint32_t INVALID_BLOCK = 0xFFFFFFFF;
+
+        struct block_info {
+            std::uint32_t offset;
+            std::uint32_t size;
+
+            std::uint32_t prev_phys; ///< Block right before this one in the space.
+            std::uint32_t next_phys; ///< Block right after this one in the space.
+
+            std::uint32_t prev_free;
+            std::uint32_t next_free;
+
+            bool free;
+        };
+
+        std::vector<block_info> blocks_;
+        std::vector<std::uint32_t> unused_infos_;
+        std::unordered_map<std::uint32_t, std::uint32_t> used_blocks_; ///< Offset of each allocation to its block.
+
+        std::uint32_t fl_bitmap_;
+        std::uint32_t sl_bitmap_[FL_INDEX_COUNT];
+        std::uint32_t free_heads_[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+        std::uint32_t last_block_; ///< Block at the end of the space.
+        std::size_t align_skip_; ///< Bytes skipped at the start of the space to align it.
+        std::size_t used_size_;
+
+        std::mutex lock_;
+
+        std::uint32_t new_block_info();
+        void delete_block_info(const std::uint32_t idx);
+
+        void insert_free_block(const std::uint32_t idx);
+        void remove_free_block(const std::uint32_t idx);
+        std::uint32_t find_free_block(const std::uint32_t size);
+        std::uint32_t find_free_block_exact(const std::uint32_t size);
+
+        void add_free_space(const std::uint32_t offset, const std::uint32_t size);
+        bool grow(const std::uint32_t size);
+
+    public:
+        explicit tlsf_allocator(std::uint8_t *sptr, const std::size_t initial_max_size);
+
+        void *allocate(std::size_t bytes) override;
+        bool free(const void *ptr) override;
+
+        virtual bool expand(std::size_t target) override {
+            return false;
+        }
+
+        allocator_stats get_stats();
+    };
+
     struct bitmap_allocator {
         std::vector<std::uint32_t> words_;
 
@@ -38,6 +38,8 @@ namespace eka2l1 {
          *  \param dest_size The size of the destination buffer
          *  \param buffer The compressed data
          *  \param buf_size The compressed data size		 
+         *
+         *  \returns Number of bytes written, 0 if the pair table of the chunk is invalid.
 		*/
         int bytepair_decompress(void *dest, unsigned int dest_size, void *buffer, unsigned int buf_size);
 
@@ -47,7 +49,7 @@ namespace eka2l1 {
 
         /*! \brief A read-only bytepair stream. */
         class ibytepair_stream {
-            common::ro_stream *compress_stream;
+            common::ro_stream *compress_stream = nullptr;
 
         public:
             struct index_table_header {
@@ -64,6 +66,10 @@ namespace eka2l1 {
         private:
             index_table idx_tab;
 
+            std::uint64_t data_start = 0; ///< Stream position of the first page, right after the table.
+            std::vector<std::uint32_t> page_starts; ///< Offset of each page from the first, plus the end of the last.
+            std::vector<std::uint8_t> page_buf; ///< Compressed page being decompressed, reused between pages.
+
         public:
             ibytepair_stream() = default;
             explicit ibytepair_stream(common::ro_stream *stream);
@@ -87,6 +93,9 @@ namespace eka2l1 {
             void read_table();
 
             /*! \brief Read a page.
+			 *
+			 *  Pages can be read in any order once the table is read, only the requested one is
+			 *  decompressed.
 			 *
 			 *  \param page The page index
 			 *  \param size The page size
@@ -100,6 +109,18 @@ namespace eka2l1 {
 			*/
             uint32_t read_pages(char *dest, size_t size);
 
+            /*! \brief Read decompressed data at an offset.
+			 *
+			 *  Only the pages covering the range are decompressed. The table must have been read.
+			 *
+			 *  \param dest   The destination to write decompressed data to.
+			 *  \param offset Offset of the data in the decompressed stream.
+			 *  \param size   Number of bytes to read.
+			 *
+			 *  \returns Number of bytes read.
+			*/
+            uint32_t read_range(char *dest, uint32_t offset, uint32_t size);
+
             /*! \brief Get all the pages's offsets */
             std::vector<uint32_t> page_offsets(uint32_t initial_off);
         };
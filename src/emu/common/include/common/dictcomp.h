@@ -35,25 +35,44 @@ namespace eka2l1::common {
     */
 
     /*! \brief A dictionary compress stream
+     *
+     * The stream is a sequence of tokens. A token starting with a set bit is the index of a dictionary
+     * entry, to be expanded in place. Otherwise, a prefix telling the number of bytes follows, then the
+     * bytes themselves, not aligned.
+     *
+     * Bits are read from the least significant bit of each byte, through a 64-bit window loaded at
+     * the current offset.
     */
     struct dictcomp {
         int num_bits_used_for_dict_tokens;
         int off_beg; ///< Begin offset in bit
-        int off_cur; ///< End offset in bit
-        int off_end;
-        bool owns_bit_buffer;
+        int off_cur; ///< Current offset in bit
+        int off_end; ///< End offset in bit
 
-        std::uint8_t *buffer;
+        const std::uint8_t *buffer;
+        int buffer_size; ///< Size of the buffer in bytes.
+
+        /*! \brief Get the next bits without moving the stream.
+         *
+         * \param num_bit Number of bits to get, 56 at most. Bits past the buffer are zero.
+        */
+        std::uint64_t peek_bits(const int num_bit) const;
 
         // Check if the current bit the stream pointing to is 1
         bool is_cur_bit_on();
 
-        explicit dictcomp(std::uint8_t *buf, const int off_beg, const int off_end,
+        /*! \brief Check if all tokens of the stream have been read.
+        */
+        bool end_of_stream() const {
+            return off_cur >= off_end;
+        }
+
+        explicit dictcomp(const std::uint8_t *buf, const int buf_size, const int off_beg, const int off_end,
             const int num_bits_used_for_dict_tokens);
 
         /*! \brief Calculate the size of the buffer, when finish decompressing
          *
-         * Size is in bytes.
+         * The stream must point to bytes, not to a dictionary entry. Size is in bytes.
         */
         int calculate_decompress_size(const bool calypso, bool reset_when_done = true);
 
@@ -61,8 +80,20 @@ namespace eka2l1::common {
         */
         int read_int(int num_bit);
 
+        /*! \brief Read the index of the dictionary entry the stream points to.
+         *
+         * \returns The index, or -1 if the stream points to bytes. The stream only moves in the first case.
+        */
         int index_of_current_directory_entry();
 
+        /*! \brief Read the bytes the stream points to.
+         *
+         * \param dest      The destination to write bytes to.
+         * \param dest_size Size of the destination.
+         * \param calypso   True if the stream comes from a Calypso resource file.
+         *
+         * \returns Number of bytes read, -1 if they don't fit in the destination or the stream.
+        */
         int read(std::uint8_t *dest, int &dest_size, const bool calypso);
     };
 }
\ No newline at end of file
@@ -71,6 +71,7 @@ namespace eka2l1::common {
     struct dir_entry {
         file_type type;
         std::size_t size;
+        std::uint64_t last_write; ///< Last modification time, in microseconds since 1AD.
 
         std::string name;
     };
@@ -85,12 +85,18 @@ namespace eka2l1 {
             void pad(uint32_t pad_size);
         };
 
-        /*! \brief Represents a deflate bit input. */
+        /*! \brief Represents a deflate bit input.
+         *
+         * Bits are read from the most significant bit of each byte first. Up to 64 bits are
+         * buffered, refilled 8 bytes at a time when the input allows.
+         */
         class bit_input {
-            int count;
-            uint32_t bits;
-            int remain;
-            const uint32_t *buf_ptr;
+            std::uint64_t buffer; ///< Unread bits, starting from the most significant one.
+            int buffered; ///< Number of valid bits in the buffer.
+            const uint8_t *next; ///< Next byte to be loaded into the buffer.
+            std::int64_t remain; ///< Number of bits left to be loaded, starting from next.
+
+            void refill();
 
         public:
             bit_input();
@@ -105,6 +111,20 @@ namespace eka2l1 {
 
             uint32_t read(int size);
             uint32_t huffman(const uint32_t *tree);
+
+            /**
+             * \brief Look at the next bits without consuming them.
+             * 
+             * \param size Number of bits to look at, 32 at most. Bits past the end of input are zeros.
+             */
+            uint32_t peek(int size);
+
+            /**
+             * \brief Consume bits previously looked at with peek.
+             * 
+             * \returns False if there were not enough bits left.
+             */
+            bool consume(int size);
         };
 
         enum {
@@ -129,6 +149,45 @@ namespace eka2l1 {
             INFLATER_SAFE_ZONE = 8
         };
 
+        /**
+         * \brief Lookup table decoding a canonical Huffman code.
+         * 
+         * The next TABLE_BITS bits of input index the table directly, codes longer than that
+         * continue into a subtable. When a short code is followed by another short code that
+         * still fits in the index, the entry holds both symbols, so pairs of literals are decoded
+         * with a single lookup.
+         */
+        class huffman_table {
+            std::vector<std::uint32_t> entries;
+
+        public:
+            enum {
+                TABLE_BITS = 10
+            };
+
+            /**
+             * \brief Build the table from code lengths.
+             * 
+             * \param lengths   Code length of each symbol, 0 if the symbol is not used.
+             * \param num_codes Total number of symbols.
+             * \param pair_limit Only symbols below this can be paired in an entry.
+             * 
+             * \returns False if the lengths are invalid.
+             */
+            bool build(const uint32_t *lengths, const int num_codes, const int pair_limit = 0);
+
+            /**
+             * \brief Decode the next symbol.
+             * 
+             * \returns The symbol, or -1 if the input does not form a valid code.
+             */
+            int decode(bit_input &input) const;
+
+            const std::uint32_t *data() const {
+                return entries.data();
+            }
+        };
+
         /**
          * \brief An inflater for non-standard Gzip data.
          */
@@ -138,13 +197,18 @@ namespace eka2l1 {
             int len;
             const uint8_t *avail;
             const uint8_t *limit;
-            encoding encode;
+            encoding encode; ///< Code lengths read from the stream header.
+            huffman_table lit_len_table;
+            huffman_table dist_table;
             uint8_t out[DEFLATE_MAX_DIST];
             uint8_t huff[INFLATER_BUF_SIZE + INFLATER_SAFE_ZONE];
 
             /** \brief Do inflation */
             int inflate();
 
+            /** \brief Copy the pending back reference from history, as much as fits. */
+            void copy_history(uint8_t *&tout, uint8_t *end);
+
         public:
             explicit inflater(bit_input &input);
             ~inflater() {}
@@ -33,6 +33,10 @@ namespace eka2l1 {
         uint32_t hash(std::string const &s);
         std::string normalize_for_hash(std::string org);
 
+        /*! \brief 64-bit FNV-1a hash of a memory region.
+        */
+        std::uint64_t hash_fnv1a64(const void *data, const std::size_t size);
+
         template <class T>
         inline void hash_combine(std::size_t &seed, const T &v) {
             std::hash<T> hasher;
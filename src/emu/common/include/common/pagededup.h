@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <common/types.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1::common {
+    /**
+     * \brief Keeps one copy of each distinct page content, mapped copy-on-write wherever it's used.
+     *
+     * Pages given to the pool are hashed. The first page with a content is moved into an anonymous
+     * memory file, and every later page with the same content is remapped onto it, so they all use
+     * the same host memory until one of them is written to.
+     *
+     * With a shared directory, whole regions are also published there as files keyed by their
+     * content and load address. Other emulators on the host that end up with the same region map
+     * the file, sharing its pages through the host page cache.
+     *
+     * This is only implemented on Linux. Elsewhere, regions are left as they are.
+     */
+    class page_dedup_pool {
+        int fd_; ///< Memory file backing the distinct pages. -1 if the pool is unavailable.
+        std::size_t page_size_;
+
+        std::size_t total_pages_;
+        std::vector<std::uint8_t *> segments_; ///< Writable views of the memory file, a segment each.
+
+        std::unordered_multimap<std::uint64_t, std::size_t> pages_; ///< Content hash to page index.
+
+        std::string shared_dir_;
+        std::size_t bytes_saved_;
+
+        std::uint8_t *get_page(const std::size_t index);
+        bool allocate_page(std::size_t &index);
+
+        bool share_with_instances(std::uint8_t *ptr, const std::size_t size, const prot map_prot,
+            const std::uint64_t region_key);
+
+    public:
+        /**
+         * \brief Create a pool.
+         *
+         * \param shared_dir Directory to exchange regions with other emulators in, preferably on
+         *                   a memory file system. Empty to only share pages inside this emulator.
+         */
+        explicit page_dedup_pool(const std::string &shared_dir = "");
+        ~page_dedup_pool();
+
+        page_dedup_pool(const page_dedup_pool &) = delete;
+        page_dedup_pool &operator=(const page_dedup_pool &) = delete;
+
+        /**
+         * \brief Back a region by pages with the same content, if there are some.
+         *
+         * The region must be committed memory that the caller owns, aligned to the host page size.
+         * Its content doesn't change, but writing to it afterwards only copies the page written.
+         *
+         * \param ptr        Pointer to the region.
+         * \param size       Size of the region, in bytes. A last partial host page is left alone.
+         * \param map_prot   Protection the region is committed with.
+         * \param region_key Identify the region between emulators, usually its load address.
+         *
+         * \returns Number of bytes no longer using memory of their own.
+         */
+        std::size_t share(void *ptr, const std::size_t size, const prot map_prot, const std::uint64_t region_key = 0);
+
+        /**
+         * \brief Get the total number of bytes that share() has saved so far.
+         */
+        std::size_t bytes_saved() const {
+            return bytes_saved_;
+        }
+
+        /**
+         * \brief Get the number of bytes held by the pool, one copy per distinct page.
+         */
+        std::size_t bytes_pooled() const {
+            return total_pages_ * page_size_;
+        }
+    };
+}
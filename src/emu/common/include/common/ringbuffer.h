@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace eka2l1::common {
+    /**
+     * \brief Lock-free ring buffer with a single producer and a single consumer.
+     *
+     * One thread may write while another reads, without any locking. Capacity is rounded up
+     * to a power of two.
+     */
+    template <typename T>
+    class spsc_ring_buffer {
+        static_assert(std::is_trivially_copyable_v<T>, "Ring buffer elements must be trivially copyable!");
+
+        std::vector<T> buffer_;
+        std::size_t mask_;
+
+        // Free running positions, on separate cache lines so the two threads don't fight over them
+        alignas(64) std::atomic<std::size_t> read_;
+        alignas(64) std::atomic<std::size_t> write_;
+
+    public:
+        explicit spsc_ring_buffer(const std::size_t min_capacity = 0)
+            : mask_(0)
+            , read_(0)
+            , write_(0) {
+            reset(min_capacity);
+        }
+
+        /**
+         * \brief Empty the ring and resize it. No thread may be reading or writing during this call.
+         */
+        void reset(const std::size_t min_capacity) {
+            std::size_t capacity = 1;
+
+            while (capacity < min_capacity) {
+                capacity <<= 1;
+            }
+
+            if (buffer_.size() != capacity) {
+                buffer_.resize(capacity);
+            }
+
+            mask_ = capacity - 1;
+            read_.store(0, std::memory_order_relaxed);
+            write_.store(0, std::memory_order_relaxed);
+        }
+
+        std::size_t capacity() const {
+            return buffer_.size();
+        }
+
+        /**
+         * \brief Get the number of elements available to read.
+         */
+        std::size_t size() const {
+            return write_.load(std::memory_order_acquire) - read_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * \brief Get the number of elements that can be written without overwriting unread ones.
+         */
+        std::size_t free() const {
+            return capacity() - size();
+        }
+
+        /**
+         * \brief Write elements to the ring. Must only be called by the producer.
+         * \returns Number of elements written, which is less than count if the ring is full.
+         */
+        std::size_t write(const T *data, const std::size_t count) {
+            const std::size_t write_pos = write_.load(std::memory_order_relaxed);
+            const std::size_t read_pos = read_.load(std::memory_order_acquire);
+
+            const std::size_t to_write = std::min(count, capacity() - (write_pos - read_pos));
+
+            if (to_write == 0) {
+                return 0;
+            }
+
+            const std::size_t offset = write_pos & mask_;
+            const std::size_t first_part = std::min(to_write, capacity() - offset);
+
+            std::memcpy(buffer_.data() + offset, data, first_part * sizeof(T));
+            std::memcpy(buffer_.data(), data + first_part, (to_write - first_part) * sizeof(T));
+
+            write_.store(write_pos + to_write, std::memory_order_release);
+            return to_write;
+        }
+
+        /**
+         * \brief Read elements from the ring. Must only be called by the consumer.
+         * \returns Number of elements read, which is less than count if the ring ran dry.
+         */
+        std::size_t read(T *data, const std::size_t count) {
+            const std::size_t read_pos = read_.load(std::memory_order_relaxed);
+            const std::size_t write_pos = write_.load(std::memory_order_acquire);
+
+            const std::size_t to_read = std::min(count, write_pos - read_pos);
+
+            if (to_read == 0) {
+                return 0;
+            }
+
+            const std::size_t offset = read_pos & mask_;
+            const std::size_t first_part = std::min(to_read, capacity() - offset);
+
+            std::memcpy(data, buffer_.data() + offset, first_part * sizeof(T));
+            std::memcpy(data + first_part, buffer_.data(), (to_read - first_part) * sizeof(T));
+
+            read_.store(read_pos + to_read, std::memory_order_release);
+            return to_read;
+        }
+    };
+}
@@ -22,115 +22,129 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 
+#include <common/algorithm.h>
 #include <common/buffer.h>
 
 namespace eka2l1 {
     /**
-     * \brief Compress original data to RLEd.
+     * \brief Count the number of leading bytes two memory ranges have in common.
+     * 
+     * Compares 8 bytes at a time. The ranges may overlap, so a run of repeated pixels can be
+     * found by comparing the data with itself, one pixel further.
+     * 
+     * \param lhs       First range.
+     * \param rhs       Second range.
+     * \param max_size  Maximum number of bytes to compare.
+     * 
+     * \returns Number of equal bytes from the start.
+     */
+    std::size_t rle_common_prefix(const std::uint8_t *lhs, const std::uint8_t *rhs, const std::size_t max_size);
+
+    /**
+     * \brief Fill a span with a repeated pixel.
+     * 
+     * \param dest          Destination to fill.
+     * \param pixel         The pixel to repeat.
+     * \param pixel_size    Size of a pixel in bytes.
+     * \param count         Number of pixels to write.
+     */
+    void rle_fill_pixels(std::uint8_t *dest, const std::uint8_t *pixel, const std::size_t pixel_size, const std::size_t count);
+
+    /**
+     * \brief Compress a span of pixels to RLE.
+     * 
+     * Equal neighbour pixels form runs, written as a count from 0 to 127 (meaning 1 to 128 pixels) followed
+     * by the pixel. Other pixels are copied as is, after a count from -1 to -128.
      * 
      * Support only 8-bit aligned compression.
      * 
-     * \param source        Read-only source stream of binary data.
-     * \param dest          Write-only destination stream. Can be null for size estimation.
-     * \param dest_size     Size of the destination will be written here.
+     * \param source        Pointer to the original data.
+     * \param source_size   Size of the original data, in bytes.
+     * \param dest          Destination to write compressed data to. Can be null for size estimation.
+     * \param dest_size     On entry, size of the destination. On return, size of the compressed data.
+     * 
+     * \returns False if the source is not made of whole pixels, or the destination is too small.
      */
     template <size_t BIT>
-    bool compress_rle(common::ro_stream *source, common::wo_stream *dest, std::size_t &dest_size) {
+    bool compress_rle(const std::uint8_t *source, const std::size_t source_size, std::uint8_t *dest, std::size_t &dest_size) {
         static_assert(BIT % 8 == 0, "This RLE compress function don't support unaligned bit decompress!");
-        dest_size = 0;
-
-        while (source->valid() && (!dest || dest->valid())) {
-            // Read 3 bytes
-            static constexpr std::int32_t BYTE_COUNT = BIT / 8;
+        static constexpr std::size_t BYTE_COUNT = BIT / 8;
+        static constexpr std::size_t MAX_SESSION = 128;
 
-            std::uint8_t bytes[BYTE_COUNT];
-            std::uint64_t last_position = source->tell();
+        const std::size_t total = source_size / BYTE_COUNT;
+        const std::size_t dest_max = dest_size;
 
-            if (source->read(bytes, BYTE_COUNT) != BYTE_COUNT) {
-                return false;
-            }
+        std::size_t written = 0;
+        std::size_t pos = 0;
 
-            std::uint8_t temp_bytes[BYTE_COUNT];
+        const auto pixel_at = [&](const std::size_t index) {
+            return source + index * BYTE_COUNT;
+        };
 
-            if ((source->read(temp_bytes, BYTE_COUNT) == BYTE_COUNT) && std::equal(bytes, bytes + BYTE_COUNT, temp_bytes)) {
-                // Seek back BYTE_COUNT in prepare of the do while loop
-                source->seek(-BYTE_COUNT, common::seek_where::cur);
+        const auto pixel_equal = [&](const std::size_t lhs, const std::size_t rhs) {
+            return std::memcmp(pixel_at(lhs), pixel_at(rhs), BYTE_COUNT) == 0;
+        };
 
-                do {
-                    source->read(temp_bytes, static_cast<std::uint64_t>(BYTE_COUNT));
-                } while (source->valid() && std::equal(bytes, bytes + BYTE_COUNT, temp_bytes));
-
-                // Seek back again, to evade the unequal sequence
-                if (source->valid()) {
-                    source->seek(-BYTE_COUNT, common::seek_where::cur);
-                }
+        while (pos < total) {
+            if ((pos + 1 < total) && pixel_equal(pos, pos + 1)) {
+                // A run continues as long as the data equals itself shifted by a pixel
+                const std::size_t run = 1 + rle_common_prefix(pixel_at(pos + 1), pixel_at(pos), (total - pos - 1) * BYTE_COUNT) / BYTE_COUNT;
 
-                const std::uint64_t total_bytes_repeated = source->tell() - last_position;
-                assert(total_bytes_repeated % BYTE_COUNT == 0);
-
-                std::int64_t total_pair = static_cast<std::int64_t>(total_bytes_repeated / BYTE_COUNT);
-
-                while (total_pair > 0) {
-                    std::uint8_t total_this_session = (total_pair > 128) ? 127 : static_cast<std::uint8_t>(total_pair - 1);
+                for (std::size_t left = run; left > 0;) {
+                    const std::size_t session = common::min(left, MAX_SESSION);
 
                     if (dest) {
-                        dest->write(&total_this_session, 1);
-                        dest->write(bytes, BYTE_COUNT);
+                        if (written + 1 + BYTE_COUNT > dest_max) {
+                            return false;
+                        }
+
+                        dest[written] = static_cast<std::uint8_t>(session - 1);
+                        std::memcpy(dest + written + 1, pixel_at(pos), BYTE_COUNT);
                     }
 
-                    dest_size += BYTE_COUNT + 1;
-                    total_pair -= (total_this_session + 1);
+                    written += 1 + BYTE_COUNT;
+                    left -= session;
                 }
-            } else {
-                // Seek back BYTE_COUNT in prepare of the do while loop
-                source->seek(-BYTE_COUNT, common::seek_where::cur);
 
-                bool should_copy = false;
+                pos += run;
+                continue;
+            }
 
-                do {
-                    if (should_copy)
-                        std::copy(temp_bytes, temp_bytes + BYTE_COUNT, bytes);
+            // The literal goes up to the first pixel of the next equal pair, included.
+            // A pair ending the data stays in the literal.
+            std::size_t end = pos + 2;
 
-                    source->read(temp_bytes, static_cast<std::uint64_t>(BYTE_COUNT));
-                    should_copy = true;
-                } while (source->valid() && !std::equal(bytes, bytes + BYTE_COUNT, temp_bytes));
+            while ((end + 1 < total) && !pixel_equal(end, end - 1)) {
+                end++;
+            }
 
-                if (source->valid()) {
-                    source->seek(-BYTE_COUNT, common::seek_where::cur);
-                }
+            if (end + 1 >= total) {
+                end = total;
+            }
 
-                const std::uint64_t total_bytes_repeated = source->tell() - last_position;
-                std::int64_t total_pair = static_cast<std::int64_t>(total_bytes_repeated / BYTE_COUNT);
+            for (std::size_t left = end - pos; left > 0;) {
+                const std::size_t session = common::min(left, MAX_SESSION);
 
                 if (dest) {
-                    source->seek(last_position, common::seek_where::beg);
-                }
-
-                std::vector<std::uint8_t> temp_data;
-
-                while (total_pair > 0) {
-                    std::int8_t total_this_session = (total_pair > 128) ? -128 : static_cast<std::int8_t>(-total_pair);
-
-                    if (dest) {
-                        dest->write(&total_this_session, 1);
-
-                        // Read the source
-                        temp_data.resize(total_this_session * -BYTE_COUNT);
-                        source->read(&temp_data[0], temp_data.size());
-                        dest->write(&temp_data[0], static_cast<std::uint32_t>(temp_data.size()));
+                    if (written + 1 + session * BYTE_COUNT > dest_max) {
+                        return false;
                     }
 
-                    dest_size += 1 + static_cast<std::size_t>(total_this_session * -BYTE_COUNT);
-
-                    // Negative already!
-                    total_pair += total_this_session;
+                    dest[written] = static_cast<std::uint8_t>(-static_cast<int>(session));
+                    std::memcpy(dest + written + 1, pixel_at(pos), session * BYTE_COUNT);
                 }
+
+                written += 1 + session * BYTE_COUNT;
+                left -= session;
+                pos += session;
             }
         }
 
-        return true;
+        dest_size = written;
+        return (source_size % BYTE_COUNT) == 0;
     }
 
     /**
@@ -138,46 +152,115 @@ namespace eka2l1 {
      * 
      * Support only 8-bit aligned compression.
      * 
-     * \param source Read-only source stream of binary data.
-     * \param dest   Write-only destination stream.
+     * \param source        Pointer to the compressed data.
+     * \param source_size   On entry, size of the compressed data. On return, number of bytes consumed.
+     * \param dest          Destination to write decompressed data to. Can be null for size estimation.
+     * \param dest_size     On entry, size of the destination. On return, size of the decompressed data.
      */
     template <size_t BIT>
-    void decompress_rle(common::ro_stream *source, common::wo_stream *dest) {
+    void decompress_rle(const std::uint8_t *source, std::size_t &source_size, std::uint8_t *dest, std::size_t &dest_size) {
         static_assert(BIT % 8 == 0, "This RLE decompress function don't support unaligned bit decompress!");
+        static constexpr std::size_t BYTE_COUNT = BIT / 8;
 
-        while (source->valid() && dest->valid()) {
-            std::int8_t count8 = 0;
-            source->read(&count8, 1);
+        const std::uint8_t *source_org = source;
+        const std::uint8_t *source_end = source + source_size;
 
-            std::int32_t count = count8;
+        std::size_t written = 0;
 
-            constexpr int BYTE_COUNT = static_cast<int>(BIT) / 8;
+        while ((source < source_end) && (!dest || (written < dest_size))) {
+            const std::int32_t count = static_cast<std::int8_t>(*source++);
 
             if (count >= 0) {
-                count = common::min(count, static_cast<const std::int32_t>(dest->left() / BYTE_COUNT));
-                std::uint8_t comp[BYTE_COUNT];
+                if (source_end - source < static_cast<std::ptrdiff_t>(BYTE_COUNT)) {
+                    source = source_end;
+                    break;
+                }
 
-                for (std::size_t i = 0; i < BYTE_COUNT; i++) {
-                    source->read(&comp[i], 1);
+                std::size_t pixels = static_cast<std::size_t>(count) + 1;
+
+                if (dest) {
+                    pixels = common::min(pixels, (dest_size - written) / BYTE_COUNT);
+                    rle_fill_pixels(dest + written, source, BYTE_COUNT, pixels);
                 }
 
-                while (count >= 0) {
-                    for (std::size_t i = 0; i < BYTE_COUNT; i++) {
-                        dest->write(&comp[i], 1);
-                    }
+                source += BYTE_COUNT;
+                written += pixels * BYTE_COUNT;
 
-                    count--;
+                if (dest && (pixels <= static_cast<std::size_t>(count))) {
+                    // Not even a whole pixel fits anymore
+                    break;
                 }
             } else {
-                std::uint32_t num_bytes_to_copy = static_cast<std::uint32_t>(count * -BYTE_COUNT);
-                num_bytes_to_copy = common::min(num_bytes_to_copy, static_cast<const std::uint32_t>(dest->left()));
+                std::size_t num_bytes_to_copy = common::min(static_cast<std::size_t>(-count) * BYTE_COUNT,
+                    static_cast<std::size_t>(source_end - source));
 
-                std::vector<std::uint8_t> temp_buf_holder;
-                temp_buf_holder.resize(num_bytes_to_copy);
+                if (dest) {
+                    num_bytes_to_copy = common::min(num_bytes_to_copy, dest_size - written);
+                    std::memcpy(dest + written, source, num_bytes_to_copy);
+                }
 
-                source->read(&temp_buf_holder[0], num_bytes_to_copy);
-                dest->write(temp_buf_holder.data(), num_bytes_to_copy);
+                source += num_bytes_to_copy;
+                written += num_bytes_to_copy;
             }
         }
+
+        source_size = source - source_org;
+        dest_size = written;
+    }
+
+    /**
+     * \brief Compress original data to RLEd.
+     * 
+     * Support only 8-bit aligned compression. Prefer the span version, this one reads the whole source first.
+     * 
+     * \param source        Read-only source stream of binary data.
+     * \param dest          Write-only destination stream. Can be null for size estimation.
+     * \param dest_size     Size of the destination will be written here.
+     */
+    template <size_t BIT>
+    bool compress_rle(common::ro_stream *source, common::wo_stream *dest, std::size_t &dest_size) {
+        std::vector<std::uint8_t> source_data(static_cast<std::size_t>(source->left()));
+        source_data.resize(static_cast<std::size_t>(source->read(source_data.data(), source_data.size())));
+
+        dest_size = 0;
+
+        if (!compress_rle<BIT>(source_data.data(), source_data.size(), nullptr, dest_size)) {
+            return false;
+        }
+
+        if (dest) {
+            std::vector<std::uint8_t> dest_data(dest_size);
+
+            compress_rle<BIT>(source_data.data(), source_data.size(), dest_data.data(), dest_size);
+            dest->write(dest_data.data(), static_cast<std::uint32_t>(common::min<std::uint64_t>(dest_size, dest->left())));
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Decompress RLE compressed data.
+     * 
+     * Support only 8-bit aligned compression. Prefer the span version, this one reads the whole source first.
+     * The source stream is left after the last byte consumed.
+     * 
+     * \param source Read-only source stream of binary data.
+     * \param dest   Write-only destination stream.
+     */
+    template <size_t BIT>
+    void decompress_rle(common::ro_stream *source, common::wo_stream *dest) {
+        const std::uint64_t source_pos = source->tell();
+
+        std::vector<std::uint8_t> source_data(static_cast<std::size_t>(source->left()));
+        source_data.resize(static_cast<std::size_t>(source->read(source_data.data(), source_data.size())));
+
+        std::size_t source_size = source_data.size();
+        std::vector<std::uint8_t> dest_data(static_cast<std::size_t>(dest->left()));
+        std::size_t dest_size = dest_data.size();
+
+        decompress_rle<BIT>(source_data.data(), source_size, dest_data.data(), dest_size);
+
+        source->seek(source_pos + source_size, common::seek_where::beg);
+        dest->write(dest_data.data(), static_cast<std::uint32_t>(dest_size));
     }
 }
@@ -88,7 +88,8 @@ namespace eka2l1::common {
      * \param perm The permission of mapped pages.
      * \param size Total size of the file to be mapped. Use 0 to map the whole file.
      * \param is_private Use this so any write to the mapped regions are abadoned when the mapped file close.
-     *                   On Linux this is always private.
+     *                   The file is then opened read-only, and pages not written to stay shared with
+     *                   other processes mapping the same file. On Linux this is always private.
      *
      * \returns A valid pointer to the mapped region on success.
     */
@@ -98,9 +99,12 @@ namespace eka2l1::common {
     /**
      * \brief Unmap a file mapped to memory
      *
+     * \param ptr  Pointer returned by map_file.
+     * \param size Size of the mapped region. Needed to unmap on POSIX, where 0 leaves the region mapped.
+     *
      * \returns True on success.
     */
-    bool unmap_file(void *ptr);
+    bool unmap_file(void *ptr, const std::size_t size = 0);
 
     /**
      * \brief Returns true if the platform doesn't allow write and executable memory at the same time.
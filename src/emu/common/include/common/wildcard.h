@@ -27,4 +27,22 @@ namespace eka2l1::common {
      * \brief Convert a wildcard string to regex 
      */
     std::string wildcard_to_regex_string(std::string regexstr);
+
+    /**
+     * \brief Match a string against a Symbian wildcard pattern.
+     *
+     * '*' matches any sequence of characters, including an empty one, and '?' matches exactly
+     * one character. Everything else, dots and regex metacharacters included, is literal.
+     *
+     * The matcher only ever backtracks to the last star seen, so it runs in linear time for
+     * usual patterns and never worse than name length times pattern length. Nothing is allocated.
+     *
+     * \param str         The string to match.
+     * \param pattern     The wildcard pattern.
+     * \param ignore_case True to compare characters case-insensitively.
+     *
+     * \returns True if the whole string matches the pattern.
+     */
+    bool match_wildcard(const std::string &str, const std::string &pattern, const bool ignore_case = true);
+    bool match_wildcard(const std::u16string &str, const std::u16string &pattern, const bool ignore_case = true);
 }
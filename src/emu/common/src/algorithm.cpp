@@ -177,6 +177,21 @@ namespace eka2l1 {
 #endif
         }
 
+        int count_trailing_zero(const std::uint32_t v) {
+            if (v == 0) {
+                return 32;
+            }
+
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_ctz(v);
+#elif defined(_MSC_VER)
+            unsigned long tz = 0;
+            _BitScanForward(&tz, v);
+
+            return static_cast<int>(tz);
+#endif
+        }
+
         int find_most_significant_bit_one(const std::uint32_t v) {
             return 32 - count_leading_zero(v);
         }
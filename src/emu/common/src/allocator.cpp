@@ -112,6 +112,361 @@ namespace eka2l1::common {
         return true;
     }
 
+    static void tlsf_mapping(const std::uint64_t size, std::uint32_t &fl, std::uint32_t &sl) {
+        if (size < tlsf_allocator::SMALL_BLOCK_SIZE) {
+            // Small blocks are spread linearly over the first list
+            fl = 0;
+            sl = static_cast<std::uint32_t>(size) >> tlsf_allocator::ALIGN_LOG2;
+
+            return;
+        }
+
+        const std::uint32_t msb = static_cast<std::uint32_t>(find_most_significant_bit_one(static_cast<std::uint32_t>(size)) - 1);
+
+        fl = msb - tlsf_allocator::FL_INDEX_SHIFT + 1;
+        sl = static_cast<std::uint32_t>(size >> (msb - tlsf_allocator::SL_INDEX_COUNT_LOG2)) ^ tlsf_allocator::SL_INDEX_COUNT;
+    }
+
+    tlsf_allocator::tlsf_allocator(std::uint8_t *sptr, const std::size_t initial_max_size)
+        : space_based_allocator(sptr, initial_max_size)
+        , fl_bitmap_(0)
+        , last_block_(INVALID_BLOCK)
+        , align_skip_(0)
+        , used_size_(0) {
+        std::fill(sl_bitmap_, sl_bitmap_ + FL_INDEX_COUNT, 0);
+        std::fill(&free_heads_[0][0], &free_heads_[0][0] + FL_INDEX_COUNT * SL_INDEX_COUNT, INVALID_BLOCK);
+
+        align_skip_ = (ALIGN_SIZE - reinterpret_cast<std::uint64_t>(ptr) % ALIGN_SIZE) % ALIGN_SIZE;
+        ptr += align_skip_;
+
+        if (max_size > align_skip_) {
+            const std::size_t usable = (max_size - align_skip_) & ~static_cast<std::size_t>(ALIGN_SIZE - 1);
+
+            if (usable != 0) {
+                add_free_space(0, static_cast<std::uint32_t>(usable));
+            }
+        }
+    }
+
+    std::uint32_t tlsf_allocator::new_block_info() {
+        if (!unused_infos_.empty()) {
+            const std::uint32_t idx = unused_infos_.back();
+            unused_infos_.pop_back();
+
+            return idx;
+        }
+
+        blocks_.emplace_back();
+        return static_cast<std::uint32_t>(blocks_.size() - 1);
+    }
+
+    void tlsf_allocator::delete_block_info(const std::uint32_t idx) {
+        unused_infos_.push_back(idx);
+    }
+
+    void tlsf_allocator::insert_free_block(const std::uint32_t idx) {
+        block_info &block = blocks_[idx];
+
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
+
+        tlsf_mapping(block.size, fl, sl);
+
+        block.free = true;
+        block.prev_free = INVALID_BLOCK;
+        block.next_free = free_heads_[fl][sl];
+
+        if (block.next_free != INVALID_BLOCK) {
+            blocks_[block.next_free].prev_free = idx;
+        }
+
+        free_heads_[fl][sl] = idx;
+
+        fl_bitmap_ |= (1U << fl);
+        sl_bitmap_[fl] |= (1U << sl);
+    }
+
+    void tlsf_allocator::remove_free_block(const std::uint32_t idx) {
+        block_info &block = blocks_[idx];
+
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
+
+        tlsf_mapping(block.size, fl, sl);
+
+        if (block.prev_free != INVALID_BLOCK) {
+            blocks_[block.prev_free].next_free = block.next_free;
+        } else {
+            free_heads_[fl][sl] = block.next_free;
+        }
+
+        if (block.next_free != INVALID_BLOCK) {
+            blocks_[block.next_free].prev_free = block.prev_free;
+        }
+
+        if (free_heads_[fl][sl] == INVALID_BLOCK) {
+            sl_bitmap_[fl] &= ~(1U << sl);
+
+            if (sl_bitmap_[fl] == 0) {
+                fl_bitmap_ &= ~(1U << fl);
+            }
+        }
+
+        block.free = false;
+        block.prev_free = INVALID_BLOCK;
+        block.next_free = INVALID_BLOCK;
+    }
+
+    std::uint32_t tlsf_allocator::find_free_block(const std::uint32_t size) {
+        std::uint64_t search_size = size;
+
+        // Round up to the next list, so that any block found there is big enough
+        if (search_size >= SMALL_BLOCK_SIZE) {
+            const std::uint32_t msb = static_cast<std::uint32_t>(find_most_significant_bit_one(size) - 1);
+            search_size += (1ULL << (msb - SL_INDEX_COUNT_LOG2)) - 1;
+
+            if (search_size > 0xFFFFFFFFULL) {
+                return find_free_block_exact(size);
+            }
+        }
+
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
+
+        tlsf_mapping(search_size, fl, sl);
+
+        std::uint32_t sl_map = sl_bitmap_[fl] & (~0U << sl);
+
+        if (sl_map == 0) {
+            // Nothing in this power of two, take the smallest bigger one
+            const std::uint32_t fl_map = (fl + 1 >= 32) ? 0 : (fl_bitmap_ & (~0U << (fl + 1)));
+
+            if (fl_map == 0) {
+                return find_free_block_exact(size);
+            }
+
+            fl = static_cast<std::uint32_t>(count_trailing_zero(fl_map));
+            sl_map = sl_bitmap_[fl];
+        }
+
+        sl = static_cast<std::uint32_t>(count_trailing_zero(sl_map));
+        return free_heads_[fl][sl];
+    }
+
+    std::uint32_t tlsf_allocator::find_free_block_exact(const std::uint32_t size) {
+        // The rounded search skips the list the size itself maps to. Blocks there may still
+        // be large enough, so walk it before giving up and growing the space.
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
+
+        tlsf_mapping(size, fl, sl);
+
+        for (std::uint32_t idx = free_heads_[fl][sl]; idx != INVALID_BLOCK; idx = blocks_[idx].next_free) {
+            if (blocks_[idx].size >= size) {
+                return idx;
+            }
+        }
+
+        return INVALID_BLOCK;
+    }
+
+    void tlsf_allocator::add_free_space(const std::uint32_t offset, const std::uint32_t size) {
+        // Extend the last block if it is free, so that space grown stays in one piece
+        if ((last_block_ != INVALID_BLOCK) && blocks_[last_block_].free) {
+            remove_free_block(last_block_);
+            blocks_[last_block_].size += size;
+            insert_free_block(last_block_);
+
+            return;
+        }
+
+        const std::uint32_t idx = new_block_info();
+        block_info &block = blocks_[idx];
+
+        block.offset = offset;
+        block.size = size;
+        block.prev_phys = last_block_;
+        block.next_phys = INVALID_BLOCK;
+
+        if (last_block_ != INVALID_BLOCK) {
+            blocks_[last_block_].next_phys = idx;
+        }
+
+        last_block_ = idx;
+        insert_free_block(idx);
+    }
+
+    bool tlsf_allocator::grow(const std::uint32_t size) {
+        const std::size_t old_usable = (max_size > align_skip_) ? ((max_size - align_skip_) & ~static_cast<std::size_t>(ALIGN_SIZE - 1)) : 0;
+        std::size_t needed = size;
+
+        if ((last_block_ != INVALID_BLOCK) && blocks_[last_block_].free) {
+            needed -= blocks_[last_block_].size;
+        }
+
+        // Try doubling first like the other allocators, then just what is needed
+        std::size_t target = common::max(max_size * 2, max_size + needed);
+
+        if (!expand(target)) {
+            target = max_size + needed;
+
+            if (!expand(target)) {
+                return false;
+            }
+        }
+
+        max_size = target;
+
+        const std::size_t new_usable = (max_size - align_skip_) & ~static_cast<std::size_t>(ALIGN_SIZE - 1);
+
+        if ((new_usable <= old_usable) || (new_usable > 0xFFFFFFFFULL)) {
+            return false;
+        }
+
+        add_free_space(static_cast<std::uint32_t>(old_usable), static_cast<std::uint32_t>(new_usable - old_usable));
+        return true;
+    }
+
+    void *tlsf_allocator::allocate(std::size_t bytes) {
+        if (bytes == 0) {
+            bytes = 1;
+        }
+
+        if (bytes > 0xFFFFFFFFULL - ALIGN_SIZE) {
+            return nullptr;
+        }
+
+        const std::uint32_t size = static_cast<std::uint32_t>((bytes + ALIGN_SIZE - 1) & ~static_cast<std::size_t>(ALIGN_SIZE - 1));
+
+        const std::lock_guard<std::mutex> guard(lock_);
+        std::uint32_t idx = find_free_block(size);
+
+        if (idx == INVALID_BLOCK) {
+            if (!grow(size)) {
+                return nullptr;
+            }
+
+            idx = find_free_block(size);
+
+            if (idx == INVALID_BLOCK) {
+                return nullptr;
+            }
+        }
+
+        remove_free_block(idx);
+
+        // Split the rest back to the free lists
+        if (blocks_[idx].size - size >= ALIGN_SIZE) {
+            const std::uint32_t rest_idx = new_block_info();
+
+            block_info &block = blocks_[idx];
+            block_info &rest = blocks_[rest_idx];
+
+            rest.offset = block.offset + size;
+            rest.size = block.size - size;
+            rest.prev_phys = idx;
+            rest.next_phys = block.next_phys;
+
+            if (rest.next_phys != INVALID_BLOCK) {
+                blocks_[rest.next_phys].prev_phys = rest_idx;
+            } else {
+                last_block_ = rest_idx;
+            }
+
+            block.size = size;
+            block.next_phys = rest_idx;
+
+            insert_free_block(rest_idx);
+        }
+
+        used_blocks_.emplace(blocks_[idx].offset, idx);
+        used_size_ += blocks_[idx].size;
+
+        return ptr + blocks_[idx].offset;
+    }
+
+    bool tlsf_allocator::free(const void *tptr) {
+        const std::uint8_t *target = reinterpret_cast<const std::uint8_t *>(tptr);
+
+        if (target < ptr) {
+            return false;
+        }
+
+        const std::lock_guard<std::mutex> guard(lock_);
+        auto ite = used_blocks_.find(static_cast<std::uint32_t>(target - ptr));
+
+        if (ite == used_blocks_.end()) {
+            return false;
+        }
+
+        std::uint32_t idx = ite->second;
+        used_blocks_.erase(ite);
+        used_size_ -= blocks_[idx].size;
+
+        // Merge with the previous block
+        const std::uint32_t prev = blocks_[idx].prev_phys;
+
+        if ((prev != INVALID_BLOCK) && blocks_[prev].free) {
+            remove_free_block(prev);
+
+            blocks_[prev].size += blocks_[idx].size;
+            blocks_[prev].next_phys = blocks_[idx].next_phys;
+
+            if (blocks_[idx].next_phys != INVALID_BLOCK) {
+                blocks_[blocks_[idx].next_phys].prev_phys = prev;
+            } else {
+                last_block_ = prev;
+            }
+
+            delete_block_info(idx);
+            idx = prev;
+        }
+
+        // Merge with the next block
+        const std::uint32_t next = blocks_[idx].next_phys;
+
+        if ((next != INVALID_BLOCK) && blocks_[next].free) {
+            remove_free_block(next);
+
+            blocks_[idx].size += blocks_[next].size;
+            blocks_[idx].next_phys = blocks_[next].next_phys;
+
+            if (blocks_[next].next_phys != INVALID_BLOCK) {
+                blocks_[blocks_[next].next_phys].prev_phys = idx;
+            } else {
+                last_block_ = idx;
+            }
+
+            delete_block_info(next);
+        }
+
+        insert_free_block(idx);
+        return true;
+    }
+
+    allocator_stats tlsf_allocator::get_stats() {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        allocator_stats stats;
+        stats.total_size = (max_size > align_skip_) ? ((max_size - align_skip_) & ~static_cast<std::size_t>(ALIGN_SIZE - 1)) : 0;
+        stats.used_size = used_size_;
+        stats.free_size = stats.total_size - used_size_;
+        stats.used_block_count = used_blocks_.size();
+        stats.free_block_count = blocks_.size() - unused_infos_.size() - used_blocks_.size();
+
+        if (fl_bitmap_ != 0) {
+            // The biggest block is somewhere in the highest list that is not empty
+            const std::uint32_t fl = static_cast<std::uint32_t>(find_most_significant_bit_one(fl_bitmap_) - 1);
+            const std::uint32_t sl = static_cast<std::uint32_t>(find_most_significant_bit_one(sl_bitmap_[fl]) - 1);
+
+            for (std::uint32_t idx = free_heads_[fl][sl]; idx != INVALID_BLOCK; idx = blocks_[idx].next_free) {
+                stats.largest_free_block = common::max<std::size_t>(stats.largest_free_block, blocks_[idx].size);
+            }
+        }
+
+        return stats;
+    }
+
     bitmap_allocator::bitmap_allocator(const std::size_t total_bits)
         : words_((total_bits >> 5) + ((total_bits % 32 != 0) ? 1 : 0), 0xFFFFFFFF) {
     }
@@ -23,147 +23,227 @@
 #include <common/bytepair.h>
 #include <common/log.h>
 
+#include <array>
 #include <cstdint>
-#include <functional>
-#include <stack>
+#include <cstring>
 
 namespace eka2l1 {
     namespace common {
-        int bytepair_decompress(void *destination, unsigned int dest_size, void *buffer, unsigned int buf_size) {
-            uint8_t *data8 = reinterpret_cast<uint8_t *>(buffer);
-            uint32_t lookup_table[0x200];
+        enum {
+            BYTEPAIR_SHORT_EXPANSION = 8, ///< Expansions up to this long are stored whole and written at once.
+            BYTEPAIR_MAX_DEPTH = 256 ///< Pairs only refer to earlier pairs, so nesting can't get deeper than this.
+        };
+
+        /*! \brief Pair table of a bytepair page, with the expansion of each byte worked out ahead. */
+        struct bytepair_table {
+            std::uint8_t first[256]; ///< First half of a pair. Equals the byte itself for a literal.
+            std::uint8_t second[256]; ///< Second half of a pair.
+            std::uint16_t length[256]; ///< Length of the full expansion, saturated at 0xFFFF.
+            std::uint8_t expansion[256][BYTEPAIR_SHORT_EXPANSION]; ///< Whole expansion, when short enough.
+            int marker; ///< Byte escaping the next one as a literal, -1 if there is none.
+        };
+
+        static bool is_bytepair_pair(const bytepair_table &table, const std::uint8_t b) {
+            return (table.first[b] != b) && (b != table.marker);
+        }
 
-            uint8_t *lookup_table_first = reinterpret_cast<uint8_t *>(lookup_table);
-            uint8_t *lookup_table_second = lookup_table_first + 0x100;
+        // Parse the pair table at the start of a page. Returns the first byte of page data, nullptr if invalid.
+        static const std::uint8_t *read_bytepair_table(bytepair_table &table, const std::uint8_t *data, const std::uint8_t *data_end) {
+            for (int i = 0; i < 256; i++) {
+                table.first[i] = static_cast<std::uint8_t>(i);
+                table.second[i] = static_cast<std::uint8_t>(i);
+            }
 
-            uint32_t marker = ~0u;
-            uint8_t p1, p2;
+            table.marker = -1;
 
-            // Fill the table
-            uint32_t b = 0x03020100;
-            uint32_t step = 0x04040404;
+            if (data >= data_end) {
+                return nullptr;
+            }
 
-            std::stack<uint8_t> sec_stack;
+            int total_pair = *data++;
 
-            uint8_t *buf_end = reinterpret_cast<uint8_t *>(buffer) + buf_size;
-            uint8_t *dest_end = reinterpret_cast<uint8_t *>(destination) + dest_size;
+            if (total_pair == 0) {
+                return data;
+            }
 
-            uint8_t *dest = reinterpret_cast<uint8_t *>(destination);
+            if (data >= data_end) {
+                return nullptr;
+            }
 
-            uint32_t *lut = (uint32_t *)(lookup_table);
+            table.marker = *data++;
 
-            do {
-                *lut++ = b;
-                b += step;
-            } while (b > step);
+            if (total_pair < 32) {
+                if (data_end - data < 3 * total_pair) {
+                    return nullptr;
+                }
 
-            uint8_t total_pair = *data8++;
+                for (int i = 0; i < total_pair; i++, data += 3) {
+                    table.first[data[0]] = data[1];
+                    table.second[data[0]] = data[2];
+                }
+            } else {
+                if (data_end - data < 32) {
+                    return nullptr;
+                }
 
-            if (total_pair) {
-                marker = *data8++;
-                lookup_table_first[marker] = (uint8_t)(~marker);
+                const std::uint8_t *mask = data;
+                data += 32;
 
-                if (total_pair < 32) {
-                    uint8_t *pair_end = data8 + 3 * total_pair;
+                for (int b = 0; b < 256; b++) {
+                    if (mask[b >> 3] & (1 << (b & 7))) {
+                        if ((data_end - data < 2) || (total_pair-- == 0)) {
+                            return nullptr;
+                        }
 
-                    do {
-                        b = *data8++;
-                        p1 = *data8++;
-                        p2 = *data8++;
+                        table.first[b] = *data++;
+                        table.second[b] = *data++;
+                    }
+                }
 
-                        lookup_table_first[b] = p1;
-                        lookup_table_second[b] = p2;
-                    } while (data8 < pair_end);
+                if (total_pair) {
+                    return nullptr;
+                }
+            }
 
-                } else {
-                    uint8_t *mask_st = data8;
-                    data8 += 32;
+            return data;
+        }
+
+        // Work out expansion lengths, and the bytes of short ones. Children are done before their parent,
+        // with an explicit stack holding the path being walked.
+        static bool expand_bytepair_table(bytepair_table &table) {
+            bool done[256] = {};
+            std::uint8_t path[BYTEPAIR_MAX_DEPTH];
 
-                    for (b = 0; b < 0x100; b++) {
-                        uint8_t mask = mask_st[b >> 3];
+            for (int i = 0; i < 256; i++) {
+                const std::uint8_t b = static_cast<std::uint8_t>(i);
 
-                        if (mask & (1 << (b & 7))) {
-                            // Read the pair
-                            p1 = *data8++;
-                            p2 = *data8++;
+                if (!is_bytepair_pair(table, b)) {
+                    table.length[b] = 1;
+                    table.expansion[b][0] = b;
 
-                            lookup_table_first[b] = p1;
-                            lookup_table_second[b] = p2;
+                    done[b] = true;
+                }
+            }
 
-                            --total_pair;
+            for (int i = 0; i < 256; i++) {
+                if (done[i]) {
+                    continue;
+                }
+
+                bool on_path[256] = {};
+                int depth = 0;
+
+                path[depth++] = static_cast<std::uint8_t>(i);
+                on_path[i] = true;
+
+                while (depth) {
+                    const std::uint8_t b = path[depth - 1];
+                    const std::uint8_t p1 = table.first[b];
+                    const std::uint8_t p2 = table.second[b];
+
+                    if (!done[p1] || !done[p2]) {
+                        const std::uint8_t next = done[p1] ? p2 : p1;
+
+                        if (on_path[next] || (depth == BYTEPAIR_MAX_DEPTH)) {
+                            // A pair containing itself
+                            return false;
                         }
+
+                        path[depth++] = next;
+                        on_path[next] = true;
+
+                        continue;
                     }
 
-                    if (total_pair) {
-                        return 0;
+                    const std::uint32_t len = common::min<std::uint32_t>(table.length[p1] + table.length[p2], 0xFFFF);
+                    table.length[b] = static_cast<std::uint16_t>(len);
+
+                    if (len <= BYTEPAIR_SHORT_EXPANSION) {
+                        std::memcpy(table.expansion[b], table.expansion[p1], table.length[p1]);
+                        std::memcpy(table.expansion[b] + table.length[p1], table.expansion[p2], table.length[p2]);
                     }
+
+                    done[b] = true;
+                    on_path[b] = false;
+                    depth--;
                 }
             }
 
-            b = *data8++;
-            p1 = lookup_table_first[b];
+            return true;
+        }
 
-            // I'm so depressed that i have to do this
-            if (p1 != b)
-                goto not_single;
+        int bytepair_decompress(void *destination, unsigned int dest_size, void *buffer, unsigned int buf_size) {
+            const std::uint8_t *data = reinterpret_cast<const std::uint8_t *>(buffer);
+            const std::uint8_t *data_end = data + buf_size;
 
-        process_replace:
-            if (data8 >= buf_end) {
-                goto done_data8;
-            }
+            std::uint8_t *dest = reinterpret_cast<std::uint8_t *>(destination);
+            std::uint8_t *dest_end = dest + dest_size;
 
-            b = *data8++;
-            *dest++ = p1;
+            bytepair_table table;
+            data = read_bytepair_table(table, data, data_end);
 
-            if (dest >= dest_end) {
-                goto done_dest;
+            if (!data || !expand_bytepair_table(table)) {
+                LOG_ERROR("Bytepair page has an invalid pair table!");
+                return 0;
             }
 
-            p1 = lookup_table_first[b];
+            // Pairs still to be expanded, the last one on top
+            std::uint8_t pending[BYTEPAIR_MAX_DEPTH + 1];
 
-            if (p1 == b)
-                goto process_replace;
+            while ((data < data_end) && (dest < dest_end)) {
+                std::uint8_t b = *data++;
 
-        not_single:
-            if (b == marker) {
-                goto do_marker;
-            }
+                if (b == table.marker) {
+                    if (data == data_end) {
+                        break;
+                    }
 
-        do_pair:
-            p2 = lookup_table_second[b];
-            b = p1;
-            p1 = lookup_table_first[b];
-            sec_stack.push(p2);
+                    *dest++ = *data++;
+                    continue;
+                }
 
-        recurse:
-            if (b != p1) {
-                goto do_pair;
-            }
+                std::size_t len = table.length[b];
 
-            if (sec_stack.empty()) {
-                goto process_replace;
-            }
+                if (len == 1) {
+                    *dest++ = b;
+                    continue;
+                }
 
-            b = sec_stack.top();
-            sec_stack.pop();
+                if (len <= BYTEPAIR_SHORT_EXPANSION) {
+                    if (dest_end - dest >= BYTEPAIR_SHORT_EXPANSION) {
+                        // Always write whole, only the expansion length is kept
+                        std::memcpy(dest, table.expansion[b], BYTEPAIR_SHORT_EXPANSION);
+                    } else {
+                        len = common::min<std::size_t>(len, dest_end - dest);
+                        std::memcpy(dest, table.expansion[b], len);
+                    }
 
-            *dest++ = p1;
-            p1 = lookup_table_first[b];
+                    dest += len;
+                    continue;
+                }
 
-            goto recurse;
+                int top = 0;
+                pending[top++] = b;
 
-        do_marker:
-            p1 = *data8++;
-            goto process_replace;
+                while (top && (dest < dest_end)) {
+                    b = pending[--top];
 
-        done_data8:
-            *dest++ = p1;
-            return static_cast<int>(dest - static_cast<uint8_t *>(destination));
+                    if (table.length[b] > BYTEPAIR_SHORT_EXPANSION) {
+                        // Depth is bounded by the table, which has no loop
+                        pending[top++] = table.second[b];
+                        pending[top++] = table.first[b];
 
-        done_dest:
-            return static_cast<int>(dest - static_cast<uint8_t *>(destination));
+                        continue;
+                    }
+
+                    len = common::min<std::size_t>(table.length[b], dest_end - dest);
+                    std::memcpy(dest, table.expansion[b], len);
+
+                    dest += len;
+                }
+            }
 
-            return 1;
+            return static_cast<int>(dest - static_cast<std::uint8_t *>(destination));
         }
 
         ibytepair_stream::ibytepair_stream(common::ro_stream *stream)
@@ -185,35 +265,41 @@ namespace eka2l1 {
 
             compress_stream->read(reinterpret_cast<char *>(idx_tab.page_size.data()),
                 idx_tab.page_size.size() * sizeof(uint16_t));
+
+            data_start = compress_stream->tell();
+
+            // Pages follow each other right after the table
+            page_starts.resize(idx_tab.page_size.size() + 1);
+            page_starts[0] = 0;
+
+            for (std::size_t i = 0; i < idx_tab.page_size.size(); i++) {
+                page_starts[i + 1] = page_starts[i] + idx_tab.page_size[i];
+            }
         }
 
         uint32_t ibytepair_stream::read_page(char *dest, uint32_t page, size_t size) {
-            size_t len = common::min<size_t>(size, 4096);
-            auto crr_pos = compress_stream->tell();
-            std::vector<char> buf;
+            if (page >= idx_tab.page_size.size()) {
+                LOG_ERROR("Bytepair page {} out of range ({} pages)", page, idx_tab.page_size.size());
+                return 0;
+            }
 
-            buf.resize(idx_tab.page_size[page]);
+            const size_t len = common::min<size_t>(size, BYTEPAIR_PAGE_SIZE);
+            page_buf.resize(idx_tab.page_size[page]);
 
-            compress_stream->read(buf.data(), buf.size());
+            compress_stream->seek(data_start + page_starts[page], common::seek_where::beg);
 
-            if (buf.data() == nullptr) {
-                LOG_ERROR("Buffer is null! Size: {}", idx_tab.page_size[page]);
+            if (compress_stream->read(page_buf.data(), page_buf.size()) != page_buf.size()) {
+                LOG_ERROR("Bytepair page {} is truncated", page);
                 return 0;
             }
 
-            return bytepair_decompress(dest, static_cast<int>(len), buf.data(), idx_tab.page_size[page]);
+            return bytepair_decompress(dest, static_cast<int>(len), page_buf.data(), idx_tab.page_size[page]);
         }
 
         uint32_t ibytepair_stream::read_pages(char *dest, size_t size) {
             uint32_t decompressed_size = 0;
             read_table();
 
-            uint64_t tsize = 0;
-
-            for (uint32_t i = 0; i < idx_tab.page_size.size(); i++) {
-                tsize += idx_tab.page_size[i];
-            }
-
             for (auto i = 0; i < idx_tab.header.number_of_pages; i++) {
                 uint32_t dcs_page = read_page(dest, i, size);
 
@@ -222,24 +308,64 @@ namespace eka2l1 {
                 size -= dcs_page;
             }
 
+            // Leave the stream right after this compressed block, whatever was read
+            compress_stream->seek(data_start + page_starts.back(), common::seek_where::beg);
             return decompressed_size;
         }
 
+        uint32_t ibytepair_stream::read_range(char *dest, uint32_t offset, uint32_t size) {
+            std::array<char, BYTEPAIR_PAGE_SIZE> scratch;
+            uint32_t total = 0;
+
+            while (size) {
+                const uint32_t page = offset / BYTEPAIR_PAGE_SIZE;
+                const uint32_t in_page = offset % BYTEPAIR_PAGE_SIZE;
+
+                if (page >= idx_tab.page_size.size()) {
+                    break;
+                }
+
+                const uint32_t take = common::min<uint32_t>(size, BYTEPAIR_PAGE_SIZE - in_page);
+                uint32_t got = 0;
+
+                if (in_page == 0) {
+                    // The wanted part starts the page, decompress straight to the destination and stop early
+                    got = read_page(dest, page, take);
+                } else {
+                    const uint32_t page_len = read_page(scratch.data(), page, in_page + take);
+
+                    if (page_len > in_page) {
+                        got = common::min<uint32_t>(take, page_len - in_page);
+                        std::memcpy(dest, scratch.data() + in_page, got);
+                    }
+                }
+
+                total += got;
+
+                if (got < take) {
+                    break;
+                }
+
+                dest += got;
+                offset += got;
+                size -= got;
+            }
+
+            return total;
+        }
+
         std::vector<uint32_t> ibytepair_stream::page_offsets(uint32_t initial_off) {
             read_table();
             std::vector<uint32_t> res;
 
-            res.resize(idx_tab.header.number_of_pages + 1);
+            res.resize(page_starts.size());
 
-            size_t bytes = initial_off + 10 + res.size() * sizeof(uint16_t);
+            const size_t table_size = 10 + idx_tab.page_size.size() * sizeof(uint16_t);
 
-            for (auto i = 0; i < res.size(); ++i) {
-                res[i] = static_cast<uint32_t>(bytes);
-                bytes += idx_tab.page_size[i];
+            for (size_t i = 0; i < res.size(); ++i) {
+                res[i] = static_cast<uint32_t>(initial_off + table_size + page_starts[i]);
             }
 
-            res[res.size()] = static_cast<uint32_t>(bytes);
-
             return res;
         }
     }
@@ -25,17 +25,89 @@
 #include <common/dictcomp.h>
 #include <common/log.h>
 
+#include <array>
+#include <cstring>
+
 namespace eka2l1::common {
-    dictcomp::dictcomp(std::uint8_t *buf, const int off_beg, const int off_end,
+    namespace {
+        // How the bytes of a token are counted, looked up with the 4 bits after the leading zero
+        struct dictcomp_bytes_header {
+            std::uint8_t header_bits; ///< Bits of the header, including the leading zero.
+            std::uint8_t extra_bits; ///< Bits of the number following the header.
+            std::uint16_t base; ///< Number of bytes following the first one, before adding the extra number.
+        };
+
+        using dictcomp_header_table = std::array<dictcomp_bytes_header, 16>;
+
+        constexpr dictcomp_header_table make_dictcomp_header_table(const bool calypso) {
+            dictcomp_header_table table{};
+
+            for (int i = 0; i < 16; i++) {
+                int prefix_bits = 0;
+
+                while ((prefix_bits < 4) && (i & (1 << prefix_bits))) {
+                    prefix_bits++;
+                }
+
+                dictcomp_bytes_header &header = table[i];
+
+                // The zero ending the prefix is there unless the prefix is full
+                header.header_bits = static_cast<std::uint8_t>(1 + prefix_bits + ((prefix_bits < 4) ? 1 : 0));
+
+                switch (prefix_bits) {
+                case 3:
+                    header.extra_bits = 3;
+                    header.base = 3;
+                    break;
+
+                case 4:
+                    header.extra_bits = 8;
+                    header.base = calypso ? 4 : (3 + (1 << 3));
+                    break;
+
+                default:
+                    header.extra_bits = 0;
+                    header.base = static_cast<std::uint16_t>(prefix_bits);
+                    break;
+                }
+            }
+
+            return table;
+        }
+
+        constexpr dictcomp_header_table DICTCOMP_HEADERS = make_dictcomp_header_table(false);
+        constexpr dictcomp_header_table DICTCOMP_CALYPSO_HEADERS = make_dictcomp_header_table(true);
+    }
+
+    dictcomp::dictcomp(const std::uint8_t *buf, const int buf_size, const int off_beg, const int off_end,
         const int num_bits_used_for_dict_tokens)
         : num_bits_used_for_dict_tokens(num_bits_used_for_dict_tokens)
         , off_beg(off_beg)
-        , off_end(off_end)
-        , buffer(buf) {
+        , off_cur(off_beg)
+        , off_end(common::min(off_end, buf_size * 8))
+        , buffer(buf)
+        , buffer_size(buf_size) {
+    }
+
+    std::uint64_t dictcomp::peek_bits(const int num_bit) const {
+        const int byte_off = off_cur >> 3;
+        std::uint64_t window = 0;
+
+        if (byte_off + 8 <= buffer_size) {
+            for (int i = 7; i >= 0; i--) {
+                window = (window << 8) | buffer[byte_off + i];
+            }
+        } else {
+            for (int i = buffer_size - byte_off - 1; i >= 0; i--) {
+                window = (window << 8) | buffer[byte_off + i];
+            }
+        }
+
+        return (window >> (off_cur & 7)) & ((1ULL << num_bit) - 1);
     }
 
     bool dictcomp::is_cur_bit_on() {
-        return buffer[off_cur / 8] & (1 << (off_cur) % 8);
+        return peek_bits(1) != 0;
     }
 
     int dictcomp::index_of_current_directory_entry() {
@@ -48,78 +120,20 @@ namespace eka2l1::common {
     }
 
     int dictcomp::read_int(int num_bit) {
-        int result = 0;
-
-        auto do_read_bits_seperately = [&]() {
-            // If the offset is not aligned, we can't read this properly
-            // We need to do some bits tweaking, to read these byte to an integer, then align the bit offset to 8
-            if (off_cur % 8 != 0) {
-                int num_bit_to_read_next = common::min(num_bit, 8 - off_cur % 8);
-                char me = buffer[off_cur % 8];
-
-                // Example:
-                // 0b11110000, from bit 1, size = 3
-                // => 0b11100000
-                // 0b11111111 << 5 = 0b11100000
-                // => 0b11100000 & 0b11100000 => 0b111
-                result = (result << 8) | (me << (off_cur % 8) & (0xFF << (8 - num_bit_to_read_next)));
-
-                off_cur += num_bit_to_read_next;
-                num_bit -= num_bit_to_read_next;
-            }
-        };
-
-        // Do align if neccessary
-        do_read_bits_seperately();
-
-        if (num_bit <= 0) {
-            return result;
-        }
-
-        // Read byte by byte
-        for (int i = 0; i < num_bit / 8; i++) {
-            result = (result << 8) | buffer[off_cur / 8];
-            off_cur += 8;
-        }
-
-        if (num_bit <= 0) {
-            return result;
-        }
-
-        // Try to read left-out bits, if we haven't read them all
-        do_read_bits_seperately();
+        const int result = static_cast<int>(peek_bits(num_bit));
+        off_cur += num_bit;
 
         return result;
     }
 
     int dictcomp::calculate_decompress_size(const bool calypso, bool reset_when_done) {
-        int last_off_cur = off_cur;
-        int num_consecutive_prefix_bits = 0;
+        const int last_off_cur = off_cur;
+        const dictcomp_bytes_header &header = (calypso ? DICTCOMP_CALYPSO_HEADERS : DICTCOMP_HEADERS)[(peek_bits(5) >> 1) & 0xF];
 
-        for (std::uint8_t i = 0; i < 4; i++) {
-            bool cur_bit_on = is_cur_bit_on();
-            off_cur++;
+        off_cur += header.header_bits;
 
-            if (!cur_bit_on) {
-                break;
-            }
-
-            num_consecutive_prefix_bits++;
-        }
-
-        int num_bytes_to_read = 0;
-
-        if (num_consecutive_prefix_bits == 3) {
-            num_bytes_to_read = 3 + read_int(3);
-        } else if (num_consecutive_prefix_bits == 4) {
-            num_bytes_to_read = 4 + read_int(8);
-
-            if (!calypso) {
-                num_bytes_to_read = 3 + (1 << 3);
-            }
-        } else {
-            num_bytes_to_read = num_consecutive_prefix_bits;
-        }
+        // There is always at least one byte
+        const int num_bytes_to_read = 1 + header.base + read_int(header.extra_bits);
 
         if (reset_when_done) {
             off_cur = last_off_cur;
@@ -130,30 +144,31 @@ namespace eka2l1::common {
 
     int dictcomp::read(std::uint8_t *dest, int &dest_size, const bool calypso) {
         // These size in bytes
-        int size = calculate_decompress_size(calypso, false);
-        int *dest_i = reinterpret_cast<int *>(dest);
+        const int size = calculate_decompress_size(calypso, false);
 
         if (size > dest_size) {
             LOG_ERROR("Can't decompress: unsufficent memory (needed: 0x{:X} vs provided 0x{:X})", size, dest_size);
             return -1;
         }
 
+        if (off_cur + size * 8 > off_end) {
+            LOG_ERROR("Can't decompress: bytes go past the end of the stream");
+            return -1;
+        }
+
         const int num_bits_off_byte_bound = off_cur % 8;
         const std::uint8_t *cur_byte = buffer + (off_cur / 8);
 
-        for (int i = 0; i < size; i++, ++cur_byte) {
-            int b = *cur_byte;
-
-            if (num_bits_off_byte_bound > 0) {
-                b >>= num_bits_off_byte_bound;
-                b |= (*(cur_byte) + 1) << (8 - num_bits_off_byte_bound);
-                b &= 0xFF;
+        if (num_bits_off_byte_bound == 0) {
+            std::memcpy(dest, cur_byte, size);
+        } else {
+            // Stays inside the buffer, since the last byte ends before the stream does
+            for (int i = 0; i < size; i++, ++cur_byte) {
+                dest[i] = static_cast<std::uint8_t>((cur_byte[0] >> num_bits_off_byte_bound) | (cur_byte[1] << (8 - num_bits_off_byte_bound)));
             }
-
-            *(dest_i++) = b;
         }
 
         off_cur += size * 8;
         return size;
     }
-}
\ No newline at end of file
+}
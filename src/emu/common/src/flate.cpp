@@ -21,7 +21,9 @@
 #include <common/flate.h>
 #include <common/log.h>
 
+#include <algorithm>
 #include <array>
+#include <cstring>
 #include <miniz.h>
 
 namespace eka2l1 {
@@ -531,97 +533,102 @@ namespace eka2l1 {
                 do_write(pad_size ? 0xffffffffu : 0, -bits);
         }
 
-        uint32_t swap_bo(uint32_t val) {
-            uint32_t tval = (val << 16) | (val >> 16);
-            tval ^= val;
-            tval &= 0xff00ffff;
-            val = (val >> 8) | (val << 24);
-            return val ^ (tval >> 8);
+        static inline std::uint64_t load_be64(const uint8_t *ptr) {
+            return (static_cast<std::uint64_t>(ptr[0]) << 56) | (static_cast<std::uint64_t>(ptr[1]) << 48)
+                | (static_cast<std::uint64_t>(ptr[2]) << 40) | (static_cast<std::uint64_t>(ptr[3]) << 32)
+                | (static_cast<std::uint64_t>(ptr[4]) << 24) | (static_cast<std::uint64_t>(ptr[5]) << 16)
+                | (static_cast<std::uint64_t>(ptr[6]) << 8) | static_cast<std::uint64_t>(ptr[7]);
         }
 
-        bit_input::bit_input() {}
+        bit_input::bit_input()
+            : buffer(0)
+            , buffered(0)
+            , next(nullptr)
+            , remain(0) {
+        }
 
         bit_input::bit_input(const uint8_t *ptr, int len, int off) {
             set(ptr, len, off);
         }
 
         void bit_input::set(const uint8_t *ptr, int len, int off) {
-            uintptr_t p = (uintptr_t)ptr;
-
-            p += off >> 3; // nearest byte to the specified bit offset
-            off &= 7; // bit offset within the byte
-            uint32_t *nptr = (uint32_t *)(p & ~3); // word containing this byte
-            off += (p & 3) << 3; // bit offset within the word
+            next = ptr + (off >> 3);
+            off &= 7;
 
-            if (len == 0)
-                count = 0;
-            else {
-                // read the first few bits of the stream
-                bits = swap_bo(*nptr++) << off;
-                off = 32 - off;
-                len -= off;
+            buffer = 0;
+            buffered = 0;
+            remain = len;
 
-                if (len < 0)
-                    off += len;
+            if (off && (remain > 0)) {
+                // Start in the middle of the first byte
+                const int take = common::min(8 - off, len);
 
-                count = off;
+                buffer = static_cast<std::uint64_t>((*next++ << off) & 0xFF & (0xFF00 >> take)) << 56;
+                buffered = take;
+                remain -= take;
             }
-
-            remain = len;
-            buf_ptr = nptr;
         }
 
-        uint32_t bit_input::read() {
-            uint32_t tbits = bits;
-            int tcount = count;
+        void bit_input::refill() {
+            if (remain >= 64) {
+                // Load 8 bytes at once. Only whole bytes that fit are accounted, the bits of the rest
+                // are loaded again with the next refill.
+                buffer |= load_be64(next) >> buffered;
+
+                const int bytes = (63 - buffered) >> 3;
+
+                next += bytes;
+                remain -= bytes << 3;
+                buffered += bytes << 3;
 
-            if (--tcount < 0)
-                return read(1);
+                return;
+            }
 
-            count = tcount;
-            bits = tbits << 1;
+            while ((buffered <= 56) && (remain > 0)) {
+                const int take = static_cast<int>(common::min<std::int64_t>(remain, 8));
 
-            return tbits >> 31;
+                buffer |= static_cast<std::uint64_t>(*next++ & (0xFF00 >> take)) << (56 - buffered);
+                buffered += take;
+                remain -= take;
+            }
         }
 
-        uint32_t bit_input::read(int size) {
-            // Nothing to read
-            if (!size)
-                return 0;
+        uint32_t bit_input::peek(int size) {
+            if (buffered < size) {
+                refill();
+            }
 
-            uint32_t val = 0;
-            uint32_t tbits = bits;
+            return size ? static_cast<uint32_t>(buffer >> (64 - size)) : 0;
+        }
 
-            count -= size;
+        bool bit_input::consume(int size) {
+            if (size > buffered) {
+                LOG_ERROR("Bit input read underflow!");
 
-            while (count < 0) {
-                // Disable warning
-                if (count + size != 0)
-                    val |= tbits >> (32 - (count + size)) << (-count);
+                buffer = 0;
+                buffered = 0;
 
-                size = -count; // bits still required
+                return false;
+            }
 
-                // Things are still remain shit
-                if (remain > 0) {
-                    tbits = swap_bo(*buf_ptr++);
-                    count += 32;
-                    remain -= 32;
+            buffer <<= size;
+            buffered -= size;
 
-                    if (remain < 0)
-                        count += remain;
+            return true;
+        }
 
-                } else {
-                    LOG_ERROR("Bit input read underflow!");
-                    tbits = bits;
-                    count -= size;
+        uint32_t bit_input::read() {
+            return read(1);
+        }
 
-                    return 0;
-                }
+        uint32_t bit_input::read(int size) {
+            // Nothing to read
+            if (!size) {
+                return 0;
             }
 
-            bits = (size == 32) ? 0 : tbits << size;
-
-            return val | (tbits >> (32 - size));
+            const uint32_t val = peek(size);
+            return consume(size) ? val : 0;
         }
 
         uint32_t bit_input::huffman(const uint32_t *tree) {
@@ -640,6 +647,183 @@ namespace eka2l1 {
             return huff >> 17;
         }
 
+        // Entry of a huffman_table. Kind tells how the rest is laid out:
+        // - single: the symbol and its code length.
+        // - pair: two symbols, the first code length and the total length of both codes.
+        // - link: offset and index bits of the subtable the code continues in.
+        enum huffman_entry_kind {
+            HUFFMAN_ENTRY_INVALID = 0,
+            HUFFMAN_ENTRY_SINGLE = 1,
+            HUFFMAN_ENTRY_PAIR = 2,
+            HUFFMAN_ENTRY_LINK = 3
+        };
+
+        static constexpr std::uint32_t make_huffman_entry(const huffman_entry_kind kind, const std::uint32_t sym,
+            const std::uint32_t len, const std::uint32_t sym2 = 0, const std::uint32_t total_len = 0) {
+            return len | ((total_len ? total_len : len) << 5) | (static_cast<std::uint32_t>(kind) << 10) | (sym << 12) | (sym2 << 21);
+        }
+
+        static constexpr std::uint32_t make_huffman_link(const std::uint32_t offset, const std::uint32_t sub_bits) {
+            return sub_bits | (static_cast<std::uint32_t>(HUFFMAN_ENTRY_LINK) << 10) | (offset << 12);
+        }
+
+        static inline std::uint32_t huffman_entry_len(const std::uint32_t entry) {
+            return entry & 0x1F;
+        }
+
+        static inline std::uint32_t huffman_entry_total_len(const std::uint32_t entry) {
+            return (entry >> 5) & 0x1F;
+        }
+
+        static inline huffman_entry_kind huffman_entry_get_kind(const std::uint32_t entry) {
+            return static_cast<huffman_entry_kind>((entry >> 10) & 3);
+        }
+
+        static inline std::uint32_t huffman_entry_symbol(const std::uint32_t entry) {
+            return (entry >> 12) & 0x1FF;
+        }
+
+        static inline std::uint32_t huffman_entry_symbol2(const std::uint32_t entry) {
+            return (entry >> 21) & 0xFF;
+        }
+
+        static inline std::uint32_t huffman_entry_link_offset(const std::uint32_t entry) {
+            return entry >> 12;
+        }
+
+        bool huffman_table::build(const uint32_t *lengths, const int num_codes, const int pair_limit) {
+            std::array<std::uint32_t, HUFFMAN_MAX_CODELENGTH + 1> len_count{};
+            int used = 0;
+            int last_used = 0;
+
+            for (int i = 0; i < num_codes; i++) {
+                if (lengths[i] > HUFFMAN_MAX_CODELENGTH) {
+                    return false;
+                }
+
+                if (lengths[i]) {
+                    len_count[lengths[i]]++;
+                    used++;
+                    last_used = i;
+                }
+            }
+
+            entries.assign(1 << TABLE_BITS, make_huffman_entry(HUFFMAN_ENTRY_INVALID, 0, 0));
+
+            if (used == 0) {
+                return true;
+            }
+
+            if (used == 1) {
+                // A lone code decodes on both branches, to the same symbol
+                std::fill(entries.begin(), entries.end(), make_huffman_entry(HUFFMAN_ENTRY_SINGLE, last_used, 1));
+                return true;
+            }
+
+            // Same canonical order as the encoder: shorter codes first, then by symbol
+            std::array<std::uint32_t, HUFFMAN_MAX_CODELENGTH + 1> next_code{};
+            std::uint32_t code = 0;
+
+            for (int i = 1; i <= HUFFMAN_MAX_CODELENGTH; i++) {
+                code = (code + len_count[i - 1]) << 1;
+                next_code[i] = code;
+            }
+
+            std::vector<std::uint32_t> codes(num_codes);
+            std::array<std::uint32_t, 1 << TABLE_BITS> sub_bits{};
+
+            for (int i = 0; i < num_codes; i++) {
+                const std::uint32_t len = lengths[i];
+
+                if (!len) {
+                    continue;
+                }
+
+                codes[i] = next_code[len]++;
+
+                if (len > TABLE_BITS) {
+                    const std::uint32_t prefix = codes[i] >> (len - TABLE_BITS);
+                    sub_bits[prefix] = common::max<std::uint32_t>(sub_bits[prefix], len - TABLE_BITS);
+                }
+            }
+
+            // Lay the subtables after the main one
+            for (std::uint32_t prefix = 0; prefix < (1 << TABLE_BITS); prefix++) {
+                if (sub_bits[prefix]) {
+                    entries[prefix] = make_huffman_link(static_cast<std::uint32_t>(entries.size()), sub_bits[prefix]);
+                    entries.resize(entries.size() + (1ULL << sub_bits[prefix]), make_huffman_entry(HUFFMAN_ENTRY_INVALID, 0, 0));
+                }
+            }
+
+            for (int i = 0; i < num_codes; i++) {
+                const std::uint32_t len = lengths[i];
+
+                if (!len) {
+                    continue;
+                }
+
+                if (len <= TABLE_BITS) {
+                    const std::uint32_t first = codes[i] << (TABLE_BITS - len);
+                    std::fill(entries.begin() + first, entries.begin() + first + (1 << (TABLE_BITS - len)),
+                        make_huffman_entry(HUFFMAN_ENTRY_SINGLE, i, len));
+
+                    continue;
+                }
+
+                const std::uint32_t rest_len = len - TABLE_BITS;
+                const std::uint32_t link = entries[codes[i] >> rest_len];
+                const std::uint32_t link_bits = huffman_entry_len(link);
+                const std::uint32_t first = huffman_entry_link_offset(link) + ((codes[i] & ((1 << rest_len) - 1)) << (link_bits - rest_len));
+
+                std::fill(entries.begin() + first, entries.begin() + first + (1 << (link_bits - rest_len)),
+                    make_huffman_entry(HUFFMAN_ENTRY_SINGLE, i, rest_len));
+            }
+
+            if (pair_limit > 0) {
+                // The bits left in the index after a short code may already hold the whole next code
+                for (std::uint32_t i = 0; i < (1 << TABLE_BITS); i++) {
+                    const std::uint32_t entry = entries[i];
+
+                    if ((huffman_entry_get_kind(entry) != HUFFMAN_ENTRY_SINGLE) || (huffman_entry_symbol(entry) >= static_cast<std::uint32_t>(pair_limit))) {
+                        continue;
+                    }
+
+                    const std::uint32_t len = huffman_entry_len(entry);
+                    const std::uint32_t following = entries[(i << len) & ((1 << TABLE_BITS) - 1)];
+                    const huffman_entry_kind following_kind = huffman_entry_get_kind(following);
+
+                    if ((following_kind != HUFFMAN_ENTRY_SINGLE) && (following_kind != HUFFMAN_ENTRY_PAIR)) {
+                        continue;
+                    }
+
+                    const std::uint32_t following_len = huffman_entry_len(following);
+
+                    if ((huffman_entry_symbol(following) < static_cast<std::uint32_t>(pair_limit)) && (len + following_len <= TABLE_BITS)) {
+                        entries[i] = make_huffman_entry(HUFFMAN_ENTRY_PAIR, huffman_entry_symbol(entry), len,
+                            huffman_entry_symbol(following), len + following_len);
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        int huffman_table::decode(bit_input &input) const {
+            std::uint32_t entry = entries[input.peek(TABLE_BITS)];
+
+            if (huffman_entry_get_kind(entry) == HUFFMAN_ENTRY_LINK) {
+                input.consume(TABLE_BITS);
+                entry = entries[huffman_entry_link_offset(entry) + input.peek(huffman_entry_len(entry))];
+            }
+
+            if (huffman_entry_get_kind(entry) == HUFFMAN_ENTRY_INVALID) {
+                return -1;
+            }
+
+            input.consume(huffman_entry_len(entry));
+            return static_cast<int>(huffman_entry_symbol(entry));
+        }
+
         inflater::inflater(bit_input &input)
             : bits(&input) {
             out[0] = 5;
@@ -649,71 +833,134 @@ namespace eka2l1 {
             limit = out;
         }
 
+        void inflater::copy_history(uint8_t *&tout, uint8_t *end) {
+            int tfr = common::min(static_cast<int>(end - tout), static_cast<int>(len));
+            len -= tfr;
+
+            const uint8_t *from = rptr;
+
+            if ((from + tfr <= end) && ((from + tfr <= tout) || (from >= tout + tfr))) {
+                // Neither wraps nor overlaps what is being written
+                std::memcpy(tout, from, tfr);
+
+                tout += tfr;
+                from += tfr;
+
+                if (from == end) {
+                    from -= DEFLATE_MAX_DIST;
+                }
+            } else {
+                do {
+                    *tout++ = *from++;
+
+                    if (from == end)
+                        from -= DEFLATE_MAX_DIST;
+
+                } while (--tfr != 0);
+            }
+
+            rptr = from;
+        }
+
+        // Turn a length or distance code and its extra bits into the value
+        static inline int read_code_value(bit_input &input, int code) {
+            if (code >= 8) {
+                const int xtra = (code >> 2) - 1;
+                code -= xtra << 2;
+                code <<= xtra;
+                code |= input.read(xtra);
+            }
+
+            return code;
+        }
+
         int inflater::inflate() {
             uint8_t *tout = out;
             uint8_t *end = out + DEFLATE_MAX_DIST;
-            uint32_t *tree = encode.lit_len;
 
             if (len < 0) // Nothing more for you
                 return 0;
-            if (len > 0)
-                goto useHistory; // TODO: Lambda.
 
-            while (tout < end) {
-                {
-                    int val = bits->huffman(reinterpret_cast<uint32_t *>(tree)) - ENCODING_LITERALS;
+            if (len > 0) {
+                copy_history(tout, end);
+            }
 
-                    if (val < 0) {
-                        *tout++ = (uint8_t)val;
-                        continue; // Combo literal, please continue getting them
-                    }
+            const std::uint32_t *lit_len_entries = lit_len_table.data();
 
-                    if (val == ENCODING_EOS - ENCODING_LITERALS) {
-                        len -= 1;
-                        break;
+            while (tout < end) {
+                std::uint32_t entry = lit_len_entries[bits->peek(huffman_table::TABLE_BITS)];
+
+                switch (huffman_entry_get_kind(entry)) {
+                case HUFFMAN_ENTRY_PAIR:
+                    if (end - tout >= 2) {
+                        // Two literals at once
+                        tout[0] = static_cast<uint8_t>(huffman_entry_symbol(entry));
+                        tout[1] = static_cast<uint8_t>(huffman_entry_symbol2(entry));
+                        tout += 2;
+
+                        bits->consume(huffman_entry_total_len(entry));
+                        continue;
                     }
 
-                    // Get the extra bits for the code
-                    int code = val & 0xff;
+                    break;
 
-                    if (code >= 8) {
-                        int xtra = (code >> 2) - 1;
-                        code -= xtra << 2;
-                        code <<= xtra;
-                        code |= bits->read(xtra);
-                    }
+                case HUFFMAN_ENTRY_LINK:
+                    bits->consume(huffman_table::TABLE_BITS);
+                    entry = lit_len_entries[huffman_entry_link_offset(entry) + bits->peek(huffman_entry_len(entry))];
+
+                    if (huffman_entry_get_kind(entry) == HUFFMAN_ENTRY_INVALID) {
+                        LOG_ERROR("Inflate stream invalid!");
+                        len = -1;
 
-                    if (val < DEFLATE_DIST_CODE_BASE - ENCODING_LITERALS) {
-                        // Length code
-                        len = code + DEFLATE_MIN_LENGTH;
-                        tree = encode.dist;
-                        continue; // read the huffman code
+                        return static_cast<int>(tout - out);
                     }
 
-                    // distance code
-                    rptr = tout - (code + 1);
+                    break;
 
-                    if (rptr + DEFLATE_MAX_DIST < end) {
-                        rptr += DEFLATE_MAX_DIST;
-                    }
+                case HUFFMAN_ENTRY_INVALID:
+                    LOG_ERROR("Inflate stream invalid!");
+                    len = -1;
+
+                    return static_cast<int>(tout - out);
+
+                default:
+                    break;
                 }
-            // Digging things up from the cache: rptr
-            useHistory:
-                int tfr = common::min(static_cast<int>(end - tout), static_cast<int>(len));
-                len -= tfr;
 
-                const uint8_t *from = rptr;
-                do {
-                    *tout++ = *from++;
+                bits->consume(huffman_entry_len(entry));
 
-                    if (from == end)
-                        from -= DEFLATE_MAX_DIST;
+                const int val = static_cast<int>(huffman_entry_symbol(entry)) - ENCODING_LITERALS;
 
-                } while (--tfr != 0);
+                if (val < 0) {
+                    *tout++ = static_cast<uint8_t>(val);
+                    continue; // Combo literal, please continue getting them
+                }
 
-                rptr = from;
-                tree = encode.lit_len;
-            };
+                if (val == ENCODING_EOS - ENCODING_LITERALS) {
+                    len -= 1;
+                    break;
+                }
+
+                len = read_code_value(*bits, val) + DEFLATE_MIN_LENGTH;
+
+                // A length is always followed by its distance
+                const int dist_code = dist_table.decode(*bits);
+
+                if (dist_code < 0) {
+                    LOG_ERROR("Inflate stream invalid!");
+                    len = -1;
+
+                    break;
+                }
+
+                rptr = tout - (read_code_value(*bits, dist_code) + 1);
+
+                if (rptr < out) {
+                    rptr += DEFLATE_MAX_DIST;
+                }
+
+                copy_history(tout, end);
+            }
 
             return static_cast<int>(tout - out);
         }
@@ -730,8 +977,8 @@ namespace eka2l1 {
                 return;
             }
 
-            huffman::decoding(reinterpret_cast<int *>(encode.lit_len), ENCODING_LITERAL_LEN, reinterpret_cast<uint32_t *>(encode.lit_len));
-            huffman::decoding(reinterpret_cast<int *>(encode.dist), ENCODING_DISTS, reinterpret_cast<uint32_t *>(encode.dist), DEFLATE_DIST_CODE_BASE);
+            lit_len_table.build(encode.lit_len, ENCODING_LITERAL_LEN, ENCODING_LITERALS);
+            dist_table.build(encode.dist, ENCODING_DISTS);
         }
 
         int inflater::read(uint8_t *buf, size_t rlen) {
@@ -20,6 +20,18 @@ namespace eka2l1 {
             return h;
         }
 
+        std::uint64_t hash_fnv1a64(const void *data, const std::size_t size) {
+            const std::uint8_t *bytes = reinterpret_cast<const std::uint8_t *>(data);
+            std::uint64_t h = 0xCBF29CE484222325ULL;
+
+            for (std::size_t i = 0; i < size; i++) {
+                h ^= bytes[i];
+                h *= 0x100000001B3ULL;
+            }
+
+            return h;
+        }
+
         std::string normalize_for_hash(std::string org) {
             auto remove = [](std::string &inp, std::string to_remove) {
                 size_t pos = 0;
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <common/algorithm.h>
+#include <common/fileutils.h>
+#include <common/hash.h>
+#include <common/log.h>
+#include <common/pagededup.h>
+#include <common/path.h>
+#include <common/virtualmem.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#if defined(__linux__) && !defined(__ANDROID__)
+#define EKA2L1_PAGE_DEDUP 1
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define EKA2L1_PAGE_DEDUP 0
+#endif
+
+namespace eka2l1::common {
+    // The memory file grows by this many pages at a time
+    static constexpr std::size_t PAGE_DEDUP_SEGMENT_PAGES = 256;
+
+#if EKA2L1_PAGE_DEDUP
+    /**
+     * \brief Replace the pages at the target with a private mapping of a file.
+     *
+     * The mapping is made elsewhere first, then moved over the target, so that a failure
+     * leaves the target untouched.
+     */
+    static bool map_file_over(void *target, const std::size_t size, const int fd, const std::size_t offset,
+        const prot map_prot) {
+        void *temp = mmap(nullptr, size, translate_protection(map_prot), MAP_PRIVATE, fd, static_cast<off_t>(offset));
+
+        if (temp == MAP_FAILED) {
+            return false;
+        }
+
+        if (mremap(temp, size, size, MREMAP_MAYMOVE | MREMAP_FIXED, target) == MAP_FAILED) {
+            munmap(temp, size);
+            return false;
+        }
+
+        return true;
+    }
+#endif
+
+    page_dedup_pool::page_dedup_pool(const std::string &shared_dir)
+        : fd_(-1)
+        , page_size_(static_cast<std::size_t>(get_host_page_size()))
+        , total_pages_(0)
+        , shared_dir_(shared_dir)
+        , bytes_saved_(0) {
+#if EKA2L1_PAGE_DEDUP
+        fd_ = memfd_create("eka2l1-pages", MFD_CLOEXEC);
+
+        if (fd_ == -1) {
+            LOG_WARN("Unable to create the memory file for shared pages, pages will not be shared");
+            return;
+        }
+
+        if (!shared_dir_.empty() && !eka2l1::exists(shared_dir_)) {
+            eka2l1::create_directories(shared_dir_);
+        }
+#endif
+    }
+
+    page_dedup_pool::~page_dedup_pool() {
+#if EKA2L1_PAGE_DEDUP
+        // Pages mapped from the file stay valid after it's closed
+        for (std::uint8_t *segment : segments_) {
+            munmap(segment, PAGE_DEDUP_SEGMENT_PAGES * page_size_);
+        }
+
+        if (fd_ != -1) {
+            close(fd_);
+        }
+#endif
+    }
+
+    std::uint8_t *page_dedup_pool::get_page(const std::size_t index) {
+        return segments_[index / PAGE_DEDUP_SEGMENT_PAGES] + (index % PAGE_DEDUP_SEGMENT_PAGES) * page_size_;
+    }
+
+    bool page_dedup_pool::allocate_page(std::size_t &index) {
+#if EKA2L1_PAGE_DEDUP
+        if (total_pages_ == segments_.size() * PAGE_DEDUP_SEGMENT_PAGES) {
+            const std::size_t segment_size = PAGE_DEDUP_SEGMENT_PAGES * page_size_;
+            const std::size_t segment_offset = segments_.size() * segment_size;
+
+            if (ftruncate(fd_, static_cast<off_t>(segment_offset + segment_size)) == -1) {
+                return false;
+            }
+
+            void *segment = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                static_cast<off_t>(segment_offset));
+
+            if (segment == MAP_FAILED) {
+                return false;
+            }
+
+            segments_.push_back(reinterpret_cast<std::uint8_t *>(segment));
+        }
+
+        index = total_pages_++;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool page_dedup_pool::share_with_instances(std::uint8_t *ptr, const std::size_t size, const prot map_prot,
+        const std::uint64_t region_key) {
+#if EKA2L1_PAGE_DEDUP
+        const std::uint64_t content_hash = hash_fnv1a64(ptr, size);
+        const std::string region_path = eka2l1::add_path(shared_dir_, fmt::format("{:016X}-{:X}-{:X}.pages",
+                                                                          content_hash, region_key, size));
+
+        bool published = false;
+
+        if (common::file_size(region_path) != static_cast<std::int64_t>(size)) {
+            // Every emulator writes its own temporary file, then swaps it in whole
+            const std::string temp_path = fmt::format("{}.{}.tmp", region_path, getpid());
+
+            {
+                std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+                out.write(reinterpret_cast<const char *>(ptr), size);
+
+                if (!out) {
+                    out.close();
+                    common::remove(temp_path);
+
+                    return false;
+                }
+            }
+
+            if (!common::move_file(temp_path, region_path)) {
+                common::remove(temp_path);
+                return false;
+            }
+
+            published = true;
+        }
+
+        const int fd = open(region_path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd == -1) {
+            return false;
+        }
+
+        // Different content may share the same hash
+        void *view = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        bool mapped = false;
+
+        if (view != MAP_FAILED) {
+            mapped = (std::memcmp(view, ptr, size) == 0) && map_file_over(ptr, size, fd, 0, map_prot);
+            munmap(view, size);
+        }
+
+        close(fd);
+
+        if (mapped && !published) {
+            bytes_saved_ += size;
+        }
+
+        return mapped;
+#else
+        return false;
+#endif
+    }
+
+    std::size_t page_dedup_pool::share(void *ptr, const std::size_t size, const prot map_prot, const std::uint64_t region_key) {
+#if EKA2L1_PAGE_DEDUP
+        std::uint8_t *region = reinterpret_cast<std::uint8_t *>(ptr);
+        const std::size_t region_size = size - (size % page_size_);
+
+        if ((fd_ == -1) || (region_size == 0) || (reinterpret_cast<std::uintptr_t>(region) % page_size_)) {
+            return 0;
+        }
+
+        const std::size_t saved_before = bytes_saved_;
+
+        if (!shared_dir_.empty() && share_with_instances(region, region_size, map_prot, region_key)) {
+            return bytes_saved_ - saved_before;
+        }
+
+        for (std::size_t offset = 0; offset < region_size; offset += page_size_) {
+            std::uint8_t *page = region + offset;
+            const std::uint64_t page_hash = hash_fnv1a64(page, page_size_);
+
+            auto candidates = pages_.equal_range(page_hash);
+            auto same_page = std::find_if(candidates.first, candidates.second, [&](const std::pair<const std::uint64_t, std::size_t> &candidate) {
+                return std::memcmp(get_page(candidate.second), page, page_size_) == 0;
+            });
+
+            if (same_page != candidates.second) {
+                if (map_file_over(page, page_size_, fd_, same_page->second * page_size_, map_prot)) {
+                    bytes_saved_ += page_size_;
+                }
+
+                continue;
+            }
+
+            std::size_t index = 0;
+
+            if (!allocate_page(index)) {
+                break;
+            }
+
+            std::memcpy(get_page(index), page, page_size_);
+            pages_.emplace(page_hash, index);
+
+            // The pool now holds the only copy, so this costs nothing until another page matches it
+            map_file_over(page, page_size_, fd_, index * page_size_, map_prot);
+        }
+
+        return bytes_saved_ - saved_before;
+#else
+        return 0;
+#endif
+    }
+}
@@ -23,106 +23,72 @@
 #include <common/runlen.h>
 
 namespace eka2l1 {
-    void decompress_rle_24bit(const std::uint8_t *src, std::size_t &src_size,
-        std::uint8_t *dest, std::size_t &dest_size) {
-        const std::uint8_t *src_org = src;
-        const std::uint8_t *dest_org = dest;
-
-        const std::uint8_t *src_end = src + src_size;
-        const std::uint8_t *dest_end = dest + dest_size;
-
-        while (src < src_end && (dest_org ? dest < dest_end : true)) {
-            std::int32_t count = static_cast<std::int8_t>(*src++);
-
-            if (count >= 0) {
-                if (dest_org) {
-                    count = common::min(count, static_cast<std::int32_t>((dest_end - dest) / 3));
-                }
-
-                const std::uint8_t comp1 = *src++;
-                const std::uint8_t comp2 = *src++;
-                const std::uint8_t comp3 = *src++;
-
-                if (dest_org) {
-                    while (count >= 0) {
-                        *dest++ = comp1;
-                        *dest++ = comp2;
-                        *dest++ = comp3;
-
-                        count--;
-                    }
-                } else {
-                    dest += (count + 1) * 3;
-                }
-            } else {
-                std::uint32_t num_bytes_to_copy = count * -3;
-
-                if (dest_org) {
-                    num_bytes_to_copy = common::min(num_bytes_to_copy, static_cast<const std::uint32_t>(dest_end - dest));
-                    std::copy(src, src + num_bytes_to_copy, dest);
-                }
-
-                src += num_bytes_to_copy;
-                dest += num_bytes_to_copy;
+    std::size_t rle_common_prefix(const std::uint8_t *lhs, const std::uint8_t *rhs, const std::size_t max_size) {
+        std::size_t same = 0;
+
+        while (same + sizeof(std::uint64_t) <= max_size) {
+            std::uint64_t lhs_word = 0;
+            std::uint64_t rhs_word = 0;
+
+            std::memcpy(&lhs_word, lhs + same, sizeof(std::uint64_t));
+            std::memcpy(&rhs_word, rhs + same, sizeof(std::uint64_t));
+
+            const std::uint64_t diff = lhs_word ^ rhs_word;
+
+            if (diff) {
+                // Little endian, the first differing byte holds the lowest set bit
+                const std::uint32_t low = static_cast<std::uint32_t>(diff);
+                const int bit = low ? common::count_trailing_zero(low) : 32 + common::count_trailing_zero(static_cast<std::uint32_t>(diff >> 32));
+
+                return same + (bit >> 3);
             }
+
+            same += sizeof(std::uint64_t);
+        }
+
+        while ((same < max_size) && (lhs[same] == rhs[same])) {
+            same++;
         }
 
-        dest_size = dest - dest_org;
-        src_size = src - src_org;
+        return same;
     }
 
-    void decompress_rle_24bit_stream(common::ro_stream *stream, std::size_t &src_size, std::uint8_t *dest, std::size_t &dest_size) {
-        const std::uint8_t *dest_org = dest;
-        const std::uint8_t *dest_end = dest + dest_size;
-
-        const std::size_t src_org = src_size;
-        const std::size_t crr_pos = stream->tell();
-
-        while (stream->valid() && (dest_org ? dest < dest_end : true)) {
-            std::int8_t count8 = 0;
-            stream->read(&count8, 1);
-
-            std::int32_t count = count8;
-
-            if (count >= 0) {
-                if (dest_org) {
-                    count = common::min(count, static_cast<std::int32_t>((dest_end - dest) / 3));
-                }
-
-                std::uint8_t comp1 = 0;
-                std::uint8_t comp2 = 0;
-                std::uint8_t comp3 = 0;
-
-                stream->read(&comp1, 1);
-                stream->read(&comp2, 1);
-                stream->read(&comp3, 1);
-
-                if (dest_org) {
-                    while (count >= 0) {
-                        *dest++ = comp1;
-                        *dest++ = comp2;
-                        *dest++ = comp3;
-
-                        count--;
-                    }
-                } else {
-                    dest += (count + 1) * 3;
-                }
-            } else {
-                std::uint32_t num_bytes_to_copy = count * -3;
-
-                if (dest_org) {
-                    num_bytes_to_copy = common::min(num_bytes_to_copy, static_cast<const std::uint32_t>(dest_end - dest));
-                    stream->read(dest, num_bytes_to_copy);
-                } else {
-                    stream->seek(num_bytes_to_copy, common::seek_where::cur);
-                }
-
-                dest += num_bytes_to_copy;
-            }
+    void rle_fill_pixels(std::uint8_t *dest, const std::uint8_t *pixel, const std::size_t pixel_size, const std::size_t count) {
+        if (!count) {
+            return;
+        }
+
+        if (pixel_size == 1) {
+            std::memset(dest, pixel[0], count);
+            return;
         }
 
-        dest_size = dest - dest_org;
-        src_size = stream->tell() - crr_pos;
+        const std::size_t total = pixel_size * count;
+        std::size_t filled = pixel_size;
+
+        std::memcpy(dest, pixel, pixel_size);
+
+        // Double what is already written until the span is full
+        while (filled < total) {
+            const std::size_t copy = common::min(filled, total - filled);
+            std::memcpy(dest + filled, dest, copy);
+
+            filled += copy;
+        }
+    }
+
+    void decompress_rle_24bit(const std::uint8_t *src, std::size_t &src_size,
+        std::uint8_t *dest, std::size_t &dest_size) {
+        decompress_rle<24>(src, src_size, dest, dest_size);
+    }
+
+    void decompress_rle_24bit_stream(common::ro_stream *stream, std::size_t &src_size, std::uint8_t *dest, std::size_t &dest_size) {
+        const std::uint64_t crr_pos = stream->tell();
+
+        std::vector<std::uint8_t> source_data(static_cast<std::size_t>(stream->left()));
+        src_size = static_cast<std::size_t>(stream->read(source_data.data(), source_data.size()));
+
+        decompress_rle<24>(source_data.data(), src_size, dest, dest_size);
+        stream->seek(crr_pos + src_size, common::seek_where::beg);
     }
 }
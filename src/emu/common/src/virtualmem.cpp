@@ -176,7 +176,15 @@ namespace eka2l1::common {
         }
 
         if (is_private) {
+            // Writes stay in the copied pages, so the file itself only needs to be readable
+            desired_access = GENERIC_READ;
+            share_mode = FILE_SHARE_READ;
+            open_type = OPEN_EXISTING;
             map_type = FILE_MAP_COPY;
+
+            if (perm != prot::read) {
+                page_type = PAGE_WRITECOPY;
+            }
         }
 
         HANDLE file_handle = CreateFileA(file_name.c_str(), desired_access, share_mode,
@@ -227,6 +235,11 @@ namespace eka2l1::common {
         }
         }
 
+        if (is_private) {
+            // Pages written are copied, the rest are shared with other mappings through the page cache
+            open_mode = O_RDONLY;
+        }
+
         int file_handle = open(file_name.c_str(), open_mode, 0);
 
         if (file_handle == -1) {
@@ -235,7 +248,7 @@ namespace eka2l1::common {
 
         std::size_t map_size = size;
 
-        if (perm == prot::read || (perm == prot::read_write && size == 0)) {
+        if (map_size == 0) {
             struct stat file_stat;
             stat(file_name.c_str(), &file_stat);
 
@@ -243,14 +256,25 @@ namespace eka2l1::common {
         }
 
         auto map_ptr = mmap(nullptr, map_size, prot_mode, MAP_PRIVATE, file_handle, 0);
+
+        // The mapping keeps its own reference to the file
+        close(file_handle);
+
+        if (map_ptr == MAP_FAILED) {
+            return nullptr;
+        }
 #endif
 
         return map_ptr;
     }
 
-    bool unmap_file(void *ptr) {
+    bool unmap_file(void *ptr, const std::size_t size) {
 #if EKA2L1_PLATFORM(WIN32)
         UnmapViewOfFile(ptr);
+#else
+        if (size != 0) {
+            return (munmap(ptr, size) == 0);
+        }
 #endif
 
         return true;
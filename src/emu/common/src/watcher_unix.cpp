@@ -20,53 +20,89 @@
 #include "watcher_unix.h"
 #include <common/log.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+
+#include <poll.h>
 #include <sys/inotify.h>
 
 namespace eka2l1::common {
-    static constexpr std::size_t EVENT_MAX_SIZE = sizeof(struct inotify_event) + 16;
+    static constexpr std::size_t EVENT_MAX_SIZE = sizeof(struct inotify_event) + NAME_MAX + 1;
 
     directory_watcher_impl::directory_watcher_impl()
-        : should_stop(false) {
-        instance_ = inotify_init();
+        : stop_event_(-1)
+        , should_stop(false)
+        , handle_counter_(1) {
+        instance_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
 
         if (instance_ == -1) {
             LOG_ERROR("Error creating INotify instance!");
             return;
         }
 
+        stop_event_ = eventfd(0, EFD_CLOEXEC);
+
+        if (stop_event_ == -1) {
+            LOG_ERROR("Error creating stop event for INotify watcher!");
+            return;
+        }
+
         // 512 is maximum event count
         events_.resize(EVENT_MAX_SIZE * 512);
 
         wait_thread_ = std::make_unique<std::thread>([this]() {
             std::vector<directory_change> changes;
 
-            auto flush_changes = [&](const int wd) {
-                // Flush changes
-                auto ite = std::find(container_.begin(), container_.end(), wd);
+            struct pollfd fds[2];
+            fds[0].fd = instance_;
+            fds[0].events = POLLIN;
+            fds[1].fd = stop_event_;
+            fds[1].events = POLLIN;
 
-                if (ite != container_.end()) {
-                    auto &callback = callbacks_[std::distance(container_.begin(), ite)];
-                    callback.callback_pair_.first(callback.callback_pair_.second, changes);
+            while (!should_stop) {
+                if (poll(fds, 2, -1) == -1) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
 
-                    changes.clear();
+                    LOG_ERROR("Error waiting for notify event!");
+                    break;
+                }
+
+                if (should_stop || (fds[1].revents & POLLIN)) {
+                    break;
                 }
-            };
 
-            while (!should_stop) {
                 const ssize_t length = read(instance_, &events_[0], events_.size());
 
-                if (length == -1) {
-                    LOG_ERROR("Error reading notify event!");
-                    should_stop = true;
-                }
+                if (length <= 0) {
+                    if ((length == -1) && (errno != EAGAIN) && (errno != EINTR)) {
+                        LOG_ERROR("Error reading notify event!");
+                        break;
+                    }
 
-                std::size_t i = 0;
+                    continue;
+                }
 
+                ssize_t i = 0;
                 int last_wd = -1;
 
                 // Parse all event
                 while (i < length) {
                     struct inotify_event *evt = reinterpret_cast<struct inotify_event *>(&events_[i]);
+                    i += evt->len + sizeof(struct inotify_event);
+
+                    // Changes are delivered per watch, flush the previous watch's batch first
+                    if ((last_wd != -1) && (last_wd != evt->wd) && !changes.empty()) {
+                        dispatch(last_wd, changes);
+                    }
+
+                    last_wd = evt->wd;
+
+                    if (evt->mask & (IN_IGNORED | IN_Q_OVERFLOW)) {
+                        continue;
+                    }
 
                     directory_change change;
                     change.change_ = 0;
@@ -101,47 +137,83 @@ namespace eka2l1::common {
                     }
 
                     changes.push_back(change);
-
-                    if ((last_wd != -1) && (last_wd != evt->wd)) {
-                        flush_changes(evt->wd);
-                    }
-
-                    last_wd = evt->wd;
-                    i += evt->len + sizeof(struct inotify_event);
                 }
 
-                if (changes.size() != 0) {
-                    flush_changes(last_wd);
+                if (!changes.empty()) {
+                    dispatch(last_wd, changes);
                 }
             }
         });
     }
 
     directory_watcher_impl::~directory_watcher_impl() {
-        for (auto &wd : container_) {
-            inotify_rm_watch(instance_, wd);
+        should_stop = true;
+
+        if (wait_thread_) {
+            const std::uint64_t wake = 1;
+            [[maybe_unused]] const ssize_t written = write(stop_event_, &wake, sizeof(wake));
+
+            wait_thread_->join();
         }
 
-        should_stop = true;
-        wait_thread_->join();
+        if (instance_ != -1) {
+            // Descriptors shared by many watches fail to remove more than once, that's fine
+            for (auto &wd : container_) {
+                inotify_rm_watch(instance_, wd);
+            }
 
-        close(instance_);
+            close(instance_);
+        }
+
+        if (stop_event_ != -1) {
+            close(stop_event_);
+        }
+    }
+
+    void directory_watcher_impl::dispatch(const int wd, directory_changes &changes) {
+        std::vector<directory_watcher_callback_pair> callbacks;
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            for (std::size_t i = 0; i < container_.size(); i++) {
+                if (container_[i] == wd) {
+                    callbacks.push_back(callbacks_[i].callback_pair_);
+                }
+            }
+        }
+
+        // The callbacks may watch or unwatch, so they run unlocked
+        for (auto &callback : callbacks) {
+            callback.first(callback.second, changes);
+        }
+
+        changes.clear();
     }
 
     bool directory_watcher_impl::unwatch(const std::int32_t watch_handle) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
         // Find in container
-        auto ite = std::find(container_.begin(), container_.end(), watch_handle);
+        auto ite = std::find(handles_.begin(), handles_.end(), watch_handle);
 
-        if (ite == container_.end()) {
+        if (ite == handles_.end()) {
             return false;
         }
 
-        auto callback_ite = callbacks_.begin() + std::distance(container_.begin(), ite);
+        const std::size_t index = std::distance(handles_.begin(), ite);
+        const int wd = container_[index];
+
+        handles_.erase(ite);
+        callbacks_.erase(callbacks_.begin() + index);
+        container_.erase(container_.begin() + index);
 
-        callbacks_.erase(callback_ite);
-        container_.erase(ite);
+        // Other watches on the same folder still need the descriptor
+        if (std::find(container_.begin(), container_.end(), wd) != container_.end()) {
+            return true;
+        }
 
-        const bool remove_result = (inotify_rm_watch(instance_, watch_handle) != -1);
+        const bool remove_result = (inotify_rm_watch(instance_, wd) != -1);
 
         if (!remove_result) {
             LOG_WARN("Can not removing watch from inotify!");
@@ -174,16 +246,25 @@ namespace eka2l1::common {
 
     std::int32_t directory_watcher_impl::watch(const std::string &folder, directory_watcher_callback callback,
         void *callback_userdata, const std::uint32_t mask) {
-        const int wd_handle = inotify_add_watch(instance_, folder.c_str(), IN_CREATE | IN_DELETE | IN_MODIFY);
+        if (instance_ == -1) {
+            return 0;
+        }
+
+        const int filters = convert_to_unix_notify_mask(mask);
+        const int wd_handle = inotify_add_watch(instance_, folder.c_str(), IN_MASK_ADD | ((filters == 0) ? (IN_CREATE | IN_DELETE | IN_MODIFY) : filters));
 
         if (wd_handle == -1) {
             LOG_ERROR("Error creating new inotify watch!");
             return 0;
         }
 
+        const std::lock_guard<std::mutex> guard(lock_);
+        const std::int32_t handle = handle_counter_++;
+
         container_.push_back(wd_handle);
-        callbacks_.emplace_back(callback, callback_userdata, convert_to_unix_notify_mask(mask));
+        handles_.push_back(handle);
+        callbacks_.emplace_back(callback, callback_userdata, filters);
 
-        return wd_handle;
+        return handle;
     }
 }
\ No newline at end of file
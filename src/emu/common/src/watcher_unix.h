@@ -39,13 +39,18 @@ namespace eka2l1::common {
         std::vector<std::uint8_t> events_;
 
         int instance_;
+        int stop_event_; ///< Eventfd signalled to wake the wait thread up when stopping.
 
         std::atomic<bool> should_stop;
 
-        std::vector<int> container_;
+        std::vector<int> container_; ///< Inotify watch descriptor of each watch.
+        std::vector<std::int32_t> handles_; ///< Handle given out for each watch. Watches on one folder share a descriptor.
         std::vector<directory_watcher_data> callbacks_;
+        std::int32_t handle_counter_;
 
-        std::mutex lock_;
+        std::mutex lock_; ///< Guards the watch list. Not held while callbacks run.
+
+        void dispatch(const int wd, directory_changes &changes);
 
     public:
         explicit directory_watcher_impl();
@@ -21,6 +21,9 @@
 #include <common/algorithm.h>
 #include <common/wildcard.h>
 
+#include <cctype>
+#include <cwctype>
+
 namespace eka2l1::common {
     std::string wildcard_to_regex_string(std::string regexstr) {
         regexstr = replace_all(regexstr, "\\", "\\\\");
@@ -30,4 +33,68 @@ namespace eka2l1::common {
 
         return regexstr;
     }
+
+    static inline char fold_wildcard_char(const char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    static inline char16_t fold_wildcard_char(const char16_t c) {
+        return static_cast<char16_t>(std::towlower(c));
+    }
+
+    template <typename T>
+    static bool match_wildcard_impl(const T *str, const std::size_t str_len, const T *pattern,
+        const std::size_t pattern_len, const bool ignore_case) {
+        static constexpr std::size_t NO_STAR = static_cast<std::size_t>(-1);
+
+        std::size_t s = 0;
+        std::size_t p = 0;
+
+        // Position of the last star in the pattern, and where in the string it starts matching
+        std::size_t star_p = NO_STAR;
+        std::size_t star_s = 0;
+
+        while (s < str_len) {
+            if (p < pattern_len) {
+                const T pc = pattern[p];
+
+                if (pc == static_cast<T>('*')) {
+                    star_p = p++;
+                    star_s = s;
+
+                    continue;
+                }
+
+                if ((pc == static_cast<T>('?')) || (pc == str[s])
+                    || (ignore_case && (fold_wildcard_char(pc) == fold_wildcard_char(str[s])))) {
+                    s++;
+                    p++;
+
+                    continue;
+                }
+            }
+
+            if (star_p == NO_STAR) {
+                return false;
+            }
+
+            // Let the last star eat one more character and retry what follows it
+            p = star_p + 1;
+            s = ++star_s;
+        }
+
+        while ((p < pattern_len) && (pattern[p] == static_cast<T>('*'))) {
+            p++;
+        }
+
+        return p == pattern_len;
+    }
+
+    bool match_wildcard(const std::string &str, const std::string &pattern, const bool ignore_case) {
+        return match_wildcard_impl(str.data(), str.length(), pattern.data(), pattern.length(), ignore_case);
+    }
+
+    bool match_wildcard(const std::u16string &str, const std::u16string &pattern, const bool ignore_case) {
+        return match_wildcard_impl(str.data(), str.length(), pattern.data(), pattern.length(), ignore_case);
+    }
 }
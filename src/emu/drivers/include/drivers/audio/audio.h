@@ -19,13 +19,18 @@
 
 #pragma once
 
+#include <drivers/audio/mixer.h>
 #include <drivers/audio/stream.h>
 #include <drivers/driver.h>
 
 #include <cstdint>
+#include <memory>
 
 namespace eka2l1::drivers {
     class audio_driver : public driver {
+    protected:
+        std::unique_ptr<audio_mixer> mixer_;
+
     public:
         virtual ~audio_driver() {}
 
@@ -35,6 +40,8 @@ namespace eka2l1::drivers {
         /**
          * \brief Create a signed 16-bit LE audio output stream.
          * 
+         * All streams are mixed into one host stream, so any sample rate and channel count can be used.
+         * 
          * \param sample_rate       The target sample rate of output stream.
          * \param channels          The number of channels of the stream.
          * \param callback          The callback that the stream will use to retrive data.
@@ -44,14 +51,18 @@ namespace eka2l1::drivers {
          * \see     native_sample_rate
          */
         virtual std::unique_ptr<audio_output_stream> new_output_stream(const std::uint32_t sample_rate,
-            const std::uint8_t channels, data_callback callback)
-            = 0;
+            const std::uint8_t channels, data_callback callback);
 
         virtual std::uint32_t native_sample_rate() = 0;
+
+        audio_mixer *get_mixer() {
+            return mixer_.get();
+        }
     };
 
     enum class audio_driver_backend {
-        cubeb
+        cubeb,
+        null ///< Mix without any host output. Used for headless runs, tests and benchmarks.
     };
 
     std::unique_ptr<audio_driver> make_audio_driver(const audio_driver_backend backend);
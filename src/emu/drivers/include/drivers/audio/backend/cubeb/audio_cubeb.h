@@ -22,18 +22,21 @@
 #include <cubeb/cubeb.h>
 #include <drivers/audio/audio.h>
 
+#include <memory>
+
 namespace eka2l1::drivers {
     struct cubeb_audio_driver : public audio_driver {
     private:
         cubeb *context_;
         bool init_;
 
+        std::uint32_t native_rate_;
+        std::unique_ptr<audio_output_stream> host_stream_; ///< The only cubeb stream, fed by the mixer.
+
     public:
         explicit cubeb_audio_driver();
 
         ~cubeb_audio_driver() override;
-        std::unique_ptr<audio_output_stream> new_output_stream(const std::uint32_t sample_rate,
-            const std::uint8_t channels, data_callback callback) override;
         std::uint32_t native_sample_rate() override;
     };
 }
\ No newline at end of file
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <drivers/audio/backend/dsp_shared.h>
+#include <drivers/audio/backend/ffmpeg/resampler_ffmpeg.h>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -30,6 +31,11 @@ namespace eka2l1::drivers {
     protected:
         AVCodecContext *codec_;
 
+        // Reused for every buffer decoded
+        AVPacket *packet_;
+        AVFrame *frame_;
+        ffmpeg_resampler resampler_;
+
     public:
         explicit dsp_output_stream_ffmpeg(drivers::audio_driver *aud);
         ~dsp_output_stream_ffmpeg() override;
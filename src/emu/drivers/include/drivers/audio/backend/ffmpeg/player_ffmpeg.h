@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <drivers/audio/backend/ffmpeg/resampler_ffmpeg.h>
 #include <drivers/audio/backend/player_shared.h>
 
 extern "C" {
@@ -31,10 +32,13 @@ namespace eka2l1::drivers {
         AVCodecContext *codec_;
         AVFormatContext *format_;
         AVPacket packet_;
+        AVFrame *frame_;
+        ffmpeg_resampler resampler_;
 
         explicit player_ffmpeg_request()
             : codec_(nullptr)
-            , format_(nullptr) {
+            , format_(nullptr)
+            , frame_(nullptr) {
         }
 
         ~player_ffmpeg_request();
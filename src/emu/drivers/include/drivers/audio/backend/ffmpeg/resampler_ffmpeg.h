@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libswresample/swresample.h>
+}
+
+namespace eka2l1::drivers {
+    /**
+     * \brief Convert decoded frames to interleaved signed 16-bit PCM.
+     *
+     * The resample context is kept between frames, and only rebuilt when the format of the
+     * incoming frames or the requested output changes.
+     */
+    struct ffmpeg_resampler {
+    private:
+        SwrContext *context_;
+
+        std::int64_t in_layout_;
+        int in_format_;
+        int in_rate_;
+
+        std::int64_t out_layout_;
+        int out_rate_;
+
+        bool prepare(const AVFrame *frame, const std::int64_t in_layout, const std::int64_t out_layout,
+            const int out_rate);
+
+    public:
+        explicit ffmpeg_resampler();
+        ~ffmpeg_resampler();
+
+        /**
+         * \brief Convert a frame and append the result to the destination buffer.
+         *
+         * \param frame         The decoded frame.
+         * \param out_channels  Number of channels of the result, 1 or 2.
+         * \param out_rate      Sample rate of the result.
+         * \param dest          Buffer to append to. Its capacity is reused between calls.
+         *
+         * \returns False on failure, in which case the destination is left untouched.
+         */
+        bool convert(const AVFrame *frame, const std::uint8_t out_channels, const std::uint32_t out_rate,
+            std::vector<std::uint8_t> &dest);
+
+        void reset();
+    };
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <drivers/audio/audio.h>
+
+namespace eka2l1::drivers {
+    /**
+     * \brief Audio driver with no host output.
+     *
+     * Streams are still mixed, but only when someone calls mix on the mixer. This makes the driver
+     * useful for headless runs, tests and benchmarks.
+     */
+    struct null_audio_driver : public audio_driver {
+    public:
+        static constexpr std::uint32_t NULL_SAMPLE_RATE = 48000;
+
+        explicit null_audio_driver(const std::uint32_t sample_rate = NULL_SAMPLE_RATE);
+        ~null_audio_driver() override;
+
+        std::uint32_t native_sample_rate() override;
+    };
+}
@@ -19,12 +19,16 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <thread>
 #include <vector>
 
+#include <common/ringbuffer.h>
 #include <drivers/audio/common.h>
 #include <drivers/audio/player.h>
 #include <drivers/audio/stream.h>
@@ -62,6 +66,8 @@ namespace eka2l1::drivers {
     using player_request_instance = std::unique_ptr<player_request_base>;
 
     struct player_shared : public player {
+        static constexpr std::uint32_t DEFAULT_DECODE_AHEAD_MS = 200;
+
         audio_driver *aud_;
 
         std::unique_ptr<audio_output_stream> output_stream_;
@@ -70,6 +76,44 @@ namespace eka2l1::drivers {
 
         std::vector<player_metadata> metadatas_;
 
+        // Decoded stereo PCM of the playing request. The decode worker writes, the output stream reads.
+        common::spsc_ring_buffer<std::int16_t> pcm_ring_;
+        std::vector<std::int16_t> stereo_staging_;
+
+        std::thread decode_thread_;
+        std::mutex decode_wait_lock_;
+        std::condition_variable decode_cond_;
+        std::uint32_t decode_ahead_ms_;
+
+        std::atomic<bool> decoding_;
+        std::atomic<bool> decode_quit_;
+        std::atomic<bool> decode_wake_;
+        std::atomic<bool> end_of_stream_;
+        std::atomic<bool> notified_done_;
+        std::atomic<std::uint64_t> underruns_;
+
+        bool primed_; ///< Output got data at least once since play. Only touched by the output stream.
+
+        void decode_worker_loop();
+
+        /**
+         * \brief Move decoded data of the front request into the PCM ring, decoding more if needed.
+         *
+         * Must be called with the request queue lock held.
+         *
+         * \returns False when there is nothing more to decode, or the ring is full.
+         */
+        bool decode_ahead();
+
+    protected:
+        /**
+         * \brief Stop the decode worker.
+         *
+         * The worker calls into get_more_data, so backends must call this in their destructor,
+         * before they are torn down.
+         */
+        void stop_decode_worker();
+
     public:
         explicit player_shared(audio_driver *driver);
         ~player_shared() override;
@@ -85,5 +129,14 @@ namespace eka2l1::drivers {
         void clear_notify_done() override;
 
         void set_repeat(const std::int32_t repeat_times, const std::uint64_t silence_intervals_micros) override;
+
+        /**
+         * \brief Set how much audio the worker keeps decoded ahead of playback.
+         *
+         * Takes effect on the next play.
+         */
+        void set_decode_ahead_duration(const std::uint32_t milliseconds);
+
+        std::uint64_t underrun_count() const override;
     };
 }
\ No newline at end of file
@@ -51,6 +51,7 @@ namespace eka2l1::drivers {
 
     struct player_wmf : public player_shared {
         explicit player_wmf(audio_driver *driver);
+        ~player_wmf() override;
 
         void reset_request(player_request_instance &request) override;
         void get_more_data(player_request_instance &request) override;
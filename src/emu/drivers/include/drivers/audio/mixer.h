@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <drivers/audio/stream.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace eka2l1::drivers {
+    class audio_mixer;
+
+    /**
+     * \brief An output stream that gets mixed together with other streams into the host stream.
+     *
+     * The stream pulls data from its callback at its own sample rate and channel count. The mixer
+     * resamples it to the host rate and applies the volume and balance of the stream.
+     */
+    struct mixer_output_stream : public audio_output_stream {
+    private:
+        friend class audio_mixer;
+
+        audio_mixer *mixer_;
+        data_callback callback_;
+
+        std::uint32_t sample_rate_;
+        std::uint8_t channels_;
+        std::uint64_t step_; ///< Source frames advanced per output frame, in 32.32 fixed point.
+
+        std::atomic<bool> playing_;
+        std::atomic<float> volume_;
+        std::atomic<float> balance_;
+
+        // Only touched by the mixing thread.
+        std::vector<std::int16_t> pulled_; ///< Frames pulled but not consumed yet, starting with the current one.
+        std::vector<float> resampled_;
+        std::size_t buffered_; ///< Number of frames in pulled_.
+        std::uint64_t position_; ///< Position between the first two pulled frames, in 32.32 fixed point.
+
+    public:
+        explicit mixer_output_stream(audio_mixer *mixer, const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback);
+
+        ~mixer_output_stream() override;
+
+        bool start() override;
+        bool stop() override;
+
+        bool is_playing() override;
+
+        bool set_volume(const float volume) override;
+        bool set_balance(const float balance) override;
+    };
+
+    /**
+     * \brief Mix every output stream of an audio driver into one stereo, signed 16-bit stream.
+     *
+     * Streams are registered into fixed slots with atomic operations, so creating or destroying
+     * a stream never blocks on the mixing thread, even from inside another stream's callback.
+     */
+    class audio_mixer {
+    public:
+        static constexpr std::size_t MAX_STREAM_COUNT = 64;
+
+    private:
+        std::array<std::atomic<mixer_output_stream *>, MAX_STREAM_COUNT> streams_;
+        std::atomic<std::uint64_t> mix_serial_; ///< Odd while a mix pass is running.
+
+        std::uint32_t sample_rate_;
+        std::vector<float> accumulator_;
+
+        void mix_stream(mixer_output_stream *stream, const std::size_t frame_count);
+
+    public:
+        explicit audio_mixer(const std::uint32_t sample_rate);
+
+        /**
+         * \brief Create a new stream that will be mixed by this mixer.
+         *
+         * \returns Nullptr if all stream slots are taken.
+         */
+        std::unique_ptr<audio_output_stream> new_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback);
+
+        bool add_stream(mixer_output_stream *stream);
+        void remove_stream(mixer_output_stream *stream);
+
+        /**
+         * \brief Wait until the mix pass currently running, if any, has finished.
+         *
+         * Calling this from inside a stream callback returns immediately.
+         */
+        void wait_for_pass();
+
+        /**
+         * \brief Mix all playing streams into an interleaved stereo buffer.
+         *
+         * Only one thread may mix at a time. This is usually the host stream callback.
+         *
+         * \param output        Destination buffer, large enough for frame_count stereo frames.
+         * \param frame_count   The number of frames to mix.
+         *
+         * \returns The number of frames written, which is always frame_count.
+         */
+        std::size_t mix(std::int16_t *output, const std::size_t frame_count);
+
+        std::uint32_t sample_rate() const {
+            return sample_rate_;
+        }
+    };
+}
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -105,6 +106,13 @@ namespace eka2l1::drivers {
         }
 
         virtual void set_repeat(const std::int32_t repeat_times, const std::uint64_t silence_intervals_micros) = 0;
+
+        /**
+         * \brief Get how many times the output ran out of decoded data while playing.
+         */
+        virtual std::uint64_t underrun_count() const {
+            return 0;
+        }
     };
 
     enum player_type {
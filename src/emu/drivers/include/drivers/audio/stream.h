@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
 
 namespace eka2l1::drivers {
@@ -33,5 +34,12 @@ namespace eka2l1::drivers {
         virtual bool is_playing() = 0;
 
         virtual bool set_volume(const float volume) = 0;
+
+        /**
+         * \brief Pan the stream between the left and right channel.
+         *
+         * \param balance   -1.0 for left only, 0.0 for center and 1.0 for right only.
+         */
+        virtual bool set_balance(const float balance) = 0;
     };
 };
\ No newline at end of file
@@ -21,34 +21,108 @@
 #pragma once
 
 #include <common/queue.h>
+
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
 
 namespace eka2l1::drivers {
-    static constexpr std::uint32_t MAX_COMMAND_DATA_SIZE = 80;
+    static constexpr std::size_t COMMAND_ARENA_BLOCK_SIZE = 0x10000;
+    static constexpr std::size_t COMMAND_ARENA_ALIGNMENT = alignof(std::max_align_t);
+    static constexpr std::size_t MAX_POOLED_COMMAND_ARENA = 16;
+
+    /**
+     * \brief A bump-pointer allocator backing command lists.
+     *
+     * Memory is carved out of big blocks and never freed individually. The whole arena is rewinded
+     * once the commands it holds have been consumed by the driver, keeping blocks for the next frame.
+     */
+    class command_arena {
+        struct block {
+            std::unique_ptr<std::uint8_t[]> data_;
+            std::size_t size_;
+        };
+
+        std::vector<block> blocks_;
+        std::size_t current_;
+        std::size_t offset_;
+
+    public:
+        explicit command_arena();
+
+        /**
+         * \brief Allocate memory from the arena.
+         *
+         * The memory stays valid until the arena is reset.
+         *
+         * \param size       Size of the memory to allocate.
+         * \param alignment  Alignment of the returned pointer. Must be power of two.
+         *
+         * \returns Pointer to the allocated memory.
+         */
+        void *allocate(const std::size_t size, const std::size_t alignment = COMMAND_ARENA_ALIGNMENT);
+
+        /**
+         * \brief Copy data to memory owned by the arena.
+         */
+        void *copy(const void *source, const std::size_t size);
+
+        /**
+         * \brief Rewind the arena. All allocated memory is invalidated, blocks are kept.
+         */
+        void reset();
+
+        /**
+         * \brief Get total bytes that this arena reserves from the host.
+         */
+        std::size_t capacity() const;
+    };
+
+    /**
+     * \brief Recycle command arenas between frames.
+     *
+     * Clients acquire an arena when they start recording, and the driver releases it back after
+     * dispatching all commands inside it. This is safe to access from multiple threads.
+     */
+    class command_arena_pool {
+        std::mutex lock_;
+        std::vector<std::unique_ptr<command_arena>> free_;
+
+    public:
+        command_arena *acquire();
+        void release(command_arena *arena);
+    };
+
+    using command_arena_pool_ptr = std::shared_ptr<command_arena_pool>;
 
     /**
      * \brief Represent a command for driver.
+     *
+     * The argument data of the command is packed right after this header.
      */
     struct command {
         std::uint16_t opcode_;
-        std::uint8_t data_[MAX_COMMAND_DATA_SIZE];
+        std::uint16_t size_;
 
         command *next_;
         int *status_;
 
-        explicit command()
-            : opcode_(0)
-            , data_()
-            , next_(nullptr)
-            , status_(nullptr) {
-        }
-
-        explicit command(const std::uint16_t opcode, int *status = nullptr)
+        explicit command(const std::uint16_t opcode, int *status = nullptr, const std::uint16_t size = 0)
             : opcode_(opcode)
-            , data_()
+            , size_(size)
             , next_(nullptr)
             , status_(status) {
         }
+
+        std::uint8_t *data() {
+            return reinterpret_cast<std::uint8_t *>(this + 1);
+        }
     };
 
     struct command_helper {
@@ -61,24 +135,24 @@ namespace eka2l1::drivers {
         }
 
         bool push(const std::uint8_t *data, const std::uint16_t data_size) {
-            if (cursor_ + data_size > MAX_COMMAND_DATA_SIZE) {
+            if (cursor_ + data_size > todo_->size_) {
                 // Data full, abort
                 return false;
             }
 
-            std::copy(data, data + data_size, todo_->data_ + cursor_);
+            std::memcpy(todo_->data() + cursor_, data, data_size);
             cursor_ += data_size;
 
             return true;
         }
 
         bool pop(std::uint8_t *dest, const std::uint16_t dest_size) {
-            if (cursor_ + dest_size > MAX_COMMAND_DATA_SIZE) {
+            if (cursor_ + dest_size > todo_->size_) {
                 // Not possible to pop, abort
                 return false;
             }
 
-            std::copy(todo_->data_ + cursor_, todo_->data_ + cursor_ + dest_size, dest);
+            std::memcpy(dest, todo_->data() + cursor_, dest_size);
 
             cursor_ += dest_size;
             return true;
@@ -99,43 +173,6 @@ namespace eka2l1::drivers {
             *todo_->status_ = code;
             drv->cond_.notify_all();
         }
-
-        bool push_string(const std::u16string &data) {
-            // Alloc memory for the string
-            std::uint16_t length = static_cast<std::uint16_t>(data.length());
-
-            if (!push(length)) {
-                return false;
-            }
-
-            char16_t *dat = new char16_t[length];
-            std::copy(data.data(), data.data() + length, dat);
-
-            if (!push(dat)) {
-                return false;
-            }
-
-            return true;
-        }
-
-        bool pop_string(std::u16string &dat) {
-            std::uint16_t length = 0;
-            if (!pop(length)) {
-                return false;
-            }
-
-            dat.resize(length);
-            char16_t *ptr = nullptr;
-
-            if (!pop(ptr)) {
-                return false;
-            }
-
-            std::copy(ptr, ptr + length, &dat[0]);
-            delete ptr;
-
-            return true;
-        }
     };
 
     template <typename Head, typename... Args>
@@ -147,26 +184,45 @@ namespace eka2l1::drivers {
         }
     }
 
-    template <typename... Args>
-    command *make_command(const std::uint16_t opcode, int *status, Args... arguments) {
-        command *cmd = new command(opcode, status);
-        command_helper helper(cmd);
-
-        if constexpr (sizeof...(Args) > 0)
-            push_arguments(helper, arguments...);
-
-        return cmd;
-    }
-
     /**
-     * \brief A linked list of command.
+     * \brief A linked list of command, allocated from an arena.
+     *
+     * The list does not own the arena by itself. Whoever consumes the list last should call release(),
+     * so that the arena is returned to its pool.
      */
     struct command_list {
         command *first_;
         command *last_;
 
-        explicit command_list()
-            : first_(nullptr) {
+        command_arena *arena_;
+        command_arena_pool_ptr pool_;
+
+        explicit command_list(command_arena_pool_ptr pool = nullptr)
+            : first_(nullptr)
+            , last_(nullptr)
+            , arena_(nullptr)
+            , pool_(pool) {
+        }
+
+        void *allocate(const std::size_t size) {
+            if (!arena_) {
+                arena_ = pool_->acquire();
+            }
+
+            return arena_->allocate(size);
+        }
+
+        /**
+         * \brief Copy a payload into the list's arena.
+         *
+         * The copied data lives as long as the commands of this list.
+         */
+        void *copy_data(const void *source, const std::size_t size) {
+            if (!arena_) {
+                arena_ = pool_->acquire();
+            }
+
+            return arena_->copy(source, size);
         }
 
         void add(command *cmd_) {
@@ -180,8 +236,54 @@ namespace eka2l1::drivers {
             last_->next_ = cmd_;
             last_ = cmd_;
         }
+
+        /**
+         * \brief Take all the commands out of this list.
+         *
+         * The list becomes empty and can continue to record new commands.
+         *
+         * \returns A list contains all commands recorded so far.
+         */
+        command_list detach() {
+            command_list result = *this;
+
+            first_ = nullptr;
+            last_ = nullptr;
+            arena_ = nullptr;
+
+            return result;
+        }
+
+        /**
+         * \brief Return the arena to the pool. All commands in this list are invalidated.
+         */
+        void release() {
+            if (arena_ && pool_) {
+                pool_->release(arena_);
+            }
+
+            first_ = nullptr;
+            last_ = nullptr;
+            arena_ = nullptr;
+        }
     };
 
+    template <typename... Args>
+    command *make_command(command_list &list, const std::uint16_t opcode, int *status, Args... arguments) {
+        constexpr std::size_t data_size = (sizeof(Args) + ... + 0);
+        static_assert(data_size <= 0xFFFF, "Command arguments are too large!");
+
+        command *cmd = new (list.allocate(sizeof(command) + data_size)) command(opcode, status,
+            static_cast<std::uint16_t>(data_size));
+
+        if constexpr (sizeof...(Args) > 0) {
+            command_helper helper(cmd);
+            push_arguments(helper, arguments...);
+        }
+
+        return cmd;
+    }
+
     class driver {
     public:
         std::mutex mut_;
@@ -53,7 +53,14 @@ namespace eka2l1::drivers {
         std::vector<graphics_object_instance> graphic_objects;
 
         bitmap *binding;
-        bitmap *get_bitmap(const drivers::handle h);
+        bitmap *get_bitmap(drivers::handle h);
+
+        // Map client-reserved handles to real object handles, indexed by reserved slot
+        std::vector<drivers::handle> handle_remap;
+
+        drivers::handle resolve_handle(const drivers::handle h) const;
+        void bind_reserved_handle(const drivers::handle reserved, const drivers::handle real);
+        void unbind_reserved_handle(const drivers::handle reserved);
 
         int current_fb_height;
         eka2l1::vec2 swapchain_size;
@@ -61,9 +68,12 @@ namespace eka2l1::drivers {
         glm::mat4 projection_matrix;
         eka2l1::vecx<float, 4> brush_color;
 
+        // Recycled memory for command lists, shared with clients recording them
+        command_arena_pool_ptr arena_pool;
+
         drivers::handle append_graphics_object(graphics_object_instance &instance);
-        bool delete_graphics_object(const drivers::handle handle);
-        graphics_object *get_graphics_object(const drivers::handle num);
+        bool delete_graphics_object(drivers::handle handle);
+        graphics_object *get_graphics_object(drivers::handle num);
 
         // Implementations
         void set_swapchain_size(command_helper &helper);
@@ -29,6 +29,7 @@
 
 #include <memory>
 #include <queue>
+#include <vector>
 
 namespace eka2l1::drivers {
     struct ogl_state {
@@ -51,7 +52,7 @@ namespace eka2l1::drivers {
     };
 
     class ogl_graphics_driver : public shared_graphics_driver {
-        eka2l1::request_queue<server_graphics_command_list> list_queue;
+        eka2l1::request_queue<command_list> list_queue;
         std::unique_ptr<ogl_shader> sprite_program;
         std::unique_ptr<ogl_shader> fill_program;
         std::unique_ptr<ogl_shader> mask_program;
@@ -60,6 +61,10 @@ namespace eka2l1::drivers {
         GLuint sprite_vbo;
         GLuint sprite_ibo;
 
+        GLuint batch_ibo;
+        std::size_t batch_ibo_quad_count;
+        std::vector<GLfloat> batch_verts;
+
         GLuint fill_vao;
         GLuint fill_vbo;
 
@@ -85,6 +90,7 @@ namespace eka2l1::drivers {
 
         void clear(command_helper &helper);
         void draw_bitmap(command_helper &helper);
+        void draw_bitmap_batch(command_helper &helper);
         void draw_rectangle(command_helper &helper);
         void set_invalidate(command_helper &helper);
         void invalidate_rect(command_helper &helper);
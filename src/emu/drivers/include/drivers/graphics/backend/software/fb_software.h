@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/backend/software/texture_software.h>
+#include <drivers/graphics/fb.h>
+
+namespace eka2l1::drivers {
+    /**
+     * \brief Framebuffer of the software rasterizer. The rasterizer draws directly into the color texture.
+     */
+    class software_framebuffer : public framebuffer {
+    public:
+        explicit software_framebuffer(texture *color_buffer, texture *depth_buffer)
+            : framebuffer(color_buffer, depth_buffer) {
+        }
+
+        ~software_framebuffer() override {}
+
+        void bind(graphics_driver *driver) override {}
+        void unbind(graphics_driver *driver) override {}
+
+        software_texture *get_color_buffer() {
+            return reinterpret_cast<software_texture *>(color_buffer);
+        }
+
+        std::uint64_t texture_handle() override {
+            return color_buffer->texture_handle();
+        }
+    };
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/backend/graphics_driver_shared.h>
+#include <drivers/graphics/backend/software/raster_software.h>
+#include <drivers/graphics/backend/software/texture_software.h>
+
+#include <common/queue.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace eka2l1::drivers {
+    enum software_draw_op_kind {
+        software_draw_op_clear,
+        software_draw_op_fill,
+        software_draw_op_blit
+    };
+
+    /**
+     * \brief A draw waiting to be rasterized. Everything it needs is captured when recorded.
+     */
+    struct software_draw_op {
+        software_draw_op_kind kind;
+
+        eka2l1::rect dest; ///< Destination on the render target, unclipped.
+        eka2l1::rect clip; ///< Pixels that can be touched, already inside the render target.
+
+        std::uint32_t color;
+        bool invert_mask;
+
+        const std::uint32_t *source;
+        eka2l1::vec2 source_size;
+        eka2l1::rect source_rect;
+
+        const std::uint32_t *mask;
+        eka2l1::vec2 mask_size;
+
+        software_blend_state blend;
+    };
+
+    struct software_state {
+        software_blend_state blend;
+        bool scissor_enable = false;
+        eka2l1::rect scissor;
+        eka2l1::rect viewport;
+    };
+
+    /**
+     * \brief Graphics driver rasterizing on the CPU, without any window or GPU.
+     *
+     * Draws are recorded per render target and rasterized in horizontal bands, spread over a pool of threads,
+     * once something needs the result (a bind, an upload, a present...).
+     *
+     * Only the 2D command set is supported. Shader programs and buffers do not exist here.
+     */
+    class software_graphics_driver : public shared_graphics_driver {
+        eka2l1::request_queue<command_list> list_queue;
+        std::atomic_bool should_stop;
+
+        std::unique_ptr<software_texture> swapchain_tex;
+        eka2l1::vec2 projection_size;
+
+        software_state state;
+        software_state backup;
+
+        std::vector<software_draw_op> pending_ops;
+        std::vector<std::uint32_t> self_copy;
+
+        std::unique_ptr<software_raster_pool> raster_pool;
+
+        std::mutex present_lock;
+        std::vector<std::uint32_t> presented_frame;
+        eka2l1::vec2 presented_size;
+        std::uint32_t presented_count;
+
+        software_texture *get_render_target();
+        software_texture *get_sample_texture(drivers::handle h);
+
+        bool get_clip_rect(const eka2l1::rect &dest, eka2l1::rect &clip);
+        eka2l1::rect map_to_viewport(const eka2l1::rect &r) const;
+
+        void flush();
+        void rasterize_band(software_texture *target, const int band_start, const int band_end);
+        void record_blit(software_texture *source, software_texture *mask, eka2l1::rect dest_rect, eka2l1::rect source_rect,
+            const std::uint32_t flags);
+
+        void clear(command_helper &helper);
+        void draw_bitmap(command_helper &helper);
+        void draw_bitmap_batch(command_helper &helper);
+        void draw_rectangle(command_helper &helper);
+        void set_invalidate(command_helper &helper);
+        void invalidate_rect(command_helper &helper);
+        void set_viewport(command_helper &helper);
+        void set_blend(command_helper &helper);
+        void blend_formula(command_helper &helper);
+        void set_swapchain_size(command_helper &helper);
+        void bind_bitmap(command_helper &helper);
+        void display(command_helper &helper);
+        void create_program_unsupported(command_helper &helper);
+        void create_buffer_unsupported(command_helper &helper);
+
+    public:
+        /**
+         * \brief Create the software driver.
+         *
+         * \param worker_count    Number of rasterizer threads besides the driver thread. Negative to pick
+         *                        from the number of host cores.
+         */
+        explicit software_graphics_driver(const int worker_count = -1);
+        ~software_graphics_driver() override;
+
+        void set_viewport(const eka2l1::rect &viewport) override;
+
+        void attach_descriptors(drivers::handle h, const int stride, const bool instance_move, const attribute_descriptor *descriptors,
+            const int descriptor_count) override;
+
+        std::unique_ptr<graphics_command_list> new_command_list() override;
+        void submit_command_list(graphics_command_list &command_list) override;
+        std::unique_ptr<graphics_command_list_builder> new_command_builder(graphics_command_list *list) override;
+
+        void run() override;
+        void abort() override;
+        void dispatch(command *cmd) override;
+        void bind_swapchain_framebuf() override;
+
+        /**
+         * \brief Copy the last presented frame out. Safe to call from any thread.
+         *
+         * Pixels are RGBA8, red in the lowest byte, rows going from top to bottom.
+         *
+         * \param pixels    Vector to receive the pixels.
+         * \param size      Receive the size of the frame.
+         *
+         * \returns Number of frames presented so far, 0 if nothing has been presented yet.
+         */
+        std::uint32_t dump_presented_frame(std::vector<std::uint32_t> &pixels, eka2l1::vec2 &size);
+    };
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/common.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eka2l1::drivers {
+    /**
+     * \brief Blend state of the software rasterizer, mirrors GL's separate blend function.
+     */
+    struct software_blend_state {
+        bool enable = false;
+
+        blend_equation rgb_equation = blend_equation::add;
+        blend_equation a_equation = blend_equation::add;
+
+        blend_factor rgb_frag_out_factor = blend_factor::one;
+        blend_factor rgb_current_factor = blend_factor::zero;
+        blend_factor a_frag_out_factor = blend_factor::one;
+        blend_factor a_current_factor = blend_factor::zero;
+    };
+
+    /**
+     * \brief Shade a span of pixels and merge them into the destination.
+     *
+     * The fragment color is the source texel multiplied by the color, or the color alone if there is no source.
+     * If there is a mask, the fragment is then multiplied by the mask texel, or its inverse. This is the same
+     * thing the sprite, mask and fill shaders of the GL backend do.
+     *
+     * All pixels are RGBA8 with red in the lowest byte.
+     *
+     * \param dest       Pixels to write to.
+     * \param source     Source texels, can be null.
+     * \param mask       Mask texels, can be null.
+     * \param count      Number of pixels in the span.
+     * \param color      Color to multiply with.
+     * \param invert     True to invert the mask.
+     * \param blend      The blend state.
+     */
+    void software_shade_span(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t *mask, const int count,
+        const std::uint32_t color, const bool invert, const software_blend_state &blend);
+
+    /**
+     * \brief Fill a span of pixels with a color, without blending.
+     */
+    void software_fill_span(std::uint32_t *dest, const int count, const std::uint32_t color);
+
+    /**
+     * \brief Pool of threads that rasterize bands of a render target in parallel.
+     *
+     * The thread calling run() also takes tasks, so a pool with no worker rasterizes on the caller only.
+     */
+    class software_raster_pool {
+        std::vector<std::thread> workers_;
+
+        std::mutex lock_;
+        std::condition_variable job_cond_;
+        std::condition_variable done_cond_;
+
+        std::function<void(const int)> job_;
+        std::atomic<int> next_task_;
+        int total_task_;
+        int busy_worker_;
+        std::uint32_t generation_;
+        bool stopping_;
+
+        void take_tasks();
+        void worker_loop();
+
+    public:
+        explicit software_raster_pool(const int worker_count);
+        ~software_raster_pool();
+
+        /**
+         * \brief Run a job over a number of tasks and wait for all of them to be done.
+         *
+         * \param task_count    Number of tasks.
+         * \param job           Function to run, receives the task index.
+         */
+        void run(const int task_count, std::function<void(const int)> job);
+
+        std::size_t worker_count() const {
+            return workers_.size();
+        }
+    };
+}
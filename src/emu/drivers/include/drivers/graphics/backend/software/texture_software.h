@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/texture.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace eka2l1::drivers {
+    /**
+     * \brief Texture living in host memory, used by the software rasterizer.
+     *
+     * Every format is expanded to RGBA8 on upload. A pixel is stored as a 32-bit word with the red
+     * channel in the lowest byte. Channel swizzle is only applied when the texture is sampled, same as GL.
+     */
+    class software_texture : public texture {
+        int dimensions{ 0 };
+        int mip_level{ 0 };
+
+        vec3 tex_size;
+        texture_format internal_format{ texture_format::none };
+        texture_format format{ texture_format::none };
+        texture_data_type tex_data_type{ texture_data_type::ubyte };
+
+        void *tex_data{ nullptr };
+
+        std::vector<std::uint32_t> pixels;
+        int stored_width{ 0 };
+        int stored_rows{ 0 };
+
+        std::vector<std::uint32_t> swizzled;
+
+        channel_swizzles swizzle;
+        bool swizzle_dirty{ false };
+
+        bool has_identity_swizzle() const;
+
+    public:
+        software_texture();
+        ~software_texture() override {}
+
+        bool tex(graphics_driver *driver, const bool is_first = false) override;
+
+        bool create(graphics_driver *driver, const int dim, const int miplvl, const vec3 &size, const texture_format internal_format,
+            const texture_format format, const texture_data_type data_type, void *data) override;
+
+        void change_size(const vec3 &new_size) override;
+        void change_data(const texture_data_type data_type, void *data) override;
+        void change_texture_format(const texture_format format) override;
+
+        void set_filter_minmag(const bool min, const filter_option op) override {}
+        void set_channel_swizzle(channel_swizzles swizz) override;
+
+        void bind(graphics_driver *driver, const int binding) override {}
+        void unbind(graphics_driver *driver) override {}
+
+        void update_data(graphics_driver *driver, const int mip_lvl, const vec3 &offset, const vec3 &size, const texture_format data_format,
+            const texture_data_type data_type, const void *data) override;
+
+        /**
+         * \brief Get pixels to sample from, with channel swizzle applied.
+         */
+        const std::uint32_t *get_sample_pixels();
+
+        /**
+         * \brief Get pixels to render to.
+         *
+         * Caller must call mark_dirty() after writing to it.
+         */
+        std::uint32_t *get_render_pixels() {
+            return pixels.data();
+        }
+
+        void mark_dirty() {
+            swizzle_dirty = true;
+        }
+
+        vec2 get_size() const override {
+            return { tex_size.x, tex_size.y };
+        }
+
+        texture_format get_format() const override {
+            return internal_format;
+        }
+
+        texture_data_type get_data_type() const override {
+            return tex_data_type;
+        }
+
+        int get_mip_level() const override {
+            return mip_level;
+        }
+
+        int get_total_dimensions() const override {
+            return dimensions;
+        }
+
+        void *get_data_ptr() const override {
+            return tex_data;
+        }
+
+        std::uint64_t texture_handle() override {
+            return reinterpret_cast<std::uint64_t>(this);
+        }
+    };
+}
@@ -24,6 +24,7 @@
 
 #include <drivers/driver.h>
 #include <drivers/graphics/common.h>
+#include <drivers/graphics/handle.h>
 #include <drivers/itc.h>
 
 #include <functional>
@@ -52,6 +53,7 @@ namespace eka2l1::drivers {
         graphics_driver_draw_bitmap,
         graphics_driver_draw_rectangle,
         graphics_driver_resize_bitmap,
+        graphics_driver_draw_bitmap_batch,
 
         // Mode 1: Advance - Lower access to functions
         graphics_driver_create_program,
@@ -80,6 +82,7 @@ namespace eka2l1::drivers {
 
     protected:
         display_hook disp_hook_;
+        reserved_handle_allocator handle_allocator_;
 
     public:
         explicit graphics_driver(graphic_api api)
@@ -106,6 +109,19 @@ namespace eka2l1::drivers {
             disp_hook_ = hook;
         }
 
+        /**
+         * \brief Reserve an object handle on the client side.
+         *
+         * The handle can be used in commands right away. The driver will bind it to the real object
+         * once the creation command that carries it is executed.
+         *
+         * \param is_bitmap    True if the handle is for a bitmap.
+         * \returns The reserved handle, or 0 if no more handle can be reserved.
+         */
+        drivers::handle reserve_handle(const bool is_bitmap) {
+            return handle_allocator_.reserve(is_bitmap);
+        }
+
         virtual void update_bitmap(drivers::handle h, const std::size_t size, const eka2l1::vec2 &offset,
             const eka2l1::vec2 &dim, const int bpp, const void *data)
             = 0;
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/common.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace eka2l1::drivers {
+    static constexpr drivers::handle HANDLE_BITMAP = 1ULL << 32;
+    static constexpr drivers::handle HANDLE_RESERVED = 1ULL << 33;
+    static constexpr std::uint32_t MAX_RESERVED_HANDLE = 1 << 16;
+
+    /**
+     * \brief Lock-free allocator for handles reserved on client side.
+     *
+     * A client reserves an handle before the object is created by the driver, so that the creation
+     * command can be queued like any other command. The driver later maps the reserved handle to the
+     * real object handle when it executes the creation.
+     */
+    class reserved_handle_allocator {
+        std::unique_ptr<std::atomic<std::uint32_t>[]> words_;
+        std::atomic<std::uint32_t> hint_;
+
+    public:
+        explicit reserved_handle_allocator();
+
+        /**
+         * \brief Reserve a new handle.
+         *
+         * \param is_bitmap     True if the handle will be used for a bitmap.
+         * \returns The reserved handle, 0 if there is no more free slot.
+         */
+        drivers::handle reserve(const bool is_bitmap);
+
+        /**
+         * \brief Return a reserved handle so that it can be used again.
+         */
+        void free(const drivers::handle h);
+    };
+
+    inline bool is_handle_reserved(const drivers::handle h) {
+        return h & HANDLE_RESERVED;
+    }
+
+    inline std::uint32_t get_reserved_handle_index(const drivers::handle h) {
+        return static_cast<std::uint32_t>(h & 0xFFFFFFFF) - 1;
+    }
+}
@@ -104,4 +104,9 @@ namespace eka2l1::drivers {
     using texture_ptr = std::unique_ptr<texture>;
 
     texture_ptr make_texture(graphics_driver *driver);
+
+    /**
+     * \brief Get the number of bytes a pixel takes in the given format and data type.
+     */
+    std::size_t get_texture_pixel_size(const texture_format format, const texture_data_type data_type);
 }
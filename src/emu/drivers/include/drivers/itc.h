@@ -36,7 +36,6 @@
 #include <string>
 
 namespace eka2l1::drivers {
-    struct command_list;
     class graphics_driver;
 
     /** \brief Create a new bitmap in the server size.
@@ -44,6 +43,9 @@ namespace eka2l1::drivers {
       * A bitmap will be created in the server side when using this function. When you bind
       * a bitmap for rendering, a render target will be automatically created for it.
       *
+      * The creation is queued asynchronously. The returned handle is reserved on the client side
+      * and can be used in commands submitted afterwards.
+      *
       * \param initial_size       The initial size of the bitmap.
       * 
       * \returns ID of the bitmap.
@@ -66,6 +68,9 @@ namespace eka2l1::drivers {
     /**
      * \brief Create a new texture.
      *
+     * Like bitmap, the creation is queued asynchronously. The data is copied and can be freed
+     * right after this call.
+     *
      * \param driver            The driver associated with the texture.
      * \param dim               Total dimensions of this texture.
      * \param mip_levels        Total mips that the data contains.
@@ -95,10 +100,20 @@ namespace eka2l1::drivers {
         const buffer_upload_hint upload_hint);
 
     struct graphics_command_list {
+        virtual ~graphics_command_list() {}
     };
 
     struct server_graphics_command_list : public graphics_command_list {
         command_list list_;
+
+        explicit server_graphics_command_list(command_arena_pool_ptr pool)
+            : list_(pool) {
+        }
+
+        ~server_graphics_command_list() override {
+            // Commands that were never submitted
+            list_.release();
+        }
     };
 
     class graphics_command_list_builder {
@@ -177,6 +192,21 @@ namespace eka2l1::drivers {
          */
         virtual void draw_bitmap(drivers::handle h, drivers::handle maskh, const eka2l1::rect &dest_rect, const eka2l1::rect &source_rect, const std::uint32_t flags = 0) = 0;
 
+        /**
+         * \brief Draw many parts of a bitmap to currently binded bitmap, in one batch.
+         *
+         * Used to draw text from a glyph atlas. The rectangles are copied, and can be freed right after.
+         *
+         * \param h            The handle of the bitmap to blit.
+         * \param dest_rects   The destination rectangles.
+         * \param source_rects The source rectangles, one for each destination.
+         * \param count        Number of rectangles.
+         * \param flags        Drawing flags.
+         */
+        virtual void draw_bitmap_batch(drivers::handle h, const eka2l1::rect *dest_rects, const eka2l1::rect *source_rects,
+            const std::uint32_t count, const std::uint32_t flags = 0)
+            = 0;
+
         /**
          * \brief Draw a rectangle with brush color.
          * 
@@ -378,6 +408,9 @@ namespace eka2l1::drivers {
 
         void draw_bitmap(drivers::handle h, drivers::handle maskh, const eka2l1::rect &dest_rect, const eka2l1::rect &source_rect, const std::uint32_t flags = 0) override;
 
+        void draw_bitmap_batch(drivers::handle h, const eka2l1::rect *dest_rects, const eka2l1::rect *source_rects,
+            const std::uint32_t count, const std::uint32_t flags = 0) override;
+
         void draw_rectangle(const eka2l1::rect &target_rect) override;
 
         void use_program(drivers::handle h) override;
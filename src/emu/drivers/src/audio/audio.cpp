@@ -19,14 +19,28 @@
 
 #include <drivers/audio/audio.h>
 #include <drivers/audio/backend/cubeb/audio_cubeb.h>
+#include <drivers/audio/backend/null/audio_null.h>
 
 namespace eka2l1::drivers {
+    std::unique_ptr<audio_output_stream> audio_driver::new_output_stream(const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback) {
+        if (!mixer_) {
+            return nullptr;
+        }
+
+        return mixer_->new_stream(sample_rate, channels, callback);
+    }
+
     std::unique_ptr<audio_driver> make_audio_driver(const audio_driver_backend backend) {
         switch (backend) {
         case audio_driver_backend::cubeb: {
             return std::make_unique<cubeb_audio_driver>();
         }
 
+        case audio_driver_backend::null: {
+            return std::make_unique<null_audio_driver>();
+        }
+
         default:
             break;
         }
@@ -29,7 +29,8 @@
 namespace eka2l1::drivers {
     cubeb_audio_driver::cubeb_audio_driver()
         : context_(nullptr)
-        , init_(false) {
+        , init_(false)
+        , native_rate_(0) {
 #if EKA2L1_PLATFORM(WIN32)
         HRESULT hr = S_OK;
         hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
@@ -45,32 +46,41 @@ namespace eka2l1::drivers {
             return;
         }
 
+        if (cubeb_get_preferred_sample_rate(context_, &native_rate_) != CUBEB_OK) {
+            LOG_ERROR("Can't get preferred sample rate, use 48000Hz");
+            native_rate_ = 48000;
+        }
+
+        mixer_ = std::make_unique<audio_mixer>(native_rate_);
+        host_stream_ = std::make_unique<cubeb_audio_output_stream>(context_, native_rate_, 2,
+            [this](std::int16_t *buffer, const std::size_t frames) {
+                return mixer_->mix(buffer, frames);
+            });
+
+        if (!host_stream_->start()) {
+            LOG_CRITICAL("Can't start the host audio stream!");
+
+            host_stream_.reset();
+            mixer_.reset();
+
+            return;
+        }
+
         init_ = true;
     }
 
     cubeb_audio_driver::~cubeb_audio_driver() {
+        if (host_stream_) {
+            host_stream_->stop();
+            host_stream_.reset();
+        }
+
         if (context_) {
             cubeb_destroy(context_);
         }
     }
 
     std::uint32_t cubeb_audio_driver::native_sample_rate() {
-        std::uint32_t preferred_rate = 0;
-        const auto result = cubeb_get_preferred_sample_rate(context_, &preferred_rate);
-
-        if (result != CUBEB_OK) {
-            return 0;
-        }
-
-        return preferred_rate;
-    }
-
-    std::unique_ptr<audio_output_stream> cubeb_audio_driver::new_output_stream(const std::uint32_t sample_rate,
-        const std::uint8_t channels, data_callback callback) {
-        if (!init_) {
-            return nullptr;
-        }
-
-        return std::make_unique<cubeb_audio_output_stream>(context_, sample_rate, channels, callback);
+        return native_rate_;
     }
 };
\ No newline at end of file
@@ -102,4 +102,9 @@ namespace eka2l1::drivers {
 
         return false;
     }
-}
\ No newline at end of file
+
+    bool cubeb_audio_output_stream::set_balance(const float balance) {
+        // Cubeb has no panning control. Streams that need it go through the mixer
+        return false;
+    }
+}
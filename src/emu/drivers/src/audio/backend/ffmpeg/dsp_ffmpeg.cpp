@@ -22,10 +22,6 @@
 
 #include <common/log.h>
 
-extern "C" {
-#include <libswresample/swresample.h>
-}
-
 namespace eka2l1::drivers {
     static std::map<four_cc, AVCodecID> FOUR_CC_TO_FFMPEG_CODEC_MAP = {
         { AMR_FOUR_CC_CODE, AV_CODEC_ID_AMR_NB },
@@ -36,7 +32,9 @@ namespace eka2l1::drivers {
 
     dsp_output_stream_ffmpeg::dsp_output_stream_ffmpeg(drivers::audio_driver *aud)
         : dsp_output_stream_shared(aud)
-        , codec_(nullptr) {
+        , codec_(nullptr)
+        , packet_(av_packet_alloc())
+        , frame_(av_frame_alloc()) {
         format(PCM16_FOUR_CC_CODE);
     }
 
@@ -44,6 +42,9 @@ namespace eka2l1::drivers {
         if (codec_) {
             avcodec_free_context(&codec_);
         }
+
+        av_frame_free(&frame_);
+        av_packet_free(&packet_);
     }
 
     void dsp_output_stream_ffmpeg::get_supported_formats(std::vector<four_cc> &cc_list) {
@@ -67,6 +68,10 @@ namespace eka2l1::drivers {
             return false;
         }
 
+        if (codec_) {
+            avcodec_free_context(&codec_);
+        }
+
         codec_ = avcodec_alloc_context3(decoder);
 
         if (!codec_) {
@@ -75,52 +80,30 @@ namespace eka2l1::drivers {
         }
 
         format_ = fmt;
+        resampler_.reset();
+
         return true;
     }
 
     void dsp_output_stream_ffmpeg::decode_data(dsp_buffer &original, std::vector<std::uint8_t> &dest) {
-        AVPacket packet;
-        av_init_packet(&packet);
+        // Keep the capacity, the next buffer is likely to decode to the same size
+        dest.clear();
 
-        packet.size = original.size();
-        packet.data = original.data();
+        packet_->data = original.data();
+        packet_->size = static_cast<int>(original.size());
 
-        if (avcodec_send_packet(codec_, &packet) >= 0) {
-            AVFrame *frame = av_frame_alloc();
+        const int send_result = avcodec_send_packet(codec_, packet_);
 
-            if (avcodec_receive_frame(codec_, frame) < 0) {
-                av_frame_free(&frame);
-                return;
-            }
+        packet_->data = nullptr;
+        packet_->size = 0;
 
-            dest.resize(2 * frame->nb_samples * sizeof(std::uint16_t));
-
-            if ((channels_ != codec_->channels) || (frame->format != AV_SAMPLE_FMT_S16)) {
-                SwrContext *swr = swr_alloc_set_opts(nullptr,
-                    AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_S16, freq_,
-                    frame->channel_layout, static_cast<AVSampleFormat>(frame->format), frame->sample_rate,
-                    0, nullptr);
-
-                if (swr_init(swr) < 0) {
-                    LOG_ERROR("Error initializing SWR context");
-                    av_frame_free(&frame);
-
-                    return;
-                }
-
-                std::uint8_t *output = &dest[0];
-                const std::uint8_t *source = frame->data[0];
-
-                const int result = swr_convert(swr, &output, frame->nb_samples, &source, frame->nb_samples);
-                swr_free(&swr);
+        if (send_result < 0) {
+            return;
+        }
 
-                if (result < 0) {
-                    LOG_ERROR("Error resample audio data!");
-                    return;
-                }
-            } else {
-                std::memcpy(&dest[0], frame->data[0], dest.size());
-            }
+        while (avcodec_receive_frame(codec_, frame_) >= 0) {
+            resampler_.convert(frame_, channels_, freq_, dest);
+            av_frame_unref(frame_);
         }
     }
 }
\ No newline at end of file
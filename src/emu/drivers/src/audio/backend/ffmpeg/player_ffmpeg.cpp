@@ -20,10 +20,6 @@
 #include <common/log.h>
 #include <drivers/audio/backend/ffmpeg/player_ffmpeg.h>
 
-extern "C" {
-#include <libswresample/swresample.h>
-}
-
 namespace eka2l1::drivers {
     void player_ffmpeg_request::deinit() {
         if (type_ == player_request_format) {
@@ -32,6 +28,12 @@ namespace eka2l1::drivers {
 
             codec_ = nullptr;
         }
+
+        if (frame_) {
+            av_frame_free(&frame_);
+        }
+
+        resampler_.reset();
     }
 
     player_ffmpeg_request::~player_ffmpeg_request() {
@@ -95,6 +97,7 @@ namespace eka2l1::drivers {
 
         request.channels_ = request.codec_->channels;
         request.freq_ = request.codec_->sample_rate;
+        request.frame_ = av_frame_alloc();
 
         return true;
     }
@@ -127,6 +130,7 @@ namespace eka2l1::drivers {
         player_ffmpeg_request *request_ff = reinterpret_cast<player_ffmpeg_request *>(request.get());
 
         avformat_flush(request_ff->format_);
+        avcodec_flush_buffers(request_ff->codec_);
 
         if (avformat_seek_file(request_ff->format_, -1, INT64_MIN, 0, INT64_MAX, 0) < 0) {
             LOG_ERROR("Error seeking the stream!");
@@ -139,7 +143,6 @@ namespace eka2l1::drivers {
         // Data drain, try to get more
         if (request_ff->type_ == player_request_format) {
             if (request_ff->flags_ & 1) {
-                output_stream_->stop();
                 return;
             }
 
@@ -149,59 +152,41 @@ namespace eka2l1::drivers {
             }
 
             // Send packet to decoder
-            if (avcodec_send_packet(request_ff->codec_, &request_ff->packet_) >= 0) {
-                AVFrame *frame = av_frame_alloc();
-
-                if (avcodec_receive_frame(request_ff->codec_, frame) < 0) {
-                    LOG_ERROR("Error while decoding a frame!");
-                    av_frame_free(&frame);
-                    request_ff->flags_ |= 1;
-                    return;
-                }
+            const int send_result = avcodec_send_packet(request_ff->codec_, &request_ff->packet_);
+            av_packet_unref(&request_ff->packet_);
 
-                std::size_t base_ptr = 0;
-
-                if (request_ff->use_push_new_data_) {
-                    base_ptr = request_ff->data_.size();
-                    request_ff->use_push_new_data_ = false;
-                }
-
-                request_ff->data_.resize(base_ptr + request_ff->channels_ * frame->nb_samples * sizeof(std::int16_t));
+            if (send_result < 0) {
+                return;
+            }
 
-                if ((frame->format != AV_SAMPLE_FMT_S16) || (frame->channels != request_ff->channels_)
-                    || (frame->sample_rate != request_ff->freq_)) {
-                    // Resample it
-                    const int dest_channel_type = (request_ff->channels_ == 2) ? AV_CH_LAYOUT_STEREO : AV_CH_LAYOUT_MONO;
+            if (!request_ff->use_push_new_data_) {
+                // Keep the capacity, so the buffer stops being reallocated after the first few frames
+                request_ff->data_.clear();
+            }
 
-                    SwrContext *swr = swr_alloc_set_opts(nullptr,
-                        dest_channel_type, AV_SAMPLE_FMT_S16, request_ff->freq_,
-                        frame->channel_layout, static_cast<AVSampleFormat>(frame->format), frame->sample_rate,
-                        0, nullptr);
+            request_ff->use_push_new_data_ = false;
 
-                    if (swr_init(swr) < 0) {
-                        LOG_ERROR("Error initializing SWR context");
-                        av_frame_free(&frame);
+            int receive_result = 0;
 
-                        return;
-                    }
+            // A packet may decode to several frames. Drain them all into the data buffer directly
+            while ((receive_result = avcodec_receive_frame(request_ff->codec_, request_ff->frame_)) >= 0) {
+                const bool converted = request_ff->resampler_.convert(request_ff->frame_,
+                    static_cast<std::uint8_t>(request_ff->channels_), request_ff->freq_, request_ff->data_);
 
-                    std::uint8_t *output = request_ff->data_.data() + base_ptr;
-                    const std::uint8_t *source = frame->data[0];
+                av_frame_unref(request_ff->frame_);
 
-                    const int result = swr_convert(swr, &output, frame->nb_samples, &source, frame->nb_samples);
-                    swr_free(&swr);
+                if (!converted) {
+                    request_ff->flags_ |= 1;
+                    break;
+                }
+            }
 
-                    if (result < 0) {
-                        LOG_ERROR("Error resample audio data!");
-                        request_ff->flags_ |= 1;
-                        return;
-                    }
-                } else {
-                    // Just gonna copy smh
-                    std::memcpy(&request_ff->data_[base_ptr], frame->data[0], request_ff->data_.size());
+            if ((receive_result < 0) && (receive_result != AVERROR(EAGAIN))) {
+                if (receive_result != AVERROR_EOF) {
+                    LOG_ERROR("Error while decoding a frame!");
                 }
 
-                av_frame_free(&frame);
+                request_ff->flags_ |= 1;
             }
         }
 
@@ -219,5 +204,6 @@ namespace eka2l1::drivers {
     }
 
     player_ffmpeg::~player_ffmpeg() {
+        stop_decode_worker();
     }
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <common/log.h>
+#include <drivers/audio/backend/ffmpeg/resampler_ffmpeg.h>
+
+#include <cstring>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+}
+
+namespace eka2l1::drivers {
+    ffmpeg_resampler::ffmpeg_resampler()
+        : context_(nullptr)
+        , in_layout_(0)
+        , in_format_(AV_SAMPLE_FMT_NONE)
+        , in_rate_(0)
+        , out_layout_(0)
+        , out_rate_(0) {
+    }
+
+    ffmpeg_resampler::~ffmpeg_resampler() {
+        reset();
+    }
+
+    void ffmpeg_resampler::reset() {
+        if (context_) {
+            swr_free(&context_);
+        }
+    }
+
+    bool ffmpeg_resampler::prepare(const AVFrame *frame, const std::int64_t in_layout, const std::int64_t out_layout,
+        const int out_rate) {
+        if (context_ && (in_layout_ == in_layout) && (in_format_ == frame->format) && (in_rate_ == frame->sample_rate)
+            && (out_layout_ == out_layout) && (out_rate_ == out_rate)) {
+            return true;
+        }
+
+        reset();
+
+        context_ = swr_alloc_set_opts(nullptr, out_layout, AV_SAMPLE_FMT_S16, out_rate,
+            in_layout, static_cast<AVSampleFormat>(frame->format), frame->sample_rate, 0, nullptr);
+
+        if (!context_ || (swr_init(context_) < 0)) {
+            LOG_ERROR("Error initializing SWR context");
+            reset();
+
+            return false;
+        }
+
+        in_layout_ = in_layout;
+        in_format_ = frame->format;
+        in_rate_ = frame->sample_rate;
+        out_layout_ = out_layout;
+        out_rate_ = out_rate;
+
+        return true;
+    }
+
+    bool ffmpeg_resampler::convert(const AVFrame *frame, const std::uint8_t out_channels, const std::uint32_t out_rate,
+        std::vector<std::uint8_t> &dest) {
+        const std::size_t base = dest.size();
+        const std::size_t frame_size = out_channels * sizeof(std::int16_t);
+
+        if ((frame->format == AV_SAMPLE_FMT_S16) && (frame->channels == out_channels)
+            && (frame->sample_rate == static_cast<int>(out_rate)) && !context_) {
+            // Already what we want, and no samples are left behind in the resampler
+            dest.resize(base + frame->nb_samples * frame_size);
+            std::memcpy(dest.data() + base, frame->data[0], frame->nb_samples * frame_size);
+
+            return true;
+        }
+
+        const std::int64_t in_layout = frame->channel_layout ? frame->channel_layout
+                                                             : av_get_default_channel_layout(frame->channels);
+        const std::int64_t out_layout = (out_channels == 2) ? AV_CH_LAYOUT_STEREO : AV_CH_LAYOUT_MONO;
+
+        if (!prepare(frame, in_layout, out_layout, static_cast<int>(out_rate))) {
+            return false;
+        }
+
+        const int max_out_samples = swr_get_out_samples(context_, frame->nb_samples);
+
+        if (max_out_samples < 0) {
+            return false;
+        }
+
+        // Convert straight into the destination, then trim to what was produced
+        dest.resize(base + max_out_samples * frame_size);
+        std::uint8_t *output = dest.data() + base;
+
+        const int result = swr_convert(context_, &output, max_out_samples,
+            const_cast<const std::uint8_t **>(frame->extended_data), frame->nb_samples);
+
+        if (result < 0) {
+            LOG_ERROR("Error resample audio data!");
+            dest.resize(base);
+
+            return false;
+        }
+
+        dest.resize(base + result * frame_size);
+        return true;
+    }
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <drivers/audio/backend/null/audio_null.h>
+
+namespace eka2l1::drivers {
+    null_audio_driver::null_audio_driver(const std::uint32_t sample_rate) {
+        mixer_ = std::make_unique<audio_mixer>(sample_rate);
+    }
+
+    null_audio_driver::~null_audio_driver() {
+    }
+
+    std::uint32_t null_audio_driver::native_sample_rate() {
+        return mixer_->sample_rate();
+    }
+}
@@ -23,80 +23,153 @@
 #include <common/cvt.h>
 #include <common/log.h>
 
+#include <algorithm>
+#include <chrono>
+
 namespace eka2l1::drivers {
+    // How long the decode worker sleeps when nobody wakes it up
+    static constexpr std::uint32_t DECODE_POLL_MS = 10;
+
     std::size_t player_shared::data_supply_callback(std::int16_t *data, std::size_t size) {
-        // Get the oldest request
-        const std::lock_guard<std::mutex> guard(request_queue_lock_);
-        player_request_instance &request = requests_.front();
+        // Check for the end before reading, so no data written after the flag can be missed
+        const bool drained = end_of_stream_;
+        const std::size_t frame_copied = pcm_ring_.read(data, size * 2) / 2;
 
-        std::size_t frame_copied = 0;
+        if (pcm_ring_.free() >= pcm_ring_.capacity() / 2) {
+            decode_wake_ = true;
+            decode_cond_.notify_one();
+        }
 
-        auto supply_stuff = [&]() {
-            while ((frame_copied < size) && (!(request->flags_ & 1))) {
-                if (request->data_.size() == request->data_pointer_)
-                    get_more_data(request);
+        if (frame_copied == size) {
+            primed_ = true;
+            return frame_copied;
+        }
 
-                const std::size_t total_frame_left = (request->data_.size() - request->data_pointer_) / request->channels_ / sizeof(std::uint16_t);
-                const std::size_t frame_to_copy = std::min<std::size_t>(total_frame_left, size - frame_copied);
+        if (!drained) {
+            // The decoder fell behind. Play silence rather than ending the stream
+            std::fill(data + frame_copied * 2, data + size * 2, 0);
 
-                // Copy the frames first
-                if (request->channels_ == 1) {
-                    const std::uint16_t *original_data_u16 = reinterpret_cast<std::uint16_t *>(request->data_.data() + request->data_pointer_);
+            if (primed_) {
+                underruns_++;
+            }
 
-                    // We have to do something!
-                    for (std::size_t frame_ite = 0; frame_ite < frame_to_copy; frame_ite++) {
-                        data[2 * (frame_ite + frame_copied)] = original_data_u16[frame_ite];
-                        data[2 * (frame_ite + frame_copied) + 1] = original_data_u16[frame_ite];
-                    }
-                } else {
-                    // Well, just copy straight up
-                    std::memcpy(data + frame_copied * 2, request->data_.data() + request->data_pointer_, frame_to_copy * 2 * sizeof(std::uint16_t));
-                }
+            return size;
+        }
 
-                request->data_pointer_ += frame_to_copy * request->channels_ * sizeof(std::uint16_t);
-                frame_copied += frame_to_copy;
-            }
-        };
+        // We are drained (out of frame). Call the finish callback
+        if (!notified_done_.exchange(true)) {
+            const std::lock_guard<std::mutex> guard(request_queue_lock_);
 
-        supply_stuff();
+            if (callback_)
+                callback_(userdata_.data());
+        }
 
-        if ((frame_copied < size) || (request->flags_ & 1)) {
-            bool no_more_way = false;
+        return frame_copied;
+    }
+
+    bool player_shared::decode_ahead() {
+        if (requests_.empty()) {
+            return false;
+        }
+
+        player_request_instance &request = requests_.front();
+
+        if (request->data_pointer_ >= request->data_.size()) {
+            if (!(request->flags_ & 1)) {
+                get_more_data(request);
+                return true;
+            }
 
             // There is no more data for us! Either repeat or kill
             if (request->repeat_left_ == 0) {
-                no_more_way = true;
-            } else {
-                // Seek back to do a loop. Intentionally left this so that negative repeat can do infinite loop
-                if (request->repeat_left_ > 0) {
-                    request->repeat_left_ -= 1;
-                }
-
-                // Reset the stream if we are the custom format guy!
-                if (request->type_ == player_request_format) {
-                    reset_request(request);
-                }
-
-                request->data_pointer_ = 0;
-                request->flags_ = 0;
-
-                // We want to supply silence samples
-                // 1s = 1ms
-                const std::size_t silence_samples = request->freq_ * request->silence_micros_ / 1000000;
-                request->data_.resize(silence_samples * sizeof(std::uint16_t) * request->channels_);
-                std::fill(request->data_.begin(), request->data_.end(), 0);
-
-                request->use_push_new_data_ = true;
-                supply_stuff();
+                end_of_stream_ = true;
+                return false;
             }
 
-            // We are drained (out of frame)
-            // Call the finish callback
-            if (no_more_way && callback_)
-                callback_(userdata_.data());
+            // Seek back to do a loop. Intentionally left this so that negative repeat can do infinite loop
+            if (request->repeat_left_ > 0) {
+                request->repeat_left_ -= 1;
+            }
+
+            // Reset the stream if we are the custom format guy!
+            if (request->type_ == player_request_format) {
+                reset_request(request);
+            }
+
+            request->data_pointer_ = 0;
+            request->flags_ = 0;
+
+            // We want to supply silence samples
+            const std::size_t silence_samples = request->freq_ * request->silence_micros_ / 1000000;
+            request->data_.assign(silence_samples * sizeof(std::uint16_t) * request->channels_, 0);
+
+            return true;
         }
 
-        return frame_copied;
+        const std::size_t frame_size = request->channels_ * sizeof(std::int16_t);
+        const std::size_t total_frame_left = (request->data_.size() - request->data_pointer_) / frame_size;
+        const std::size_t frame_to_copy = std::min<std::size_t>(total_frame_left, pcm_ring_.free() / 2);
+
+        if (total_frame_left == 0) {
+            // Only a partial frame left, drop it
+            request->data_pointer_ = request->data_.size();
+            return true;
+        }
+
+        if (frame_to_copy == 0) {
+            // Ring is full
+            return false;
+        }
+
+        const std::int16_t *source = reinterpret_cast<const std::int16_t *>(request->data_.data() + request->data_pointer_);
+
+        if (request->channels_ == 1) {
+            stereo_staging_.resize(frame_to_copy * 2);
+
+            for (std::size_t frame_ite = 0; frame_ite < frame_to_copy; frame_ite++) {
+                stereo_staging_[2 * frame_ite] = source[frame_ite];
+                stereo_staging_[2 * frame_ite + 1] = source[frame_ite];
+            }
+
+            pcm_ring_.write(stereo_staging_.data(), frame_to_copy * 2);
+        } else {
+            // Well, just copy straight up
+            pcm_ring_.write(source, frame_to_copy * 2);
+        }
+
+        request->data_pointer_ += frame_to_copy * frame_size;
+        return true;
+    }
+
+    void player_shared::decode_worker_loop() {
+        while (!decode_quit_) {
+            bool has_more = false;
+
+            if (decoding_) {
+                // Only hold the lock for one step, so the emulator thread is never kept waiting long
+                const std::lock_guard<std::mutex> guard(request_queue_lock_);
+                has_more = decoding_ && decode_ahead();
+            }
+
+            if (has_more) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> wait_guard(decode_wait_lock_);
+            decode_cond_.wait_for(wait_guard, std::chrono::milliseconds(DECODE_POLL_MS), [this]() {
+                return decode_quit_ || decode_wake_.exchange(false);
+            });
+        }
+    }
+
+    void player_shared::stop_decode_worker() {
+        decode_quit_ = true;
+        decode_wake_ = true;
+        decode_cond_.notify_one();
+
+        if (decode_thread_.joinable()) {
+            decode_thread_.join();
+        }
     }
 
     bool player_shared::play() {
@@ -104,6 +177,8 @@ namespace eka2l1::drivers {
         if (output_stream_)
             output_stream_->stop();
 
+        decoding_ = false;
+
         // Reset the request
         {
             const std::lock_guard<std::mutex> guard(request_queue_lock_);
@@ -115,6 +190,13 @@ namespace eka2l1::drivers {
             request->flags_ = 0;
             request->data_.clear();
 
+            // Nobody reads or writes the ring now: the stream is stopped and the worker needs the lock
+            pcm_ring_.reset(static_cast<std::size_t>(request->freq_) * decode_ahead_ms_ / 1000 * 2);
+
+            end_of_stream_ = false;
+            notified_done_ = false;
+            primed_ = false;
+
             // New stream to restart everything
             output_stream_ = aud_->new_output_stream(request->freq_, 2, [this](std::int16_t *u1, std::size_t u2) {
                 return data_supply_callback(u1, u2);
@@ -126,12 +208,22 @@ namespace eka2l1::drivers {
             }
 
             output_stream_->set_volume(static_cast<float>(volume_) / 100.0f);
+            decoding_ = true;
+        }
+
+        if (!decode_thread_.joinable()) {
+            decode_thread_ = std::thread([this]() { decode_worker_loop(); });
         }
 
+        decode_wake_ = true;
+        decode_cond_.notify_one();
+
         return output_stream_->start();
     }
 
     bool player_shared::stop() {
+        decoding_ = false;
+
         if (output_stream_)
             return output_stream_->stop();
 
@@ -156,11 +248,30 @@ namespace eka2l1::drivers {
         request->silence_micros_ = silence_intervals_micros;
     }
 
+    void player_shared::set_decode_ahead_duration(const std::uint32_t milliseconds) {
+        const std::lock_guard<std::mutex> guard(request_queue_lock_);
+        decode_ahead_ms_ = milliseconds;
+    }
+
+    std::uint64_t player_shared::underrun_count() const {
+        return underruns_;
+    }
+
     player_shared::player_shared(audio_driver *driver)
-        : aud_(driver) {
+        : aud_(driver)
+        , decode_ahead_ms_(DEFAULT_DECODE_AHEAD_MS)
+        , decoding_(false)
+        , decode_quit_(false)
+        , decode_wake_(false)
+        , end_of_stream_(false)
+        , notified_done_(false)
+        , underruns_(0)
+        , primed_(false) {
     }
 
     player_shared::~player_shared() {
+        stop_decode_worker();
+
         if (output_stream_) {
             output_stream_->stop();
         }
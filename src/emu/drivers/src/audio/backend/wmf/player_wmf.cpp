@@ -56,13 +56,16 @@ namespace eka2l1::drivers {
         hr = MFStartup(MF_VERSION);
     }
 
+    player_wmf::~player_wmf() {
+        stop_decode_worker();
+    }
+
     void player_wmf::get_more_data(player_request_instance &request) {
         player_wmf_request *request_wmf = reinterpret_cast<player_wmf_request *>(request.get());
 
         // Data drain, try to get more
         if (request_wmf->type_ == player_request_format) {
             if (request_wmf->flags_ & 1) {
-                output_stream_->stop();
                 return;
             }
 
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <common/algorithm.h>
+#include <common/log.h>
+#include <common/platform.h>
+#include <drivers/audio/mixer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#if EKA2L1_ARCH(X86) || EKA2L1_ARCH(X64)
+#include <emmintrin.h>
+#define EKA2L1_AUDIO_MIXER_SSE2 1
+#endif
+
+namespace eka2l1::drivers {
+    static constexpr std::uint64_t FIXED_ONE = 1ULL << 32;
+    static constexpr float FIXED_TO_FLOAT = 1.0f / 4294967296.0f;
+
+    // Set while the current thread runs a mix pass, so stream callbacks can stop themselves.
+    static thread_local bool in_mix_pass = false;
+
+    static void accumulate_f32(float *acc, const float *source, const std::size_t frame_count,
+        const float gain_left, const float gain_right) {
+        const std::size_t value_count = frame_count * 2;
+        std::size_t i = 0;
+
+#if EKA2L1_AUDIO_MIXER_SSE2
+        const __m128 gains = _mm_setr_ps(gain_left, gain_right, gain_left, gain_right);
+
+        for (; i + 4 <= value_count; i += 4) {
+            const __m128 sum = _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(source + i), gains));
+            _mm_storeu_ps(acc + i, sum);
+        }
+#endif
+
+        for (; i < value_count; i++) {
+            acc[i] += source[i] * ((i & 1) ? gain_right : gain_left);
+        }
+    }
+
+    static void accumulate_s16(float *acc, const std::int16_t *source, const std::size_t frame_count,
+        const float gain_left, const float gain_right) {
+        const std::size_t value_count = frame_count * 2;
+        std::size_t i = 0;
+
+#if EKA2L1_AUDIO_MIXER_SSE2
+        const __m128 gains = _mm_setr_ps(gain_left, gain_right, gain_left, gain_right);
+
+        for (; i + 8 <= value_count; i += 8) {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+
+            // Sign extend by placing each sample in the upper half, then shifting it back down
+            const __m128 low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16));
+            const __m128 high = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16));
+
+            _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(low, gains)));
+            _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_mul_ps(high, gains)));
+        }
+#endif
+
+        for (; i < value_count; i++) {
+            acc[i] += static_cast<float>(source[i]) * ((i & 1) ? gain_right : gain_left);
+        }
+    }
+
+    static void convert_to_s16(std::int16_t *dest, const float *acc, const std::size_t value_count) {
+        std::size_t i = 0;
+
+#if EKA2L1_AUDIO_MIXER_SSE2
+        for (; i + 8 <= value_count; i += 8) {
+            // Round to nearest, then saturate while packing
+            const __m128i low = _mm_cvtps_epi32(_mm_loadu_ps(acc + i));
+            const __m128i high = _mm_cvtps_epi32(_mm_loadu_ps(acc + i + 4));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_packs_epi32(low, high));
+        }
+#endif
+
+        for (; i < value_count; i++) {
+            dest[i] = static_cast<std::int16_t>(std::lrint(common::clamp(-32768.0f, 32767.0f, acc[i])));
+        }
+    }
+
+    mixer_output_stream::mixer_output_stream(audio_mixer *mixer, const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback)
+        : mixer_(mixer)
+        , callback_(callback)
+        , sample_rate_(sample_rate)
+        , channels_(common::max<std::uint8_t>(channels, 1))
+        , step_(FIXED_ONE)
+        , playing_(false)
+        , volume_(1.0f)
+        , balance_(0.0f)
+        , buffered_(0)
+        , position_(0) {
+        if (sample_rate && mixer->sample_rate()) {
+            step_ = (static_cast<std::uint64_t>(sample_rate) << 32) / mixer->sample_rate();
+        }
+    }
+
+    mixer_output_stream::~mixer_output_stream() {
+        mixer_->remove_stream(this);
+    }
+
+    bool mixer_output_stream::start() {
+        playing_ = true;
+        return true;
+    }
+
+    bool mixer_output_stream::stop() {
+        playing_ = false;
+
+        // Like a host stream, no callback may be running anymore once stop returns
+        mixer_->wait_for_pass();
+        return true;
+    }
+
+    bool mixer_output_stream::is_playing() {
+        return playing_;
+    }
+
+    bool mixer_output_stream::set_volume(const float volume) {
+        volume_ = common::clamp(0.0f, 1.0f, volume);
+        return true;
+    }
+
+    bool mixer_output_stream::set_balance(const float balance) {
+        balance_ = common::clamp(-1.0f, 1.0f, balance);
+        return true;
+    }
+
+    audio_mixer::audio_mixer(const std::uint32_t sample_rate)
+        : mix_serial_(0)
+        , sample_rate_(sample_rate) {
+        for (auto &stream : streams_) {
+            stream = nullptr;
+        }
+    }
+
+    std::unique_ptr<audio_output_stream> audio_mixer::new_stream(const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback) {
+        auto stream = std::make_unique<mixer_output_stream>(this, sample_rate, channels, callback);
+
+        if (!add_stream(stream.get())) {
+            return nullptr;
+        }
+
+        return stream;
+    }
+
+    bool audio_mixer::add_stream(mixer_output_stream *stream) {
+        for (auto &slot : streams_) {
+            mixer_output_stream *expected = nullptr;
+
+            if (slot.compare_exchange_strong(expected, stream)) {
+                return true;
+            }
+        }
+
+        LOG_ERROR("Out of audio mixer slots (max {} streams)", MAX_STREAM_COUNT);
+        return false;
+    }
+
+    void audio_mixer::remove_stream(mixer_output_stream *stream) {
+        for (auto &slot : streams_) {
+            mixer_output_stream *expected = stream;
+
+            if (slot.compare_exchange_strong(expected, nullptr)) {
+                break;
+            }
+        }
+
+        // The mixing thread may still hold the pointer it loaded before the slot was cleared
+        wait_for_pass();
+    }
+
+    void audio_mixer::wait_for_pass() {
+        if (in_mix_pass) {
+            return;
+        }
+
+        const std::uint64_t serial = mix_serial_.load();
+
+        if ((serial & 1) == 0) {
+            return;
+        }
+
+        while (mix_serial_.load() == serial) {
+            std::this_thread::yield();
+        }
+    }
+
+    void audio_mixer::mix_stream(mixer_output_stream *stream, const std::size_t frame_count) {
+        const float volume = stream->volume_.load(std::memory_order_relaxed);
+        const float balance = stream->balance_.load(std::memory_order_relaxed);
+
+        const float gain_left = volume * ((balance > 0.0f) ? (1.0f - balance) : 1.0f);
+        const float gain_right = volume * ((balance < 0.0f) ? (1.0f + balance) : 1.0f);
+
+        const std::size_t channels = stream->channels_;
+        const std::uint64_t step = stream->step_;
+
+        // Interpolating the last output frame needs the frame after it, and the position after this pass
+        // must also land inside the buffer.
+        const std::uint64_t last_position = stream->position_ + step * (frame_count - 1);
+        const std::uint64_t end_position = last_position + step;
+
+        const std::size_t needed = common::max<std::size_t>(static_cast<std::size_t>(last_position >> 32) + 2,
+            static_cast<std::size_t>(end_position >> 32) + 1);
+
+        if (needed > stream->buffered_) {
+            const std::size_t pull_count = needed - stream->buffered_;
+            stream->pulled_.resize(needed * channels);
+
+            const std::size_t pulled_count = common::min(pull_count,
+                stream->callback_(stream->pulled_.data() + stream->buffered_ * channels, pull_count));
+
+            if (pulled_count < pull_count) {
+                // Source drained. Pad with silence and stop pulling from it, like a host stream would
+                std::fill(stream->pulled_.begin() + (stream->buffered_ + pulled_count) * channels, stream->pulled_.end(), 0);
+                stream->playing_ = false;
+            }
+
+            stream->buffered_ = needed;
+        }
+
+        if ((step == FIXED_ONE) && (stream->position_ == 0) && (channels == 2)) {
+            // Same rate and layout as the host, no interpolation needed
+            accumulate_s16(accumulator_.data(), stream->pulled_.data(), frame_count, gain_left, gain_right);
+        } else {
+            stream->resampled_.resize(frame_count * 2);
+
+            const std::int16_t *pulled = stream->pulled_.data();
+            float *resampled = stream->resampled_.data();
+
+            std::uint64_t position = stream->position_;
+
+            for (std::size_t i = 0; i < frame_count; i++, position += step) {
+                const std::int16_t *first = pulled + (position >> 32) * channels;
+                const std::int16_t *second = first + channels;
+                const float frac = static_cast<float>(position & 0xFFFFFFFF) * FIXED_TO_FLOAT;
+
+                const float left = first[0] + (second[0] - first[0]) * frac;
+                resampled[i * 2] = left;
+                resampled[i * 2 + 1] = (channels > 1) ? (first[1] + (second[1] - first[1]) * frac) : left;
+            }
+
+            accumulate_f32(accumulator_.data(), resampled, frame_count, gain_left, gain_right);
+        }
+
+        // Keep the frame we stopped at and everything after it for the next pass
+        const std::size_t consumed = static_cast<std::size_t>(end_position >> 32);
+
+        stream->pulled_.erase(stream->pulled_.begin(), stream->pulled_.begin() + consumed * channels);
+        stream->buffered_ -= consumed;
+
+        stream->position_ = end_position & 0xFFFFFFFF;
+    }
+
+    std::size_t audio_mixer::mix(std::int16_t *output, const std::size_t frame_count) {
+        if (frame_count == 0) {
+            return 0;
+        }
+
+        in_mix_pass = true;
+        mix_serial_++;
+
+        accumulator_.assign(frame_count * 2, 0.0f);
+
+        for (auto &slot : streams_) {
+            mixer_output_stream *stream = slot.load();
+
+            if (stream && stream->playing_) {
+                mix_stream(stream, frame_count);
+            }
+        }
+
+        convert_to_s16(output, accumulator_.data(), frame_count * 2);
+
+        mix_serial_++;
+        in_mix_pass = false;
+
+        return frame_count;
+    }
+}
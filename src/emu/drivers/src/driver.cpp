@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/driver.h>
+
+#include <algorithm>
+
+namespace eka2l1::drivers {
+    command_arena::command_arena()
+        : current_(0)
+        , offset_(0) {
+    }
+
+    void *command_arena::allocate(const std::size_t size, const std::size_t alignment) {
+        while (current_ < blocks_.size()) {
+            block &blk = blocks_[current_];
+            const std::size_t aligned_offset = (offset_ + alignment - 1) & ~(alignment - 1);
+
+            if (aligned_offset + size <= blk.size_) {
+                offset_ = aligned_offset + size;
+                return blk.data_.get() + aligned_offset;
+            }
+
+            // Move on to the next block, which may be left from previous frames.
+            current_++;
+            offset_ = 0;
+        }
+
+        // Need a fresh block. Big payloads (bitmap updates) get a dedicated one.
+        block new_block;
+        new_block.size_ = std::max<std::size_t>(COMMAND_ARENA_BLOCK_SIZE, size + alignment);
+        new_block.data_ = std::make_unique<std::uint8_t[]>(new_block.size_);
+
+        blocks_.push_back(std::move(new_block));
+        current_ = blocks_.size() - 1;
+
+        // Operator new already returns memory aligned to the biggest fundamental alignment.
+        offset_ = size;
+        return blocks_[current_].data_.get();
+    }
+
+    void *command_arena::copy(const void *source, const std::size_t size) {
+        void *dest = allocate(size);
+        std::memcpy(dest, source, size);
+
+        return dest;
+    }
+
+    void command_arena::reset() {
+        // Free the oversized blocks, they are likely one-off uploads.
+        blocks_.erase(std::remove_if(blocks_.begin(), blocks_.end(), [](const block &blk) {
+            return blk.size_ > COMMAND_ARENA_BLOCK_SIZE;
+        }),
+            blocks_.end());
+
+        current_ = 0;
+        offset_ = 0;
+    }
+
+    std::size_t command_arena::capacity() const {
+        std::size_t total = 0;
+
+        for (const block &blk : blocks_) {
+            total += blk.size_;
+        }
+
+        return total;
+    }
+
+    command_arena *command_arena_pool::acquire() {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (free_.empty()) {
+            return new command_arena;
+        }
+
+        command_arena *arena = free_.back().release();
+        free_.pop_back();
+
+        return arena;
+    }
+
+    void command_arena_pool::release(command_arena *arena) {
+        arena->reset();
+
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (free_.size() >= MAX_POOLED_COMMAND_ARENA) {
+            delete arena;
+            return;
+        }
+
+        free_.emplace_back(arena);
+    }
+}
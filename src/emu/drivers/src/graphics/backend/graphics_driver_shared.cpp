@@ -17,6 +17,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/algorithm.h>
 #include <common/log.h>
 #include <drivers/graphics/backend/graphics_driver_shared.h>
 #include <drivers/graphics/buffer.h>
@@ -80,14 +81,54 @@ namespace eka2l1::drivers {
         , binding(nullptr)
         , brush_color({ 255.0f, 255.0f, 255.0f, 255.0f })
         , current_fb_height(0) {
+        arena_pool = std::make_shared<command_arena_pool>();
     }
 
     shared_graphics_driver::~shared_graphics_driver() {
     }
 
-#define HANDLE_BITMAP (1ULL << 32)
+    drivers::handle shared_graphics_driver::resolve_handle(const drivers::handle h) const {
+        if (!is_handle_reserved(h)) {
+            return h;
+        }
+
+        const std::uint32_t idx = get_reserved_handle_index(h);
+
+        if (idx >= handle_remap.size()) {
+            return 0;
+        }
+
+        return handle_remap[idx];
+    }
+
+    void shared_graphics_driver::bind_reserved_handle(const drivers::handle reserved, const drivers::handle real) {
+        const std::uint32_t idx = get_reserved_handle_index(reserved);
+
+        if (idx >= handle_remap.size()) {
+            handle_remap.resize(common::max<std::size_t>(idx + 1, handle_remap.size() * 2), 0);
+        }
+
+        handle_remap[idx] = real;
+    }
+
+    void shared_graphics_driver::unbind_reserved_handle(const drivers::handle reserved) {
+        if (!is_handle_reserved(reserved)) {
+            return;
+        }
+
+        const std::uint32_t idx = get_reserved_handle_index(reserved);
+
+        if (idx < handle_remap.size()) {
+            handle_remap[idx] = 0;
+        }
+
+        // Every command referencing this handle has been executed, clients can now take it again
+        handle_allocator_.free(reserved);
+    }
+
+    bitmap *shared_graphics_driver::get_bitmap(drivers::handle h) {
+        h = resolve_handle(h);
 
-    bitmap *shared_graphics_driver::get_bitmap(const drivers::handle h) {
         if ((h & HANDLE_BITMAP) == 0) {
             return nullptr;
         }
@@ -111,7 +152,9 @@ namespace eka2l1::drivers {
         return graphic_objects.size();
     }
 
-    bool shared_graphics_driver::delete_graphics_object(const drivers::handle handle) {
+    bool shared_graphics_driver::delete_graphics_object(drivers::handle handle) {
+        handle = resolve_handle(handle);
+
         if (handle > graphic_objects.size() || handle == 0) {
             return 0;
         }
@@ -120,7 +163,9 @@ namespace eka2l1::drivers {
         return true;
     }
 
-    graphics_object *shared_graphics_driver::get_graphics_object(const drivers::handle num) {
+    graphics_object *shared_graphics_driver::get_graphics_object(drivers::handle num) {
+        num = resolve_handle(num);
+
         if (num > graphic_objects.size() || num == 0) {
             return nullptr;
         }
@@ -178,29 +223,39 @@ namespace eka2l1::drivers {
         helper.pop(dim);
 
         update_bitmap(handle, size, offset, dim, bpp, data);
-
-        delete data;
     }
 
     void shared_graphics_driver::create_bitmap(command_helper &helper) {
         eka2l1::vec2 size;
+        drivers::handle reserved = 0;
         drivers::handle *result = nullptr;
 
         helper.pop(size);
+        helper.pop(reserved);
         helper.pop(result);
 
+        drivers::handle res = 0;
+
         // Find free slot
         auto slot_free = std::find(bmp_textures.begin(), bmp_textures.end(), nullptr);
 
         if (slot_free != bmp_textures.end()) {
             *slot_free = std::make_unique<bitmap>(this, size, 32);
-            *result = std::distance(bmp_textures.begin(), slot_free) + 1;
+            res = std::distance(bmp_textures.begin(), slot_free) + 1;
         } else {
             bmp_textures.push_back(std::make_unique<bitmap>(this, size, 32));
-            *result = bmp_textures.size();
+            res = bmp_textures.size();
+        }
+
+        res |= HANDLE_BITMAP;
+
+        if (reserved) {
+            // Asynchronous creation, the client already holds the reserved handle
+            bind_reserved_handle(reserved, res);
+            return;
         }
 
-        *result |= HANDLE_BITMAP;
+        *result = res;
 
         // Notify
         helper.finish(this, 0);
@@ -249,12 +304,19 @@ namespace eka2l1::drivers {
         drivers::handle h = 0;
         helper.pop(h);
 
-        if ((h & ~HANDLE_BITMAP) > bmp_textures.size()) {
+        const drivers::handle real = resolve_handle(h);
+        unbind_reserved_handle(h);
+
+        if (((real & ~HANDLE_BITMAP) > bmp_textures.size()) || ((real & ~HANDLE_BITMAP) == 0)) {
             LOG_ERROR("Invalid bitmap handle to destroy");
             return;
         }
 
-        bmp_textures[(h & ~HANDLE_BITMAP) - 1].reset();
+        if (binding == bmp_textures[(real & ~HANDLE_BITMAP) - 1].get()) {
+            binding = nullptr;
+        }
+
+        bmp_textures[(real & ~HANDLE_BITMAP) - 1].reset();
     }
 
     void shared_graphics_driver::resize_bitmap(command_helper &helper) {
@@ -366,9 +428,17 @@ namespace eka2l1::drivers {
         std::unique_ptr<graphics_object> obj_casted = std::move(obj);
         drivers::handle res = append_graphics_object(obj_casted);
 
+        drivers::handle reserved = 0;
         drivers::handle *store = nullptr;
+
+        helper.pop(reserved);
         helper.pop(store);
 
+        if (reserved) {
+            bind_reserved_handle(reserved, res);
+            return;
+        }
+
         *store = res;
 
         helper.finish(this, 0);
@@ -428,8 +498,6 @@ namespace eka2l1::drivers {
         }
 
         shobj->set(this, binding, var_type, data);
-
-        delete data;
     }
 
     void shared_graphics_driver::set_swizzle(command_helper &helper) {
@@ -522,8 +590,6 @@ namespace eka2l1::drivers {
         }
 
         bufobj->update_data(this, data, offset, size);
-
-        delete data;
     }
 
     void shared_graphics_driver::attach_descriptors(drivers::handle h, const int stride, const bool instance_move,
@@ -551,8 +617,6 @@ namespace eka2l1::drivers {
         helper.pop(descriptor_count);
 
         attach_descriptors(h, stride, instance_move, descriptors, descriptor_count);
-
-        delete descriptors;
     }
 
     void shared_graphics_driver::destroy_object(command_helper &helper) {
@@ -560,6 +624,7 @@ namespace eka2l1::drivers {
         helper.pop(h);
 
         delete_graphics_object(h);
+        unbind_reserved_handle(h);
     }
 
     void shared_graphics_driver::set_filter(command_helper &helper) {
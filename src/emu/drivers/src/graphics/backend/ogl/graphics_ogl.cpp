@@ -17,6 +17,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/algorithm.h>
 #include <common/log.h>
 #include <fstream>
 #include <sstream>
@@ -30,6 +31,8 @@
 namespace eka2l1::drivers {
     ogl_graphics_driver::ogl_graphics_driver()
         : shared_graphics_driver(graphic_api::opengl)
+        , batch_ibo(0)
+        , batch_ibo_quad_count(0)
         , should_stop(false) {
         init_graphics_library(eka2l1::drivers::graphic_api::opengl);
         list_queue.max_pending_count_ = 128;
@@ -76,6 +79,8 @@ namespace eka2l1::drivers {
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
+        glGenBuffers(1, &batch_ibo);
+
         color_loc = sprite_program->get_uniform_location("u_color").value_or(-1);
         proj_loc = sprite_program->get_uniform_location("u_proj").value_or(-1);
         model_loc = sprite_program->get_uniform_location("u_model").value_or(-1);
@@ -319,6 +324,114 @@ namespace eka2l1::drivers {
         glBindVertexArray(0);
     }
 
+    // Vertex index is 16-bit, four vertices per quad
+    static constexpr std::uint32_t MAX_QUAD_PER_BATCH = 0x10000 / 4;
+
+    void ogl_graphics_driver::draw_bitmap_batch(command_helper &helper) {
+        if (!sprite_program) {
+            do_init();
+        }
+
+        drivers::handle to_draw = 0;
+        eka2l1::rect *rects = nullptr;
+        std::uint32_t count = 0;
+        std::uint32_t flags = 0;
+
+        helper.pop(to_draw);
+        helper.pop(rects);
+        helper.pop(count);
+        helper.pop(flags);
+
+        bitmap *bmp = get_bitmap(to_draw);
+
+        if (!bmp) {
+            LOG_ERROR("Invalid bitmap handle to draw");
+            return;
+        }
+
+        if (batch_ibo_quad_count < common::min(count, MAX_QUAD_PER_BATCH)) {
+            // Same winding as the single sprite, repeated for every quad
+            batch_ibo_quad_count = common::min<std::size_t>(common::max<std::size_t>(count, batch_ibo_quad_count * 2),
+                MAX_QUAD_PER_BATCH);
+
+            std::vector<GLushort> indices(batch_ibo_quad_count * 6);
+
+            for (std::size_t i = 0; i < batch_ibo_quad_count; i++) {
+                const GLushort base = static_cast<GLushort>(i * 4);
+                const GLushort quad[] = { base, static_cast<GLushort>(base + 1), static_cast<GLushort>(base + 2),
+                    base, static_cast<GLushort>(base + 3), static_cast<GLushort>(base + 1) };
+
+                std::copy(quad, quad + 6, indices.begin() + i * 6);
+            }
+
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch_ibo);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+
+        const float texel_width = 1.0f / bmp->tex->get_size().x;
+        const float texel_height = 1.0f / bmp->tex->get_size().y;
+
+        // Vertices are in target pixels already, no model transform needed
+        batch_verts.resize(count * 16);
+
+        for (std::uint32_t i = 0; i < count; i++) {
+            const eka2l1::rect &dest_rect = rects[i * 2];
+            const eka2l1::rect &source_rect = rects[i * 2 + 1];
+
+            const GLfloat left = static_cast<GLfloat>(dest_rect.top.x);
+            const GLfloat top = static_cast<GLfloat>(dest_rect.top.y);
+            const GLfloat right = static_cast<GLfloat>(dest_rect.top.x + dest_rect.size.x);
+            const GLfloat bottom = static_cast<GLfloat>(dest_rect.top.y + dest_rect.size.y);
+
+            const GLfloat u0 = source_rect.top.x * texel_width;
+            const GLfloat v0 = source_rect.top.y * texel_height;
+            const GLfloat u1 = (source_rect.top.x + source_rect.size.x) * texel_width;
+            const GLfloat v1 = (source_rect.top.y + source_rect.size.y) * texel_height;
+
+            // Bottom left, top right, top left, bottom right
+            const GLfloat quad[] = {
+                left, bottom, u0, v1,
+                right, top, u1, v0,
+                left, top, u0, v0,
+                right, bottom, u1, v1
+            };
+
+            std::copy(quad, quad + 16, batch_verts.begin() + i * 16);
+        }
+
+        sprite_program->use(this);
+
+        glBindVertexArray(sprite_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, sprite_vbo);
+        glBufferData(GL_ARRAY_BUFFER, batch_verts.size() * sizeof(GLfloat), batch_verts.data(), GL_STREAM_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid *)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid *)(2 * sizeof(GLfloat)));
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(bmp->tex->texture_handle()));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        const glm::mat4 model_matrix = glm::identity<glm::mat4>();
+        glUniformMatrix4fv(model_loc, 1, false, glm::value_ptr(model_matrix));
+        glUniformMatrix4fv(proj_loc, 1, false, glm::value_ptr(projection_matrix));
+
+        const GLfloat color[] = { 255.0f, 255.0f, 255.0f, 255.0f };
+        glUniform4fv(color_loc, 1, (flags & bitmap_draw_flag_use_brush) ? brush_color.elements.data() : color);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch_ibo);
+
+        for (std::uint32_t drawn = 0; drawn < count; drawn += MAX_QUAD_PER_BATCH) {
+            const std::uint32_t to_draw_count = common::min(count - drawn, MAX_QUAD_PER_BATCH);
+            glDrawElementsBaseVertex(GL_TRIANGLES, to_draw_count * 6, GL_UNSIGNED_SHORT, nullptr, drawn * 4);
+        }
+
+        glBindVertexArray(0);
+    }
+
     void ogl_graphics_driver::set_invalidate(command_helper &helper) {
         bool enable = false;
         helper.pop(enable);
@@ -565,7 +678,7 @@ namespace eka2l1::drivers {
     }
 
     std::unique_ptr<graphics_command_list> ogl_graphics_driver::new_command_list() {
-        return std::make_unique<server_graphics_command_list>();
+        return std::make_unique<server_graphics_command_list>(arena_pool);
     }
 
     std::unique_ptr<graphics_command_list_builder> ogl_graphics_driver::new_command_builder(graphics_command_list *list) {
@@ -573,7 +686,8 @@ namespace eka2l1::drivers {
     }
 
     void ogl_graphics_driver::submit_command_list(graphics_command_list &command_list) {
-        list_queue.push(static_cast<server_graphics_command_list &>(command_list));
+        // The arena now belongs to the driver, it will be recycled once the commands are dispatched.
+        list_queue.push(static_cast<server_graphics_command_list &>(command_list).list_.detach());
     }
 
     void ogl_graphics_driver::display(command_helper &helper) {
@@ -655,6 +769,11 @@ namespace eka2l1::drivers {
             break;
         }
 
+        case graphics_driver_draw_bitmap_batch: {
+            draw_bitmap_batch(helper);
+            break;
+        }
+
         default:
             shared_graphics_driver::dispatch(cmd);
             break;
@@ -663,25 +782,22 @@ namespace eka2l1::drivers {
 
     void ogl_graphics_driver::run() {
         while (!should_stop) {
-            std::optional<server_graphics_command_list> list = list_queue.pop();
+            std::optional<command_list> list = list_queue.pop();
 
             if (!list) {
                 LOG_ERROR("Corrupted graphics command list! Emulation halt.");
                 break;
             }
 
-            command *cmd = list->list_.first_;
-            command *next = nullptr;
+            command *cmd = list->first_;
 
             while (cmd) {
                 dispatch(cmd);
-                next = cmd->next_;
-
-                // TODO: If any command list requires not rebuilding the buffer, dont delete the command.
-                // For now, not likely
-                delete cmd;
-                cmd = next;
+                cmd = cmd->next_;
             }
+
+            // All commands and their payloads live in the arena, give it back for the next frame
+            list->release();
         }
     }
 
@@ -0,0 +1,762 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/algorithm.h>
+#include <common/log.h>
+
+#include <drivers/graphics/backend/software/graphics_software.h>
+#include <drivers/graphics/buffer.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace eka2l1::drivers {
+    // Height of a band of rows given to a rasterizer thread
+    static constexpr int SOFTWARE_BAND_HEIGHT = 32;
+
+    // Below this many pixels, waking up other threads costs more than it saves
+    static constexpr std::int64_t SOFTWARE_PARALLEL_MIN_PIXELS = 1 << 15;
+
+    // Pixels sampled at once when a blit has to be scaled or clamped
+    static constexpr int SOFTWARE_GATHER_CHUNK = 256;
+
+    static constexpr int SOFTWARE_MAX_WORKER = 7;
+
+    static std::uint32_t to_rgba8(const eka2l1::vecx<float, 4> &color) {
+        std::uint32_t result = 0;
+
+        for (int i = 0; i < 4; i++) {
+            const float comp = common::clamp(0.0f, 255.0f, color[i]);
+            result |= static_cast<std::uint32_t>(comp + 0.5f) << (i * 8);
+        }
+
+        return result;
+    }
+
+    static bool intersect_rect(const eka2l1::rect &a, const eka2l1::rect &b, eka2l1::rect &result) {
+        const int left = common::max(a.top.x, b.top.x);
+        const int top = common::max(a.top.y, b.top.y);
+        const int right = common::min(a.top.x + a.size.x, b.top.x + b.size.x);
+        const int bottom = common::min(a.top.y + a.size.y, b.top.y + b.size.y);
+
+        if ((left >= right) || (top >= bottom)) {
+            return false;
+        }
+
+        result = eka2l1::rect(eka2l1::vec2(left, top), eka2l1::vec2(right - left, bottom - top));
+        return true;
+    }
+
+    software_graphics_driver::software_graphics_driver(const int worker_count)
+        : shared_graphics_driver(graphic_api::software)
+        , should_stop(false)
+        , presented_count(0) {
+        list_queue.max_pending_count_ = 128;
+
+        int total_worker = worker_count;
+
+        if (total_worker < 0) {
+            total_worker = common::clamp(0, SOFTWARE_MAX_WORKER, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+        }
+
+        raster_pool = std::make_unique<software_raster_pool>(total_worker);
+    }
+
+    software_graphics_driver::~software_graphics_driver() {
+        // Bitmaps hold pointers to our textures, let them go while we are still alive
+        bmp_textures.clear();
+        graphic_objects.clear();
+    }
+
+    software_texture *software_graphics_driver::get_render_target() {
+        if (binding) {
+            return reinterpret_cast<software_texture *>(binding->tex.get());
+        }
+
+        return swapchain_tex.get();
+    }
+
+    software_texture *software_graphics_driver::get_sample_texture(drivers::handle h) {
+        if (h & HANDLE_BITMAP) {
+            bitmap *bmp = get_bitmap(h);
+            return bmp ? reinterpret_cast<software_texture *>(bmp->tex.get()) : nullptr;
+        }
+
+        // Only textures can be created as objects on this backend
+        return reinterpret_cast<software_texture *>(get_graphics_object(h));
+    }
+
+    void software_graphics_driver::bind_swapchain_framebuf() {
+        // Nothing to do, the swapchain texture is picked when there is no bitmap binded
+    }
+
+    void software_graphics_driver::set_viewport(const eka2l1::rect &viewport) {
+        state.viewport = viewport;
+    }
+
+    void software_graphics_driver::attach_descriptors(drivers::handle h, const int stride, const bool instance_move,
+        const attribute_descriptor *descriptors, const int descriptor_count) {
+        // No vertex buffer on this backend
+    }
+
+    eka2l1::rect software_graphics_driver::map_to_viewport(const eka2l1::rect &r) const {
+        const eka2l1::rect &vp = state.viewport;
+
+        if (vp.empty() || (projection_size.x <= 0) || (projection_size.y <= 0)) {
+            return r;
+        }
+
+        if ((vp.top == eka2l1::vec2(0, 0)) && (vp.size == projection_size)) {
+            return r;
+        }
+
+        const std::int64_t left = vp.top.x + static_cast<std::int64_t>(r.top.x) * vp.size.x / projection_size.x;
+        const std::int64_t top = vp.top.y + static_cast<std::int64_t>(r.top.y) * vp.size.y / projection_size.y;
+        const std::int64_t right = vp.top.x + static_cast<std::int64_t>(r.top.x + r.size.x) * vp.size.x / projection_size.x;
+        const std::int64_t bottom = vp.top.y + static_cast<std::int64_t>(r.top.y + r.size.y) * vp.size.y / projection_size.y;
+
+        return eka2l1::rect(eka2l1::vec2(static_cast<int>(left), static_cast<int>(top)),
+            eka2l1::vec2(static_cast<int>(right - left), static_cast<int>(bottom - top)));
+    }
+
+    bool software_graphics_driver::get_clip_rect(const eka2l1::rect &dest, eka2l1::rect &clip) {
+        software_texture *target = get_render_target();
+
+        if (!target) {
+            return false;
+        }
+
+        if (!intersect_rect(dest, eka2l1::rect(eka2l1::vec2(0, 0), target->get_size()), clip)) {
+            return false;
+        }
+
+        if (state.scissor_enable && !intersect_rect(clip, state.scissor, clip)) {
+            return false;
+        }
+
+        return true;
+    }
+
+    void software_graphics_driver::clear(command_helper &helper) {
+        std::uint32_t color_to_clear = 0;
+        std::uint8_t clear_bits = 0;
+
+        helper.pop(color_to_clear);
+        helper.pop(clear_bits);
+
+        if (!(clear_bits & clear_bit_color_buffer)) {
+            return;
+        }
+
+        software_draw_op op{};
+        op.kind = software_draw_op_clear;
+
+        // Same channel order as the GL backend
+        op.color = ((color_to_clear >> 24) & 0xFF) | (((color_to_clear >> 16) & 0xFF) << 8)
+            | (((color_to_clear >> 8) & 0xFF) << 16) | ((color_to_clear & 0xFF) << 24);
+
+        // Clear is only limited by the scissor, not the viewport
+        software_texture *target = get_render_target();
+
+        if (!target) {
+            return;
+        }
+
+        op.dest = eka2l1::rect(eka2l1::vec2(0, 0), target->get_size());
+
+        if (!get_clip_rect(op.dest, op.clip)) {
+            return;
+        }
+
+        pending_ops.push_back(op);
+    }
+
+    void software_graphics_driver::draw_rectangle(command_helper &helper) {
+        eka2l1::rect fill_rect;
+        helper.pop(fill_rect);
+
+        software_draw_op op{};
+        op.kind = software_draw_op_fill;
+        op.dest = map_to_viewport(fill_rect);
+        op.color = to_rgba8(brush_color);
+        op.blend = state.blend;
+
+        if (!get_clip_rect(op.dest, op.clip)) {
+            return;
+        }
+
+        if (!state.viewport.empty() && !intersect_rect(op.clip, state.viewport, op.clip)) {
+            return;
+        }
+
+        pending_ops.push_back(op);
+    }
+
+    void software_graphics_driver::draw_bitmap(command_helper &helper) {
+        drivers::handle to_draw = 0;
+        drivers::handle mask_to_use = 0;
+        eka2l1::rect dest_rect;
+        eka2l1::rect source_rect;
+        std::uint32_t flags = 0;
+
+        helper.pop(to_draw);
+        helper.pop(mask_to_use);
+        helper.pop(dest_rect);
+        helper.pop(source_rect);
+        helper.pop(flags);
+
+        software_texture *source = get_sample_texture(to_draw);
+
+        if (!source) {
+            LOG_ERROR("Invalid bitmap handle to draw");
+            return;
+        }
+
+        software_texture *mask = nullptr;
+
+        if (mask_to_use) {
+            mask = get_sample_texture(mask_to_use);
+
+            if (!mask) {
+                LOG_ERROR("Mask handle was provided but invalid!");
+                return;
+            }
+        }
+
+        record_blit(source, mask, dest_rect, source_rect, flags);
+    }
+
+    void software_graphics_driver::draw_bitmap_batch(command_helper &helper) {
+        drivers::handle to_draw = 0;
+        eka2l1::rect *rects = nullptr;
+        std::uint32_t count = 0;
+        std::uint32_t flags = 0;
+
+        helper.pop(to_draw);
+        helper.pop(rects);
+        helper.pop(count);
+        helper.pop(flags);
+
+        software_texture *source = get_sample_texture(to_draw);
+
+        if (!source) {
+            LOG_ERROR("Invalid bitmap handle to draw");
+            return;
+        }
+
+        for (std::uint32_t i = 0; i < count; i++) {
+            record_blit(source, nullptr, rects[i * 2], rects[i * 2 + 1], flags);
+        }
+    }
+
+    void software_graphics_driver::record_blit(software_texture *source, software_texture *mask, eka2l1::rect dest_rect,
+        eka2l1::rect source_rect, const std::uint32_t flags) {
+        if (source_rect.empty()) {
+            source_rect = eka2l1::rect(eka2l1::vec2(0, 0), source->get_size());
+        }
+
+        if (source_rect.size.x == 0) {
+            source_rect.size.x = source->get_size().x;
+        }
+
+        if (source_rect.size.y == 0) {
+            source_rect.size.y = source->get_size().y;
+        }
+
+        if (dest_rect.size.x == 0) {
+            dest_rect.size.x = source_rect.size.x;
+        }
+
+        if (dest_rect.size.y == 0) {
+            dest_rect.size.y = source_rect.size.y;
+        }
+
+        if ((source_rect.size.x <= 0) || (source_rect.size.y <= 0) || (source->get_size().x <= 0) || (source->get_size().y <= 0)) {
+            return;
+        }
+
+        software_draw_op op{};
+        op.kind = software_draw_op_blit;
+        op.dest = map_to_viewport(dest_rect);
+        op.color = (flags & bitmap_draw_flag_use_brush) ? to_rgba8(brush_color) : 0xFFFFFFFF;
+        op.invert_mask = (flags & bitmap_draw_flag_invert_mask);
+        op.blend = state.blend;
+        op.source_size = source->get_size();
+        op.source_rect = source_rect;
+
+        if ((op.dest.size.x <= 0) || (op.dest.size.y <= 0) || !get_clip_rect(op.dest, op.clip)) {
+            return;
+        }
+
+        if (!state.viewport.empty() && !intersect_rect(op.clip, state.viewport, op.clip)) {
+            return;
+        }
+
+        software_texture *target = get_render_target();
+        const bool read_from_target = (source == target) || (mask == target);
+
+        if (read_from_target) {
+            // Pending draws must land first, and bands must not read what other bands are writing
+            flush();
+        }
+
+        op.source = source->get_sample_pixels();
+
+        if (mask) {
+            op.mask = mask->get_sample_pixels();
+            op.mask_size = mask->get_size();
+        }
+
+        if (read_from_target) {
+            const std::size_t total = static_cast<std::size_t>(target->get_size().x) * target->get_size().y;
+            self_copy.assign(target->get_render_pixels(), target->get_render_pixels() + total);
+
+            if (source == target) {
+                op.source = self_copy.data();
+            }
+
+            if (mask == target) {
+                op.mask = self_copy.data();
+            }
+
+            pending_ops.push_back(op);
+            flush();
+
+            return;
+        }
+
+        pending_ops.push_back(op);
+    }
+
+    static void gather_row(std::uint32_t *dest, const std::uint32_t *row, const int row_width, std::int64_t fx,
+        const std::int64_t step, const int count) {
+        const std::int64_t max_x = row_width - 1;
+
+        for (int i = 0; i < count; i++, fx += step) {
+            dest[i] = row[common::clamp<std::int64_t>(0, max_x, fx >> 16)];
+        }
+    }
+
+    static void rasterize_blit_row(const software_draw_op &op, std::uint32_t *dest, const int y, const int left, const int right) {
+        const std::int64_t step_x = (static_cast<std::int64_t>(op.source_rect.size.x) << 16) / op.dest.size.x;
+        const std::int64_t step_y = (static_cast<std::int64_t>(op.source_rect.size.y) << 16) / op.dest.size.y;
+
+        // Sample at the center of the destination pixel, same as GL with nearest filtering
+        const std::int64_t fx = (static_cast<std::int64_t>(op.source_rect.top.x) << 16) + step_x / 2 + (left - op.dest.top.x) * step_x;
+        const std::int64_t fy = (static_cast<std::int64_t>(op.source_rect.top.y) << 16) + step_y / 2 + (y - op.dest.top.y) * step_y;
+
+        const int sy = static_cast<int>(common::clamp<std::int64_t>(0, op.source_size.y - 1, fy >> 16));
+        const std::uint32_t *source_row = op.source + static_cast<std::size_t>(sy) * op.source_size.x;
+
+        const bool same_size_mask = op.mask && (op.mask_size == op.source_size);
+        const std::uint32_t *mask_row = nullptr;
+
+        std::int64_t mask_fx = fx;
+        std::int64_t mask_step_x = step_x;
+
+        if (op.mask) {
+            int my = sy;
+
+            if (!same_size_mask) {
+                // Mask is sampled with the same normalized coordinates as the source
+                my = static_cast<int>(common::clamp<std::int64_t>(0, op.mask_size.y - 1, (fy * op.mask_size.y / op.source_size.y) >> 16));
+                mask_fx = fx * op.mask_size.x / op.source_size.x;
+                mask_step_x = step_x * op.mask_size.x / op.source_size.x;
+            }
+
+            mask_row = op.mask + static_cast<std::size_t>(my) * op.mask_size.x;
+        }
+
+        const int count = right - left;
+        const int sx = static_cast<int>(fx >> 16);
+
+        // Unscaled and inside the texture: no need to sample one by one
+        if ((step_x == (1 << 16)) && (sx >= 0) && (sx + count <= op.source_size.x) && (!op.mask || same_size_mask)) {
+            software_shade_span(dest + left, source_row + sx, mask_row ? mask_row + sx : nullptr, count, op.color,
+                op.invert_mask, op.blend);
+
+            return;
+        }
+
+        std::uint32_t source_buf[SOFTWARE_GATHER_CHUNK];
+        std::uint32_t mask_buf[SOFTWARE_GATHER_CHUNK];
+
+        for (int done = 0; done < count; done += SOFTWARE_GATHER_CHUNK) {
+            const int chunk = common::min(SOFTWARE_GATHER_CHUNK, count - done);
+            gather_row(source_buf, source_row, op.source_size.x, fx + done * step_x, step_x, chunk);
+
+            if (mask_row) {
+                gather_row(mask_buf, mask_row, op.mask_size.x, mask_fx + done * mask_step_x, mask_step_x, chunk);
+            }
+
+            software_shade_span(dest + left + done, source_buf, mask_row ? mask_buf : nullptr, chunk, op.color,
+                op.invert_mask, op.blend);
+        }
+    }
+
+    void software_graphics_driver::rasterize_band(software_texture *target, const int band_start, const int band_end) {
+        std::uint32_t *pixels = target->get_render_pixels();
+        const int stride = target->get_size().x;
+
+        for (const software_draw_op &op : pending_ops) {
+            const int top = common::max(op.clip.top.y, band_start);
+            const int bottom = common::min(op.clip.top.y + op.clip.size.y, band_end);
+            const int left = op.clip.top.x;
+            const int right = op.clip.top.x + op.clip.size.x;
+
+            for (int y = top; y < bottom; y++) {
+                std::uint32_t *row = pixels + static_cast<std::size_t>(y) * stride;
+
+                switch (op.kind) {
+                case software_draw_op_clear:
+                    software_fill_span(row + left, right - left, op.color);
+                    break;
+
+                case software_draw_op_fill:
+                    software_shade_span(row + left, nullptr, nullptr, right - left, op.color, false, op.blend);
+                    break;
+
+                case software_draw_op_blit:
+                    rasterize_blit_row(op, row, y, left, right);
+                    break;
+
+                default:
+                    break;
+                }
+            }
+        }
+    }
+
+    void software_graphics_driver::flush() {
+        if (pending_ops.empty()) {
+            return;
+        }
+
+        software_texture *target = get_render_target();
+
+        if (!target) {
+            pending_ops.clear();
+            return;
+        }
+
+        const int height = target->get_size().y;
+        std::int64_t total_pixels = 0;
+
+        for (const software_draw_op &op : pending_ops) {
+            total_pixels += static_cast<std::int64_t>(op.clip.size.x) * op.clip.size.y;
+        }
+
+        if ((total_pixels < SOFTWARE_PARALLEL_MIN_PIXELS) || (raster_pool->worker_count() == 0)) {
+            rasterize_band(target, 0, height);
+        } else {
+            const int band_count = (height + SOFTWARE_BAND_HEIGHT - 1) / SOFTWARE_BAND_HEIGHT;
+
+            raster_pool->run(band_count, [&](const int band) {
+                rasterize_band(target, band * SOFTWARE_BAND_HEIGHT, common::min(height, (band + 1) * SOFTWARE_BAND_HEIGHT));
+            });
+        }
+
+        target->mark_dirty();
+        pending_ops.clear();
+    }
+
+    void software_graphics_driver::set_invalidate(command_helper &helper) {
+        bool enable = false;
+        helper.pop(enable);
+
+        state.scissor_enable = enable;
+    }
+
+    void software_graphics_driver::invalidate_rect(command_helper &helper) {
+        eka2l1::rect inv_rect;
+        helper.pop(inv_rect);
+
+        state.scissor = inv_rect;
+    }
+
+    void software_graphics_driver::set_viewport(command_helper &helper) {
+        eka2l1::rect viewport;
+        helper.pop(viewport);
+
+        set_viewport(viewport);
+    }
+
+    void software_graphics_driver::set_blend(command_helper &helper) {
+        bool enable = true;
+        helper.pop(enable);
+
+        state.blend.enable = enable;
+    }
+
+    void software_graphics_driver::blend_formula(command_helper &helper) {
+        helper.pop(state.blend.rgb_equation);
+        helper.pop(state.blend.a_equation);
+        helper.pop(state.blend.rgb_frag_out_factor);
+        helper.pop(state.blend.rgb_current_factor);
+        helper.pop(state.blend.a_frag_out_factor);
+        helper.pop(state.blend.a_current_factor);
+    }
+
+    void software_graphics_driver::set_swapchain_size(command_helper &helper) {
+        shared_graphics_driver::set_swapchain_size(helper);
+        projection_size = swapchain_size;
+
+        if (!swapchain_tex) {
+            swapchain_tex = std::make_unique<software_texture>();
+            swapchain_tex->create(this, 2, 0, eka2l1::vec3(swapchain_size.x, swapchain_size.y, 0), texture_format::rgba,
+                texture_format::rgba, texture_data_type::ubyte, nullptr);
+
+            return;
+        }
+
+        swapchain_tex->change_size(eka2l1::vec3(swapchain_size.x, swapchain_size.y, 0));
+        swapchain_tex->tex(this, false);
+    }
+
+    void software_graphics_driver::bind_bitmap(command_helper &helper) {
+        shared_graphics_driver::bind_bitmap(helper);
+
+        if (binding) {
+            projection_size = binding->tex->get_size();
+        }
+    }
+
+    void software_graphics_driver::create_program_unsupported(command_helper &helper) {
+        char *vert_data = nullptr;
+        char *frag_data = nullptr;
+        std::size_t vert_size = 0;
+        std::size_t frag_size = 0;
+        void **metadata = nullptr;
+        drivers::handle *store = nullptr;
+
+        helper.pop(vert_data);
+        helper.pop(frag_data);
+        helper.pop(vert_size);
+        helper.pop(frag_size);
+        helper.pop(metadata);
+        helper.pop(store);
+
+        LOG_ERROR("Shader programs are not supported by the software graphics driver");
+
+        *store = 0;
+        helper.finish(this, -1);
+    }
+
+    void software_graphics_driver::create_buffer_unsupported(command_helper &helper) {
+        std::size_t initial_size = 0;
+        buffer_hint hint = buffer_hint::none;
+        buffer_upload_hint upload_hint = static_cast<buffer_upload_hint>(0);
+        drivers::handle *store = nullptr;
+
+        helper.pop(initial_size);
+        helper.pop(hint);
+        helper.pop(upload_hint);
+        helper.pop(store);
+
+        LOG_ERROR("Buffers are not supported by the software graphics driver");
+
+        *store = 0;
+        helper.finish(this, -1);
+    }
+
+    void software_graphics_driver::display(command_helper &helper) {
+        if (swapchain_tex) {
+            const std::lock_guard<std::mutex> guard(present_lock);
+            const eka2l1::vec2 size = swapchain_tex->get_size();
+
+            presented_frame.assign(swapchain_tex->get_render_pixels(), swapchain_tex->get_render_pixels() + size.x * size.y);
+            presented_size = size;
+            presented_count++;
+        }
+
+        if (disp_hook_) {
+            disp_hook_();
+        }
+
+        helper.finish(this, 0);
+    }
+
+    std::uint32_t software_graphics_driver::dump_presented_frame(std::vector<std::uint32_t> &pixels, eka2l1::vec2 &size) {
+        const std::lock_guard<std::mutex> guard(present_lock);
+
+        pixels = presented_frame;
+        size = presented_size;
+
+        return presented_count;
+    }
+
+    std::unique_ptr<graphics_command_list> software_graphics_driver::new_command_list() {
+        return std::make_unique<server_graphics_command_list>(arena_pool);
+    }
+
+    std::unique_ptr<graphics_command_list_builder> software_graphics_driver::new_command_builder(graphics_command_list *list) {
+        return std::make_unique<server_graphics_command_list_builder>(list);
+    }
+
+    void software_graphics_driver::submit_command_list(graphics_command_list &command_list) {
+        list_queue.push(static_cast<server_graphics_command_list &>(command_list).list_.detach());
+    }
+
+    static bool is_recorded_opcode(const std::uint16_t opcode) {
+        switch (opcode) {
+        case graphics_driver_clear:
+        case graphics_driver_draw_bitmap:
+        case graphics_driver_draw_bitmap_batch:
+        case graphics_driver_draw_rectangle:
+        case graphics_driver_set_brush_color:
+        case graphics_driver_set_invalidate:
+        case graphics_driver_invalidate_rect:
+        case graphics_driver_set_viewport:
+        case graphics_driver_set_blend:
+        case graphics_driver_blend_formula:
+        case graphics_driver_set_depth:
+        case graphics_driver_set_cull:
+        case graphics_driver_set_back_face_rule:
+        case graphics_driver_backup_state:
+        case graphics_driver_restore_state:
+            return true;
+
+        default:
+            break;
+        }
+
+        return false;
+    }
+
+    void software_graphics_driver::dispatch(command *cmd) {
+        // Draws and states are captured, anything else may read or change what they touch
+        if (!is_recorded_opcode(cmd->opcode_)) {
+            flush();
+        }
+
+        command_helper helper(cmd);
+
+        switch (cmd->opcode_) {
+        case graphics_driver_clear:
+            clear(helper);
+            break;
+
+        case graphics_driver_draw_bitmap:
+            draw_bitmap(helper);
+            break;
+
+        case graphics_driver_draw_bitmap_batch:
+            draw_bitmap_batch(helper);
+            break;
+
+        case graphics_driver_draw_rectangle:
+            draw_rectangle(helper);
+            break;
+
+        case graphics_driver_set_invalidate:
+            set_invalidate(helper);
+            break;
+
+        case graphics_driver_invalidate_rect:
+            invalidate_rect(helper);
+            break;
+
+        case graphics_driver_set_viewport:
+            set_viewport(helper);
+            break;
+
+        case graphics_driver_set_blend:
+            set_blend(helper);
+            break;
+
+        case graphics_driver_blend_formula:
+            blend_formula(helper);
+            break;
+
+        case graphics_driver_backup_state:
+            backup = state;
+            break;
+
+        case graphics_driver_restore_state:
+            state = backup;
+            break;
+
+        case graphics_driver_set_swapchain_size:
+            set_swapchain_size(helper);
+            break;
+
+        case graphics_driver_bind_bitmap:
+            bind_bitmap(helper);
+            break;
+
+        case graphics_driver_display:
+            display(helper);
+            break;
+
+        case graphics_driver_create_program:
+            create_program_unsupported(helper);
+            break;
+
+        case graphics_driver_create_buffer:
+            create_buffer_unsupported(helper);
+            break;
+
+        // No depth, culling, programs or vertex data on this backend
+        case graphics_driver_set_depth:
+        case graphics_driver_set_cull:
+        case graphics_driver_set_back_face_rule:
+        case graphics_driver_draw_indexed:
+        case graphics_driver_use_program:
+        case graphics_driver_set_uniform:
+        case graphics_driver_bind_buffer:
+        case graphics_driver_update_buffer:
+        case graphics_driver_attach_descriptors:
+            break;
+
+        default:
+            shared_graphics_driver::dispatch(cmd);
+            break;
+        }
+    }
+
+    void software_graphics_driver::run() {
+        while (!should_stop) {
+            std::optional<command_list> list = list_queue.pop();
+
+            if (!list) {
+                // Abort wakes us up with nothing, that is not an error
+                if (!should_stop) {
+                    LOG_ERROR("Corrupted graphics command list! Emulation halt.");
+                }
+
+                break;
+            }
+
+            command *cmd = list->first_;
+
+            while (cmd) {
+                dispatch(cmd);
+                cmd = cmd->next_;
+            }
+
+            list->release();
+        }
+    }
+
+    void software_graphics_driver::abort() {
+        should_stop = true;
+        list_queue.abort();
+    }
+}
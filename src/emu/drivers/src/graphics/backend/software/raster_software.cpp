@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/platform.h>
+#include <drivers/graphics/backend/software/raster_software.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if EKA2L1_ARCH(X86) || EKA2L1_ARCH(X64)
+#include <emmintrin.h>
+#define EKA2L1_SOFTWARE_RASTER_SSE2 1
+#endif
+
+namespace eka2l1::drivers {
+    // Exact (a * b) / 255 with rounding, for values in range [0, 255]
+    static inline std::uint32_t mul_255(const std::uint32_t a, const std::uint32_t b) {
+        const std::uint32_t t = a * b + 128;
+        return (t + (t >> 8)) >> 8;
+    }
+
+    static inline std::uint32_t mul_255_pixel(const std::uint32_t a, const std::uint32_t b) {
+        return mul_255(a & 0xFF, b & 0xFF) | (mul_255((a >> 8) & 0xFF, (b >> 8) & 0xFF) << 8)
+            | (mul_255((a >> 16) & 0xFF, (b >> 16) & 0xFF) << 16) | (mul_255(a >> 24, b >> 24) << 24);
+    }
+
+    static inline std::uint32_t blend_factor_value(const blend_factor factor, const std::uint32_t frag_alpha, const std::uint32_t current_alpha) {
+        switch (factor) {
+        case blend_factor::one:
+            return 255;
+
+        case blend_factor::frag_out_alpha:
+            return frag_alpha;
+
+        case blend_factor::one_minus_frag_out_alpha:
+            return 255 - frag_alpha;
+
+        case blend_factor::current_alpha:
+            return current_alpha;
+
+        case blend_factor::one_minus_current_alpha:
+            return 255 - current_alpha;
+
+        default:
+            break;
+        }
+
+        return 0;
+    }
+
+    static inline std::uint32_t blend_equation_value(const blend_equation eq, const std::uint32_t frag, const std::uint32_t current) {
+        switch (eq) {
+        case blend_equation::sub:
+            return (frag > current) ? (frag - current) : 0;
+
+        case blend_equation::isub:
+            return (current > frag) ? (current - frag) : 0;
+
+        default:
+            break;
+        }
+
+        return std::min<std::uint32_t>(frag + current, 255);
+    }
+
+    static std::uint32_t blend_pixel(const std::uint32_t frag, const std::uint32_t current, const software_blend_state &blend) {
+        const std::uint32_t frag_alpha = frag >> 24;
+        const std::uint32_t current_alpha = current >> 24;
+
+        const std::uint32_t rgb_frag_factor = blend_factor_value(blend.rgb_frag_out_factor, frag_alpha, current_alpha);
+        const std::uint32_t rgb_current_factor = blend_factor_value(blend.rgb_current_factor, frag_alpha, current_alpha);
+
+        std::uint32_t result = 0;
+
+        for (int i = 0; i < 24; i += 8) {
+            result |= blend_equation_value(blend.rgb_equation, mul_255((frag >> i) & 0xFF, rgb_frag_factor),
+                          mul_255((current >> i) & 0xFF, rgb_current_factor))
+                << i;
+        }
+
+        const std::uint32_t a = blend_equation_value(blend.a_equation,
+            mul_255(frag_alpha, blend_factor_value(blend.a_frag_out_factor, frag_alpha, current_alpha)),
+            mul_255(current_alpha, blend_factor_value(blend.a_current_factor, frag_alpha, current_alpha)));
+
+        return result | (a << 24);
+    }
+
+    static inline std::uint32_t shade_pixel(const std::uint32_t current, const std::uint32_t *source, const std::uint32_t *mask,
+        const std::uint32_t color, const std::uint32_t invert_bits, const software_blend_state &blend) {
+        std::uint32_t frag = source ? mul_255_pixel(*source, color) : color;
+
+        if (mask) {
+            frag = mul_255_pixel(frag, *mask ^ invert_bits);
+        }
+
+        return blend.enable ? blend_pixel(frag, current, blend) : frag;
+    }
+
+#if EKA2L1_SOFTWARE_RASTER_SSE2
+    // Two pixels per register, one channel per 16-bit lane
+    static inline __m128i mul_255_epi16(const __m128i a, const __m128i b) {
+        const __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+
+    static inline __m128i broadcast_alpha_epi16(const __m128i v) {
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    }
+
+    static inline __m128i blend_factor_epi16(const blend_factor factor, const __m128i frag_alpha, const __m128i current_alpha) {
+        const __m128i full = _mm_set1_epi16(255);
+
+        switch (factor) {
+        case blend_factor::one:
+            return full;
+
+        case blend_factor::frag_out_alpha:
+            return frag_alpha;
+
+        case blend_factor::one_minus_frag_out_alpha:
+            return _mm_sub_epi16(full, frag_alpha);
+
+        case blend_factor::current_alpha:
+            return current_alpha;
+
+        case blend_factor::one_minus_current_alpha:
+            return _mm_sub_epi16(full, current_alpha);
+
+        default:
+            break;
+        }
+
+        return _mm_setzero_si128();
+    }
+
+    static inline __m128i blend_equation_epi16(const blend_equation eq, const __m128i frag, const __m128i current) {
+        switch (eq) {
+        case blend_equation::sub:
+            return _mm_subs_epu16(frag, current);
+
+        case blend_equation::isub:
+            return _mm_subs_epu16(current, frag);
+
+        default:
+            break;
+        }
+
+        // Saturated to 255 when packed
+        return _mm_add_epi16(frag, current);
+    }
+
+    static inline __m128i select_epi16(const __m128i lane_mask, const __m128i if_set, const __m128i if_clear) {
+        return _mm_or_si128(_mm_and_si128(lane_mask, if_set), _mm_andnot_si128(lane_mask, if_clear));
+    }
+
+    static inline __m128i blend_epi16(const __m128i frag, const __m128i current, const software_blend_state &blend,
+        const __m128i alpha_lanes) {
+        const __m128i frag_alpha = broadcast_alpha_epi16(frag);
+        const __m128i current_alpha = broadcast_alpha_epi16(current);
+
+        const __m128i frag_factor = select_epi16(alpha_lanes, blend_factor_epi16(blend.a_frag_out_factor, frag_alpha, current_alpha),
+            blend_factor_epi16(blend.rgb_frag_out_factor, frag_alpha, current_alpha));
+
+        const __m128i current_factor = select_epi16(alpha_lanes, blend_factor_epi16(blend.a_current_factor, frag_alpha, current_alpha),
+            blend_factor_epi16(blend.rgb_current_factor, frag_alpha, current_alpha));
+
+        const __m128i frag_mul = mul_255_epi16(frag, frag_factor);
+        const __m128i current_mul = mul_255_epi16(current, current_factor);
+
+        if (blend.rgb_equation == blend.a_equation) {
+            return blend_equation_epi16(blend.rgb_equation, frag_mul, current_mul);
+        }
+
+        return select_epi16(alpha_lanes, blend_equation_epi16(blend.a_equation, frag_mul, current_mul),
+            blend_equation_epi16(blend.rgb_equation, frag_mul, current_mul));
+    }
+#endif
+
+    void software_fill_span(std::uint32_t *dest, const int count, const std::uint32_t color) {
+        std::fill_n(dest, count, color);
+    }
+
+    void software_shade_span(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t *mask, const int count,
+        const std::uint32_t color, const bool invert, const software_blend_state &blend) {
+        if (count <= 0) {
+            return;
+        }
+
+        // Straight copies and fills are the most common, let them go fast
+        if (!mask && !blend.enable) {
+            if (!source) {
+                software_fill_span(dest, count, color);
+                return;
+            }
+
+            if (color == 0xFFFFFFFF) {
+                std::memmove(dest, source, count * sizeof(std::uint32_t));
+                return;
+            }
+        }
+
+        const std::uint32_t invert_bits = invert ? 0xFFFFFFFF : 0;
+        int i = 0;
+
+#if EKA2L1_SOFTWARE_RASTER_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i color_v = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color)), zero);
+        const __m128i invert_v = _mm_set1_epi32(static_cast<int>(invert_bits));
+        const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+        const bool color_is_white = (color == 0xFFFFFFFF);
+
+        for (; i + 4 <= count; i += 4) {
+            __m128i frag_lo = color_v;
+            __m128i frag_hi = color_v;
+
+            if (source) {
+                const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+                frag_lo = _mm_unpacklo_epi8(s, zero);
+                frag_hi = _mm_unpackhi_epi8(s, zero);
+
+                if (!color_is_white) {
+                    frag_lo = mul_255_epi16(frag_lo, color_v);
+                    frag_hi = mul_255_epi16(frag_hi, color_v);
+                }
+            }
+
+            if (mask) {
+                const __m128i m = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + i)), invert_v);
+                frag_lo = mul_255_epi16(frag_lo, _mm_unpacklo_epi8(m, zero));
+                frag_hi = mul_255_epi16(frag_hi, _mm_unpackhi_epi8(m, zero));
+            }
+
+            if (blend.enable) {
+                const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dest + i));
+                frag_lo = blend_epi16(frag_lo, _mm_unpacklo_epi8(d, zero), blend, alpha_lanes);
+                frag_hi = blend_epi16(frag_hi, _mm_unpackhi_epi8(d, zero), blend, alpha_lanes);
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_packus_epi16(frag_lo, frag_hi));
+        }
+#endif
+
+        for (; i < count; i++) {
+            dest[i] = shade_pixel(dest[i], source ? source + i : nullptr, mask ? mask + i : nullptr, color, invert_bits, blend);
+        }
+    }
+
+    software_raster_pool::software_raster_pool(const int worker_count)
+        : next_task_(0)
+        , total_task_(0)
+        , busy_worker_(0)
+        , generation_(0)
+        , stopping_(false) {
+        for (int i = 0; i < worker_count; i++) {
+            workers_.emplace_back([this]() { worker_loop(); });
+        }
+    }
+
+    software_raster_pool::~software_raster_pool() {
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            stopping_ = true;
+        }
+
+        job_cond_.notify_all();
+
+        for (auto &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void software_raster_pool::take_tasks() {
+        int task = 0;
+
+        while ((task = next_task_.fetch_add(1)) < total_task_) {
+            job_(task);
+        }
+    }
+
+    void software_raster_pool::worker_loop() {
+        std::uint32_t seen_generation = 0;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> ulock(lock_);
+                job_cond_.wait(ulock, [&]() { return stopping_ || (generation_ != seen_generation); });
+
+                if (stopping_) {
+                    return;
+                }
+
+                seen_generation = generation_;
+                busy_worker_++;
+            }
+
+            take_tasks();
+
+            {
+                const std::lock_guard<std::mutex> guard(lock_);
+                busy_worker_--;
+            }
+
+            done_cond_.notify_all();
+        }
+    }
+
+    void software_raster_pool::run(const int task_count, std::function<void(const int)> job) {
+        if (task_count <= 0) {
+            return;
+        }
+
+        if (workers_.empty() || (task_count == 1)) {
+            for (int i = 0; i < task_count; i++) {
+                job(i);
+            }
+
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> ulock(lock_);
+
+            // Late workers of the last run may still be around, wait for them to leave before replacing the job
+            done_cond_.wait(ulock, [&]() { return busy_worker_ == 0; });
+
+            job_ = std::move(job);
+            total_task_ = task_count;
+            next_task_ = 0;
+            generation_++;
+        }
+
+        job_cond_.notify_all();
+        take_tasks();
+
+        std::unique_lock<std::mutex> ulock(lock_);
+        done_cond_.wait(ulock, [&]() { return busy_worker_ == 0; });
+    }
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project 
+ * (see bentokun.github.com/EKA2L1).
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/graphics/backend/software/texture_software.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace eka2l1::drivers {
+    static std::uint32_t pack_rgba(const std::uint32_t r, const std::uint32_t g, const std::uint32_t b, const std::uint32_t a) {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    static std::uint32_t expand_565(const std::uint16_t v) {
+        const std::uint32_t r5 = (v >> 11) & 0x1F;
+        const std::uint32_t g6 = (v >> 5) & 0x3F;
+        const std::uint32_t b5 = v & 0x1F;
+
+        return pack_rgba((r5 << 3) | (r5 >> 2), (g6 << 2) | (g6 >> 4), (b5 << 3) | (b5 >> 2), 0xFF);
+    }
+
+    /**
+     * \brief Convert a row of client pixels to RGBA8. Components wider than a byte keep their high byte.
+     */
+    static void convert_row_to_rgba8(std::uint32_t *dest, const std::uint8_t *source, const int width,
+        const texture_format format, const texture_data_type data_type) {
+        if (data_type == texture_data_type::ushort_5_6_5) {
+            for (int i = 0; i < width; i++) {
+                std::uint16_t v = 0;
+                std::memcpy(&v, source + i * 2, 2);
+
+                dest[i] = expand_565(v);
+            }
+
+            return;
+        }
+
+        if ((format == texture_format::rgba) && (data_type == texture_data_type::ubyte)) {
+            std::memcpy(dest, source, width * sizeof(std::uint32_t));
+            return;
+        }
+
+        const int comp_size = (data_type == texture_data_type::ushort) ? 2 : 1;
+        const int pixel_size = static_cast<int>(get_texture_pixel_size(format, data_type));
+
+        // Little endian, the high byte of an ushort comes last
+        const std::uint8_t *comp = source + (comp_size - 1);
+
+        for (int i = 0; i < width; i++, comp += pixel_size) {
+            switch (format) {
+            case texture_format::r:
+                dest[i] = pack_rgba(comp[0], 0, 0, 0xFF);
+                break;
+
+            case texture_format::rg:
+                dest[i] = pack_rgba(comp[0], comp[comp_size], 0, 0xFF);
+                break;
+
+            case texture_format::rgb:
+                dest[i] = pack_rgba(comp[0], comp[comp_size], comp[comp_size * 2], 0xFF);
+                break;
+
+            case texture_format::bgr:
+                dest[i] = pack_rgba(comp[comp_size * 2], comp[comp_size], comp[0], 0xFF);
+                break;
+
+            case texture_format::bgra:
+                dest[i] = pack_rgba(comp[comp_size * 2], comp[comp_size], comp[0], comp[comp_size * 3]);
+                break;
+
+            default:
+                dest[i] = pack_rgba(comp[0], comp[comp_size], comp[comp_size * 2], comp[comp_size * 3]);
+                break;
+            }
+        }
+    }
+
+    software_texture::software_texture()
+        : swizzle({ channel_swizzle::red, channel_swizzle::green, channel_swizzle::blue, channel_swizzle::alpha }) {
+    }
+
+    bool software_texture::tex(graphics_driver *driver, const bool is_first) {
+        if ((dimensions < 1) || (dimensions > 3)) {
+            return false;
+        }
+
+        const int width = std::max(tex_size.x, 0);
+        const int height = (dimensions >= 2) ? std::max(tex_size.y, 0) : 1;
+        const int depth = (dimensions == 3) ? std::max(tex_size.z, 0) : 1;
+
+        // Keep what was drawn in the area the new size still covers, like resizing a bitmap is expected to
+        std::vector<std::uint32_t> new_pixels(width * height * depth, 0);
+
+        if (!is_first && !pixels.empty()) {
+            const int copy_width = std::min(stored_width, width);
+            const int copy_rows = std::min(stored_rows, height * depth);
+
+            for (int y = 0; y < copy_rows; y++) {
+                std::copy(pixels.begin() + y * stored_width, pixels.begin() + y * stored_width + copy_width,
+                    new_pixels.begin() + y * width);
+            }
+        }
+
+        pixels = std::move(new_pixels);
+        stored_width = width;
+        stored_rows = height * depth;
+
+        if (tex_data) {
+            update_data(driver, mip_level, vec3(0, 0, 0), vec3(width, height, depth), format, tex_data_type, tex_data);
+        }
+
+        swizzle_dirty = true;
+        return true;
+    }
+
+    bool software_texture::create(graphics_driver *driver, const int dim, const int miplvl, const vec3 &size, const texture_format internal_format,
+        const texture_format format, const texture_data_type data_type, void *data) {
+        dimensions = dim;
+        tex_size = size;
+        tex_data_type = data_type;
+        tex_data = data;
+        mip_level = miplvl;
+
+        this->internal_format = internal_format;
+        this->format = format;
+
+        return tex(driver, true);
+    }
+
+    void software_texture::change_size(const vec3 &new_size) {
+        tex_size = new_size;
+    }
+
+    void software_texture::change_data(const texture_data_type data_type, void *data) {
+        tex_data_type = data_type;
+        tex_data = data;
+    }
+
+    void software_texture::change_texture_format(const texture_format format) {
+        this->format = format;
+    }
+
+    void software_texture::set_channel_swizzle(channel_swizzles swizz) {
+        swizzle = swizz;
+        swizzle_dirty = true;
+    }
+
+    bool software_texture::has_identity_swizzle() const {
+        return (swizzle[0] == channel_swizzle::red) && (swizzle[1] == channel_swizzle::green)
+            && (swizzle[2] == channel_swizzle::blue) && (swizzle[3] == channel_swizzle::alpha);
+    }
+
+    static std::uint32_t pick_channel(const std::uint32_t pixel, const channel_swizzle swizz) {
+        switch (swizz) {
+        case channel_swizzle::red:
+            return pixel & 0xFF;
+
+        case channel_swizzle::green:
+            return (pixel >> 8) & 0xFF;
+
+        case channel_swizzle::blue:
+            return (pixel >> 16) & 0xFF;
+
+        case channel_swizzle::alpha:
+            return pixel >> 24;
+
+        case channel_swizzle::one:
+            return 0xFF;
+
+        default:
+            break;
+        }
+
+        return 0;
+    }
+
+    const std::uint32_t *software_texture::get_sample_pixels() {
+        if (has_identity_swizzle()) {
+            return pixels.data();
+        }
+
+        if (swizzle_dirty || (swizzled.size() != pixels.size())) {
+            swizzled.resize(pixels.size());
+
+            for (std::size_t i = 0; i < pixels.size(); i++) {
+                swizzled[i] = pack_rgba(pick_channel(pixels[i], swizzle[0]), pick_channel(pixels[i], swizzle[1]),
+                    pick_channel(pixels[i], swizzle[2]), pick_channel(pixels[i], swizzle[3]));
+            }
+
+            swizzle_dirty = false;
+        }
+
+        return swizzled.data();
+    }
+
+    void software_texture::update_data(graphics_driver *driver, const int mip_lvl, const vec3 &offset, const vec3 &size, const texture_format data_format,
+        const texture_data_type data_type, const void *data) {
+        if (!data || (mip_lvl != mip_level)) {
+            return;
+        }
+
+        // Go with the storage size, the size may have been changed without reallocating yet
+        const int width = stored_width;
+        const int depth = (dimensions == 3) ? std::max(tex_size.z, 1) : 1;
+        const int height = stored_rows / depth;
+
+        const int update_height = (dimensions >= 2) ? size.y : 1;
+        const int update_depth = (dimensions == 3) ? size.z : 1;
+
+        // Rows are aligned to 4 bytes, same as the default GL unpack alignment
+        const std::size_t source_pitch = (get_texture_pixel_size(data_format, data_type) * size.x + 3) & ~static_cast<std::size_t>(3);
+
+        const int copy_width = std::min(size.x, width - offset.x);
+
+        if ((copy_width <= 0) || (offset.x < 0) || (offset.y < 0) || (offset.z < 0)) {
+            return;
+        }
+
+        const std::uint8_t *source = reinterpret_cast<const std::uint8_t *>(data);
+
+        for (int z = 0; z < update_depth; z++) {
+            if (z + offset.z >= depth) {
+                break;
+            }
+
+            for (int y = 0; y < update_height; y++) {
+                if (y + offset.y >= height) {
+                    break;
+                }
+
+                std::uint32_t *dest = pixels.data() + ((z + offset.z) * height + (y + offset.y)) * width + offset.x;
+                convert_row_to_rgba8(dest, source + (z * update_height + y) * source_pitch, copy_width, data_format, data_type);
+            }
+        }
+
+        swizzle_dirty = true;
+    }
+}
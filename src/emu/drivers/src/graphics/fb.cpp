@@ -18,6 +18,7 @@
  */
 
 #include <drivers/graphics/backend/ogl/fb_ogl.h>
+#include <drivers/graphics/backend/software/fb_software.h>
 #include <drivers/graphics/fb.h>
 #include <drivers/graphics/graphics.h>
 
@@ -29,6 +30,10 @@ namespace eka2l1::drivers {
             break;
         }
 
+        case graphic_api::software: {
+            return std::make_unique<software_framebuffer>(color_buffer, depth_buffer);
+        }
+
         default:
             break;
         }
@@ -18,6 +18,7 @@
  */
 
 #include <drivers/graphics/backend/ogl/graphics_ogl.h>
+#include <drivers/graphics/backend/software/graphics_software.h>
 #include <drivers/graphics/graphics.h>
 
 #include <common/log.h>
@@ -42,6 +43,10 @@ namespace eka2l1::drivers {
             return true;
         }
 
+        case graphic_api::software:
+            // Nothing to load, everything is done on the CPU
+            return true;
+
         default:
             break;
         }
@@ -55,6 +60,10 @@ namespace eka2l1::drivers {
             return std::make_unique<ogl_graphics_driver>();
         }
 
+        case graphic_api::software: {
+            return std::make_unique<software_graphics_driver>();
+        }
+
         default:
             break;
         }
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/algorithm.h>
+#include <drivers/graphics/handle.h>
+
+namespace eka2l1::drivers {
+    static constexpr std::uint32_t TOTAL_RESERVED_WORD = MAX_RESERVED_HANDLE >> 5;
+
+    reserved_handle_allocator::reserved_handle_allocator()
+        : words_(new std::atomic<std::uint32_t>[TOTAL_RESERVED_WORD])
+        , hint_(0) {
+        for (std::uint32_t i = 0; i < TOTAL_RESERVED_WORD; i++) {
+            words_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    drivers::handle reserved_handle_allocator::reserve(const bool is_bitmap) {
+        const std::uint32_t start = hint_.load(std::memory_order_relaxed);
+
+        for (std::uint32_t i = 0; i < TOTAL_RESERVED_WORD; i++) {
+            const std::uint32_t word_idx = (start + i) % TOTAL_RESERVED_WORD;
+            std::uint32_t word = words_[word_idx].load(std::memory_order_relaxed);
+
+            while (word != 0xFFFFFFFFU) {
+                const int bit = common::count_trailing_zero(~word);
+
+                if (words_[word_idx].compare_exchange_weak(word, word | (1U << bit), std::memory_order_acquire,
+                        std::memory_order_relaxed)) {
+                    hint_.store(word_idx, std::memory_order_relaxed);
+
+                    drivers::handle result = HANDLE_RESERVED | ((word_idx << 5) + bit + 1);
+
+                    if (is_bitmap) {
+                        result |= HANDLE_BITMAP;
+                    }
+
+                    return result;
+                }
+            }
+        }
+
+        return 0;
+    }
+
+    void reserved_handle_allocator::free(const drivers::handle h) {
+        if (!is_handle_reserved(h)) {
+            return;
+        }
+
+        const std::uint32_t idx = get_reserved_handle_index(h);
+
+        if (idx >= MAX_RESERVED_HANDLE) {
+            return;
+        }
+
+        words_[idx >> 5].fetch_and(~(1U << (idx & 31)), std::memory_order_release);
+    }
+}
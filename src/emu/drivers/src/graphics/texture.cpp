@@ -18,6 +18,7 @@
  */
 
 #include <drivers/graphics/backend/ogl/texture_ogl.h>
+#include <drivers/graphics/backend/software/texture_software.h>
 #include <drivers/graphics/graphics.h>
 #include <drivers/graphics/texture.h>
 
@@ -29,10 +30,46 @@ namespace eka2l1::drivers {
             break;
         }
 
+        case graphic_api::software: {
+            return std::make_unique<software_texture>();
+        }
+
         default:
             break;
         }
 
         return nullptr;
     }
+
+    std::size_t get_texture_pixel_size(const texture_format format, const texture_data_type data_type) {
+        switch (data_type) {
+        case texture_data_type::ushort_5_6_5:
+            return 2;
+
+        case texture_data_type::uint_24_8:
+            return 4;
+
+        default:
+            break;
+        }
+
+        const std::size_t comp_size = (data_type == texture_data_type::ushort) ? 2 : 1;
+
+        switch (format) {
+        case texture_format::r:
+            return comp_size;
+
+        case texture_format::rg:
+            return comp_size * 2;
+
+        case texture_format::rgb:
+        case texture_format::bgr:
+            return comp_size * 3;
+
+        default:
+            break;
+        }
+
+        return comp_size * 4;
+    }
 }
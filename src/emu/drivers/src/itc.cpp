@@ -27,40 +27,55 @@
 using namespace std::chrono_literals;
 
 namespace eka2l1::drivers {
-    static int send_sync_command_detail(graphics_driver *drv, command *cmd) {
-        int status = -100;
-        cmd->status_ = &status;
-
-        command_list cmd_list;
-        cmd_list.add(cmd);
+    template <typename... Args>
+    static int send_sync_command(graphics_driver *drv, const std::uint16_t opcode, Args... args) {
+        std::unique_ptr<graphics_command_list> list = drv->new_command_list();
+        command_list &cmd_list = static_cast<server_graphics_command_list *>(list.get())->list_;
 
-        server_graphics_command_list gcmd_list;
-        gcmd_list.list_ = cmd_list;
+        int status = -100;
+        cmd_list.add(make_command(cmd_list, opcode, &status, args...));
 
         std::unique_lock<std::mutex> ulock(drv->mut_);
-        drv->submit_command_list(gcmd_list);
+        drv->submit_command_list(*list);
         drv->cond_.wait(ulock, [&]() { return status != -100; });
 
         return status;
     }
 
-    template <typename T, typename... Args>
-    static int send_sync_command(T drv, const std::uint16_t opcode, Args... args) {
-        command *cmd = make_command(opcode, nullptr, args...);
-        return send_sync_command_detail(drv, cmd);
-    }
+    static std::size_t get_texture_data_size(const drivers::texture_format format, const drivers::texture_data_type data_type,
+        const eka2l1::vec3 &size, const std::uint8_t dim) {
+        std::size_t total = get_texture_pixel_size(format, data_type) * size.x;
+
+        if (dim >= 2) {
+            total *= size.y;
+        }
 
-    static void *make_data_copy(const void *source, const std::size_t size) {
-        std::uint8_t *copy = new std::uint8_t[size];
-        std::copy(reinterpret_cast<const std::uint8_t *>(source), reinterpret_cast<const std::uint8_t *>(source) + size, copy);
+        if (dim == 3) {
+            total *= size.z;
+        }
 
-        return copy;
+        return total;
     }
 
     drivers::handle create_bitmap(graphics_driver *driver, const eka2l1::vec2 &size) {
+        const drivers::handle reserved = driver->reserve_handle(true);
+        drivers::handle *no_result = nullptr;
+
+        if (reserved) {
+            // Queue the creation like any draw command, the driver will bind the reserved handle later.
+            std::unique_ptr<graphics_command_list> list = driver->new_command_list();
+            command_list &cmd_list = static_cast<server_graphics_command_list *>(list.get())->list_;
+
+            cmd_list.add(make_command(cmd_list, graphics_driver_create_bitmap, nullptr, size.x, size.y, reserved, no_result));
+            driver->submit_command_list(*list);
+
+            return reserved;
+        }
+
+        // Run out of reserved handles. Wait for the driver to give us one.
         drivers::handle handle_num = 0;
 
-        if (send_sync_command(driver, graphics_driver_create_bitmap, size.x, size.y, &handle_num) != 0) {
+        if (send_sync_command(driver, graphics_driver_create_bitmap, size.x, size.y, reserved, &handle_num) != 0) {
             return 0;
         }
 
@@ -96,34 +111,67 @@ namespace eka2l1::drivers {
     drivers::handle create_texture(graphics_driver *driver, const std::uint8_t dim, const std::uint8_t mip_levels,
         drivers::texture_format internal_format, drivers::texture_format data_format, drivers::texture_data_type data_type,
         const void *data, const eka2l1::vec3 &size) {
+        if ((dim == 0) || (dim > 3)) {
+            return 0;
+        }
+
+        drivers::handle reserved = driver->reserve_handle(false);
         drivers::handle handle_num = 0;
+        drivers::handle *store = &handle_num;
 
-        switch (dim) {
-        case 1:
-            if (send_sync_command(driver, graphics_driver_create_texture, dim, mip_levels, internal_format, data_format, data_type, data, size.x, &handle_num) != 0) {
-                return 0;
+        int status = -100;
+        int *status_ptr = &status;
+
+        std::unique_ptr<graphics_command_list> list = driver->new_command_list();
+        command_list &cmd_list = static_cast<server_graphics_command_list *>(list.get())->list_;
+
+        if (reserved) {
+            // The caller may free the data right after we return. Keep a copy along with the command.
+            if (data) {
+                data = cmd_list.copy_data(data, get_texture_data_size(data_format, data_type, size, dim));
             }
 
+            store = nullptr;
+            status_ptr = nullptr;
+        }
+
+        command *cmd = nullptr;
+
+        switch (dim) {
+        case 1:
+            cmd = make_command(cmd_list, graphics_driver_create_texture, status_ptr, dim, mip_levels, internal_format, data_format,
+                data_type, data, size.x, reserved, store);
             break;
 
         case 2:
-            if (send_sync_command(driver, graphics_driver_create_texture, dim, mip_levels, internal_format, data_format, data_type, data, size.x, size.y, &handle_num) != 0) {
-                return 0;
-            }
-
+            cmd = make_command(cmd_list, graphics_driver_create_texture, status_ptr, dim, mip_levels, internal_format, data_format,
+                data_type, data, size.x, size.y, reserved, store);
             break;
 
         case 3:
-            if (send_sync_command(driver, graphics_driver_create_texture, dim, mip_levels, internal_format, data_format, data_type, data, size.x, size.y, size.z, &handle_num) != 0) {
-                return 0;
-            }
-
+            cmd = make_command(cmd_list, graphics_driver_create_texture, status_ptr, dim, mip_levels, internal_format, data_format,
+                data_type, data, size.x, size.y, size.z, reserved, store);
             break;
 
         default:
             break;
         }
 
+        cmd_list.add(cmd);
+
+        if (reserved) {
+            driver->submit_command_list(*list);
+            return reserved;
+        }
+
+        std::unique_lock<std::mutex> ulock(driver->mut_);
+        driver->submit_command_list(*list);
+        driver->cond_.wait(ulock, [&]() { return status != -100; });
+
+        if (status != 0) {
+            return 0;
+        }
+
         return handle_num;
     }
 
@@ -132,83 +180,101 @@ namespace eka2l1::drivers {
     }
 
     void server_graphics_command_list_builder::invalidate_rect(eka2l1::rect &rect) {
-        command *cmd = make_command(graphics_driver_invalidate_rect, nullptr, rect.top.x, rect.top.y,
+        command *cmd = make_command(get_command_list(), graphics_driver_invalidate_rect, nullptr, rect.top.x, rect.top.y,
             rect.size.x, rect.size.y);
 
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::set_invalidate(const bool enabled) {
-        command *cmd = make_command(graphics_driver_set_invalidate, nullptr, enabled);
+        command *cmd = make_command(get_command_list(), graphics_driver_set_invalidate, nullptr, enabled);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::clear(vecx<std::uint8_t, 4> color, const std::uint8_t clear_bitarr) {
-        command *cmd = make_command(graphics_driver_clear, nullptr, color[0], color[1], color[2], color[3], clear_bitarr);
+        command *cmd = make_command(get_command_list(), graphics_driver_clear, nullptr, color[0], color[1], color[2], color[3], clear_bitarr);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::resize_bitmap(drivers::handle h, const eka2l1::vec2 &new_size) {
         // This opcode has two variant: sync or async.
         // The first argument is bitmap handle. If it's null then the currently binded one will be used.
-        command *cmd = make_command(graphics_driver_resize_bitmap, nullptr, h, new_size);
+        command *cmd = make_command(get_command_list(), graphics_driver_resize_bitmap, nullptr, h, new_size);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::update_bitmap(drivers::handle h, const int bpp, const char *data, const std::size_t size,
         const eka2l1::vec2 &offset, const eka2l1::vec2 &dim) {
         // Copy data
-        command *cmd = make_command(graphics_driver_update_bitmap, nullptr, h, make_data_copy(data, size), bpp, size, offset, dim);
+        command *cmd = make_command(get_command_list(), graphics_driver_update_bitmap, nullptr, h, get_command_list().copy_data(data, size), bpp, size, offset, dim);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::draw_bitmap(drivers::handle h, drivers::handle maskh, const eka2l1::rect &dest_rect, const eka2l1::rect &source_rect, const std::uint32_t flags) {
-        command *cmd = make_command(graphics_driver_draw_bitmap, nullptr, h, maskh, dest_rect, source_rect, flags);
+        command *cmd = make_command(get_command_list(), graphics_driver_draw_bitmap, nullptr, h, maskh, dest_rect, source_rect, flags);
+        get_command_list().add(cmd);
+    }
+
+    void server_graphics_command_list_builder::draw_bitmap_batch(drivers::handle h, const eka2l1::rect *dest_rects, const eka2l1::rect *source_rects,
+        const std::uint32_t count, const std::uint32_t flags) {
+        if (count == 0) {
+            return;
+        }
+
+        // Pack destination and source of each quad next to each other
+        eka2l1::rect *rects = reinterpret_cast<eka2l1::rect *>(get_command_list().allocate(count * 2 * sizeof(eka2l1::rect)));
+
+        for (std::uint32_t i = 0; i < count; i++) {
+            rects[i * 2] = dest_rects[i];
+            rects[i * 2 + 1] = source_rects[i];
+        }
+
+        command *cmd = make_command(get_command_list(), graphics_driver_draw_bitmap_batch, nullptr, h, rects, count, flags);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::bind_bitmap(const drivers::handle h) {
-        command *cmd = make_command(graphics_driver_bind_bitmap, nullptr, h);
+        command *cmd = make_command(get_command_list(), graphics_driver_bind_bitmap, nullptr, h);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::draw_rectangle(const eka2l1::rect &target_rect) {
-        command *cmd = make_command(graphics_driver_draw_rectangle, nullptr, target_rect);
+        command *cmd = make_command(get_command_list(), graphics_driver_draw_rectangle, nullptr, target_rect);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::set_brush_color_detail(const eka2l1::vecx<int, 4> &color) {
-        command *cmd = make_command(graphics_driver_set_brush_color, nullptr, static_cast<float>(color[0]),
+        command *cmd = make_command(get_command_list(), graphics_driver_set_brush_color, nullptr, static_cast<float>(color[0]),
             static_cast<float>(color[1]), static_cast<float>(color[2]), static_cast<float>(color[3]));
 
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::use_program(drivers::handle h) {
-        command *cmd = make_command(graphics_driver_use_program, nullptr, h);
+        command *cmd = make_command(get_command_list(), graphics_driver_use_program, nullptr, h);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::set_uniform(drivers::handle h, const int binding, const drivers::shader_set_var_type var_type,
         const void *data, const std::size_t data_size) {
-        const void *uniform_data = make_data_copy(data, data_size);
+        const void *uniform_data = get_command_list().copy_data(data, data_size);
 
-        command *cmd = make_command(graphics_driver_set_uniform, nullptr, h, var_type, uniform_data, binding);
+        command *cmd = make_command(get_command_list(), graphics_driver_set_uniform, nullptr, h, var_type, uniform_data, binding);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::bind_texture(drivers::handle h, const int binding) {
-        command *cmd = make_command(graphics_driver_bind_texture, nullptr, h, binding);
+        command *cmd = make_command(get_command_list(), graphics_driver_bind_texture, nullptr, h, binding);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::draw_indexed(const graphics_primitive_mode prim_mode, const int count, const data_format index_type, const int index_off, const int vert_base) {
-        command *cmd = make_command(graphics_driver_draw_indexed, nullptr, prim_mode, count, index_type, index_off, vert_base);
+        command *cmd = make_command(get_command_list(), graphics_driver_draw_indexed, nullptr, prim_mode, count, index_type, index_off, vert_base);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::bind_buffer(drivers::handle h) {
-        command *cmd = make_command(graphics_driver_bind_buffer, nullptr, h);
+        command *cmd = make_command(get_command_list(), graphics_driver_bind_buffer, nullptr, h);
         get_command_list().add(cmd);
     }
 
@@ -220,24 +286,24 @@ namespace eka2l1::drivers {
             total_chunk_size += chunk_size[i];
         }
 
-        std::uint8_t *data = new std::uint8_t[total_chunk_size];
+        std::uint8_t *data = reinterpret_cast<std::uint8_t *>(get_command_list().allocate(total_chunk_size));
 
         for (int i = 0; i < chunk_count; i++) {
             std::copy(reinterpret_cast<const std::uint8_t *>(chunk_ptr[i]), reinterpret_cast<const std::uint8_t *>(chunk_ptr[i]) + chunk_size[i], data + cursor);
             cursor += chunk_size[i];
         }
 
-        command *cmd = make_command(graphics_driver_update_buffer, nullptr, h, data, offset, total_chunk_size);
+        command *cmd = make_command(get_command_list(), graphics_driver_update_buffer, nullptr, h, data, offset, total_chunk_size);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::set_viewport(const eka2l1::rect &viewport_rect) {
-        command *cmd = make_command(graphics_driver_set_viewport, nullptr, viewport_rect);
+        command *cmd = make_command(get_command_list(), graphics_driver_set_viewport, nullptr, viewport_rect);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::create_single_set_command(const std::uint16_t op, const bool enable) {
-        command *cmd = make_command(op, nullptr, enable);
+        command *cmd = make_command(get_command_list(), op, nullptr, enable);
         get_command_list().add(cmd);
     }
 
@@ -256,56 +322,56 @@ namespace eka2l1::drivers {
     void server_graphics_command_list_builder::blend_formula(const blend_equation rgb_equation, const blend_equation a_equation,
         const blend_factor rgb_frag_output_factor, const blend_factor rgb_current_factor,
         const blend_factor a_frag_output_factor, const blend_factor a_current_factor) {
-        command *cmd = make_command(graphics_driver_blend_formula, nullptr, rgb_equation, a_equation, rgb_frag_output_factor,
+        command *cmd = make_command(get_command_list(), graphics_driver_blend_formula, nullptr, rgb_equation, a_equation, rgb_frag_output_factor,
             rgb_current_factor, a_frag_output_factor, a_current_factor);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::backup_state() {
-        command *cmd = make_command(graphics_driver_backup_state, nullptr);
+        command *cmd = make_command(get_command_list(), graphics_driver_backup_state, nullptr);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::load_backup_state() {
-        command *cmd = make_command(graphics_driver_restore_state, nullptr);
+        command *cmd = make_command(get_command_list(), graphics_driver_restore_state, nullptr);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::attach_descriptors(drivers::handle h, const int stride, const bool instance_move,
         const attribute_descriptor *descriptors, const int descriptor_count) {
-        void *des = make_data_copy(descriptors, descriptor_count * sizeof(attribute_descriptor));
-        command *cmd = make_command(graphics_driver_attach_descriptors, nullptr, h, stride, instance_move, des, descriptor_count);
+        void *des = get_command_list().copy_data(descriptors, descriptor_count * sizeof(attribute_descriptor));
+        command *cmd = make_command(get_command_list(), graphics_driver_attach_descriptors, nullptr, h, stride, instance_move, des, descriptor_count);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::present(int *status) {
-        command *cmd = make_command(graphics_driver_display, status);
+        command *cmd = make_command(get_command_list(), graphics_driver_display, status);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::destroy(drivers::handle h) {
-        command *cmd = make_command(graphics_driver_destroy_object, nullptr, h);
+        command *cmd = make_command(get_command_list(), graphics_driver_destroy_object, nullptr, h);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::destroy_bitmap(drivers::handle h) {
-        command *cmd = make_command(graphics_driver_destroy_bitmap, nullptr, h);
+        command *cmd = make_command(get_command_list(), graphics_driver_destroy_bitmap, nullptr, h);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::set_texture_filter(drivers::handle h, const drivers::filter_option min, const drivers::filter_option mag) {
-        command *cmd = make_command(graphics_driver_set_texture_filter, nullptr, h);
+        command *cmd = make_command(get_command_list(), graphics_driver_set_texture_filter, nullptr, h, min, mag);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::set_swizzle(drivers::handle h, drivers::channel_swizzle r, drivers::channel_swizzle g,
         drivers::channel_swizzle b, drivers::channel_swizzle a) {
-        command *cmd = make_command(graphics_driver_set_swizzle, nullptr, h, r, g, b, a);
+        command *cmd = make_command(get_command_list(), graphics_driver_set_swizzle, nullptr, h, r, g, b, a);
         get_command_list().add(cmd);
     }
 
     void server_graphics_command_list_builder::set_swapchain_size(const eka2l1::vec2 &swsize) {
-        command *cmd = make_command(graphics_driver_set_swapchain_size, nullptr, swsize);
+        command *cmd = make_command(get_command_list(), graphics_driver_set_swapchain_size, nullptr, swsize);
         get_command_list().add(cmd);
     }
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace eka2l1::dispatch {
+    /**
+     * \brief Write operation applied on a 32bpp pixel, resolved by the screen driver from its draw mode.
+     */
+    enum scdv_pixel_op : std::uint32_t {
+        scdv_pixel_op_write = 0, ///< Replace the pixel.
+        scdv_pixel_op_and = 1,
+        scdv_pixel_op_or = 2,
+        scdv_pixel_op_xor = 3,
+        scdv_pixel_op_not_screen = 4, ///< Invert the pixel, the color is not used.
+        scdv_pixel_op_and_not = 5, ///< Inverted pixel AND color.
+        scdv_pixel_op_blend = 6 ///< Pen blending of EColor16MA.
+    };
+
+    /**
+     * Pixels are 32-bit words, exactly as they are laid out in the guest framebuffer. Colors are
+     * given in the same layout: red in the lowest byte, then green, blue and alpha.
+     *
+     * Every function here produces the same pixels as the screen driver's own loops do.
+     */
+
+    /**
+     * \brief Apply an operation with a single color to a span of pixels.
+     *
+     * \param dest  The first pixel of the span.
+     * \param count Number of pixels in the span.
+     * \param color The color to apply.
+     * \param op    The operation.
+     */
+    void scdv_fill_span(std::uint32_t *dest, const std::uint32_t count, const std::uint32_t color, const scdv_pixel_op op);
+
+    /**
+     * \brief Apply an operation pixel by pixel from a source span.
+     *
+     * \param dest   The first pixel of the span.
+     * \param source Pixels to apply, one for each destination pixel.
+     * \param count  Number of pixels in the span.
+     * \param op     The operation.
+     */
+    void scdv_write_span(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t count, const scdv_pixel_op op);
+
+    /**
+     * \brief Blend source pixels (or a color) over a span, weighted by an 8-bit mask.
+     *
+     * A zero mask keeps the pixel, a full mask replaces it. Result is always opaque.
+     *
+     * \param dest   The first pixel of the span.
+     * \param source Pixels to blend, one for each destination pixel. NULL to blend the color instead.
+     * \param color  Color to blend when no source is given.
+     * \param mask   Weight of each pixel.
+     * \param count  Number of pixels in the span.
+     */
+    void scdv_blend_mask_span(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t color,
+        const std::uint8_t *mask, const std::uint32_t count);
+
+    /**
+     * \brief Remap colors in a span.
+     *
+     * Each pixel matching the first color of a pair is ANDed with the second color of the pair. Pairs
+     * are all compared with the original pixel.
+     *
+     * \param dest      The first pixel of the span.
+     * \param count     Number of pixels in the span.
+     * \param pairs     Color pairs, packed as (source, target).
+     * \param num_pairs Number of pairs.
+     */
+    void scdv_map_colors_span(std::uint32_t *dest, const std::uint32_t count, const std::uint32_t *pairs,
+        const std::uint32_t num_pairs);
+}
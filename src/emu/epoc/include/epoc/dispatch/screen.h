@@ -35,6 +35,41 @@ namespace eka2l1::dispatch {
         eka2l1::rect src_blit_rect;
     };
 
+    /**
+     * \brief Describe a rectangle of a 32bpp guest bitmap filled with one color.
+     */
+    struct scdv_fill_info {
+        eka2l1::ptr<std::uint8_t> dest_base; ///< Top-left pixel of the rectangle.
+        std::uint32_t dest_stride;
+        eka2l1::vec2 size;
+        std::uint32_t color;
+        std::uint32_t op; ///< One of scdv_pixel_op.
+    };
+
+    /**
+     * \brief Describe a line of a 32bpp guest bitmap to write or blend.
+     */
+    struct scdv_line_info {
+        eka2l1::ptr<std::uint8_t> dest;
+        eka2l1::ptr<const std::uint8_t> source; ///< 32bpp pixels. Can be null for blending a color.
+        eka2l1::ptr<const std::uint8_t> mask; ///< 8bpp mask, only for blending.
+        std::uint32_t length;
+        std::uint32_t color;
+        std::uint32_t op; ///< One of scdv_pixel_op, only for writing.
+    };
+
+    struct scdv_map_colors_info {
+        eka2l1::ptr<std::uint8_t> dest_base;
+        std::uint32_t dest_stride;
+        eka2l1::vec2 size;
+        eka2l1::ptr<const std::uint32_t> pairs;
+        std::uint32_t num_pairs;
+    };
+
     BRIDGE_FUNC_DISPATCHER(void, update_screen, const std::uint32_t screen_number, const std::uint32_t num_rects, const eka2l1::rect *rect_list);
     BRIDGE_FUNC_DISPATCHER(void, fast_blit, fast_blit_info *info);
+    BRIDGE_FUNC_DISPATCHER(void, scdv_fill_rect, scdv_fill_info *info);
+    BRIDGE_FUNC_DISPATCHER(void, scdv_write_line, scdv_line_info *info);
+    BRIDGE_FUNC_DISPATCHER(void, scdv_blend_line, scdv_line_info *info);
+    BRIDGE_FUNC_DISPATCHER(void, scdv_map_colors, scdv_map_colors_info *info);
 }
\ No newline at end of file
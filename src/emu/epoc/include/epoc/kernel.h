@@ -164,6 +164,11 @@ namespace eka2l1 {
         std::vector<kernel_obj_unq_ptr> timers;
         std::vector<kernel_obj_unq_ptr> message_queues;
 
+        /* Codeseg lookups, so loading an already loaded image does not scan every codeseg */
+        std::unordered_map<std::u16string, codeseg_ptr> codeseg_path_index; ///< Keyed by the lowercased full path.
+        std::unordered_multimap<kernel::uid, codeseg_ptr> codeseg_uid_index; ///< Keyed by the third UID.
+        std::unordered_map<address, codeseg_ptr> codeseg_ep_index; ///< ROM codesegs only, keyed by entry point.
+
         std::unique_ptr<kernel::btrace> btrace_inst;
 
         ntimer *timing;
@@ -173,7 +178,8 @@ namespace eka2l1 {
         io_system *io;
         system *sys;
 
-        void *rom_map;
+        void *rom_map; ///< Private mapping of the ROM file, shared with other emulators until written.
+        std::size_t rom_map_size;
 
         /* Contains the EPOC version */
         epocver kern_ver = epocver::epoc94;
@@ -311,6 +317,16 @@ namespace eka2l1 {
 
         codeseg_ptr pull_codeseg_by_ep(const address ep);
 
+        /*! \brief Get a codeseg that was loaded from the given path.
+         *
+         * \param path The full path of the image. Case is ignored.
+         * \returns Nullptr if no codeseg of this path exists.
+        */
+        codeseg_ptr pull_codeseg_by_path(const std::u16string &path);
+
+        void index_codeseg(codeseg_ptr seg);
+        void unindex_codeseg(codeseg_ptr seg);
+
         // Expose for scripting, indeed very dirty
         std::vector<kernel_obj_unq_ptr> &get_process_list() {
             return processes;
@@ -459,7 +475,7 @@ namespace eka2l1 {
                 ADD_OBJECT_TO_CONTAINER(kernel::object_type::mutex, mutexes, )
                 ADD_OBJECT_TO_CONTAINER(kernel::object_type::sema, semas, )
                 ADD_OBJECT_TO_CONTAINER(kernel::object_type::change_notifier, change_notifiers, )
-                ADD_OBJECT_TO_CONTAINER(kernel::object_type::codeseg, codesegs, )
+                ADD_OBJECT_TO_CONTAINER(kernel::object_type::codeseg, codesegs, index_codeseg(reinterpret_cast<codeseg_ptr>(obj.get())))
                 ADD_OBJECT_TO_CONTAINER(kernel::object_type::msg_queue, message_queues, )
 
             default:
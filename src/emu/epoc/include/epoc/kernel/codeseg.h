@@ -24,6 +24,7 @@
 #include <epoc/ptr.h>
 #include <epoc/utils/sec.h>
 
+#include <memory>
 #include <tuple>
 #include <vector>
 
@@ -34,6 +35,10 @@ namespace eka2l1 {
         class codeseg;
     }
 
+    namespace loader {
+        struct e32img;
+    }
+
     using codeseg_ptr = kernel::codeseg *;
     using chunk_ptr = kernel::chunk *;
 }
@@ -93,6 +98,9 @@ namespace eka2l1::kernel {
         std::unique_ptr<std::uint8_t[]> constant_data;
         std::unique_ptr<std::uint8_t[]> code_data;
 
+        // Image without its data, only kept to relocate and fix imports for new attaches
+        std::shared_ptr<loader::e32img> reloc_image;
+
         bool mark{ false };
 
         struct attached_info {
@@ -134,9 +142,7 @@ namespace eka2l1::kernel {
         address lookup(kernel::process *pr, const std::uint32_t ord);
         address lookup_no_relocate(const std::uint32_t ord);
 
-        void set_full_path(const std::u16string &seg_full_path) {
-            full_path = seg_full_path;
-        }
+        void set_full_path(const std::u16string &seg_full_path);
 
         std::u16string get_full_path() {
             return full_path;
@@ -191,5 +197,13 @@ namespace eka2l1::kernel {
 
         // Use for patching
         void set_export(const std::uint32_t ordinal, eka2l1::ptr<void> address);
+
+        void set_relocation_image(std::shared_ptr<loader::e32img> image) {
+            reloc_image = std::move(image);
+        }
+
+        loader::e32img *get_relocation_image() {
+            return reloc_image.get();
+        }
     };
 }
\ No newline at end of file
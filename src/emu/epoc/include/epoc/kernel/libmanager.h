@@ -49,6 +49,10 @@ namespace eka2l1 {
 
     typedef uint32_t address;
 
+    namespace common {
+        class page_dedup_pool;
+    }
+
     namespace kernel {
         class chunk;
         class process;
@@ -63,6 +67,7 @@ namespace eka2l1 {
     namespace loader {
         struct e32img;
         struct romimg;
+        class e32img_cache;
 
         using e32img_ptr = std::shared_ptr<e32img>;
         using romimg_ptr = std::shared_ptr<romimg>;
@@ -85,16 +90,39 @@ namespace eka2l1 {
 
             bool log_svc{ false };
 
+            std::unique_ptr<loader::e32img_cache> e32_cache; ///< Only there if caching is enabled in the config.
+            std::unique_ptr<common::page_dedup_pool> code_pages; ///< Only there if code page sharing is enabled in the config.
+
         protected:
             void load_patch_libraries(const std::string &patch_folder);
 
+            /*! \brief Reuse a codeseg already loaded from this path.
+             *
+             * Non-ROM codesegs are only reused if the image header on disk still matches.
+             * 
+             * \returns Nullptr if there is none, or the image has to be loaded again.
+            */
+            codeseg_ptr load_from_index(const std::u16string &path, kernel::process *pr);
+
         public:
             std::unordered_map<sid, epoc_import_func> svc_funcs;
 
             explicit lib_manager();
+            ~lib_manager();
 
             bool patch_scripts(const std::string &lib_name, kernel::process *pr, codeseg_ptr seg);
 
+            /*! \brief Back the relocated code of a RAM codeseg with pages of the same content.
+             *
+             * Code pages identical to ones already loaded, in this emulator or, if a share directory
+             * is configured, in another one, end up using the same host memory until written.
+            */
+            void share_code_pages(codeseg_ptr seg, kernel::process *pr);
+
+            /*! \brief Get the number of bytes of code that share_code_pages() no longer keeps a copy of.
+            */
+            std::size_t get_code_bytes_shared() const;
+
             /**
              * \brief Initialize the library manager.
              * 
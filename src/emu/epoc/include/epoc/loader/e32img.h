@@ -210,6 +210,19 @@ namespace eka2l1 {
          */
         std::optional<e32img> parse_e32img(common::ro_stream *stream, bool read_reloc = true);
 
+        /**
+         * @brief Parse only the header of an E32 Image from stream.
+         * 
+         * Nothing is decompressed, so this is cheap enough to validate an image against
+         * a code segment that was already loaded from it.
+         * 
+         * @param stream     The stream to parse from.
+         * @param ver        Optional pointer which will contain the EPOC version the header targets.
+         * 
+         * @returns An optional contains the header. Nullopt if invalid.
+         */
+        std::optional<e32img_header> parse_e32img_header(common::ro_stream *stream, epocver *ver = nullptr);
+
         /**
          * @brief Check if the stream content is E32 Image.
          * 
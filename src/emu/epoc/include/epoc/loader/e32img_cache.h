@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <epoc/loader/e32img.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace eka2l1::loader {
+    /**
+     * \brief Persistent cache of parsed E32 images.
+     *
+     * Each image is kept in its own file in the cache directory: the decompressed image data
+     * together with the already parsed import, export and relocation tables, so loading it back
+     * needs neither inflate/bytepair nor any table walking.
+     *
+     * An entry is keyed by the image path. It's only used if the modification time and the UIDs
+     * of the image still match and the hash of its content checks out; otherwise it's rebuilt
+     * the next time the image is parsed.
+     */
+    class e32img_cache {
+        std::string cache_dir_;
+
+        std::string get_entry_path(const std::u16string &path) const;
+
+    public:
+        explicit e32img_cache(const std::string &cache_dir);
+
+        /**
+         * \brief Load a cached image.
+         *
+         * \param path   The path of the image.
+         * \param mtime  Last modification time of the image.
+         * \param header The image header, as read from the image itself.
+         *
+         * \returns Nullopt if there is no entry, or if the entry is stale or corrupted.
+         */
+        std::optional<e32img> load(const std::u16string &path, const std::uint64_t mtime,
+            const e32img_header &header);
+
+        /**
+         * \brief Cache a parsed image, replacing any older entry of this path.
+         *
+         * \returns True on success.
+         */
+        bool store(const std::u16string &path, const std::uint64_t mtime, e32img &img);
+    };
+}
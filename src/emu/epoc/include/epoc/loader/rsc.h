@@ -24,9 +24,11 @@
 #pragma once
 
 #include <cstdint>
+#include <list>
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1 {
@@ -73,10 +75,21 @@ namespace eka2l1::loader {
 
         std::vector<std::uint8_t> unicode_flag_array;
         std::vector<std::uint8_t> res_data;
+        std::vector<std::uint8_t> dict_data;
 
         std::vector<std::uint16_t> resource_offsets;
         std::vector<std::uint16_t> dict_offsets;
 
+        struct cached_resource {
+            std::vector<std::uint8_t> data;
+            std::list<int>::iterator lru;
+        };
+
+        std::unordered_map<int, cached_resource> cache;
+        std::list<int> cache_lru; ///< Most recently used resource index first.
+        std::size_t cache_budget;
+        std::size_t cache_size;
+
     protected:
         void read_header_and_resource_index(common::ro_stream *seri);
 
@@ -84,8 +97,15 @@ namespace eka2l1::loader {
 
         bool own_res_id(const int res_id);
 
+        void add_to_cache(const int res_index, const std::vector<std::uint8_t> &data);
+        void shrink_cache(const std::size_t target_size);
+
     public:
-        explicit rsc_file(common::ro_stream *seri);
+        enum {
+            DEFAULT_CACHE_BUDGET = 64 * 1024
+        };
+
+        explicit rsc_file(common::ro_stream *seri, const std::size_t cache_budget = DEFAULT_CACHE_BUDGET);
         bool is_resource_contains_unicode(int res_id, bool first_rsc_is_gen);
 
         std::vector<std::uint8_t> read(const int res_id);
@@ -96,6 +116,18 @@ namespace eka2l1::loader {
         }
 
         bool confirm_signature();
+
+        /**
+         * \brief Set the maximum number of bytes of resources kept after being read.
+         *
+         * Resources read are kept until the budget is exceeded, dropping the least recently used
+         * first. A budget of 0 disables the cache.
+         */
+        void set_cache_budget(const std::size_t budget);
+
+        std::size_t get_cache_size() const {
+            return cache_size;
+        }
     };
 
     void absorb_resource_string(common::chunkyseri &seri, std::u16string &str);
@@ -24,6 +24,7 @@
 
 #include <atomic>
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -44,6 +45,7 @@ namespace eka2l1 {
     bool parse_new_centrep_ini(const std::string &path, central_repo &repo);
 
     class central_repo_server;
+    class compiled_repo_cache;
 
     struct central_repo_client_session {
         central_repo_server *server;
@@ -75,6 +77,8 @@ namespace eka2l1 {
         central_repos_cacher backup_cacher;
         drive_number rom_drv;
 
+        std::unique_ptr<compiled_repo_cache> compiled_cache; ///< Only there if caching is enabled in the config.
+
         std::atomic<std::uint32_t> id_counter;
 
         // These drives must be internal, aka not removeable
@@ -89,6 +93,12 @@ namespace eka2l1 {
         int load_repo_adv(eka2l1::io_system *io, manager::device_manager *mngr, central_repo *repo, const std::uint32_t key,
             bool scan_org_only = false);
 
+        /*! \brief Load an INI repository, from its compiled form if it's cached.
+         *
+         * \param path Host path of the INI.
+        */
+        bool load_ini_repo(const std::u16string &path, central_repo &repo);
+
         eka2l1::central_repo *load_repo(eka2l1::io_system *io, manager::device_manager *mngr, const std::uint32_t key);
         void callback_on_drive_change(eka2l1::io_system *io, const drive_number drv, int act);
 
@@ -98,6 +108,7 @@ namespace eka2l1 {
         void redirect_msg_to_session(service::ipc_context &ctx);
 
         explicit central_repo_server(eka2l1::system *sys);
+        ~central_repo_server() override;
         eka2l1::central_repo *get_initial_repo(eka2l1::io_system *io, manager::device_manager *mngr, const std::uint32_t key);
 
         /**
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace eka2l1 {
+    struct central_repo;
+
+    /**
+     * \brief Persistent cache of central repositories compiled from their INI form.
+     *
+     * Each repository is kept in its own file in the cache directory, as a sorted array of
+     * fixed-size key records followed by a blob holding the values. Loading it back is a
+     * single map and walk over the records, with no text parsing involved.
+     *
+     * An entry is keyed by the INI path. It's only used if the modification time and the size
+     * of the INI still match and the hash of its content checks out; otherwise it's rebuilt
+     * the next time the INI is parsed.
+     */
+    class compiled_repo_cache {
+        std::string cache_dir_;
+
+        std::string get_entry_path(const std::u16string &path) const;
+
+    public:
+        explicit compiled_repo_cache(const std::string &cache_dir);
+
+        /**
+         * \brief Load a compiled repository.
+         *
+         * Only the fields the INI describes are filled. The repository is left untouched on failure.
+         *
+         * \param path  Host path of the INI.
+         * \param repo  The repository to fill.
+         *
+         * \returns False if there is no entry, or if the entry is stale or corrupted.
+         */
+        bool load(const std::u16string &path, central_repo &repo);
+
+        /**
+         * \brief Compile a parsed repository, replacing any older entry of this INI.
+         *
+         * \returns True on success.
+         */
+        bool store(const std::u16string &path, const central_repo &repo);
+    };
+}
@@ -25,6 +25,7 @@
 
 #include <epoc/services/centralrepo/repo.h>
 #include <memory>
+#include <vector>
 
 namespace eka2l1 {
     namespace common {
@@ -32,4 +33,16 @@ namespace eka2l1 {
     }
 
     int do_state_for_cre(common::chunkyseri &seri, eka2l1::central_repo &repo);
+
+    /*! \brief Append a journal record of a changed entry to given buffer.
+    */
+    void append_cre_journal_record(std::vector<std::uint8_t> &buf, const central_repo_entry &entry);
+
+    /*! \brief Apply journal records to a repository, in the order they were written.
+     *
+     * A truncated record at the end, left by an interrupted write, is ignored.
+     *
+     * \returns Number of records applied.
+    */
+    std::uint32_t apply_cre_journal(const std::uint8_t *data, const std::size_t size, eka2l1::central_repo &repo);
 }
\ No newline at end of file
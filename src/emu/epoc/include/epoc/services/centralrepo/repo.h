@@ -26,6 +26,7 @@
 #include <common/types.h>
 
 #include <cstdint>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -83,6 +84,39 @@ namespace eka2l1 {
 
     struct central_repo_client_subsession;
 
+    struct central_repo_notify_request {
+        central_repo_client_subsession *owner;
+        epoc::notify_info sts;
+    };
+
+    /*! \brief Notify requests on a repository, bucketed by their mask and the key bits it keeps.
+     *
+     * A changed key is looked up once per distinct mask, so only the requests it matches are visited.
+    */
+    struct central_repo_notify_index {
+        // Mask -> (partial key & mask) -> requests
+        std::map<std::uint32_t, std::unordered_map<std::uint32_t, std::vector<central_repo_notify_request>>> buckets;
+
+        bool exists(central_repo_client_subsession *owner, const std::uint32_t mask, const std::uint32_t partial_key);
+        void add(central_repo_client_subsession *owner, epoc::notify_info &info, const std::uint32_t mask,
+            const std::uint32_t partial_key);
+
+        /*! \brief Take out all requests the given key matches.
+        */
+        void collect(const std::uint32_t key, std::vector<central_repo_notify_request> &matched);
+
+        /*! \brief Take out requests of a client.
+         *
+         * \param mask        The mask of requests to remove. Zero removes all of them, regardless of the partial key.
+        */
+        void remove(central_repo_client_subsession *owner, const std::uint32_t mask, const std::uint32_t partial_key,
+            std::vector<central_repo_notify_request> &removed);
+
+        bool empty() const {
+            return buckets.empty();
+        }
+    };
+
     struct central_repo {
         drive_number reside_place;
 
@@ -95,7 +129,7 @@ namespace eka2l1 {
 
         std::uint32_t owner_uid;
 
-        std::vector<central_repo_entry> entries;
+        std::vector<central_repo_entry> entries; ///< Sorted by key.
         std::vector<central_repo_client_subsession *> attached;
 
         central_repo_entry_access_policy default_policy;
@@ -109,9 +143,55 @@ namespace eka2l1 {
 
         std::vector<std::uint32_t> deleted_settings;
 
+        central_repo_notify_index notifies;
+
+        std::uint32_t journal_records = 0; ///< Number of changes appended to the journal since the last full write.
+
+        /**
+         * \brief Write the whole repository to its CRE file in the persists folder.
+         *
+         * The journal is discarded afterwards, since the CRE already has all its changes.
+         */
         void write_changes(eka2l1::io_system *io, manager::device_manager *mngr);
+
+        /**
+         * \brief Persist a change to an entry by appending it to the repository's journal.
+         *
+         * Once the journal grows past a fixed number of records, the whole repository is written
+         * instead, and the journal starts over.
+         *
+         * \param entry The entry which has changed.
+         */
+        void journal_change(eka2l1::io_system *io, manager::device_manager *mngr, const central_repo_entry &entry);
+
+        /**
+         * \brief Apply changes recorded in the journal of this repository, if there is one.
+         *
+         * The repository is then written whole, and the journal discarded.
+         *
+         * \returns Number of changes applied.
+         */
+        std::uint32_t replay_journal(eka2l1::io_system *io, manager::device_manager *mngr);
+
         central_repo_entry *find_entry(const std::uint32_t key);
 
+        /**
+         * \brief Find all entries whose key matches the partial key on the bits set in the mask.
+         *
+         * Only the range of keys sharing the leading masked bits with the partial key is walked.
+         *
+         * \param partial_key     The bit pattern to be matched.
+         * \param mask            Bits of the key to compare.
+         * \param matched_entries Vector to append matched entries to, in key order.
+         */
+        void find_entries(const std::uint32_t partial_key, const std::uint32_t mask,
+            std::vector<central_repo_entry *> &matched_entries);
+
+        /**
+         * \brief Complete all notify requests on this repository which watch the given key.
+         */
+        void notify_change(const std::uint32_t key);
+
         std::uint32_t get_default_meta_for_new_key(const std::uint32_t key);
 
         bool add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var);
@@ -225,15 +305,6 @@ namespace eka2l1 {
 
         void handle_message(service::ipc_context *ctx);
 
-        struct cenrep_notify_info {
-            epoc::notify_info sts;
-
-            std::uint32_t mask;
-            std::uint32_t match;
-        };
-
-        std::vector<cenrep_notify_info> notifies;
-
         enum session_flags {
             active = 0x1
         };
@@ -284,7 +355,8 @@ namespace eka2l1 {
 
         /*! \brief Notify that a modification has success.
          *
-         * This iters through all notify requests, if it matchs than notify request client.
+         * This completes every request on the attached repository that watches the key, no matter
+         * which client made it.
         */
         void modification_success(const std::uint32_t key);
 
@@ -68,7 +68,7 @@ namespace eka2l1::service {
         address lr_addr_;
         address data_offset_;
 
-        std::unique_ptr<common::block_allocator> allocator_;
+        std::unique_ptr<common::tlsf_allocator> allocator_;
         std::vector<std::uint8_t *> free_lists_;
 
     public:
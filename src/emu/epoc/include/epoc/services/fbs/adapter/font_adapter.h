@@ -88,6 +88,24 @@ namespace eka2l1::epoc::adapter {
         // End getting atlas.
         virtual void end_get_atlas() = 0;
 
+        /**
+         * \brief Rasterize a single glyph, to be placed in an atlas by the caller.
+         *
+         * Each pixel is 8 bits, rows are tightly packed.
+         *
+         * \param idx               Index of the font in this file.
+         * \param code              Unicode point of the glyph.
+         * \param font_size         Size of the font to render, in pixels.
+         * \param info              Receive offsets and advance of the glyph. The position in atlas is not touched.
+         * \param rasterized_width  Receive width of the glyph bitmap.
+         * \param rasterized_height Receive height of the glyph bitmap.
+         *
+         * \returns The glyph bitmap, to be freed with free_glyph_bitmap. NULL if the glyph has nothing to draw.
+         */
+        virtual std::uint8_t *get_glyph_image(const std::size_t idx, const std::uint32_t code, const int font_size,
+            character_info &info, int *rasterized_width, int *rasterized_height)
+            = 0;
+
         /**
          * \brief Get total number of font this file consists of.
          * \returns Number of font in this file.
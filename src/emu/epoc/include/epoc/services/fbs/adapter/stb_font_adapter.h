@@ -65,6 +65,9 @@ namespace eka2l1::epoc::adapter {
 
         void end_get_atlas() override;
 
+        std::uint8_t *get_glyph_image(const std::size_t idx, const std::uint32_t code, const int font_size,
+            character_info &info, int *rasterized_width, int *rasterized_height) override;
+
         glyph_bitmap_type get_output_bitmap_type() const override {
             return antialised_glyph_bitmap;
         }
@@ -259,7 +259,7 @@ namespace eka2l1 {
         fbs_load_data_err_read_decomp_fail
     };
 
-    class fbs_chunk_allocator : public common::block_allocator {
+    class fbs_chunk_allocator : public common::tlsf_allocator {
         chunk_ptr target_chunk;
 
     public:
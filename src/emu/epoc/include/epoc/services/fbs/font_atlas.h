@@ -22,10 +22,10 @@
 #include <epoc/services/fbs/adapter/font_adapter.h>
 #include <epoc/services/window/common.h>
 
-#include <deque>
-#include <map>
+#include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1::drivers {
@@ -36,23 +36,62 @@ namespace eka2l1::drivers {
 namespace eka2l1::epoc {
 #define ESTIMATE_MAX_CHAR_IN_ATLAS_WIDTH 50
 
+    /**
+     * \brief A row of glyphs in the atlas, all sharing the same top.
+     */
+    struct font_atlas_shelf {
+        int y_;
+        int height_;
+        int cursor_;
+        std::uint32_t last_use_;
+        std::vector<char16_t> glyphs_;
+    };
+
+    struct font_atlas_glyph {
+        adapter::character_info info_;
+        int shelf_; ///< -1 if the glyph has no bitmap (space, etc...).
+        std::list<char16_t>::iterator lru_;
+    };
+
     /**
      * \brief Font atlas is a texture contains glyph bitmaps.
      * 
      * The atlas dimension is a square, and height is equals to font_size *
      * estimate_max_char_in_atlas.
+     *
+     * Glyphs are rasterized on first use and packed in shelves. When the atlas is full, the shelf
+     * holding the least recently used glyph is recycled, so the rest of the atlas stays in place.
      */
     struct font_atlas {
-        std::map<char16_t, adapter::character_info> characters_;
+        std::unordered_map<char16_t, font_atlas_glyph> characters_;
+        std::list<char16_t> lru_; ///< Most recently used glyph first.
+        std::vector<font_atlas_shelf> shelves_;
+
         drivers::handle atlas_handle_;
         adapter::font_file_adapter_base *adapter_;
         int size_;
 
-        std::vector<int> last_use_;
+        int shelf_bottom_;
+        std::uint32_t draw_serial_;
+
+        // Rows of the atlas changed since the last upload, [dirty_top_, dirty_bottom_)
+        int dirty_top_;
+        int dirty_bottom_;
 
         std::pair<char16_t, char16_t> initial_range_;
         std::unique_ptr<std::uint8_t[]> atlas_data_;
 
+        std::vector<eka2l1::rect> dest_rects_;
+        std::vector<eka2l1::rect> source_rects_;
+
+        font_atlas_glyph *add_glyph(const char16_t chr);
+        int find_shelf(const int width, const int height);
+        int evict_shelf(const int height);
+
+        font_atlas_glyph *get_glyph(const char16_t chr);
+        void reset_glyphs();
+        void upload_dirty(drivers::graphics_command_list_builder *builder);
+
     public:
         explicit font_atlas();
 
@@ -22,16 +22,21 @@
 
 #include <epoc/services/context.h>
 #include <epoc/services/framework.h>
+#include <epoc/services/fs/notify.h>
 #include <epoc/services/server.h>
 #include <epoc/utils/des.h>
 
 #include <epoc/ptr.h>
 
+#include <common/watcher.h>
+
 #include <atomic>
 #include <clocale>
 #include <memory>
-#include <regex>
+#include <mutex>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace eka2l1::kernel {
     using uid = std::uint32_t;
@@ -55,6 +60,8 @@ namespace eka2l1 {
     struct io_component;
     using io_component_ptr = std::unique_ptr<io_component>;
 
+    struct entry_batch;
+
     enum class fs_file_attrib_flag {
         exclusive = 1 << 0,
         share_read = 1 << 1,
@@ -68,6 +75,8 @@ namespace eka2l1 {
         io_component_ptr vfs_node;
         file_attrib *attrib;
 
+        std::unique_ptr<entry_batch> dir_entries; ///< Directory entries fetched ahead of the client.
+
         int mix_mode;
         int open_mode;
         bool temporary = false;
@@ -140,6 +149,10 @@ namespace eka2l1 {
 
         void notify_change_ex(service::ipc_context *ctx);
         void notify_change(service::ipc_context *ctx);
+        void notify_change_cancel(service::ipc_context *ctx);
+        void notify_change_cancel_ex(service::ipc_context *ctx);
+
+        void add_notify(service::ipc_context *ctx, const std::u16string &pattern);
 
         void mkdir(service::ipc_context *ctx);
         void rmdir(service::ipc_context *ctx);
@@ -162,16 +175,13 @@ namespace eka2l1 {
             disk = 0x40
         };
 
-        struct notify_entry {
-            std::regex match_pattern;
-            notify_type type;
-            eka2l1::ptr<epoc::request_status> request_status;
-            kernel::thread *request_thread;
-        };
-
-        std::vector<notify_entry> notify_entries;
+        static constexpr std::uint32_t NOTIFY_FILE_ENTRY_CHANGE = static_cast<std::uint32_t>(notify_type::entry)
+            | static_cast<std::uint32_t>(notify_type::file);
+        static constexpr std::uint32_t NOTIFY_DIR_ENTRY_CHANGE = static_cast<std::uint32_t>(notify_type::entry)
+            | static_cast<std::uint32_t>(notify_type::dir);
+        static constexpr std::uint32_t NOTIFY_WRITE_CHANGE = static_cast<std::uint32_t>(notify_type::write);
+        static constexpr std::uint32_t NOTIFY_ATTRIB_CHANGE = static_cast<std::uint32_t>(notify_type::attrib);
 
-        void notify(const utf16_str &entry, const notify_type type);
         bool should_notify_failures;
     };
 
@@ -234,6 +244,17 @@ namespace eka2l1 {
         std::unordered_map<std::u16string, file_attrib, fs_path_case_insensitive_hasher> attribs;
         service::property *system_drive_prop;
 
+        epoc::fs::notify_trie notify_entries;
+        std::unordered_map<std::u16string, std::int64_t> notify_watches; ///< Host watch of each directory having notifies under it.
+        std::unordered_map<std::u16string, std::uint64_t> notify_recent_changes; ///< Changes made by the emulator, with the time they were made.
+        std::vector<std::u16string> notify_stale_watches; ///< Watches to remove from the server thread.
+        std::mutex notify_lock;
+
+        void watch_notify_directory(const std::u16string &dir);
+        void release_notify_watches(std::vector<std::u16string> &emptied, const bool from_host);
+        void on_host_directory_changes(const std::u16string &dir, common::directory_changes &changes);
+        void complete_notifies(std::vector<epoc::fs::notify_entry> &entries, const int err, const bool from_host);
+
         void connect(service::ipc_context &ctx) override;
         void disconnect(service::ipc_context &ctx) override;
 
@@ -249,5 +270,23 @@ namespace eka2l1 {
         explicit fs_server(system *sys);
 
         file *get_file(const kernel::uid session_uid, const std::uint32_t handle);
+
+        /**
+         * \brief Report a change of an entry to pending change notifications.
+         *
+         * \param path        Absolute path of the entry that changed.
+         * \param change_mask Bitmask of fs_server_client::notify_type describing the change.
+         * \param from_host   True if the change was picked up from the host, outside of the emulator.
+         */
+        void notify(const std::u16string &path, const std::uint32_t change_mask, const bool from_host = false);
+
+        /**
+         * \brief Cancel pending change notifications of a session.
+         *
+         * \param owner  The UID of the session.
+         * \param sts    The request to cancel, or null for every request of the session.
+         * \param err    Code to complete the cancelled requests with. Zero drops them without completion.
+         */
+        void cancel_notify(const kernel::uid owner, const eka2l1::ptr<epoc::request_status> sts, const int err);
     };
 }
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <epoc/utils/reqsts.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1::epoc::fs {
+    /**
+     * \brief A change notification request waiting for completion.
+     */
+    struct notify_entry {
+        std::u16string match_pattern; ///< Folded wildcard the full path of the changed entry must match.
+        std::uint32_t type_mask; ///< Change types this request is interested in.
+        epoc::notify_info info; ///< The request to complete.
+        std::uint32_t owner; ///< Session that requested the notification.
+    };
+
+    /**
+     * \brief Index of pending change notifications, keyed by drive and directory components.
+     *
+     * A request is stored under the longest wildcard-free directory prefix of its pattern. A change
+     * only has to look at the nodes along its own path, so the cost of a write, rename or delete
+     * grows with the path depth and the requests that could actually match it, not with the number of
+     * requests pending on the whole server.
+     *
+     * Patterns and paths are folded to lowercase. A pattern ending with a separator watches everything
+     * below that directory, as on real hardware.
+     *
+     * All functions are thread-safe.
+     */
+    class notify_trie {
+        struct node {
+            std::u16string path; ///< Folded path of this node, without trailing separator.
+            std::unordered_map<std::u16string, std::unique_ptr<node>> children;
+            std::vector<notify_entry> entries;
+            node *parent;
+
+            explicit node(node *parent, std::u16string path)
+                : path(std::move(path))
+                , parent(parent) {
+            }
+        };
+
+        node root_;
+        std::size_t count_;
+        mutable std::mutex lock_;
+
+        void prune(node *n);
+        void remove_from(node *n, const std::uint32_t owner, const eka2l1::ptr<epoc::request_status> sts,
+            std::vector<notify_entry> &removed, std::vector<std::u16string> *emptied);
+
+    public:
+        explicit notify_trie();
+
+        /**
+         * \brief Fold a path or pattern into the form used by the trie.
+         *
+         * Lowercases the string, and turns a trailing separator into a match-everything-below star.
+         */
+        static std::u16string fold(const std::u16string &path);
+
+        /**
+         * \brief Add a new pending request.
+         *
+         * \param entry       The request. Its pattern is folded before being stored.
+         * \param node_path   If not null, receives the folded directory the request was indexed under.
+         *
+         * \returns True if this is the first request indexed under that directory.
+         */
+        bool add(notify_entry entry, std::u16string *node_path = nullptr);
+
+        /**
+         * \brief Take out every request matching a change.
+         *
+         * \param path        Full path of the changed entry.
+         * \param change_mask The kind of change that happened.
+         * \param matched     Receives the requests that matched. They are removed from the trie.
+         * \param emptied     If not null, receives directories that no longer have requests under them.
+         */
+        void collect(const std::u16string &path, const std::uint32_t change_mask, std::vector<notify_entry> &matched,
+            std::vector<std::u16string> *emptied = nullptr);
+
+        /**
+         * \brief Take out requests of a session.
+         *
+         * \param owner       The session.
+         * \param sts         The request status to cancel, or null for every request of the session.
+         * \param removed     Receives the requests removed.
+         * \param emptied     If not null, receives directories that no longer have requests under them.
+         */
+        void remove(const std::uint32_t owner, const eka2l1::ptr<epoc::request_status> sts, std::vector<notify_entry> &removed,
+            std::vector<std::u16string> *emptied = nullptr);
+
+        std::size_t size() const;
+    };
+}
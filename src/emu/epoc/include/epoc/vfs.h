@@ -29,7 +29,9 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <string>
+#include <vector>
 
 namespace eka2l1 {
     class memory_system;
@@ -174,8 +176,24 @@ namespace eka2l1 {
 
         virtual std::uint64_t last_modify_since_1ad() = 0;
 
-        std::size_t read_file(const std::uint64_t offset, void *buf, std::uint32_t size,
+        /*! \brief Read from the given offset, without moving the seek cursor.
+         *
+         * The default implementation seeks around a normal read. Files that can read at an
+         * offset directly should override it.
+         *
+         * \returns Total bytes read.
+         */
+        virtual std::size_t read_file(const std::uint64_t offset, void *buf, std::uint32_t size,
             std::uint32_t count);
+
+        /*! \brief Get the whole content of the file, if it already lives in memory.
+         *
+         * Files burnt in the ROM are views of the mapped ROM image, so they can be parsed
+         * in place instead of being read into a buffer.
+         *
+         * \returns Pointer to the first byte of the file, or nullptr if it must be read.
+         */
+        virtual const std::uint8_t *direct_view() const;
     };
 
     using symfile = std::unique_ptr<file>;
@@ -214,12 +232,67 @@ namespace eka2l1 {
         std::uint64_t last_write;
     };
 
+    /*! \brief Compact directory entry, filled in bulk by directory::get_next_entries. */
+    struct packed_entry_info {
+        std::uint64_t size;
+        std::uint64_t last_write; ///< Microseconds since 1AD.
+
+        io_attrib attribute;
+        io_component_type type;
+
+        int raw_attribute;
+        bool has_raw_attribute;
+
+        std::uint32_t name_offset; ///< Offset of the name in the batch's name pool, in UCS-2 characters.
+        std::uint32_t name_length; ///< Length of the name, in UCS-2 characters.
+    };
+
+    /*! \brief Reusable storage for bulk directory enumeration.
+     *
+     * All names live back to back in one UCS-2 pool, so refilling a batch that has
+     * been used before doesn't allocate.
+     */
+    struct entry_batch {
+        std::vector<packed_entry_info> entries;
+        std::u16string names;
+
+        std::size_t cursor = 0; ///< Index of the first entry not consumed yet.
+
+        void clear() {
+            entries.clear();
+            names.clear();
+            cursor = 0;
+        }
+
+        std::size_t remaining() const {
+            return entries.size() - cursor;
+        }
+
+        const char16_t *name_of(const packed_entry_info &info) const {
+            return names.data() + info.name_offset;
+        }
+
+        void add(const packed_entry_info &info, const std::u16string &name);
+    };
+
     struct directory : public io_component {
         explicit directory(io_attrib attrib = io_attrib::none);
 
+        /*! \brief Get many of the next entries at once.
+        *
+        * The batch is cleared first. Entries are taken out of the directory the same way
+        * get_next_entry does.
+        *
+        * \param batch     The batch to fill.
+        * \param max_count Maximum number of entries to fetch.
+        *
+        * \returns Number of entries fetched. 0 means there is nothing left.
+        */
+        virtual std::size_t get_next_entries(entry_batch &batch, const std::size_t max_count);
+
         /*! \brief Get the next iterating entry. 
         *
-        * All the entries are filtered through a regex expression. The directory iterator
+        * All the entries are filtered through a wildcard pattern. The directory iterator
         * will increase itself if it's not at the end entry, and returns the entry info. Else,
         * it will return nothing
         */
@@ -296,7 +369,7 @@ namespace eka2l1 {
 
     class io_system {
         std::map<filesystem_id, file_system_inst> filesystems;
-        std::mutex access_lock;
+        std::shared_mutex access_lock;
 
         std::atomic<filesystem_id> id_counter;
 
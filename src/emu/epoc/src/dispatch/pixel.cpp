@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <common/platform.h>
+#include <epoc/dispatch/pixel.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if EKA2L1_ARCH(X86) || EKA2L1_ARCH(X64)
+#include <emmintrin.h>
+#define SCDV_PIXEL_SSE2 1
+#endif
+
+namespace eka2l1::dispatch {
+    // The driver's blend, red and blue together then green: channel + (target - channel) * alpha / 256
+    static std::uint32_t mix_rgb(const std::uint32_t pixel, const std::uint32_t color, const std::uint32_t alpha) {
+        std::uint32_t rb = pixel & 0xFF00FF;
+        std::uint32_t g = pixel & 0x00FF00;
+
+        rb += ((color & 0xFF00FF) - rb) * alpha >> 8;
+        g += ((color & 0x00FF00) - g) * alpha >> 8;
+
+        return (rb & 0xFF00FF) | (g & 0x00FF00);
+    }
+
+    static std::uint32_t blend_pen(const std::uint32_t pixel, const std::uint32_t color) {
+        const std::uint32_t alpha = color >> 24;
+
+        // Zero alpha is taken as opaque, some games never set it
+        if ((alpha == 0) || (alpha == 0xFF)) {
+            return (color & 0xFFFFFF) | 0xFF000000;
+        }
+
+        // The driver mixes with red and blue swapped, and only marks the alpha
+        const std::uint32_t swapped = ((color >> 16) & 0xFF) | (color & 0xFF00) | ((color & 0xFF) << 16);
+        return mix_rgb(pixel, swapped, alpha) | (pixel & 0xFF000000) | 0x01000000;
+    }
+
+    static std::uint32_t blend_mask(const std::uint32_t pixel, const std::uint32_t color, const std::uint32_t mask) {
+        if (mask == 0) {
+            return pixel;
+        }
+
+        if (mask == 0xFF) {
+            return color | 0xFF000000;
+        }
+
+        return mix_rgb(pixel, color, mask) | 0xFF000000;
+    }
+
+    template <scdv_pixel_op op>
+    static std::uint32_t apply_op(const std::uint32_t pixel, const std::uint32_t color) {
+        if constexpr (op == scdv_pixel_op_write) {
+            return color;
+        } else if constexpr (op == scdv_pixel_op_and) {
+            return pixel & color;
+        } else if constexpr (op == scdv_pixel_op_or) {
+            return pixel | color;
+        } else if constexpr (op == scdv_pixel_op_xor) {
+            return pixel ^ color;
+        } else if constexpr (op == scdv_pixel_op_not_screen) {
+            return ~pixel;
+        } else if constexpr (op == scdv_pixel_op_and_not) {
+            return ~pixel & color;
+        } else {
+            return blend_pen(pixel, color);
+        }
+    }
+
+#if SCDV_PIXEL_SSE2
+    static __m128i select_x4(const __m128i lane_mask, const __m128i if_set, const __m128i if_clear) {
+        return _mm_or_si128(_mm_and_si128(lane_mask, if_set), _mm_andnot_si128(lane_mask, if_clear));
+    }
+
+    // Alpha is in both 16-bit halves of each lane. A channel times alpha always fits 16 bits,
+    // so 16-bit multiplies give the same 32-bit products, and differences wrap as in the scalar code.
+    static __m128i mix_rgb_x4(const __m128i pixel, const __m128i color, const __m128i alpha) {
+        const __m128i rb_mask = _mm_set1_epi32(0xFF00FF);
+        const __m128i g_mask = _mm_set1_epi32(0x00FF00);
+
+        const __m128i rb = _mm_and_si128(pixel, rb_mask);
+        const __m128i rb_delta = _mm_sub_epi32(_mm_mullo_epi16(_mm_and_si128(color, rb_mask), alpha),
+            _mm_mullo_epi16(rb, alpha));
+        const __m128i rb_result = _mm_and_si128(_mm_add_epi32(rb, _mm_srli_epi32(rb_delta, 8)), rb_mask);
+
+        // Green is done one byte down, the lost shift is taken back by dropping the top byte of the delta
+        const __m128i g = _mm_and_si128(pixel, g_mask);
+        const __m128i g_delta = _mm_sub_epi32(_mm_mullo_epi16(_mm_srli_epi32(_mm_and_si128(color, g_mask), 8), alpha),
+            _mm_mullo_epi16(_mm_srli_epi32(g, 8), alpha));
+        const __m128i g_result = _mm_and_si128(_mm_add_epi32(g, _mm_and_si128(g_delta, _mm_set1_epi32(0xFFFFFF))), g_mask);
+
+        return _mm_or_si128(rb_result, g_result);
+    }
+
+    static __m128i spread_alpha_x4(const __m128i alpha) {
+        return _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+    }
+
+    static __m128i blend_pen_x4(const __m128i pixel, const __m128i color) {
+        const __m128i byte_mask = _mm_set1_epi32(0xFF);
+        const __m128i alpha = _mm_srli_epi32(color, 24);
+
+        const __m128i swapped = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(color, 16), byte_mask),
+                                                 _mm_and_si128(color, _mm_set1_epi32(0xFF00))),
+            _mm_slli_epi32(_mm_and_si128(color, byte_mask), 16));
+
+        const __m128i mixed = _mm_or_si128(mix_rgb_x4(pixel, swapped, spread_alpha_x4(alpha)),
+            _mm_or_si128(_mm_and_si128(pixel, _mm_set1_epi32(0xFF000000)), _mm_set1_epi32(0x01000000)));
+
+        const __m128i opaque = _mm_or_si128(_mm_and_si128(color, _mm_set1_epi32(0xFFFFFF)), _mm_set1_epi32(0xFF000000));
+        const __m128i no_mix = _mm_or_si128(_mm_cmpeq_epi32(alpha, _mm_setzero_si128()), _mm_cmpeq_epi32(alpha, byte_mask));
+
+        return select_x4(no_mix, opaque, mixed);
+    }
+
+    static __m128i blend_mask_x4(const __m128i pixel, const __m128i color, const __m128i mask) {
+        const __m128i opaque_alpha = _mm_set1_epi32(0xFF000000);
+        const __m128i mixed = _mm_or_si128(mix_rgb_x4(pixel, color, spread_alpha_x4(mask)), opaque_alpha);
+
+        const __m128i result = select_x4(_mm_cmpeq_epi32(mask, _mm_set1_epi32(0xFF)), _mm_or_si128(color, opaque_alpha), mixed);
+        return select_x4(_mm_cmpeq_epi32(mask, _mm_setzero_si128()), pixel, result);
+    }
+
+    template <scdv_pixel_op op>
+    static __m128i apply_op_x4(const __m128i pixel, const __m128i color) {
+        if constexpr (op == scdv_pixel_op_write) {
+            return color;
+        } else if constexpr (op == scdv_pixel_op_and) {
+            return _mm_and_si128(pixel, color);
+        } else if constexpr (op == scdv_pixel_op_or) {
+            return _mm_or_si128(pixel, color);
+        } else if constexpr (op == scdv_pixel_op_xor) {
+            return _mm_xor_si128(pixel, color);
+        } else if constexpr (op == scdv_pixel_op_not_screen) {
+            return _mm_xor_si128(pixel, _mm_set1_epi32(-1));
+        } else if constexpr (op == scdv_pixel_op_and_not) {
+            return _mm_andnot_si128(pixel, color);
+        } else {
+            return blend_pen_x4(pixel, color);
+        }
+    }
+
+    static __m128i load_x4(const std::uint32_t *ptr) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+    }
+
+    static void store_x4(std::uint32_t *ptr, const __m128i value) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(ptr), value);
+    }
+
+    static __m128i load_mask_x4(const std::uint8_t *mask) {
+        std::int32_t packed = 0;
+        std::memcpy(&packed, mask, sizeof(packed));
+
+        const __m128i zero = _mm_setzero_si128();
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+    }
+#endif
+
+    template <scdv_pixel_op op>
+    static void write_span_with_op(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t color,
+        const std::uint32_t count) {
+        std::uint32_t i = 0;
+
+#if SCDV_PIXEL_SSE2
+        const __m128i color_x4 = _mm_set1_epi32(static_cast<int>(color));
+
+        for (; i + 4 <= count; i += 4) {
+            store_x4(dest + i, apply_op_x4<op>(load_x4(dest + i), source ? load_x4(source + i) : color_x4));
+        }
+#endif
+
+        for (; i < count; i++) {
+            dest[i] = apply_op<op>(dest[i], source ? source[i] : color);
+        }
+    }
+
+    static void write_span_impl(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t color,
+        const std::uint32_t count, const scdv_pixel_op op) {
+        switch (op) {
+        case scdv_pixel_op_write:
+            if (source) {
+                std::memmove(dest, source, count * sizeof(std::uint32_t));
+            } else {
+                std::fill(dest, dest + count, color);
+            }
+
+            break;
+
+        case scdv_pixel_op_and:
+            write_span_with_op<scdv_pixel_op_and>(dest, source, color, count);
+            break;
+
+        case scdv_pixel_op_or:
+            write_span_with_op<scdv_pixel_op_or>(dest, source, color, count);
+            break;
+
+        case scdv_pixel_op_xor:
+            write_span_with_op<scdv_pixel_op_xor>(dest, source, color, count);
+            break;
+
+        case scdv_pixel_op_not_screen:
+            write_span_with_op<scdv_pixel_op_not_screen>(dest, source, color, count);
+            break;
+
+        case scdv_pixel_op_and_not:
+            write_span_with_op<scdv_pixel_op_and_not>(dest, source, color, count);
+            break;
+
+        case scdv_pixel_op_blend:
+            // An uniform color which does not mix is just a fill
+            if (!source && ((color >> 24) == 0 || (color >> 24) == 0xFF)) {
+                std::fill(dest, dest + count, blend_pen(0, color));
+                break;
+            }
+
+            write_span_with_op<scdv_pixel_op_blend>(dest, source, color, count);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void scdv_fill_span(std::uint32_t *dest, const std::uint32_t count, const std::uint32_t color, const scdv_pixel_op op) {
+        write_span_impl(dest, nullptr, color, count, op);
+    }
+
+    void scdv_write_span(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t count, const scdv_pixel_op op) {
+        write_span_impl(dest, source, 0, count, op);
+    }
+
+    void scdv_blend_mask_span(std::uint32_t *dest, const std::uint32_t *source, const std::uint32_t color,
+        const std::uint8_t *mask, const std::uint32_t count) {
+        std::uint32_t i = 0;
+
+#if SCDV_PIXEL_SSE2
+        const __m128i color_x4 = _mm_set1_epi32(static_cast<int>(color));
+
+        for (; i + 4 <= count; i += 4) {
+            store_x4(dest + i, blend_mask_x4(load_x4(dest + i), source ? load_x4(source + i) : color_x4, load_mask_x4(mask + i)));
+        }
+#endif
+
+        for (; i < count; i++) {
+            dest[i] = blend_mask(dest[i], source ? source[i] : color, mask[i]);
+        }
+    }
+
+    void scdv_map_colors_span(std::uint32_t *dest, const std::uint32_t count, const std::uint32_t *pairs,
+        const std::uint32_t num_pairs) {
+        std::uint32_t i = 0;
+
+#if SCDV_PIXEL_SSE2
+        for (; i + 4 <= count; i += 4) {
+            const __m128i original = load_x4(dest + i);
+            __m128i result = original;
+
+            for (std::uint32_t pair = 0; pair < num_pairs; pair++) {
+                const __m128i matched = _mm_cmpeq_epi32(original, _mm_set1_epi32(static_cast<int>(pairs[pair * 2])));
+                result = _mm_and_si128(result, _mm_or_si128(_mm_set1_epi32(static_cast<int>(pairs[pair * 2 + 1])),
+                                                   _mm_xor_si128(matched, _mm_set1_epi32(-1))));
+            }
+
+            store_x4(dest + i, result);
+        }
+#endif
+
+        for (; i < count; i++) {
+            const std::uint32_t original = dest[i];
+
+            for (std::uint32_t pair = 0; pair < num_pairs; pair++) {
+                if (original == pairs[pair * 2]) {
+                    dest[i] &= pairs[pair * 2 + 1];
+                }
+            }
+        }
+    }
+}
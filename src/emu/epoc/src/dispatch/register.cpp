@@ -25,6 +25,10 @@ namespace eka2l1::dispatch {
     const eka2l1::hle::func_map dispatch_funcs = {
         BRIDGE_REGISTER(1, update_screen),
         BRIDGE_REGISTER(2, fast_blit),
+        BRIDGE_REGISTER(3, scdv_fill_rect),
+        BRIDGE_REGISTER(4, scdv_write_line),
+        BRIDGE_REGISTER(5, scdv_blend_line),
+        BRIDGE_REGISTER(6, scdv_map_colors),
         BRIDGE_REGISTER(0x20, eaudio_player_inst),
         BRIDGE_REGISTER(0x21, eaudio_player_notify_any_done),
         BRIDGE_REGISTER(0x22, eaudio_player_supply_url),
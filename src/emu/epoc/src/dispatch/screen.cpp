@@ -19,6 +19,7 @@
 
 #include <common/log.h>
 #include <epoc/dispatch/dispatcher.h>
+#include <epoc/dispatch/pixel.h>
 #include <epoc/dispatch/screen.h>
 
 #include <drivers/graphics/graphics.h>
@@ -91,4 +92,65 @@ namespace eka2l1::dispatch {
                 bytes_to_copy_per_line);
         }
     }
-}
\ No newline at end of file
+
+    BRIDGE_FUNC_DISPATCHER(void, scdv_fill_rect, scdv_fill_info *info) {
+        kernel::process *crr_process = sys->get_kernel_system()->crr_process();
+        std::uint8_t *dest = info->dest_base.get(crr_process);
+
+        if (!dest || (info->size.x <= 0) || (info->size.y <= 0)) {
+            return;
+        }
+
+        for (int y = 0; y < info->size.y; y++) {
+            scdv_fill_span(reinterpret_cast<std::uint32_t *>(dest + y * info->dest_stride), info->size.x, info->color,
+                static_cast<scdv_pixel_op>(info->op));
+        }
+    }
+
+    BRIDGE_FUNC_DISPATCHER(void, scdv_write_line, scdv_line_info *info) {
+        kernel::process *crr_process = sys->get_kernel_system()->crr_process();
+
+        std::uint8_t *dest = info->dest.get(crr_process);
+        const std::uint8_t *source = info->source.get(crr_process);
+
+        if (!dest || !source) {
+            return;
+        }
+
+        scdv_write_span(reinterpret_cast<std::uint32_t *>(dest), reinterpret_cast<const std::uint32_t *>(source),
+            info->length, static_cast<scdv_pixel_op>(info->op));
+    }
+
+    BRIDGE_FUNC_DISPATCHER(void, scdv_blend_line, scdv_line_info *info) {
+        kernel::process *crr_process = sys->get_kernel_system()->crr_process();
+
+        std::uint8_t *dest = info->dest.get(crr_process);
+        const std::uint8_t *mask = info->mask.get(crr_process);
+
+        if (!dest || !mask) {
+            return;
+        }
+
+        // No source means the color is blended
+        const std::uint8_t *source = info->source ? info->source.get(crr_process) : nullptr;
+
+        scdv_blend_mask_span(reinterpret_cast<std::uint32_t *>(dest), reinterpret_cast<const std::uint32_t *>(source),
+            info->color, mask, info->length);
+    }
+
+    BRIDGE_FUNC_DISPATCHER(void, scdv_map_colors, scdv_map_colors_info *info) {
+        kernel::process *crr_process = sys->get_kernel_system()->crr_process();
+
+        std::uint8_t *dest = info->dest_base.get(crr_process);
+        const std::uint32_t *pairs = info->pairs.get(crr_process);
+
+        if (!dest || !pairs || (info->size.x <= 0) || (info->size.y <= 0)) {
+            return;
+        }
+
+        for (int y = 0; y < info->size.y; y++) {
+            scdv_map_colors_span(reinterpret_cast<std::uint32_t *>(dest + y * info->dest_stride), info->size.x, pairs,
+                info->num_pairs);
+        }
+    }
+}
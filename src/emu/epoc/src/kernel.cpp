@@ -81,6 +81,7 @@ namespace eka2l1 {
             *cpu);
 
         rom_map = nullptr;
+        rom_map_size = 0;
 
         // Instantiate btrace
         btrace_inst = std::make_unique<kernel::btrace>(this, io);
@@ -101,10 +102,11 @@ namespace eka2l1 {
 
     void kernel_system::shutdown() {
         if (rom_map) {
-            common::unmap_file(rom_map);
+            common::unmap_file(rom_map, rom_map_size);
         }
 
         rom_map = nullptr;
+        rom_map_size = 0;
         thr_sch.reset();
 
         // Delete one by one in order. Do not change the order
@@ -121,6 +123,9 @@ namespace eka2l1 {
         processes.clear();
         libraries.clear();
         codesegs.clear();
+        codeseg_path_index.clear();
+        codeseg_uid_index.clear();
+        codeseg_ep_index.clear();
         message_queues.clear();
 
         btrace_inst->close_trace_session();
@@ -167,6 +172,10 @@ namespace eka2l1 {
     }
 
     bool kernel_system::destroy(kernel_obj_ptr obj) {
+        if (obj->get_object_type() == kernel::object_type::codeseg) {
+            unindex_codeseg(reinterpret_cast<codeseg_ptr>(obj));
+        }
+
         switch (obj->get_object_type()) {
 #define OBJECT_SEARCH(obj_type, obj_map)                                                                         \
     case kernel::object_type::obj_type: {                                                                        \
@@ -461,29 +470,81 @@ namespace eka2l1 {
         // add_custom_server(ps_srv);
     }
 
+    void kernel_system::index_codeseg(codeseg_ptr seg) {
+        const std::u16string path = seg->get_full_path();
+
+        if (!path.empty()) {
+            codeseg_path_index[common::lowercase_ucs2_string(path)] = seg;
+        }
+
+        codeseg_uid_index.emplace(std::get<2>(seg->get_uids()), seg);
+
+        if (seg->is_rom()) {
+            codeseg_ep_index.emplace(seg->get_entry_point(nullptr), seg);
+        }
+    }
+
+    void kernel_system::unindex_codeseg(codeseg_ptr seg) {
+        const std::u16string path = seg->get_full_path();
+
+        if (!path.empty()) {
+            auto path_ite = codeseg_path_index.find(common::lowercase_ucs2_string(path));
+
+            // Another codeseg may have been loaded from this path since
+            if ((path_ite != codeseg_path_index.end()) && (path_ite->second == seg)) {
+                codeseg_path_index.erase(path_ite);
+            }
+        }
+
+        auto uid_range = codeseg_uid_index.equal_range(std::get<2>(seg->get_uids()));
+
+        for (auto ite = uid_range.first; ite != uid_range.second; ite++) {
+            if (ite->second == seg) {
+                codeseg_uid_index.erase(ite);
+                break;
+            }
+        }
+
+        if (seg->is_rom()) {
+            auto ep_ite = codeseg_ep_index.find(seg->get_entry_point(nullptr));
+
+            if ((ep_ite != codeseg_ep_index.end()) && (ep_ite->second == seg)) {
+                codeseg_ep_index.erase(ep_ite);
+            }
+        }
+    }
+
     codeseg_ptr kernel_system::pull_codeseg_by_ep(const address ep) {
-        auto res = std::find_if(codesegs.begin(), codesegs.end(), [=](const auto &cs) -> bool {
-            return reinterpret_cast<codeseg_ptr>(cs.get())->get_entry_point(nullptr) == ep;
-        });
+        auto res = codeseg_ep_index.find(ep);
 
-        if (res == codesegs.end()) {
+        if (res == codeseg_ep_index.end()) {
             return nullptr;
         }
 
-        return reinterpret_cast<codeseg_ptr>(res->get());
+        return res->second;
     }
 
     codeseg_ptr kernel_system::pull_codeseg_by_uids(const kernel::uid uid0, const kernel::uid uid1,
         const kernel::uid uid2) {
-        auto res = std::find_if(codesegs.begin(), codesegs.end(), [=](const auto &cs) -> bool {
-            return reinterpret_cast<codeseg_ptr>(cs.get())->get_uids() == std::make_tuple(uid0, uid1, uid2);
-        });
+        auto uid_range = codeseg_uid_index.equal_range(uid2);
 
-        if (res == codesegs.end()) {
+        for (auto ite = uid_range.first; ite != uid_range.second; ite++) {
+            if (ite->second->get_uids() == std::make_tuple(uid0, uid1, uid2)) {
+                return ite->second;
+            }
+        }
+
+        return nullptr;
+    }
+
+    codeseg_ptr kernel_system::pull_codeseg_by_path(const std::u16string &path) {
+        auto res = codeseg_path_index.find(common::lowercase_ucs2_string(path));
+
+        if (res == codeseg_path_index.end()) {
             return nullptr;
         }
 
-        return reinterpret_cast<codeseg_ptr>(res->get());
+        return res->second;
     }
 
     std::optional<find_handle> kernel_system::find_object(const std::string &name, int start, kernel::object_type type, const bool use_full_name) {
@@ -537,24 +598,37 @@ namespace eka2l1 {
     }
 
     bool kernel_system::map_rom(const mem::vm_address addr, const std::string &path) {
-        rom_map = common::map_file(path, prot::read_write, 0, true);
-        const std::size_t rom_size = common::file_size(path);
+        // Exports may be patched later. Pages touched by that are copied, the rest are read from
+        // the host page cache, which every emulator mapping the same ROM shares.
+        const std::int64_t rom_size = common::file_size(path);
+
+        if (rom_size <= 0) {
+            return false;
+        }
+
+        rom_map = common::map_file(path, prot::read_write, static_cast<std::size_t>(rom_size), true);
 
         if (!rom_map) {
             return false;
         }
 
+        rom_map_size = static_cast<std::size_t>(rom_size);
+
         LOG_TRACE("Rom mapped to address: 0x{:x}", reinterpret_cast<std::uint64_t>(rom_map));
 
         // Don't care about the result as long as it's not null.
         kernel::chunk *rom_chunk = create<kernel::chunk>(mem, nullptr, "ROM", 0, static_cast<address>(rom_size),
-            rom_size, prot::read_write_exec, kernel::chunk_type::normal, kernel::chunk_access::rom,
+            rom_map_size, prot::read_write_exec, kernel::chunk_type::normal, kernel::chunk_access::rom,
             kernel::chunk_attrib::none, false, addr, rom_map);
 
         if (!rom_chunk) {
             LOG_ERROR("Can't create ROM chunk!");
 
-            common::unmap_file(rom_map);
+            common::unmap_file(rom_map, rom_map_size);
+
+            rom_map = nullptr;
+            rom_map_size = 0;
+
             return false;
         }
 
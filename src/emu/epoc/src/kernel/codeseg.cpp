@@ -138,6 +138,13 @@ namespace eka2l1::kernel {
         return true;
     }
 
+    void codeseg::set_full_path(const std::u16string &seg_full_path) {
+        // The kernel looks codesegs up by path, keep it in sync
+        kern->unindex_codeseg(this);
+        full_path = seg_full_path;
+        kern->index_codeseg(this);
+    }
+
     address codeseg::get_code_run_addr(kernel::process *pr, std::uint8_t **base) {
         if (code_addr != 0) {
             if (base) {
@@ -22,6 +22,7 @@
 #include <common/fileutils.h>
 #include <common/ini.h>
 #include <common/log.h>
+#include <common/pagededup.h>
 #include <common/path.h>
 #include <common/random.h>
 
@@ -38,6 +39,7 @@
 #include <manager/config.h>
 
 #include <epoc/loader/e32img.h>
+#include <epoc/loader/e32img_cache.h>
 #include <epoc/loader/romimage.h>
 #include <epoc/vfs.h>
 
@@ -83,12 +85,12 @@ namespace eka2l1::hle {
     }
 
     // Given relocation entries, relocate the code and data
-    static bool relocate(std::vector<loader::e32_reloc_entry> entries,
+    static bool relocate(const std::vector<loader::e32_reloc_entry> &entries,
         uint8_t *dest_addr,
         uint32_t code_delta,
         uint32_t data_delta) {
         for (uint32_t i = 0; i < entries.size(); i++) {
-            auto entry = entries[i];
+            const auto &entry = entries[i];
 
             for (auto &rel_info : entry.rels_info) {
                 // Get the lower 12 bit for virtual_address
@@ -237,6 +239,35 @@ namespace eka2l1::hle {
                 elf_fix_up_import_dir(mem, mngr, code_base, pr, ib, cs);
             }
         }
+
+        // Code is final from here, up to patches which only copy the pages they touch
+        mngr.share_code_pages(cs, pr);
+    }
+
+    static std::shared_ptr<loader::e32img> make_relocation_image(const loader::e32img &img) {
+        // Leave the image data out, the codeseg already keeps its own copy of code and data
+        std::shared_ptr<loader::e32img> reloc_img = std::make_shared<loader::e32img>();
+
+        reloc_img->epoc_ver = img.epoc_ver;
+        reloc_img->header = img.header;
+        reloc_img->header_extended = img.header_extended;
+        reloc_img->has_extended_header = img.has_extended_header;
+        reloc_img->import_section = img.import_section;
+        reloc_img->code_reloc_section = img.code_reloc_section;
+        reloc_img->data_reloc_section = img.data_reloc_section;
+
+        return reloc_img;
+    }
+
+    static bool is_same_image_header(const loader::e32img_header &lhs, const loader::e32img_header &rhs) {
+        // Only compare what both EKA1 and EKA2 headers fill
+        return (lhs.uid1 == rhs.uid1) && (lhs.uid2 == rhs.uid2) && (lhs.uid3 == rhs.uid3)
+            && (lhs.check == rhs.check) && (lhs.flags == rhs.flags) && (lhs.code_size == rhs.code_size)
+            && (lhs.data_size == rhs.data_size) && (lhs.bss_size == rhs.bss_size)
+            && (lhs.entry_point == rhs.entry_point) && (lhs.code_base == rhs.code_base)
+            && (lhs.data_base == rhs.data_base) && (lhs.text_size == rhs.text_size)
+            && (lhs.code_offset == rhs.code_offset) && (lhs.import_offset == rhs.import_offset)
+            && (lhs.code_reloc_offset == rhs.code_reloc_offset) && (lhs.data_reloc_offset == rhs.data_reloc_offset);
     }
 
     static codeseg_ptr import_e32img(loader::e32img *img, memory_system *mem, kernel_system *kern, hle::lib_manager &mngr, kernel::process *pr,
@@ -282,6 +313,8 @@ namespace eka2l1::hle {
             return nullptr;
         }
 
+        cs->set_relocation_image(make_relocation_image(*img));
+
         cs->attach(pr);
 
         mngr.patch_scripts(common::ucs2_to_utf8(eka2l1::replace_extension(eka2l1::filename(path), u"")),
@@ -291,6 +324,36 @@ namespace eka2l1::hle {
         return cs;
     }
 
+    static std::optional<loader::e32img> parse_e32img_with_cache(loader::e32img_cache *cache, symfile &f,
+        const std::u16string &path) {
+        eka2l1::ro_file_stream image_data_stream(f.get());
+
+        if (!cache) {
+            return loader::parse_e32img(reinterpret_cast<common::ro_stream *>(&image_data_stream));
+        }
+
+        auto header = loader::parse_e32img_header(reinterpret_cast<common::ro_stream *>(&image_data_stream));
+        image_data_stream.seek(0, common::seek_where::beg);
+
+        if (!header) {
+            return std::nullopt;
+        }
+
+        const std::uint64_t mtime = f->last_modify_since_1ad();
+
+        if (auto cached = cache->load(path, mtime, *header)) {
+            return cached;
+        }
+
+        auto img = loader::parse_e32img(reinterpret_cast<common::ro_stream *>(&image_data_stream));
+
+        if (img) {
+            cache->store(path, mtime, *img);
+        }
+
+        return img;
+    }
+
     static std::uint16_t THUMB_TRAMPOLINE_ASM[] = {
         0xB540, // 0: push { r6, lr }
         0x4E01, // 2: ldr r6, [pc, #4]
@@ -501,6 +564,16 @@ namespace eka2l1::hle {
             break;
         }
 
+        const manager::config_state *conf = sys->get_config();
+
+        if (conf && !conf->e32img_cache_dir.empty()) {
+            e32_cache = std::make_unique<loader::e32img_cache>(conf->e32img_cache_dir);
+        }
+
+        if (conf && conf->share_code_pages) {
+            code_pages = std::make_unique<common::page_dedup_pool>(conf->code_page_share_dir);
+        }
+
         load_patch_libraries(".//patch//");
     }
 
@@ -518,6 +591,49 @@ namespace eka2l1::hle {
         return import_e32img(&img, mem, kern, *this, pr, path);
     }
 
+    codeseg_ptr lib_manager::load_from_index(const std::u16string &path, kernel::process *pr) {
+        codeseg_ptr seg = kern->pull_codeseg_by_path(path);
+
+        if (!seg) {
+            return nullptr;
+        }
+
+        if (seg->is_rom()) {
+            // ROM content can't change, no need to look at the file again
+            seg->attach(pr);
+            return seg;
+        }
+
+        loader::e32img *reloc_img = seg->get_relocation_image();
+
+        if (!reloc_img) {
+            return nullptr;
+        }
+
+        // Make sure the file was not replaced since. Only the header is read, nothing is decompressed
+        symfile f = io->open_file(path, READ_MODE | BIN_MODE);
+
+        if (!f) {
+            return nullptr;
+        }
+
+        eka2l1::ro_file_stream image_data_stream(f.get());
+        auto header = loader::parse_e32img_header(reinterpret_cast<common::ro_stream *>(&image_data_stream));
+
+        f->close();
+
+        if (!header || !is_same_image_header(*header, reloc_img->header)) {
+            return nullptr;
+        }
+
+        if (seg->attach(pr)) {
+            relocate_e32img(reloc_img, pr, mem, *this, seg);
+            patch_scripts(seg->name(), pr, seg);
+        }
+
+        return seg;
+    }
+
     codeseg_ptr lib_manager::load_as_romimg(loader::romimg &romimg, kernel::process *pr, const std::u16string &path) {
         if (auto seg = kern->pull_codeseg_by_ep(romimg.header.entry_point)) {
             seg->attach(pr);
@@ -604,9 +720,7 @@ namespace eka2l1::hle {
                     return result;
                 }
 
-                eka2l1::ro_file_stream image_data_stream(f.get());
-
-                auto parse_result = loader::parse_e32img(reinterpret_cast<common::ro_stream *>(&image_data_stream));
+                auto parse_result = parse_e32img_with_cache(e32_cache.get(), f, path);
                 if (parse_result != std::nullopt) {
                     f->close();
                     result.first = std::move(parse_result);
@@ -614,6 +728,7 @@ namespace eka2l1::hle {
                     return result;
                 }
 
+                eka2l1::ro_file_stream image_data_stream(f.get());
                 image_data_stream.seek(0, common::seek_where::beg);
                 auto parse_result_2 = loader::parse_romimg(reinterpret_cast<common::ro_stream *>(&image_data_stream), mem);
                 if (parse_result_2 != std::nullopt) {
@@ -668,7 +783,7 @@ namespace eka2l1::hle {
 
                     return load_as_romimg(*romimg, pr, lib_path);
                 } else {
-                    auto e32img = loader::parse_e32img(reinterpret_cast<common::ro_stream *>(&image_data_stream));
+                    auto e32img = parse_e32img_with_cache(e32_cache.get(), f, lib_path);
                     if (!e32img) {
                         return nullptr;
                     }
@@ -691,6 +806,10 @@ namespace eka2l1::hle {
                 lib_path += u":\\Sys\\Bin\\";
                 lib_path += name;
 
+                if (auto result = load_from_index(lib_path, pr)) {
+                    return result;
+                }
+
                 if (io->exist(lib_path)) {
                     auto result = load_depend_on_drive(drv, lib_path);
                     if (result != nullptr) {
@@ -703,6 +822,10 @@ namespace eka2l1::hle {
             return nullptr;
         }
 
+        if (auto cs = load_from_index(lib_path, pr)) {
+            return cs;
+        }
+
         drive_number drv = char16_to_drive(lib_path[0]);
         if (!io->exist(lib_path)) {
             return nullptr;
@@ -717,9 +840,35 @@ namespace eka2l1::hle {
     }
 
     void lib_manager::shutdown() {
+        if (code_pages && code_pages->bytes_saved()) {
+            LOG_INFO("Shared code pages saved {} KB, {} KB of distinct pages", code_pages->bytes_saved() / 1024,
+                code_pages->bytes_pooled() / 1024);
+        }
+
         reset();
     }
 
+    void lib_manager::share_code_pages(codeseg_ptr seg, kernel::process *pr) {
+        if (!code_pages || seg->is_rom()) {
+            return;
+        }
+
+        std::uint8_t *code_base = nullptr;
+        const address code_addr = seg->get_code_run_addr(pr, &code_base);
+
+        if (!code_base) {
+            return;
+        }
+
+        // The code chunk is committed whole, so the padding after the code can be shared too
+        code_pages->share(code_base, common::align(seg->get_code_size(), mem->get_page_size()), prot::read_write_exec,
+            code_addr);
+    }
+
+    std::size_t lib_manager::get_code_bytes_shared() const {
+        return code_pages ? code_pages->bytes_saved() : 0;
+    }
+
     void lib_manager::reset() {
         svc_funcs.clear();
     }
@@ -770,4 +919,7 @@ namespace eka2l1::hle {
 
     lib_manager::lib_manager() {
     }
+
+    lib_manager::~lib_manager() {
+    }
 }
@@ -171,22 +171,15 @@ namespace eka2l1::loader {
         return result;
     }
 
-    std::optional<e32img> parse_e32img(common::ro_stream *stream, bool read_reloc) {
-        if (!stream) {
-            return std::nullopt;
-        }
-
-        e32img img;
-        const std::size_t file_size = stream->size();
-
-        stream->read(&img.header.uid1, 4);
-        stream->read(&img.header.uid2, 4);
-        stream->read(&img.header.uid3, 4);
-        stream->read(&img.header.check, 4);
-        stream->read(&img.header.sig, 4);
-
-        if (img.header.sig != E32IMG_SIGNATURE) {
-            return std::nullopt;
+    static bool read_e32img_header(common::ro_stream *stream, e32img_header &header, epocver &ver) {
+        stream->read(&header.uid1, 4);
+        stream->read(&header.uid2, 4);
+        stream->read(&header.uid3, 4);
+        stream->read(&header.check, 4);
+        stream->read(&header.sig, 4);
+
+        if (header.sig != E32IMG_SIGNATURE) {
+            return false;
         }
 
         std::uint32_t temp = 0;
@@ -194,68 +187,102 @@ namespace eka2l1::loader {
 
         if ((temp == 0x2000) || (temp == 0x1000)) {
             // Quick hack to determinate if this is an EKA1
-            img.header.cpu = static_cast<loader::e32_cpu>(temp);
-            img.epoc_ver = epocver::epoc6;
+            header.cpu = static_cast<loader::e32_cpu>(temp);
+            ver = epocver::epoc6;
 
             stream->read(&temp, 4);
             stream->read(&temp, 4);
-            stream->read(&img.header.petran_major, 1);
-            stream->read(&img.header.petran_minor, 1);
-            stream->read(&img.header.petran_build, 2);
-            stream->read(&img.header.flags, 4);
-            stream->read(&img.header.code_size, 4);
-            stream->read(&img.header.data_size, 4);
-            stream->read(&img.header.heap_size_min, 4);
-            stream->read(&img.header.heap_size_max, 4);
-            stream->read(&img.header.stack_size, 4);
-            stream->read(&img.header.bss_size, 4);
-            stream->read(&img.header.entry_point, 4);
-            stream->read(&img.header.code_base, 4);
-            stream->read(&img.header.data_base, 4);
-            stream->read(&img.header.dll_ref_table_count, 4);
-            stream->read(&img.header.export_dir_offset, 4);
-            stream->read(&img.header.export_dir_count, 4);
-            stream->read(&img.header.text_size, 4);
-            stream->read(&img.header.code_offset, 4);
-            stream->read(&img.header.data_offset, 4);
-            stream->read(&img.header.import_offset, 4);
-            stream->read(&img.header.code_reloc_offset, 4);
-            stream->read(&img.header.data_reloc_offset, 4);
-            stream->read(&img.header.priority, 2);
-
-            img.header.compression_type = 1;
+            stream->read(&header.petran_major, 1);
+            stream->read(&header.petran_minor, 1);
+            stream->read(&header.petran_build, 2);
+            stream->read(&header.flags, 4);
+            stream->read(&header.code_size, 4);
+            stream->read(&header.data_size, 4);
+            stream->read(&header.heap_size_min, 4);
+            stream->read(&header.heap_size_max, 4);
+            stream->read(&header.stack_size, 4);
+            stream->read(&header.bss_size, 4);
+            stream->read(&header.entry_point, 4);
+            stream->read(&header.code_base, 4);
+            stream->read(&header.data_base, 4);
+            stream->read(&header.dll_ref_table_count, 4);
+            stream->read(&header.export_dir_offset, 4);
+            stream->read(&header.export_dir_count, 4);
+            stream->read(&header.text_size, 4);
+            stream->read(&header.code_offset, 4);
+            stream->read(&header.data_offset, 4);
+            stream->read(&header.import_offset, 4);
+            stream->read(&header.code_reloc_offset, 4);
+            stream->read(&header.data_reloc_offset, 4);
+            stream->read(&header.priority, 2);
+
+            header.compression_type = 1;
         } else {
-            img.epoc_ver = epocver::epoc94;
+            ver = epocver::epoc94;
 
             stream->seek(0, common::seek_where::beg);
-            stream->read(&img.header, sizeof(e32img_header));
+            stream->read(&header, sizeof(e32img_header));
         }
 
         if (common::get_system_endian_type() == common::big_endian) {
-            img.header.uid1 = static_cast<e32_img_type>(common::byte_swap(static_cast<std::uint32_t>(img.header.uid1)));
-            img.header.uid2 = common::byte_swap(img.header.uid2);
-            img.header.uid3 = common::byte_swap(img.header.uid3);
-            img.header.check = common::byte_swap(img.header.check);
-            img.header.sig = common::byte_swap(img.header.sig);
-            img.header.petran_build = common::byte_swap(img.header.petran_build);
-            img.header.flags = common::byte_swap(img.header.flags);
-            img.header.code_size = common::byte_swap(img.header.code_size);
-            img.header.data_size = common::byte_swap(img.header.data_size);
-            img.header.heap_size_min = common::byte_swap(img.header.heap_size_min);
-            img.header.stack_size = common::byte_swap(img.header.stack_size);
-            img.header.bss_size = common::byte_swap(img.header.bss_size);
-            img.header.entry_point = common::byte_swap(img.header.entry_point);
-            img.header.code_base = common::byte_swap(img.header.code_base);
-            img.header.data_base = common::byte_swap(img.header.data_base);
-            img.header.dll_ref_table_count = common::byte_swap(img.header.dll_ref_table_count);
-            img.header.export_dir_offset = common::byte_swap(img.header.export_dir_offset);
-            img.header.export_dir_count = common::byte_swap(img.header.export_dir_count);
-            img.header.text_size = common::byte_swap(img.header.text_size);
-            img.header.code_offset = common::byte_swap(img.header.code_offset);
-            img.header.data_offset = common::byte_swap(img.header.data_offset);
-            img.header.code_reloc_offset = common::byte_swap(img.header.code_reloc_offset);
-            img.header.data_reloc_offset = common::byte_swap(img.header.data_reloc_offset);
-            img.header.priority = common::byte_swap(img.header.priority);
+            header.uid1 = static_cast<e32_img_type>(common::byte_swap(static_cast<std::uint32_t>(header.uid1)));
+            header.uid2 = common::byte_swap(header.uid2);
+            header.uid3 = common::byte_swap(header.uid3);
+            header.check = common::byte_swap(header.check);
+            header.sig = common::byte_swap(header.sig);
+            header.petran_build = common::byte_swap(header.petran_build);
+            header.flags = common::byte_swap(header.flags);
+            header.code_size = common::byte_swap(header.code_size);
+            header.data_size = common::byte_swap(header.data_size);
+            header.heap_size_min = common::byte_swap(header.heap_size_min);
+            header.stack_size = common::byte_swap(header.stack_size);
+            header.bss_size = common::byte_swap(header.bss_size);
+            header.entry_point = common::byte_swap(header.entry_point);
+            header.code_base = common::byte_swap(header.code_base);
+            header.data_base = common::byte_swap(header.data_base);
+            header.dll_ref_table_count = common::byte_swap(header.dll_ref_table_count);
+            header.export_dir_offset = common::byte_swap(header.export_dir_offset);
+            header.export_dir_count = common::byte_swap(header.export_dir_count);
+            header.text_size = common::byte_swap(header.text_size);
+            header.code_offset = common::byte_swap(header.code_offset);
+            header.data_offset = common::byte_swap(header.data_offset);
+            header.code_reloc_offset = common::byte_swap(header.code_reloc_offset);
+            header.data_reloc_offset = common::byte_swap(header.data_reloc_offset);
+            header.priority = common::byte_swap(header.priority);
+        }
+
+        return true;
+    }
+
+    std::optional<e32img_header> parse_e32img_header(common::ro_stream *stream, epocver *ver) {
+        if (!stream) {
+            return std::nullopt;
+        }
+
+        e32img_header header;
+        epocver header_ver = epocver::epoc94;
+
+        if (!read_e32img_header(stream, header, header_ver)) {
+            return std::nullopt;
+        }
+
+        if (ver) {
+            *ver = header_ver;
+        }
+
+        return header;
+    }
+
+    std::optional<e32img> parse_e32img(common::ro_stream *stream, bool read_reloc) {
+        if (!stream) {
+            return std::nullopt;
+        }
+
+        e32img img;
+        const std::size_t file_size = stream->size();
+
+        if (!read_e32img_header(stream, img.header, img.epoc_ver)) {
+            return std::nullopt;
         }
 
         compress_type ctype = static_cast<compress_type>(img.header.compression_type);
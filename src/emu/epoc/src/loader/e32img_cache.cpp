@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <epoc/loader/e32img_cache.h>
+
+#include <common/algorithm.h>
+#include <common/chunkyseri.h>
+#include <common/cvt.h>
+#include <common/fileutils.h>
+#include <common/hash.h>
+#include <common/log.h>
+#include <common/path.h>
+#include <common/virtualmem.h>
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace eka2l1::loader {
+    static constexpr std::uint32_t E32IMG_CACHE_MAGIC = 0x43323345; // E32C
+    static constexpr std::uint16_t E32IMG_CACHE_VERSION = 1;
+
+    struct e32img_cache_entry_header {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t reserved;
+        std::uint64_t mtime;
+        std::uint32_t uids[3];
+        std::uint32_t content_size; ///< Size of the serialized path and image following this header.
+        std::uint64_t content_hash; ///< FNV-1a hash of the content.
+    };
+
+    static void absorb_reloc_section(common::chunkyseri &seri, e32_reloc_section &section) {
+        seri.absorb(section.size);
+        seri.absorb(section.num_relocs);
+
+        seri.absorb_container(section.entries, [](common::chunkyseri &seri, e32_reloc_entry &entry) {
+            seri.absorb(entry.base);
+            seri.absorb(entry.size);
+            seri.absorb_container(entry.rels_info);
+        });
+    }
+
+    static void absorb_e32img(common::chunkyseri &seri, e32img &img) {
+        seri.absorb(img.epoc_ver);
+        seri.absorb_impl(reinterpret_cast<std::uint8_t *>(&img.header), sizeof(e32img_header));
+        seri.absorb(img.has_extended_header);
+        seri.absorb_impl(reinterpret_cast<std::uint8_t *>(&img.header_extended), sizeof(e32img_header_extended));
+        seri.absorb(img.uncompressed_size);
+
+        // The decompressed image, by far the biggest part
+        std::uint32_t data_size = static_cast<std::uint32_t>(img.data.size());
+        seri.absorb(data_size);
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            img.data.resize(data_size);
+        }
+
+        seri.absorb_impl(reinterpret_cast<std::uint8_t *>(img.data.data()), data_size);
+
+        seri.absorb_container(img.ed.syms);
+        seri.absorb(img.iat.number_imports);
+        seri.absorb_container(img.iat.its);
+
+        seri.absorb(img.import_section.size);
+        seri.absorb_container(img.import_section.imports, [](common::chunkyseri &seri, e32img_import_block &block) {
+            seri.absorb(block.dll_name_offset);
+            seri.absorb(block.number_of_imports);
+            seri.absorb_container(block.ordinals);
+            seri.absorb(block.dll_name);
+        });
+
+        absorb_reloc_section(seri, img.code_reloc_section);
+        absorb_reloc_section(seri, img.data_reloc_section);
+
+        seri.absorb_container(img.dll_names);
+    }
+
+    static void absorb_content(common::chunkyseri &seri, std::u16string &path, e32img &img) {
+        seri.absorb(path);
+        absorb_e32img(seri, img);
+    }
+
+    e32img_cache::e32img_cache(const std::string &cache_dir)
+        : cache_dir_(cache_dir) {
+        if (!eka2l1::exists(cache_dir_)) {
+            eka2l1::create_directories(cache_dir_);
+        }
+    }
+
+    std::string e32img_cache::get_entry_path(const std::u16string &path) const {
+        const std::u16string folded = common::lowercase_ucs2_string(path);
+        const std::uint64_t path_hash = common::hash_fnv1a64(folded.data(), folded.size() * sizeof(char16_t));
+
+        return eka2l1::add_path(cache_dir_, fmt::format("{:016X}.e32c", path_hash));
+    }
+
+    std::optional<e32img> e32img_cache::load(const std::u16string &path, const std::uint64_t mtime,
+        const e32img_header &header) {
+        const std::string entry_path = get_entry_path(path);
+        const std::int64_t entry_size = common::file_size(entry_path);
+
+        if (entry_size < static_cast<std::int64_t>(sizeof(e32img_cache_entry_header))) {
+            return std::nullopt;
+        }
+
+        std::uint8_t *entry_data = reinterpret_cast<std::uint8_t *>(common::map_file(entry_path, prot::read));
+
+        if (!entry_data) {
+            return std::nullopt;
+        }
+
+        std::optional<e32img> result;
+        e32img_cache_entry_header entry_header;
+
+        std::memcpy(&entry_header, entry_data, sizeof(e32img_cache_entry_header));
+
+        const bool key_match = (entry_header.magic == E32IMG_CACHE_MAGIC)
+            && (entry_header.version == E32IMG_CACHE_VERSION) && (entry_header.mtime == mtime)
+            && (entry_header.uids[0] == static_cast<std::uint32_t>(header.uid1))
+            && (entry_header.uids[1] == header.uid2) && (entry_header.uids[2] == header.uid3)
+            && (entry_header.content_size == entry_size - sizeof(e32img_cache_entry_header));
+
+        std::uint8_t *content = entry_data + sizeof(e32img_cache_entry_header);
+
+        if (key_match && (common::hash_fnv1a64(content, entry_header.content_size) == entry_header.content_hash)) {
+            std::u16string entry_image_path;
+            e32img img;
+
+            common::chunkyseri seri(content, entry_header.content_size, common::SERI_MODE_READ);
+            absorb_content(seri, entry_image_path, img);
+
+            // Two paths may share the same hash
+            if (common::compare_ignore_case(entry_image_path, path) == 0) {
+                result = std::move(img);
+            }
+        }
+
+        common::unmap_file(entry_data, static_cast<std::size_t>(entry_size));
+        return result;
+    }
+
+    bool e32img_cache::store(const std::u16string &path, const std::uint64_t mtime, e32img &img) {
+        std::u16string image_path = path;
+
+        common::chunkyseri measurer(nullptr, 0, common::SERI_MODE_MEASURE);
+        absorb_content(measurer, image_path, img);
+
+        std::vector<std::uint8_t> content(measurer.size());
+
+        common::chunkyseri seri(content.data(), content.size(), common::SERI_MODE_WRITE);
+        absorb_content(seri, image_path, img);
+
+        e32img_cache_entry_header entry_header;
+        entry_header.magic = E32IMG_CACHE_MAGIC;
+        entry_header.version = E32IMG_CACHE_VERSION;
+        entry_header.reserved = 0;
+        entry_header.mtime = mtime;
+        entry_header.uids[0] = static_cast<std::uint32_t>(img.header.uid1);
+        entry_header.uids[1] = img.header.uid2;
+        entry_header.uids[2] = img.header.uid3;
+        entry_header.content_size = static_cast<std::uint32_t>(content.size());
+        entry_header.content_hash = common::hash_fnv1a64(content.data(), content.size());
+
+        const std::string entry_path = get_entry_path(path);
+        const std::string temp_path = entry_path + ".tmp";
+
+        {
+            std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+
+            if (!out) {
+                LOG_WARN("Unable to write E32 image cache entry {}", entry_path);
+                return false;
+            }
+
+            out.write(reinterpret_cast<const char *>(&entry_header), sizeof(e32img_cache_entry_header));
+            out.write(reinterpret_cast<const char *>(content.data()), content.size());
+
+            if (!out) {
+                out.close();
+                common::remove(temp_path);
+
+                return false;
+            }
+        }
+
+        // Swap the new entry in whole, so a crash midway never leaves a half written entry behind
+        common::remove(entry_path);
+        return common::move_file(temp_path, entry_path);
+    }
+}
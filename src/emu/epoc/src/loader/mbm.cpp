@@ -122,8 +122,6 @@ namespace eka2l1::loader {
         std::size_t compressed_size = common::min<std::size_t>(static_cast<std::size_t>(stream->left()),
             static_cast<std::size_t>(single_bm_header.bitmap_size));
 
-        common::wo_buf_stream dest_stream(dest, !dest ? 0xFFFFFFFF : dest_max);
-
         switch (single_bm_header.compression) {
         case 0: {
             dest_max = compressed_size;
@@ -135,23 +133,23 @@ namespace eka2l1::loader {
             break;
         }
 
-        case 1: {
-            eka2l1::decompress_rle<8>(stream, reinterpret_cast<common::wo_stream *>(&dest_stream));
-            dest_max = dest_stream.tell();
-
-            break;
-        }
-
-        case 3: {
-            eka2l1::decompress_rle<16>(stream, reinterpret_cast<common::wo_stream *>(&dest_stream));
-            dest_max = dest_stream.tell();
-
-            break;
-        }
-
+        case 1:
+        case 3:
         case 4: {
-            eka2l1::decompress_rle<24>(stream, reinterpret_cast<common::wo_stream *>(&dest_stream));
-            dest_max = dest_stream.tell();
+            // Decode from memory, and only from the data of this bitmap
+            std::vector<std::uint8_t> compressed(common::min<std::size_t>(static_cast<std::size_t>(stream->left()),
+                single_bm_header.bitmap_size - common::min(single_bm_header.bitmap_size, single_bm_header.header_len)));
+
+            compressed.resize(static_cast<std::size_t>(stream->read(compressed.data(), compressed.size())));
+            std::size_t source_size = compressed.size();
+
+            if (single_bm_header.compression == 1) {
+                eka2l1::decompress_rle<8>(compressed.data(), source_size, dest, dest_max);
+            } else if (single_bm_header.compression == 3) {
+                eka2l1::decompress_rle<16>(compressed.data(), source_size, dest, dest_max);
+            } else {
+                eka2l1::decompress_rle<24>(compressed.data(), source_size, dest, dest_max);
+            }
 
             break;
         }
@@ -94,7 +94,8 @@ namespace eka2l1::loader {
         
         Each entry of both index sections is 2 bytes, so it should give you something. They give information
         about 
-            * If dictionary compressed: the offset of the dict/resource entry from the dictionary/resource data
+            * If dictionary compressed: the offset in bits of the end of the dict/resource entry, from the start of
+              the dictionary/resource data. An entry begins where the previous one ends, the first one at 0
             * If the RSC not compressed, each index will points to offset of resource entry based on offset 0
 
         Calypso file:
@@ -146,42 +147,56 @@ namespace eka2l1::loader {
 
         std::stack<common::dictcomp> streams;
 
-        auto append_dictcomp_stream = [&](int resource_index) {
-            std::uint16_t begin_bits = resource_offsets[resource_index - 1];
-            std::uint16_t end_bits = resource_offsets[resource_index];
+        auto append_dictcomp_stream = [&](const std::vector<std::uint8_t> &data, const std::vector<std::uint16_t> &index,
+                                          const int entry_index) {
+            if ((entry_index < 0) || (entry_index >= static_cast<int>(index.size()))) {
+                return false;
+            }
+
+            const std::uint16_t begin_bits = (entry_index == 0) ? 0 : index[entry_index - 1];
+            const std::uint16_t end_bits = index[entry_index];
 
-            // I don't use any cache though
-            common::dictcomp comp_stream(&res_data[0], begin_bits, end_bits, num_of_bits_use_for_dict_token);
-            streams.push(std::move(comp_stream));
+            streams.emplace(data.data(), static_cast<int>(data.size()), begin_bits, end_bits, num_of_bits_use_for_dict_token);
+            return true;
         };
 
-        append_dictcomp_stream(res_index);
+        if (!append_dictcomp_stream(res_data, resource_offsets, res_index)) {
+            LOG_ERROR("Resource index {} out of range", res_index);
+            return -1;
+        }
 
-        bool is_calypso = (flags & calypso);
+        const bool is_calypso = (flags & calypso);
         int total_bytes = 0;
 
-        for (;;) {
-            if (streams.empty()) {
-                break;
+        while (!streams.empty()) {
+            common::dictcomp &comp_stream = streams.top();
+
+            if (comp_stream.end_of_stream()) {
+                streams.pop();
+                continue;
             }
 
-            common::dictcomp comp_stream = std::move(streams.top());
-            streams.pop();
+            const int index_of_dict_entry = comp_stream.index_of_current_directory_entry();
 
-            for (;;) {
-                const int index_of_dict_entry = comp_stream.index_of_current_directory_entry();
-                if (index_of_dict_entry < 0) {
-                    int result = comp_stream.read(buffer, max, is_calypso);
+            if (index_of_dict_entry < 0) {
+                int remaining = max - total_bytes;
+                const int result = comp_stream.read(buffer + total_bytes, remaining, is_calypso);
 
-                    if (result == -1) {
-                        return result;
-                    }
+                if (result < 0) {
+                    return result;
+                }
 
-                    total_bytes += result;
-                    max -= result;
-                } else {
-                    append_dictcomp_stream(index_of_dict_entry);
-                    break;
+                total_bytes += result;
+            } else {
+                // Each entry expands to at least a byte, so a deeper stack only comes from a cycle
+                if (streams.size() > dict_offsets.size()) {
+                    LOG_ERROR("Dictionary entry {} refers back to itself", index_of_dict_entry);
+                    return -1;
+                }
+
+                if (!append_dictcomp_stream(dict_data, dict_offsets, index_of_dict_entry)) {
+                    LOG_ERROR("Dictionary entry {} out of range", index_of_dict_entry);
+                    return -1;
                 }
             }
         }
@@ -258,6 +273,13 @@ namespace eka2l1::loader {
 
                 dict_offsets.resize(num_dir_entry);
                 buf->read(dict_index_offset, &dict_offsets[0], 2 * num_dir_entry);
+
+                // Dictionary data lasts until the resource index, resource data until the end of the file
+                dict_data.resize(res_index_offset - dict_offset);
+                buf->read(dict_offset, dict_data.data(), static_cast<std::uint32_t>(dict_data.size()));
+
+                res_data.resize(buf->size() - res_offset);
+                buf->read(res_offset, res_data.data(), static_cast<std::uint32_t>(res_data.size()));
             } else {
                 std::uint8_t file_flag = 0;
                 buf->read(16, &file_flag, sizeof(file_flag));
@@ -276,8 +298,7 @@ namespace eka2l1::loader {
                     flags |= first_res_generated_bit_array_of_res_contains_compressed_unicode;
                 }
 
-                // After the flag and some two byte
-                res_offset = 19;
+                buf->read(19, &res_offset, sizeof(res_offset));
                 std::uint16_t num_bits_of_res_data = 0;
 
                 buf->read(buf->size() - 2, &num_bits_of_res_data, 2);
@@ -289,7 +310,7 @@ namespace eka2l1::loader {
                 // Each resource entry is two bytes.
                 num_res = static_cast<std::uint16_t>((buf->size() - res_index_offset) / 2);
 
-                resource_offsets.resize(num_res + 1);
+                resource_offsets.resize(num_res);
                 buf->read(res_index_offset, &resource_offsets[0], 2 * num_res);
 
                 dict_offset = 21;
@@ -312,7 +333,10 @@ namespace eka2l1::loader {
                 int num_entries = (res_offset - dict_index_offset) / 2;
 
                 dict_offsets.resize(num_entries);
-                buf->read(dict_index_offset, &dict_offsets[0], 2 * num_entries);
+                buf->read(dict_index_offset, dict_offsets.data(), 2 * num_entries);
+
+                dict_data.resize(dict_index_offset - dict_offset);
+                buf->read(dict_offset, dict_data.data(), static_cast<std::uint32_t>(dict_data.size()));
 
                 // the bottom 3 bits of firstByteAfterUids stores the number of bits used for
                 // dictionary tokens as an offset from 3, e.g. if 2 is stored in these three bits
@@ -405,6 +429,13 @@ namespace eka2l1::loader {
             res_index++;
         }
 
+        auto cache_ite = cache.find(res_index);
+
+        if (cache_ite != cache.end()) {
+            cache_lru.splice(cache_lru.begin(), cache_lru, cache_ite->second.lru);
+            return cache_ite->second.data;
+        }
+
         std::vector<std::uint8_t> data;
         data.resize(size_of_largest_resource_when_uncompressed);
 
@@ -419,6 +450,7 @@ namespace eka2l1::loader {
         data.resize(err_code);
 
         if (!is_resource_contains_unicode(res_index, flags & first_res_generated_bit_array_of_res_contains_compressed_unicode)) {
+            add_to_cache(res_index, data);
             return data;
         }
 
@@ -474,9 +506,42 @@ namespace eka2l1::loader {
         }
 
         stage2_data.resize(written);
+        add_to_cache(res_index, stage2_data);
+
         return stage2_data;
     }
 
+    void rsc_file::add_to_cache(const int res_index, const std::vector<std::uint8_t> &data) {
+        if (data.size() > cache_budget) {
+            return;
+        }
+
+        shrink_cache(cache_budget - data.size());
+
+        cache_lru.push_front(res_index);
+
+        cached_resource &entry = cache[res_index];
+        entry.data = data;
+        entry.lru = cache_lru.begin();
+
+        cache_size += data.size();
+    }
+
+    void rsc_file::shrink_cache(const std::size_t target_size) {
+        while ((cache_size > target_size) && !cache_lru.empty()) {
+            auto ite = cache.find(cache_lru.back());
+            cache_size -= ite->second.data.size();
+
+            cache.erase(ite);
+            cache_lru.pop_back();
+        }
+    }
+
+    void rsc_file::set_cache_budget(const std::size_t budget) {
+        cache_budget = budget;
+        shrink_cache(budget);
+    }
+
     std::uint32_t rsc_file::get_uid(const int idx) {
         switch (idx) {
         case 1: {
@@ -513,8 +578,10 @@ namespace eka2l1::loader {
         return true;
     }
 
-    rsc_file::rsc_file(common::ro_stream *buf)
-        : flags(0) {
+    rsc_file::rsc_file(common::ro_stream *buf, const std::size_t cache_budget)
+        : flags(0)
+        , cache_budget(cache_budget)
+        , cache_size(0) {
         read_header_and_resource_index(buf);
     }
 
@@ -6,8 +6,10 @@
 
 #include <epoc/epoc.h>
 #include <epoc/services/centralrepo/centralrepo.h>
+#include <epoc/services/centralrepo/compiled.h>
 #include <epoc/services/centralrepo/cre.h>
 #include <epoc/vfs.h>
+#include <manager/config.h>
 #include <manager/device_manager.h>
 #include <manager/manager.h>
 
@@ -206,6 +208,15 @@ namespace eka2l1 {
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_get_find_res, "CenRep::GetFindResult");
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_notify_cancel, "CenRep::NofCancel");
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_notify_cancel_all, "CenRep::NofCancelAll");
+
+        const manager::config_state *conf = sys->get_config();
+
+        if (conf && !conf->centrep_cache_dir.empty()) {
+            compiled_cache = std::make_unique<compiled_repo_cache>(conf->centrep_cache_dir);
+        }
+    }
+
+    central_repo_server::~central_repo_server() {
     }
 
     void central_repo_client_session::init(service::ipc_context *ctx) {
@@ -362,6 +373,10 @@ namespace eka2l1 {
                     repo->reside_place = avail_drives[0];
                     repo->access_count = 1;
 
+                    if (!scan_org_only) {
+                        repo->replay_journal(io, mngr);
+                    }
+
                     avail_drives.pop_back();
                     return 0;
                 }
@@ -375,9 +390,14 @@ namespace eka2l1 {
                 }
 
                 repo->uid = key;
-                if (parse_new_centrep_ini(common::ucs2_to_utf8(*path), *repo)) {
+                if (load_ini_repo(*path, *repo)) {
                     repo->reside_place = avail_drives[0];
                     repo->access_count = 1;
+
+                    if (!scan_org_only) {
+                        repo->replay_journal(io, mngr);
+                    }
+
                     avail_drives.pop_back();
 
                     return 0;
@@ -389,6 +409,22 @@ namespace eka2l1 {
         return -1;
     }
 
+    bool central_repo_server::load_ini_repo(const std::u16string &path, central_repo &repo) {
+        if (compiled_cache && compiled_cache->load(path, repo)) {
+            return true;
+        }
+
+        if (!parse_new_centrep_ini(common::ucs2_to_utf8(path), repo)) {
+            return false;
+        }
+
+        if (compiled_cache) {
+            compiled_cache->store(path, repo);
+        }
+
+        return true;
+    }
+
     /* It should be like follow:
      *
      * - The ROM INI are for rollback
@@ -539,6 +575,9 @@ namespace eka2l1 {
         repo_subsession.write_changes(io, mngr);
         LOG_TRACE("Repo 0x{:X}: changes saved", repo_subsession.attach_repo->uid);
 
+        // Its requests are indexed in the repo, which outlives this subsession
+        repo_subsession.cancel_all_notify_requests();
+
         // Remove from attach
         auto &all_attached = repo_subsession.attach_repo->attached;
         auto attach_this_ite = std::find(all_attached.begin(), all_attached.end(),
@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <epoc/services/centralrepo/compiled.h>
+#include <epoc/services/centralrepo/repo.h>
+
+#include <common/cvt.h>
+#include <common/fileutils.h>
+#include <common/hash.h>
+#include <common/log.h>
+#include <common/path.h>
+#include <common/virtualmem.h>
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace eka2l1 {
+    static constexpr std::uint32_t COMPILED_REPO_MAGIC = 0x43504543; // CEPC
+    static constexpr std::uint16_t COMPILED_REPO_VERSION = 1;
+
+    /*
+     * Layout of a compiled repository, after the header:
+     *
+     * - The INI path, in UCS-2, padded to 4 bytes.
+     * - The repository info.
+     * - Default metadata ranges.
+     * - Key records, sorted by key.
+     * - The value blob. Integers and reals take 8 bytes, strings their length.
+    */
+    struct compiled_repo_header {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t reserved;
+        std::uint64_t mtime;           ///< Last modification time of the INI.
+        std::uint64_t source_size;     ///< Size of the INI.
+        std::uint32_t path_length;     ///< Length of the INI path, in characters.
+        std::uint32_t meta_range_count;
+        std::uint32_t entry_count;
+        std::uint32_t content_size;    ///< Size of everything following this header.
+        std::uint64_t content_hash;    ///< FNV-1a hash of the content.
+    };
+
+    struct compiled_repo_info {
+        std::uint8_t ver;
+        std::uint8_t keyspace_type;
+        std::uint16_t reserved;
+        std::uint32_t owner_uid;
+        std::uint32_t default_meta;
+    };
+
+    struct compiled_repo_key {
+        std::uint32_t key;
+        std::uint32_t metadata_val;
+        std::uint32_t etype;
+        std::uint32_t value_offset; ///< Offset of the value, relative to the start of the blob.
+        std::uint32_t value_size;
+    };
+
+    static std::size_t get_path_record_size(const std::size_t path_length) {
+        return (path_length * sizeof(char16_t) + 3) & ~static_cast<std::size_t>(3);
+    }
+
+    compiled_repo_cache::compiled_repo_cache(const std::string &cache_dir)
+        : cache_dir_(cache_dir) {
+        if (!eka2l1::exists(cache_dir_)) {
+            eka2l1::create_directories(cache_dir_);
+        }
+    }
+
+    std::string compiled_repo_cache::get_entry_path(const std::u16string &path) const {
+        const std::u16string folded = common::lowercase_ucs2_string(path);
+        const std::uint64_t path_hash = common::hash_fnv1a64(folded.data(), folded.size() * sizeof(char16_t));
+
+        return eka2l1::add_path(cache_dir_, fmt::format("{:016X}.cenc", path_hash));
+    }
+
+    static bool decode_compiled_repo(const std::uint8_t *content, const compiled_repo_header &header,
+        const std::u16string &path, central_repo &repo) {
+        const std::uint8_t *content_end = content + header.content_size;
+        const std::size_t path_record_size = get_path_record_size(header.path_length);
+
+        const std::size_t fixed_size = path_record_size + sizeof(compiled_repo_info)
+            + static_cast<std::size_t>(header.meta_range_count) * sizeof(central_repo_default_meta)
+            + static_cast<std::size_t>(header.entry_count) * sizeof(compiled_repo_key);
+
+        if (fixed_size > header.content_size) {
+            return false;
+        }
+
+        // Two paths may share the same hash
+        std::u16string entry_path(header.path_length, u'\0');
+        std::memcpy(&entry_path[0], content, header.path_length * sizeof(char16_t));
+
+        if (common::compare_ignore_case(entry_path, path) != 0) {
+            return false;
+        }
+
+        const std::uint8_t *cur = content + path_record_size;
+
+        compiled_repo_info info;
+        std::memcpy(&info, cur, sizeof(compiled_repo_info));
+        cur += sizeof(compiled_repo_info);
+
+        std::vector<central_repo_default_meta> meta_range(header.meta_range_count);
+
+        if (!meta_range.empty()) {
+            std::memcpy(meta_range.data(), cur, meta_range.size() * sizeof(central_repo_default_meta));
+            cur += meta_range.size() * sizeof(central_repo_default_meta);
+        }
+
+        const std::uint8_t *keys = cur;
+        const std::uint8_t *blob = keys + header.entry_count * sizeof(compiled_repo_key);
+        const std::size_t blob_size = content_end - blob;
+
+        std::vector<central_repo_entry> entries(header.entry_count);
+
+        for (std::uint32_t i = 0; i < header.entry_count; i++) {
+            compiled_repo_key record;
+            std::memcpy(&record, keys + i * sizeof(compiled_repo_key), sizeof(compiled_repo_key));
+
+            if ((record.value_offset > blob_size) || (record.value_size > blob_size - record.value_offset)) {
+                return false;
+            }
+
+            // Lookups rely on the order, so never trust it blindly
+            if (i && (record.key <= entries[i - 1].key)) {
+                return false;
+            }
+
+            central_repo_entry &entry = entries[i];
+            entry.key = record.key;
+            entry.metadata_val = record.metadata_val;
+            entry.data.etype = static_cast<central_repo_entry_type>(record.etype);
+
+            const std::uint8_t *value = blob + record.value_offset;
+
+            switch (entry.data.etype) {
+            case central_repo_entry_type::integer:
+                if (record.value_size != sizeof(std::uint64_t)) {
+                    return false;
+                }
+
+                std::memcpy(&entry.data.intd, value, sizeof(std::uint64_t));
+                break;
+
+            case central_repo_entry_type::real:
+                if (record.value_size != sizeof(double)) {
+                    return false;
+                }
+
+                std::memcpy(&entry.data.reald, value, sizeof(double));
+                break;
+
+            case central_repo_entry_type::string:
+                entry.data.strd.assign(reinterpret_cast<const char *>(value), record.value_size);
+                break;
+
+            default:
+                return false;
+            }
+        }
+
+        repo.ver = info.ver;
+        repo.keyspace_type = info.keyspace_type;
+        repo.owner_uid = info.owner_uid;
+        repo.default_meta = info.default_meta;
+        repo.meta_range = std::move(meta_range);
+        repo.entries = std::move(entries);
+
+        return true;
+    }
+
+    bool compiled_repo_cache::load(const std::u16string &path, central_repo &repo) {
+        const std::int64_t source_size = common::file_size(common::ucs2_to_utf8(path));
+
+        if (source_size < 0) {
+            return false;
+        }
+
+        const std::string entry_path = get_entry_path(path);
+        const std::int64_t entry_size = common::file_size(entry_path);
+
+        if (entry_size < static_cast<std::int64_t>(sizeof(compiled_repo_header))) {
+            return false;
+        }
+
+        std::uint8_t *entry_data = reinterpret_cast<std::uint8_t *>(common::map_file(entry_path, prot::read));
+
+        if (!entry_data) {
+            return false;
+        }
+
+        compiled_repo_header header;
+        std::memcpy(&header, entry_data, sizeof(compiled_repo_header));
+
+        const bool key_match = (header.magic == COMPILED_REPO_MAGIC) && (header.version == COMPILED_REPO_VERSION)
+            && (header.mtime == common::get_last_modifiy_since_ad(path))
+            && (header.source_size == static_cast<std::uint64_t>(source_size))
+            && (header.content_size == entry_size - sizeof(compiled_repo_header));
+
+        const std::uint8_t *content = entry_data + sizeof(compiled_repo_header);
+        bool result = false;
+
+        if (key_match && (common::hash_fnv1a64(content, header.content_size) == header.content_hash)) {
+            result = decode_compiled_repo(content, header, path, repo);
+        }
+
+        common::unmap_file(entry_data, static_cast<std::size_t>(entry_size));
+        return result;
+    }
+
+    bool compiled_repo_cache::store(const std::u16string &path, const central_repo &repo) {
+        const std::int64_t source_size = common::file_size(common::ucs2_to_utf8(path));
+
+        if (source_size < 0) {
+            return false;
+        }
+
+        const std::size_t path_record_size = get_path_record_size(path.length());
+        const std::size_t keys_offset = path_record_size + sizeof(compiled_repo_info)
+            + repo.meta_range.size() * sizeof(central_repo_default_meta);
+
+        std::vector<std::uint8_t> content(keys_offset + repo.entries.size() * sizeof(compiled_repo_key));
+        std::memcpy(content.data(), path.data(), path.length() * sizeof(char16_t));
+
+        compiled_repo_info info;
+        info.ver = repo.ver;
+        info.keyspace_type = repo.keyspace_type;
+        info.reserved = 0;
+        info.owner_uid = repo.owner_uid;
+        info.default_meta = repo.default_meta;
+
+        std::memcpy(content.data() + path_record_size, &info, sizeof(compiled_repo_info));
+
+        if (!repo.meta_range.empty()) {
+            std::memcpy(content.data() + path_record_size + sizeof(compiled_repo_info), repo.meta_range.data(),
+                repo.meta_range.size() * sizeof(central_repo_default_meta));
+        }
+
+        std::vector<std::uint8_t> blob;
+
+        for (std::size_t i = 0; i < repo.entries.size(); i++) {
+            const central_repo_entry &entry = repo.entries[i];
+
+            if (i && (entry.key <= repo.entries[i - 1].key)) {
+                LOG_WARN("Entries of repository 0x{:X} are not sorted, not compiling it", repo.uid);
+                return false;
+            }
+
+            compiled_repo_key record;
+            record.key = entry.key;
+            record.metadata_val = entry.metadata_val;
+            record.etype = static_cast<std::uint32_t>(entry.data.etype);
+            record.value_offset = static_cast<std::uint32_t>(blob.size());
+
+            const std::uint8_t *value = nullptr;
+
+            switch (entry.data.etype) {
+            case central_repo_entry_type::integer:
+                value = reinterpret_cast<const std::uint8_t *>(&entry.data.intd);
+                record.value_size = sizeof(std::uint64_t);
+                break;
+
+            case central_repo_entry_type::real:
+                value = reinterpret_cast<const std::uint8_t *>(&entry.data.reald);
+                record.value_size = sizeof(double);
+                break;
+
+            case central_repo_entry_type::string:
+                value = reinterpret_cast<const std::uint8_t *>(entry.data.strd.data());
+                record.value_size = static_cast<std::uint32_t>(entry.data.strd.size());
+                break;
+
+            default:
+                return false;
+            }
+
+            blob.insert(blob.end(), value, value + record.value_size);
+            std::memcpy(content.data() + keys_offset + i * sizeof(compiled_repo_key), &record, sizeof(compiled_repo_key));
+        }
+
+        content.insert(content.end(), blob.begin(), blob.end());
+
+        compiled_repo_header header;
+        header.magic = COMPILED_REPO_MAGIC;
+        header.version = COMPILED_REPO_VERSION;
+        header.reserved = 0;
+        header.mtime = common::get_last_modifiy_since_ad(path);
+        header.source_size = static_cast<std::uint64_t>(source_size);
+        header.path_length = static_cast<std::uint32_t>(path.length());
+        header.meta_range_count = static_cast<std::uint32_t>(repo.meta_range.size());
+        header.entry_count = static_cast<std::uint32_t>(repo.entries.size());
+        header.content_size = static_cast<std::uint32_t>(content.size());
+        header.content_hash = common::hash_fnv1a64(content.data(), content.size());
+
+        const std::string entry_path = get_entry_path(path);
+        const std::string temp_path = entry_path + ".tmp";
+
+        {
+            std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+
+            if (!out) {
+                LOG_WARN("Unable to write compiled repository {}", entry_path);
+                return false;
+            }
+
+            out.write(reinterpret_cast<const char *>(&header), sizeof(compiled_repo_header));
+            out.write(reinterpret_cast<const char *>(content.data()), content.size());
+
+            if (!out) {
+                out.close();
+                common::remove(temp_path);
+
+                return false;
+            }
+        }
+
+        // Swap the new entry in whole, so a crash midway never leaves a half written entry behind
+        common::remove(entry_path);
+        return common::move_file(temp_path, entry_path);
+    }
+}
@@ -31,6 +31,9 @@
 
 #include <manager/device_manager.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace eka2l1 {
     /* 
      * The header of a CRE file is following:
@@ -223,6 +226,13 @@ namespace eka2l1 {
             }
         }
 
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            // Lookups binary search the entries
+            std::sort(repo.entries.begin(), repo.entries.end(), [](const central_repo_entry &lhs, const central_repo_entry &rhs) {
+                return lhs.key < rhs.key;
+            });
+        }
+
         if (repo.ver >= 1) {
             std::uint32_t deleted_settings_count = static_cast<std::uint32_t>(repo.deleted_settings.size());
             seri.absorb(deleted_settings_count);
@@ -241,6 +251,118 @@ namespace eka2l1 {
         return 0;
     }
 
+    static constexpr std::uint32_t CRE_JOURNAL_MAX_RECORDS = 64;
+
+    struct cre_journal_record_header {
+        std::uint32_t key;
+        std::uint32_t metadata_val;
+        std::uint32_t etype;
+        std::uint32_t value_size;
+    };
+
+    void append_cre_journal_record(std::vector<std::uint8_t> &buf, const central_repo_entry &entry) {
+        cre_journal_record_header header;
+        header.key = entry.key;
+        header.metadata_val = entry.metadata_val;
+        header.etype = static_cast<std::uint32_t>(entry.data.etype);
+
+        const std::uint8_t *value = nullptr;
+
+        switch (entry.data.etype) {
+        case central_repo_entry_type::integer:
+            value = reinterpret_cast<const std::uint8_t *>(&entry.data.intd);
+            header.value_size = sizeof(std::uint64_t);
+            break;
+
+        case central_repo_entry_type::real:
+            value = reinterpret_cast<const std::uint8_t *>(&entry.data.reald);
+            header.value_size = sizeof(double);
+            break;
+
+        case central_repo_entry_type::string:
+            value = reinterpret_cast<const std::uint8_t *>(entry.data.strd.data());
+            header.value_size = static_cast<std::uint32_t>(entry.data.strd.size());
+            break;
+
+        default:
+            return;
+        }
+
+        const std::uint8_t *header_ptr = reinterpret_cast<const std::uint8_t *>(&header);
+
+        buf.insert(buf.end(), header_ptr, header_ptr + sizeof(cre_journal_record_header));
+        buf.insert(buf.end(), value, value + header.value_size);
+    }
+
+    std::uint32_t apply_cre_journal(const std::uint8_t *data, const std::size_t size, eka2l1::central_repo &repo) {
+        std::uint32_t applied = 0;
+        std::size_t offset = 0;
+
+        while (size - offset >= sizeof(cre_journal_record_header)) {
+            cre_journal_record_header header;
+            std::memcpy(&header, data + offset, sizeof(cre_journal_record_header));
+
+            offset += sizeof(cre_journal_record_header);
+
+            if (header.value_size > size - offset) {
+                break;
+            }
+
+            central_repo_entry_variant var;
+            var.etype = static_cast<central_repo_entry_type>(header.etype);
+
+            const std::uint8_t *value = data + offset;
+            offset += header.value_size;
+
+            switch (var.etype) {
+            case central_repo_entry_type::integer:
+                if (header.value_size != sizeof(std::uint64_t)) {
+                    return applied;
+                }
+
+                std::memcpy(&var.intd, value, sizeof(std::uint64_t));
+                break;
+
+            case central_repo_entry_type::real:
+                if (header.value_size != sizeof(double)) {
+                    return applied;
+                }
+
+                std::memcpy(&var.reald, value, sizeof(double));
+                break;
+
+            case central_repo_entry_type::string:
+                var.strd.assign(reinterpret_cast<const char *>(value), header.value_size);
+                break;
+
+            default:
+                return applied;
+            }
+
+            central_repo_entry *entry = repo.find_entry(header.key);
+
+            if (entry) {
+                entry->data = std::move(var);
+                entry->metadata_val = header.metadata_val;
+            } else {
+                repo.add_new_entry(header.key, var, header.metadata_val);
+            }
+
+            applied++;
+        }
+
+        return applied;
+    }
+
+    static std::u16string get_persist_path(const eka2l1::central_repo &repo, manager::device_manager *mngr,
+        const std::u16string &ext) {
+        std::u16string p{ drive_to_char16(repo.reside_place) };
+        std::u16string firm_code = common::utf8_to_ucs2(common::lowercase_string(mngr->get_current()->firmware_code));
+
+        p += u":\\Private\\10202BE9\\persists\\" + firm_code + u"\\" + common::utf8_to_ucs2(common::to_string(repo.uid, std::hex)) + ext;
+        return p;
+    }
+
     void central_repo::write_changes(eka2l1::io_system *io, manager::device_manager *mngr) {
         std::vector<std::uint8_t> bufs;
 
@@ -254,11 +376,7 @@ namespace eka2l1 {
         common::chunkyseri seri(&bufs[0], bufs.size(), common::SERI_MODE_WRITE);
         do_state_for_cre(seri, *this);
 
-        std::u16string p{ drive_to_char16(reside_place) };
-        std::u16string firm_code = common::utf8_to_ucs2(common::lowercase_string(mngr->get_current()->firmware_code));
-
-        p += u":\\Private\\10202BE9\\persists\\" + firm_code + u"\\" + common::utf8_to_ucs2(common::to_string(uid, std::hex)) + u".cre";
-
+        const std::u16string p = get_persist_path(*this, mngr, u".cre");
         symfile f = io->open_file(p, WRITE_MODE | BIN_MODE);
 
         if (!f) {
@@ -268,6 +386,67 @@ namespace eka2l1 {
 
         f->write_file(&bufs[0], 1, static_cast<std::uint32_t>(bufs.size()));
         f->close();
+
+        // Everything in the journal is in the CRE now
+        const std::u16string journal_path = get_persist_path(*this, mngr, u".jnl");
+
+        if (io->exist(journal_path)) {
+            io->delete_entry(journal_path);
+        }
+
+        journal_records = 0;
+    }
+
+    void central_repo::journal_change(eka2l1::io_system *io, manager::device_manager *mngr, const central_repo_entry &entry) {
+        if (journal_records >= CRE_JOURNAL_MAX_RECORDS) {
+            write_changes(io, mngr);
+            return;
+        }
+
+        std::vector<std::uint8_t> record;
+        append_cre_journal_record(record, entry);
+
+        const std::u16string p = get_persist_path(*this, mngr, u".jnl");
+        symfile f = io->open_file(p, APPEND_MODE | BIN_MODE);
+
+        if (!f) {
+            // Don't lose the change, fallback to writing everything
+            write_changes(io, mngr);
+            return;
+        }
+
+        f->write_file(record.data(), 1, static_cast<std::uint32_t>(record.size()));
+        f->close();
+
+        journal_records++;
+    }
+
+    std::uint32_t central_repo::replay_journal(eka2l1::io_system *io, manager::device_manager *mngr) {
+        const std::u16string p = get_persist_path(*this, mngr, u".jnl");
+
+        if (!io->exist(p)) {
+            return 0;
+        }
+
+        symfile f = io->open_file(p, READ_MODE | BIN_MODE);
+
+        if (!f) {
+            return 0;
+        }
+
+        std::vector<std::uint8_t> buf(f->size());
+
+        if (!buf.empty()) {
+            f->read_file(buf.data(), 1, static_cast<std::uint32_t>(buf.size()));
+        }
+
+        f->close();
+
+        const std::uint32_t applied = apply_cre_journal(buf.data(), buf.size(), *this);
+
+        // Fold the journal into the CRE, so a torn record at its end can't hide later ones
+        write_changes(io, mngr);
+        return applied;
     }
 
     void central_repo_client_subsession::write_changes(eka2l1::io_system *io, manager::device_manager *mngr) {
@@ -31,6 +31,13 @@
 #include <cstdint>
 
 namespace eka2l1 {
+    static std::vector<central_repo_entry>::iterator lower_bound_entry(std::vector<central_repo_entry> &entries,
+        const std::uint32_t key) {
+        return std::lower_bound(entries.begin(), entries.end(), key, [](const central_repo_entry &e, const std::uint32_t key) {
+            return e.key < key;
+        });
+    }
+
     std::uint32_t central_repo::get_default_meta_for_new_key(const std::uint32_t key) {
         for (std::size_t i = 0; i < meta_range.size(); i++) {
             if (meta_range[i].high_key) {
@@ -51,7 +58,9 @@ namespace eka2l1 {
     }
 
     bool central_repo::add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var) {
-        if (find_entry(key)) {
+        auto ite = lower_bound_entry(entries, key);
+
+        if ((ite != entries.end()) && (ite->key == key)) {
             return false;
         }
 
@@ -61,14 +70,16 @@ namespace eka2l1 {
         entry.key = key;
         entry.data = var;
 
-        entries.push_back(entry);
+        entries.insert(ite, entry);
 
         return true;
     }
 
     bool central_repo::add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var,
         const std::uint32_t meta) {
-        if (find_entry(key)) {
+        auto ite = lower_bound_entry(entries, key);
+
+        if ((ite != entries.end()) && (ite->key == key)) {
             return false;
         }
 
@@ -78,17 +89,15 @@ namespace eka2l1 {
         entry.key = key;
         entry.data = var;
 
-        entries.push_back(entry);
+        entries.insert(ite, entry);
 
         return true;
     }
 
     central_repo_entry *central_repo::find_entry(const std::uint32_t key) {
-        auto ite = std::find_if(entries.begin(), entries.end(), [=](const central_repo_entry &e) {
-            return e.key == key;
-        });
+        auto ite = lower_bound_entry(entries, key);
 
-        if (ite == entries.end()) {
+        if ((ite == entries.end()) || (ite->key != key)) {
             return nullptr;
         }
 
@@ -107,56 +116,155 @@ namespace eka2l1 {
         }
     }
 
-    void central_repo_client_subsession::modification_success(const std::uint32_t key) {
-        // Iters through all
-        for (std::size_t i = 0; i < notifies.size(); i++) {
-            cenrep_notify_info &notify = notifies[i];
-
-            if ((key & (notify.match & notify.mask))) {
-                // Notify and delete this request from the list
-                notify.sts.complete(0);
-                notifies.erase(notifies.begin() + i);
+    void central_repo::find_entries(const std::uint32_t partial_key, const std::uint32_t mask,
+        std::vector<central_repo_entry *> &matched_entries) {
+        // Keys sharing the leading masked bits with the partial key form one range in the sorted entries
+        std::uint32_t prefix_len = 0;
+
+        while ((prefix_len < 32) && (mask & (0x80000000 >> prefix_len))) {
+            prefix_len++;
+        }
+
+        const std::uint32_t prefix_mask = (prefix_len == 0) ? 0 : (0xFFFFFFFF << (32 - prefix_len));
+        const std::uint32_t low_key = partial_key & prefix_mask;
+        const std::uint32_t high_key = low_key | ~prefix_mask;
+
+        for (auto ite = lower_bound_entry(entries, low_key); (ite != entries.end()) && (ite->key <= high_key); ite++) {
+            if ((ite->key & mask) == (partial_key & mask)) {
+                matched_entries.push_back(&(*ite));
             }
         }
+    }
 
-        // Done all requests
+    void central_repo::notify_change(const std::uint32_t key) {
+        if (notifies.empty()) {
+            return;
+        }
+
+        std::vector<central_repo_notify_request> matched;
+        notifies.collect(key, matched);
+
+        for (auto &request : matched) {
+            request.sts.complete(0);
+        }
     }
 
-    int central_repo_client_subsession::add_notify_request(epoc::notify_info &info,
-        const std::uint32_t mask, const std::uint32_t match) {
-        auto find_result = std::find_if(notifies.begin(), notifies.end(), [&](const cenrep_notify_info &notify) {
-            return (notify.mask == mask) && (notify.match == match);
+    bool central_repo_notify_index::exists(central_repo_client_subsession *owner, const std::uint32_t mask,
+        const std::uint32_t partial_key) {
+        auto mask_ite = buckets.find(mask);
+
+        if (mask_ite == buckets.end()) {
+            return false;
+        }
+
+        auto bucket_ite = mask_ite->second.find(partial_key & mask);
+
+        if (bucket_ite == mask_ite->second.end()) {
+            return false;
+        }
+
+        return std::any_of(bucket_ite->second.begin(), bucket_ite->second.end(), [=](const central_repo_notify_request &request) {
+            return request.owner == owner;
         });
+    }
 
-        if (find_result != notifies.end()) {
-            return -1;
-        } else {
-            if (info.empty()) {
-                // Likely a test, pass
-                return 0;
+    void central_repo_notify_index::add(central_repo_client_subsession *owner, epoc::notify_info &info, const std::uint32_t mask,
+        const std::uint32_t partial_key) {
+        buckets[mask][partial_key & mask].push_back({ owner, info });
+    }
+
+    void central_repo_notify_index::collect(const std::uint32_t key, std::vector<central_repo_notify_request> &matched) {
+        for (auto mask_ite = buckets.begin(); mask_ite != buckets.end();) {
+            auto bucket_ite = mask_ite->second.find(key & mask_ite->first);
+
+            if (bucket_ite != mask_ite->second.end()) {
+                // Requests are one-shot
+                matched.insert(matched.end(), bucket_ite->second.begin(), bucket_ite->second.end());
+                mask_ite->second.erase(bucket_ite);
+            }
+
+            if (mask_ite->second.empty()) {
+                mask_ite = buckets.erase(mask_ite);
+            } else {
+                mask_ite++;
             }
         }
+    }
 
-        notifies.push_back({ info, mask, match });
+    void central_repo_notify_index::remove(central_repo_client_subsession *owner, const std::uint32_t mask,
+        const std::uint32_t partial_key, std::vector<central_repo_notify_request> &removed) {
+        auto remove_from_bucket = [&](std::vector<central_repo_notify_request> &bucket) {
+            common::erase_elements(bucket, [&](central_repo_notify_request &request) {
+                if (request.owner == owner) {
+                    removed.push_back(request);
+                    return true;
+                }
+
+                return false;
+            });
+        };
+
+        for (auto mask_ite = buckets.begin(); mask_ite != buckets.end();) {
+            if (mask == 0) {
+                for (auto bucket_ite = mask_ite->second.begin(); bucket_ite != mask_ite->second.end();) {
+                    remove_from_bucket(bucket_ite->second);
+                    bucket_ite = bucket_ite->second.empty() ? mask_ite->second.erase(bucket_ite) : std::next(bucket_ite);
+                }
+            } else if (mask_ite->first == mask) {
+                auto bucket_ite = mask_ite->second.find(partial_key & mask);
+
+                if (bucket_ite != mask_ite->second.end()) {
+                    remove_from_bucket(bucket_ite->second);
+
+                    if (bucket_ite->second.empty()) {
+                        mask_ite->second.erase(bucket_ite);
+                    }
+                }
+            }
+
+            if (mask_ite->second.empty()) {
+                mask_ite = buckets.erase(mask_ite);
+            } else {
+                mask_ite++;
+            }
+        }
+    }
+
+    void central_repo_client_subsession::modification_success(const std::uint32_t key) {
+        attach_repo->notify_change(key);
+    }
+
+    int central_repo_client_subsession::add_notify_request(epoc::notify_info &info,
+        const std::uint32_t mask, const std::uint32_t match) {
+        if (attach_repo->notifies.exists(this, mask, match)) {
+            return -1;
+        }
+
+        if (info.empty()) {
+            // Likely a test, pass
+            return 0;
+        }
+
+        attach_repo->notifies.add(this, info, mask, match);
         return 0;
     }
 
     void central_repo_client_subsession::cancel_all_notify_requests() {
-        common::erase_elements(notifies, [=](cenrep_notify_info &info) {
-            info.sts.complete(-3);
-            return true;
-        });
+        std::vector<central_repo_notify_request> removed;
+        attach_repo->notifies.remove(this, 0, 0, removed);
+
+        for (auto &request : removed) {
+            request.sts.complete(-3);
+        }
     }
 
     void central_repo_client_subsession::cancel_notify_request(const std::uint32_t match_key, const std::uint32_t mask) {
-        common::erase_elements(notifies, [=](cenrep_notify_info &info) {
-            if (info.match == match_key && info.mask == mask) {
-                info.sts.complete(-3);
-                return true;
-            }
+        std::vector<central_repo_notify_request> removed;
+        attach_repo->notifies.remove(this, mask, match_key, removed);
 
-            return false;
-        });
+        for (auto &request : removed) {
+            request.sts.complete(-3);
+        }
     }
 
     central_repo_entry *central_repo_client_subsession::get_entry(const std::uint32_t key, int mode) {
@@ -180,14 +288,7 @@ namespace eka2l1 {
         // If not in transaction, or if we are in transaction but read-mode
         // Directly get the repo data
         if (!active || mode == 0) {
-            auto result = std::find_if(attach_repo->entries.begin(), attach_repo->entries.end(),
-                [&](const central_repo_entry &entry) { return entry.key == key; });
-
-            if (result == attach_repo->entries.end()) {
-                return nullptr;
-            }
-
-            return &(*result);
+            return attach_repo->find_entry(key);
         }
 
         transactor.changes.emplace(key, central_repo_entry{});
@@ -281,7 +382,7 @@ namespace eka2l1 {
         }
 
         // Write committed changes to disk
-        write_changes(io, mngr);
+        attach_repo->journal_change(io, mngr, *attach_repo->find_entry(key));
         modification_success(key);
 
         ctx->set_request_status(epoc::error_none);
@@ -306,7 +407,7 @@ namespace eka2l1 {
         case cen_rep_set_int: {
             if (entry->data.etype != central_repo_entry_type::integer) {
                 ctx->set_request_status(epoc::error_argument);
-                break;
+                return;
             }
 
             entry->data.intd = static_cast<std::uint64_t>(*ctx->get_arg<std::uint32_t>(1));
@@ -316,7 +417,7 @@ namespace eka2l1 {
         case cen_rep_set_real: {
             if (entry->data.etype != central_repo_entry_type::real) {
                 ctx->set_request_status(epoc::error_argument);
-                break;
+                return;
             }
 
             entry->data.reald = *ctx->get_arg<float>(1);
@@ -326,7 +427,7 @@ namespace eka2l1 {
         case cen_rep_set_string: {
             if (entry->data.etype != central_repo_entry_type::string) {
                 ctx->set_request_status(epoc::error_argument);
-                break;
+                return;
             }
 
             entry->data.strd = *ctx->get_arg<std::string>(1);
@@ -340,6 +441,11 @@ namespace eka2l1 {
         }
         }
 
+        // Outside of a transaction, the change is committed right away
+        if (!is_active()) {
+            attach_repo->journal_change(ctx->sys->get_io_system(), ctx->sys->get_manager_system()->get_device_manager(), *entry);
+        }
+
         // Success in modifying
         modification_success(entry->key);
         ctx->set_request_status(epoc::error_none);
@@ -446,45 +552,49 @@ namespace eka2l1 {
         // Set found count to 0
         found_uid_result_array[0] = 0;
 
-        for (auto &entry : attach_repo->entries) {
-            // Try to match the key first
-            if ((entry.key & filter->id_mask) != (filter->partial_key & filter->id_mask)) {
-                // Mask doesn't match, abandon this entry
-                continue;
-            }
+        bool find_not_eq = false;
 
-            std::uint32_t key_found = 0;
-            bool find_not_eq = false;
+        switch (ctx->msg->function) {
+        case cen_rep_find_neq_int:
+        case cen_rep_find_neq_real:
+        case cen_rep_find_neq_string:
+            find_not_eq = true;
+            break;
 
-            switch (ctx->msg->function) {
-            case cen_rep_find_neq_int:
-            case cen_rep_find_neq_real:
-            case cen_rep_find_neq_string:
-                find_not_eq = true;
-                break;
+        default:
+            break;
+        }
 
-            default:
-                break;
-            }
+        // Index 1 argument contains the value we should look for
+        std::int32_t int_to_compare = 0;
+
+        if ((ctx->msg->function == cen_rep_find_eq_int) || (ctx->msg->function == cen_rep_find_neq_int)) {
+            int_to_compare = *ctx->get_arg<std::int32_t>(1);
+        }
+
+        std::vector<central_repo_entry *> matched_entries;
+        attach_repo->find_entries(filter->partial_key, filter->id_mask, matched_entries);
+
+        for (central_repo_entry *entry : matched_entries) {
+            std::uint32_t key_found = 0;
 
             // Depends on the opcode, we try to match the value
             switch (ctx->msg->function) {
             case cen_rep_find_eq_int:
             case cen_rep_find_neq_int: {
-                if (entry.data.etype != central_repo_entry_type::integer) {
+                if (entry->data.etype != central_repo_entry_type::integer) {
                     // It must be integer type
                     break;
                 }
 
-                // Index 1 argument contains the value we should look for
                 // TODO: Signed/unsigned is dangerous
-                if (static_cast<std::int32_t>(entry.data.intd) == *ctx->get_arg<std::int32_t>(1)) {
+                if (static_cast<std::int32_t>(entry->data.intd) == int_to_compare) {
                     if (!find_not_eq) {
-                        key_found = entry.key;
+                        key_found = entry->key;
                     }
                 } else {
                     if (find_not_eq) {
-                        key_found = entry.key;
+                        key_found = entry->key;
                     }
                 }
 
@@ -492,7 +602,7 @@ namespace eka2l1 {
             }
 
             case cen_rep_find:
-                key_found = entry.key;
+                key_found = entry->key;
                 break;
 
             default: {
@@ -19,7 +19,6 @@
  */
 
 #include <cassert>
-#include <regex>
 
 #include <common/buffer.h>
 #include <common/chunkyseri.h>
@@ -161,6 +160,24 @@ namespace eka2l1 {
         return &interface_ite->second;
     }
 
+    /**
+     * \brief Get the content of a file, in place when it's burnt in the ROM.
+     *
+     * \param f       The file to get the content of.
+     * \param storage Holds the content when the file has to be read.
+     */
+    static std::uint8_t *get_file_content(file *f, std::vector<std::uint8_t> &storage) {
+        if (const std::uint8_t *view = f->direct_view()) {
+            // Only read through streams from here
+            return const_cast<std::uint8_t *>(view);
+        }
+
+        storage.resize(f->size());
+        f->read_file(storage.data(), static_cast<std::uint32_t>(storage.size()), 1);
+
+        return storage.data();
+    }
+
     bool ecom_server::load_archives(eka2l1::io_system *io) {
         std::vector<std::string> archives = get_ecom_plugin_archives(io);
 
@@ -169,12 +186,13 @@ namespace eka2l1 {
 
             symfile f = io->open_file(common::utf8_to_ucs2(archive), READ_MODE | BIN_MODE);
             std::vector<std::uint8_t> buf;
-            buf.resize(f->size());
 
-            f->read_file(&buf[0], static_cast<std::uint32_t>(buf.size()), 1);
+            std::uint8_t *content = get_file_content(f.get(), buf);
+            const std::size_t content_size = f->size();
+
             f->close();
 
-            common::chunkyseri seri(buf.data(), buf.size(), common::SERI_MODE_READ);
+            common::chunkyseri seri(content, content_size, common::SERI_MODE_READ);
             loader::spi_file spi(0);
 
             bool result = spi.do_state(seri);
@@ -233,11 +251,13 @@ namespace eka2l1 {
             assert(f);
 
             std::vector<std::uint8_t> dat;
-            dat.resize(f->size());
-            f->read_file(&dat[0], static_cast<std::uint32_t>(dat.size()), 1);
+
+            std::uint8_t *content = get_file_content(f.get(), dat);
+            const std::size_t content_size = f->size();
+
             f->close();
 
-            if (!load_and_install_plugin_from_buffer(common::utf8_to_ucs2(entry->full_path), &dat[0], dat.size(), drv)) {
+            if (!load_and_install_plugin_from_buffer(common::utf8_to_ucs2(entry->full_path), content, content_size, drv)) {
                 LOG_ERROR("Can't load and install plugins description {}", entry->name);
                 return false;
             }
@@ -427,13 +447,6 @@ namespace eka2l1 {
         // - All extended interfaces given are available in the implementation
         // - Match the wildcard (if wildcard not empty)
 
-        // May want to construct a regex for name comparing if we use generic match
-        std::regex wildcard_matcher;
-
-        if (list_impl_param.match_type && !match_str.empty()) {
-            wildcard_matcher = std::move(std::regex(common::wildcard_to_regex_string(match_str)));
-        }
-
         // First, lookup the interface
         ecom_interface_info *interface = server<ecom_server>()->get_interface(uids.uid1);
 
@@ -483,7 +496,7 @@ namespace eka2l1 {
             // We still need to see if the name is match
             // Generic match ? Wildcard check
             if (list_impl_param.match_type) {
-                if (std::regex_match(implementation->default_data, wildcard_matcher)) {
+                if (common::match_wildcard(implementation->default_data, match_str, false)) {
                     satisfy = true;
                 }
             } else {
@@ -59,8 +59,8 @@ namespace eka2l1::service {
             0, 0x1000, 0x1000, prot::read_write, kernel::chunk_type::normal, kernel::chunk_access::local,
             kernel::chunk_attrib::none);
 
-        allocator_ = std::make_unique<common::block_allocator>(reinterpret_cast<std::uint8_t *>(
-                                                                   control_->host_base())
+        allocator_ = std::make_unique<common::tlsf_allocator>(reinterpret_cast<std::uint8_t *>(
+                                                                  control_->host_base())
                 + TEMP_ARGS_REGION,
             0x1000 - TEMP_ARGS_REGION);
 
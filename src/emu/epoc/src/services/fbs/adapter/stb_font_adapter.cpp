@@ -293,4 +293,38 @@ namespace eka2l1::epoc::adapter {
 
         return true;
     }
+
+    std::uint8_t *stb_font_file_adapter::get_glyph_image(const std::size_t idx, const std::uint32_t code, const int font_size,
+        character_info &info, int *rasterized_width, int *rasterized_height) {
+        int off = 0;
+        stbtt_fontinfo *finfo = get_or_create_info(static_cast<int>(idx), &off);
+
+        *rasterized_width = 0;
+        *rasterized_height = 0;
+
+        if (!finfo) {
+            return nullptr;
+        }
+
+        // Same scale the packer uses for a positive font size
+        const float scale = stbtt_ScaleForPixelHeight(finfo, static_cast<float>(font_size));
+
+        int adv_width = 0;
+        int left_side_bearing = 0;
+        int xoff = 0;
+        int yoff = 0;
+
+        stbtt_GetCodepointHMetrics(finfo, static_cast<int>(code), &adv_width, &left_side_bearing);
+
+        std::uint8_t *result = stbtt_GetCodepointBitmap(finfo, scale, scale, static_cast<int>(code), rasterized_width,
+            rasterized_height, &xoff, &yoff);
+
+        info.xoff = static_cast<float>(xoff);
+        info.yoff = static_cast<float>(yoff);
+        info.xoff2 = static_cast<float>(xoff + *rasterized_width);
+        info.yoff2 = static_cast<float>(yoff + *rasterized_height);
+        info.xadv = adv_width * scale;
+
+        return result;
+    }
 }
@@ -67,67 +67,45 @@ namespace eka2l1 {
         return epoc::bitmap_file_no_compression;
     }
 
-    static std::size_t estimate_compress_size(fbsbitmap *bmp, std::uint8_t *data_base) {
-        std::size_t est_size = 0;
-        data_base += bmp->bitmap_->data_offset_;
-
-        common::ro_buf_stream source(data_base, bmp->bitmap_->header_.bitmap_size - sizeof(loader::sbm_header));
-
-        switch (bmp->bitmap_->header_.bit_per_pixels) {
+    static bool compress_bitmap_data(const int bpp, const std::uint8_t *source, const std::size_t source_size,
+        std::uint8_t *dest, std::size_t &dest_size) {
+        switch (bpp) {
         case 8:
-            compress_rle<8>(&source, nullptr, est_size);
-            break;
+            return compress_rle<8>(source, source_size, dest, dest_size);
 
         case 16:
-            compress_rle<16>(&source, nullptr, est_size);
-            break;
+            return compress_rle<16>(source, source_size, dest, dest_size);
 
         case 24:
-            compress_rle<24>(&source, nullptr, est_size);
-            break;
+            return compress_rle<24>(source, source_size, dest, dest_size);
 
         case 32:
-            compress_rle<32>(&source, nullptr, est_size);
-            break;
+            return compress_rle<32>(source, source_size, dest, dest_size);
 
         default:
             break;
         }
 
-        return est_size;
+        dest_size = 0;
+        return false;
     }
 
-    static bool compress_data(fbsbitmap *bmp, std::uint8_t *base, std::uint8_t *dest_ptr, const std::size_t dest_size) {
+    static std::size_t estimate_compress_size(fbsbitmap *bmp, std::uint8_t *data_base) {
         std::size_t est_size = 0;
-        base += bmp->bitmap_->data_offset_;
-
-        common::ro_buf_stream source(base, bmp->bitmap_->header_.bitmap_size - sizeof(loader::sbm_header));
-        common::wo_buf_stream dest(dest_ptr, dest_size);
-
-        bool result = false;
-
-        switch (bmp->bitmap_->header_.bit_per_pixels) {
-        case 8:
-            result = compress_rle<8>(&source, &dest, est_size);
-            break;
-
-        case 16:
-            result = compress_rle<16>(&source, &dest, est_size);
-            break;
+        data_base += bmp->bitmap_->data_offset_;
 
-        case 24:
-            result = compress_rle<24>(&source, &dest, est_size);
-            break;
+        compress_bitmap_data(bmp->bitmap_->header_.bit_per_pixels, data_base,
+            bmp->bitmap_->header_.bitmap_size - sizeof(loader::sbm_header), nullptr, est_size);
 
-        case 32:
-            result = compress_rle<32>(&source, nullptr, est_size);
-            break;
+        return est_size;
+    }
 
-        default:
-            break;
-        }
+    static bool compress_data(fbsbitmap *bmp, std::uint8_t *base, std::uint8_t *dest_ptr, const std::size_t dest_size) {
+        std::size_t est_size = dest_size;
+        base += bmp->bitmap_->data_offset_;
 
-        return result;
+        return compress_bitmap_data(bmp->bitmap_->header_.bit_per_pixels, base,
+            bmp->bitmap_->header_.bitmap_size - sizeof(loader::sbm_header), dest_ptr, est_size);
     }
 
     void compress_queue::actual_compress(fbsbitmap *bmp) {
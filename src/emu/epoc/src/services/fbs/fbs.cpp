@@ -39,7 +39,7 @@
 
 namespace eka2l1 {
     fbs_chunk_allocator::fbs_chunk_allocator(chunk_ptr de_chunk, std::uint8_t *dat_ptr)
-        : block_allocator(dat_ptr, de_chunk->committed())
+        : tlsf_allocator(dat_ptr, de_chunk->committed())
         , target_chunk(std::move(de_chunk)) {
     }
 
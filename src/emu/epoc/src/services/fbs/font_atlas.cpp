@@ -21,9 +21,24 @@
 #include <common/algorithm.h>
 #include <common/time.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace eka2l1::epoc {
+    // Empty pixels kept on the right and bottom of each glyph, so filtering does not bleed neighbours in
+    static constexpr int GLYPH_PADDING = 1;
+
+    // Shelf heights are rounded to this, so glyphs of close heights can share and recycle shelves
+    static constexpr int SHELF_HEIGHT_GRANULARITY = 8;
+
     font_atlas::font_atlas()
-        : atlas_handle_(0) {
+        : atlas_handle_(0)
+        , adapter_(nullptr)
+        , size_(0)
+        , shelf_bottom_(0)
+        , draw_serial_(0)
+        , dirty_top_(0)
+        , dirty_bottom_(0) {
     }
 
     font_atlas::font_atlas(adapter::font_file_adapter_base *adapter, const char16_t initial_start,
@@ -31,6 +46,10 @@ namespace eka2l1::epoc {
         : atlas_handle_(0)
         , adapter_(adapter)
         , size_(font_size)
+        , shelf_bottom_(0)
+        , draw_serial_(0)
+        , dirty_top_(0)
+        , dirty_bottom_(0)
         , initial_range_(initial_start, initial_char_count) {
     }
 
@@ -40,6 +59,12 @@ namespace eka2l1::epoc {
         atlas_handle_ = 0;
         size_ = font_size;
         initial_range_ = { initial_start, initial_char_count };
+
+        reset_glyphs();
+        atlas_data_.reset();
+
+        dirty_top_ = 0;
+        dirty_bottom_ = 0;
     }
 
     void font_atlas::free(drivers::graphics_driver *driver) {
@@ -56,75 +81,212 @@ namespace eka2l1::epoc {
         return common::align(ESTIMATE_MAX_CHAR_IN_ATLAS_WIDTH * size_, 1024);
     }
 
-    bool font_atlas::draw_text(const std::u16string &text, const eka2l1::rect &text_box, const epoc::text_alignment alignment, drivers::graphics_driver *driver, drivers::graphics_command_list_builder *builder) {
-        const int width = get_atlas_width();
+    int font_atlas::find_shelf(const int width, const int height) {
+        const int atlas_width = get_atlas_width();
+        const int shelf_height = common::min(common::align(height, SHELF_HEIGHT_GRANULARITY), atlas_width);
 
-        if (!atlas_data_) {
-            atlas_data_ = std::make_unique<std::uint8_t[]>(width * width);
-            auto cinfos = std::make_unique<adapter::character_info[]>(initial_range_.second);
+        int best = -1;
+
+        for (std::size_t i = 0; i < shelves_.size(); i++) {
+            font_atlas_shelf &shelf = shelves_[i];
 
-            if (!adapter_->begin_get_atlas(atlas_data_.get(), { width, width })) {
-                return false;
+            if ((shelf.height_ < height) || (shelf.cursor_ + width > atlas_width)) {
+                continue;
             }
 
-            if (!adapter_->get_glyph_atlas(initial_range_.first, nullptr, initial_range_.second,
-                    size_, cinfos.get())) {
-                return false;
+            // Do not waste a tall shelf on small glyphs, unless nobody lives there yet
+            if (!shelf.glyphs_.empty() && (shelf.height_ > shelf_height + shelf_height / 4)) {
+                continue;
             }
 
-            // initialize the last used list and character map
-            for (char16_t i = 0; i < initial_range_.second; i++) {
-                last_use_.push_back(initial_range_.first + i);
-                characters_.emplace(initial_range_.first + i, cinfos[i]);
+            if ((best == -1) || (shelf.height_ < shelves_[best].height_)) {
+                best = static_cast<int>(i);
             }
+        }
 
-            atlas_handle_ = drivers::create_bitmap(driver, { width, width });
-            builder->update_bitmap(atlas_handle_, 8, reinterpret_cast<const char *>(atlas_data_.get()),
-                width * width, { 0, 0 }, { width, width });
+        if (best != -1) {
+            return best;
         }
 
-        std::vector<int> to_rast;
-        std::vector<char16_t> unique_char;
+        if (shelf_bottom_ + shelf_height <= atlas_width) {
+            shelves_.push_back({ shelf_bottom_, shelf_height, 0, draw_serial_, {} });
+            shelf_bottom_ += shelf_height;
 
-        // Iterate through characters, and filter out characters which is not available in the atlas.
-        // Add character to last used, too.
-        for (auto &chr : text) {
-            if (characters_.find(chr) == characters_.end()) {
-                if (!std::binary_search(to_rast.begin(), to_rast.end(), chr)) {
-                    to_rast.push_back(chr);
-                    std::sort(to_rast.begin(), to_rast.end());
-                }
-            }
+            return static_cast<int>(shelves_.size() - 1);
+        }
 
-            if (std::find(unique_char.begin(), unique_char.end(), chr) == unique_char.end()) {
-                last_use_.insert(last_use_.begin(), chr);
-                unique_char.push_back(chr);
+        return evict_shelf(height);
+    }
+
+    int font_atlas::evict_shelf(const int height) {
+        int victim = -1;
+
+        // Look from the least recently used glyph. Shelves drawn by the current text must stay.
+        for (auto ite = lru_.rbegin(); ite != lru_.rend(); ite++) {
+            const int shelf_index = characters_[*ite].shelf_;
+
+            if ((shelf_index >= 0) && (shelves_[shelf_index].last_use_ != draw_serial_) && (shelves_[shelf_index].height_ >= height)) {
+                victim = shelf_index;
+                break;
             }
         }
 
-        last_use_.erase(last_use_.end() - unique_char.size(), last_use_.end());
+        if (victim == -1) {
+            return -1;
+        }
+
+        font_atlas_shelf &shelf = shelves_[victim];
 
-        if (!to_rast.empty()) {
-            // Try to rasterize these
-            auto cinfos = std::make_unique<adapter::character_info[]>(to_rast.size());
+        for (const char16_t chr : shelf.glyphs_) {
+            auto glyph_ite = characters_.find(chr);
+            lru_.erase(glyph_ite->second.lru_);
+            characters_.erase(glyph_ite);
+        }
+
+        shelf.glyphs_.clear();
+        shelf.cursor_ = 0;
+
+        return victim;
+    }
+
+    font_atlas_glyph *font_atlas::add_glyph(const char16_t chr) {
+        font_atlas_glyph glyph{};
+        glyph.shelf_ = -1;
+
+        int width = 0;
+        int height = 0;
+
+        std::uint8_t *data = adapter_->get_glyph_image(0, chr, size_, glyph.info_, &width, &height);
+
+        if (data && (width > 0) && (height > 0)) {
+            const int atlas_width = get_atlas_width();
+            const int slot_width = width + GLYPH_PADDING;
+            const int slot_height = height + GLYPH_PADDING;
+
+            const int shelf_index = ((slot_width <= atlas_width) && (slot_height <= atlas_width)) ? find_shelf(slot_width, slot_height) : -1;
+
+            if (shelf_index == -1) {
+                adapter_->free_glyph_bitmap(data);
+                return nullptr;
+            }
+
+            font_atlas_shelf &shelf = shelves_[shelf_index];
+            const int x = shelf.cursor_;
+            const int y = shelf.y_;
 
-            if (!adapter_->get_glyph_atlas(0, to_rast.data(), static_cast<char16_t>(to_rast.size()), size_,
-                    cinfos.get())) {
-                // Try to redo the atlas, getting latest use characters.
-                adapter_->end_get_atlas();
-                adapter_->begin_get_atlas(atlas_data_.get(), { width, width });
+            // The slot may still hold pixels of an evicted glyph, padding included
+            for (int row = 0; row < slot_height; row++) {
+                std::uint8_t *dest = atlas_data_.get() + (y + row) * atlas_width + x;
 
-                if (!adapter_->get_glyph_atlas(0, &last_use_[0], static_cast<char16_t>(characters_.size() - 5),
-                        size_, cinfos.get())) {
-                    return false;
+                if (row < height) {
+                    std::copy(data + row * width, data + (row + 1) * width, dest);
+                    dest[width] = 0;
+                } else {
+                    std::fill(dest, dest + slot_width, 0);
                 }
+            }
+
+            glyph.info_.x0 = static_cast<std::uint16_t>(x);
+            glyph.info_.y0 = static_cast<std::uint16_t>(y);
+            glyph.info_.x1 = static_cast<std::uint16_t>(x + width);
+            glyph.info_.y1 = static_cast<std::uint16_t>(y + height);
+            glyph.shelf_ = shelf_index;
+
+            shelf.cursor_ += slot_width;
+            shelf.last_use_ = draw_serial_;
+            shelf.glyphs_.push_back(chr);
+
+            dirty_top_ = common::min(dirty_top_, y);
+            dirty_bottom_ = common::max(dirty_bottom_, y + slot_height);
+        }
+
+        if (data) {
+            adapter_->free_glyph_bitmap(data);
+        }
+
+        lru_.push_front(chr);
+        glyph.lru_ = lru_.begin();
+
+        return &characters_.emplace(chr, glyph).first->second;
+    }
+
+    void font_atlas::reset_glyphs() {
+        characters_.clear();
+        lru_.clear();
+        shelves_.clear();
 
-                for (std::size_t i = 0; i < characters_.size() - 5; i++) {
-                    characters_[last_use_[i]] = cinfos[i];
+        shelf_bottom_ = 0;
+    }
+
+    font_atlas_glyph *font_atlas::get_glyph(const char16_t chr) {
+        auto ite = characters_.find(chr);
+
+        if (ite == characters_.end()) {
+            return add_glyph(chr);
+        }
+
+        font_atlas_glyph &glyph = ite->second;
+        lru_.splice(lru_.begin(), lru_, glyph.lru_);
+
+        if (glyph.shelf_ >= 0) {
+            shelves_[glyph.shelf_].last_use_ = draw_serial_;
+        }
+
+        return &glyph;
+    }
+
+    void font_atlas::upload_dirty(drivers::graphics_command_list_builder *builder) {
+        const int width = get_atlas_width();
+
+        if (dirty_top_ < dirty_bottom_) {
+            // Full rows are contiguous in the atlas data, so the band can go in one update
+            const int band_height = dirty_bottom_ - dirty_top_;
+            builder->update_bitmap(atlas_handle_, 8, reinterpret_cast<const char *>(atlas_data_.get() + dirty_top_ * width),
+                band_height * width, { 0, dirty_top_ }, { width, band_height });
+        }
+
+        dirty_top_ = width;
+        dirty_bottom_ = 0;
+    }
+
+    bool font_atlas::draw_text(const std::u16string &text, const eka2l1::rect &text_box, const epoc::text_alignment alignment, drivers::graphics_driver *driver, drivers::graphics_command_list_builder *builder) {
+        const int width = get_atlas_width();
+        draw_serial_++;
+
+        if (!atlas_data_) {
+            atlas_data_ = std::make_unique<std::uint8_t[]>(width * width);
+            atlas_handle_ = drivers::create_bitmap(driver, { width, width });
+
+            dirty_top_ = width;
+            dirty_bottom_ = 0;
+
+            // Warm up with the initial range, it's uploaded together with the glyphs of this text
+            for (char16_t i = 0; i < initial_range_.second; i++) {
+                get_glyph(initial_range_.first + i);
+            }
+        }
+
+        std::vector<font_atlas_glyph *> glyphs(text.size());
+        bool atlas_reset = false;
+
+        // Rasterize what's not in the atlas yet. Glyphs of this text are marked used, so they can't evict each other.
+        for (std::size_t i = 0; i < text.size(); i++) {
+            glyphs[i] = get_glyph(text[i]);
+
+            if (!glyphs[i] && !atlas_reset) {
+                // No shelf could be recycled for it. Start over with only what this text needs,
+                // anything that still does not fit is not drawn.
+                reset_glyphs();
+                atlas_reset = true;
+
+                for (std::size_t j = 0; j <= i; j++) {
+                    glyphs[j] = get_glyph(text[j]);
                 }
             }
         }
 
+        upload_dirty(builder);
+
         eka2l1::vec2 cur_pos = text_box.top;
 
         // Calculate size of the text to know where to put them
@@ -132,8 +294,10 @@ namespace eka2l1::epoc {
         if (alignment != epoc::text_alignment::left) {
             float size_length = 0;
 
-            for (auto &chr : text) {
-                size_length += characters_[chr].xoff2 - characters_[chr].xoff;
+            for (auto glyph : glyphs) {
+                if (glyph) {
+                    size_length += glyph->info_.xoff2 - glyph->info_.xoff;
+                }
             }
 
             if (alignment == epoc::text_alignment::right) {
@@ -143,33 +307,46 @@ namespace eka2l1::epoc {
             }
         }
 
-        builder->set_blend_mode(true);
-        builder->blend_formula(drivers::blend_equation::add, drivers::blend_equation::add,
-            drivers::blend_factor::frag_out_alpha, drivers::blend_factor::one_minus_frag_out_alpha,
-            drivers::blend_factor::zero, drivers::blend_factor::one);
+        dest_rects_.clear();
+        source_rects_.clear();
+
+        for (auto glyph : glyphs) {
+            if (!glyph) {
+                continue;
+            }
 
-        // Start to render these texts.
-        for (auto &chr : text) {
-            eka2l1::rect source_rect;
-            adapter::character_info &info = characters_[chr];
+            const adapter::character_info &info = glyph->info_;
 
-            source_rect.top = { info.x0, info.y0 };
-            source_rect.size = eka2l1::object_size(info.x1 - info.x0, info.y1 - info.y0);
+            if (glyph->shelf_ >= 0) {
+                eka2l1::rect source_rect;
+                source_rect.top = { info.x0, info.y0 };
+                source_rect.size = eka2l1::object_size(info.x1 - info.x0, info.y1 - info.y0);
 
-            eka2l1::rect dest_rect;
-            dest_rect.top.x = cur_pos.x + static_cast<int>(info.xoff);
-            dest_rect.top.y = cur_pos.y + static_cast<int>(info.yoff);
-            dest_rect.size.x = static_cast<int>(info.xoff2 - info.xoff);
-            dest_rect.size.y = static_cast<int>(info.yoff2 - info.yoff);
+                eka2l1::rect dest_rect;
+                dest_rect.top.x = cur_pos.x + static_cast<int>(info.xoff);
+                dest_rect.top.y = cur_pos.y + static_cast<int>(info.yoff);
+                dest_rect.size.x = static_cast<int>(info.xoff2 - info.xoff);
+                dest_rect.size.y = static_cast<int>(info.yoff2 - info.yoff);
 
-            builder->draw_bitmap(atlas_handle_, 0, dest_rect, source_rect, drivers::bitmap_draw_flag_use_brush);
+                dest_rects_.push_back(dest_rect);
+                source_rects_.push_back(source_rect);
+            }
 
             // TODO: Newline
             cur_pos.x += static_cast<int>(std::round(info.xadv));
         }
 
+        builder->set_blend_mode(true);
+        builder->blend_formula(drivers::blend_equation::add, drivers::blend_equation::add,
+            drivers::blend_factor::frag_out_alpha, drivers::blend_factor::one_minus_frag_out_alpha,
+            drivers::blend_factor::zero, drivers::blend_factor::one);
+
+        // Whole text in one go
+        builder->draw_bitmap_batch(atlas_handle_, dest_rects_.data(), source_rects_.data(),
+            static_cast<std::uint32_t>(dest_rects_.size()), drivers::bitmap_draw_flag_use_brush);
+
         builder->set_blend_mode(false);
 
         return true;
     }
-}
\ No newline at end of file
+}
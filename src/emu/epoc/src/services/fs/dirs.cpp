@@ -33,6 +33,9 @@
 #include <epoc/utils/err.h>
 
 namespace eka2l1 {
+    // Upper bound on entries fetched from the host directory per packed read
+    static constexpr std::size_t MAX_DIR_ENTRIES_PER_FETCH = 256;
+
     void fs_server_client::open_dir(service::ipc_context *ctx) {
         auto dir = ctx->get_arg<std::u16string>(0);
 
@@ -112,7 +115,24 @@ namespace eka2l1 {
         directory *dir = reinterpret_cast<directory *>(dir_node->vfs_node.get());
 
         epoc::fs::entry entry;
-        std::optional<entry_info> info = dir->get_next_entry();
+        std::optional<entry_info> info;
+
+        // Hand out what a packed read fetched ahead first
+        if (dir_node->dir_entries && dir_node->dir_entries->remaining()) {
+            entry_batch &batch = *dir_node->dir_entries;
+            const packed_entry_info &packed = batch.entries[batch.cursor++];
+
+            info.emplace();
+            info->size = static_cast<std::size_t>(packed.size);
+            info->last_write = packed.last_write;
+            info->attribute = packed.attribute;
+            info->type = packed.type;
+            info->raw_attribute = packed.raw_attribute;
+            info->has_raw_attribute = packed.has_raw_attribute;
+            info->full_path = common::ucs2_to_utf8(std::u16string(batch.name_of(packed), packed.name_length));
+        } else {
+            info = dir->get_next_entry();
+        }
 
         if (!info) {
             ctx->set_request_status(epoc::error_eof);
@@ -182,28 +202,44 @@ namespace eka2l1 {
         kernel_system *kern = ctx->sys->get_kernel_system();
         const bool should_support_64bit_size = kern->get_epoc_version() >= epocver::epoc10;
 
+        if (!dir_node->dir_entries) {
+            dir_node->dir_entries = std::make_unique<entry_batch>();
+        }
+
+        entry_batch &batch = *dir_node->dir_entries;
+
+        epoc::fs::entry entry;
+        entry.uid1 = entry.uid2 = entry.uid3 = 0;
+        entry.reserved = 0;
+
         while (entry_buf < entry_buf_end) {
-            epoc::fs::entry entry;
-            std::optional<entry_info> info = dir->peek_next_entry();
+            if (!batch.remaining()) {
+                // Fetch as many entries as could possibly fit in one pass over the host directory.
+                // What doesn't fit stays in the batch for the next read.
+                const std::size_t max_fit = static_cast<std::size_t>(entry_buf_end - entry_buf) / (entry_no_name_size + 4) + 1;
 
-            if (!info) {
-                entry_arr->set_length(own_pr, static_cast<std::uint32_t>(entry_buf - entry_buf_org));
-                LOG_TRACE("Queried entries: 0x{:x}", queried_entries);
-                ctx->set_request_status(epoc::error_eof);
+                if (dir->get_next_entries(batch, common::min<std::size_t>(max_fit, MAX_DIR_ENTRIES_PER_FETCH)) == 0) {
+                    entry_arr->set_length(own_pr, static_cast<std::uint32_t>(entry_buf - entry_buf_org));
+                    LOG_TRACE("Queried entries: 0x{:x}", queried_entries);
+                    ctx->set_request_status(epoc::error_eof);
 
-                return;
+                    return;
+                }
             }
 
-            if (entry_buf + entry_no_name_size + common::align(common::utf8_to_ucs2(info->name).length() * 2, 4) + 4 > entry_buf_end) {
+            const packed_entry_info &info = batch.entries[batch.cursor];
+            const std::size_t name_size = info.name_length * 2;
+
+            if (entry_buf + entry_no_name_size + common::align(name_size, 4) + 4 > entry_buf_end) {
                 break;
             }
 
-            if (info->has_raw_attribute) {
-                entry.attrib = info->raw_attribute;
+            if (info.has_raw_attribute) {
+                entry.attrib = info.raw_attribute;
             } else {
                 entry.attrib = epoc::fs::entry_att_normal;
 
-                switch (info->attribute) {
+                switch (info.attribute) {
                 case io_attrib::hidden: {
                     entry.attrib |= epoc::fs::entry_att_hidden;
                     break;
@@ -213,24 +249,26 @@ namespace eka2l1 {
                     break;
                 }
 
-                if (info->type == io_component_type::dir) {
+                if (info.type == io_component_type::dir) {
                     entry.attrib |= epoc::fs::entry_att_dir;
                 } else {
                     entry.attrib |= epoc::fs::entry_att_archive;
                 }
             }
 
-            entry.size = static_cast<std::uint32_t>(info->size);
-            entry.name = common::utf8_to_ucs2(info->name);
-            entry.modified = epoc::time{ info->last_write };
+            entry.size = static_cast<std::uint32_t>(info.size);
+            entry.size_high = static_cast<std::uint32_t>(info.size >> 32);
+            entry.modified = epoc::time{ info.last_write };
+            entry.name.set_length(nullptr, info.name_length);
 
             const std::uint32_t entry_write_size = epoc::fs::entry_standard_size + 4;
 
             memcpy(entry_buf, &entry, entry_write_size);
             entry_buf += entry_write_size;
 
-            memcpy(entry_buf, &entry.name.data[0], info->name.length() * 2);
-            entry_buf += common::align(info->name.length() * 2, 4);
+            // The name goes straight from the batch's pool
+            memcpy(entry_buf, batch.name_of(info), name_size);
+            entry_buf += common::align(name_size, 4);
 
             if (should_support_64bit_size) {
                 // Epoc10 uses two reserved bytes
@@ -239,7 +277,7 @@ namespace eka2l1 {
             }
 
             queried_entries += 1;
-            dir->get_next_entry();
+            batch.cursor++;
         }
 
         entry_arr->set_length(own_pr, static_cast<std::uint32_t>(entry_buf - entry_buf_org));
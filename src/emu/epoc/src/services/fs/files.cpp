@@ -177,6 +177,7 @@ namespace eka2l1 {
             f->seek(size, file_seek_mode::beg);
         }
 
+        server<fs_server>()->notify(f->file_name(), NOTIFY_WRITE_CHANGE);
         ctx->set_request_status(epoc::error_none);
     }
 
@@ -328,13 +329,18 @@ namespace eka2l1 {
         }
 
         auto new_path_abs = eka2l1::absolute_path(*new_path, ss_path, true);
-        bool res = ctx->sys->get_io_system()->rename(vfs_file->file_name(), new_path_abs);
+        const std::u16string old_path = vfs_file->file_name();
+
+        bool res = ctx->sys->get_io_system()->rename(old_path, new_path_abs);
 
         if (!res) {
             ctx->set_request_status(epoc::error_general);
             return;
         }
 
+        server<fs_server>()->notify(old_path, NOTIFY_FILE_ENTRY_CHANGE);
+        server<fs_server>()->notify(new_path_abs, NOTIFY_FILE_ENTRY_CHANGE);
+
         // Save state of file and reopening it
         size_t last_pos = vfs_file->tell();
         int last_mode = vfs_file->file_mode();
@@ -357,7 +363,7 @@ namespace eka2l1 {
             return;
         }
 
-        std::optional<std::string> write_data = ctx->get_arg<std::string>(0);
+        const std::uint8_t *write_data = ctx->get_arg_ptr(0);
 
         if (!write_data) {
             ctx->set_request_status(epoc::error_argument);
@@ -378,7 +384,8 @@ namespace eka2l1 {
             return;
         }
 
-        std::int32_t write_len = *ctx->get_arg<std::int32_t>(1);
+        std::int32_t write_len = common::min(*ctx->get_arg<std::int32_t>(1),
+            static_cast<std::int32_t>(ctx->get_arg_size(0)));
         std::int32_t write_pos_provided = *ctx->get_arg<std::int32_t>(2);
 
         std::uint64_t write_pos = 0;
@@ -394,11 +401,15 @@ namespace eka2l1 {
 
         // If this write pos is beyond the current end of file, use last pos
         vfs_file->seek(write_pos > last_pos ? last_pos : write_pos, file_seek_mode::beg);
-        size_t wrote_size = vfs_file->write_file(&(*write_data)[0], 1, write_len);
+        size_t wrote_size = vfs_file->write_file(write_data, 1, write_len);
 
         // LOG_TRACE("File {} wroted with size: {}",
         //    common::ucs2_to_utf8(vfs_file->file_name()), wrote_size);
 
+        if (wrote_size != 0) {
+            server<fs_server>()->notify(vfs_file->file_name(), NOTIFY_WRITE_CHANGE);
+        }
+
         ctx->set_request_status(epoc::error_none);
     }
 
@@ -441,11 +452,18 @@ namespace eka2l1 {
             read_len = static_cast<int>(size - read_pos);
         }
 
-        std::vector<char> read_data;
-        read_data.resize(read_len);
+        std::uint8_t *read_dest = ctx->get_arg_ptr(0);
 
-        size_t read_finish_len = vfs_file->read_file(read_data.data(), 1, read_len);
-        ctx->write_arg_pkg(0, reinterpret_cast<uint8_t *>(read_data.data()), static_cast<std::uint32_t>(read_finish_len));
+        if (!read_dest) {
+            ctx->set_request_status(epoc::error_argument);
+            return;
+        }
+
+        // Read straight into the client's descriptor
+        read_len = common::min(read_len, static_cast<int>(ctx->get_arg_max_size(0)));
+
+        size_t read_finish_len = vfs_file->read_file(read_dest, 1, read_len);
+        ctx->set_arg_des_len(0, static_cast<std::uint32_t>(read_finish_len));
 
         // LOG_TRACE("Readed {} from {} to address 0x{:x}", read_finish_len, read_pos, ctx->msg->args.args[0]);
         ctx->set_request_status(epoc::error_none);
@@ -538,6 +556,8 @@ namespace eka2l1 {
         symfile f = io->open_file(full_path, WRITE_MODE);
         f->close();
 
+        server<fs_server>()->notify(full_path, NOTIFY_FILE_ENTRY_CHANGE);
+
         LOG_INFO("Opening temp file: {}", common::ucs2_to_utf8(full_path));
         int handle = new_node(ctx->sys->get_io_system(), ctx->msg->own_thr, full_path,
             *ctx->get_arg<std::int32_t>(1), true, true);
@@ -702,6 +722,9 @@ namespace eka2l1 {
 
         LOG_INFO("Opening file: {}", name_utf8);
 
+        // Replacing an existing file only rewrites its content
+        const bool existed = overwrite && ctx->sys->get_io_system()->exist(*name_res);
+
         int handle = new_node(ctx->sys->get_io_system(), ctx->msg->own_thr, *name_res,
             *open_mode_res, overwrite, temporary);
 
@@ -710,6 +733,10 @@ namespace eka2l1 {
             return;
         }
 
+        if (overwrite) {
+            server<fs_server>()->notify(*name_res, existed ? NOTIFY_WRITE_CHANGE : NOTIFY_FILE_ENTRY_CHANGE);
+        }
+
         LOG_TRACE("Handle opened: {}", handle);
 
         ctx->write_arg_pkg<int>(3, handle);
@@ -24,6 +24,8 @@
 
 #include <epoc/utils/des.h>
 
+#include <algorithm>
+#include <chrono>
 #include <clocale>
 #include <cwctype>
 #include <memory>
@@ -116,6 +118,8 @@ namespace eka2l1 {
             HANDLE_CLIENT_IPC(create_private_path, epoc::fs_msg_create_private_path, "Fs::CreatePrivatePath");
             HANDLE_CLIENT_IPC(notify_change_ex, epoc::fs_msg_notify_change_ex, "Fs::NotifyChangeEx");
             HANDLE_CLIENT_IPC(notify_change, epoc::fs_msg_notify_change, "Fs::NotifyChange");
+            HANDLE_CLIENT_IPC(notify_change_cancel, epoc::fs_msg_notify_change_cancel, "Fs::NotifyChangeCancel");
+            HANDLE_CLIENT_IPC(notify_change_cancel_ex, epoc::fs_msg_notify_change_cancel_ex, "Fs::NotifyChangeCancelEx");
             HANDLE_CLIENT_IPC(mkdir, epoc::fs_msg_mkdir, "Fs::MkDir");
             HANDLE_CLIENT_IPC(rmdir, epoc::fs_msg_rmdir, "Fs::RmDir");
             HANDLE_CLIENT_IPC(delete_entry, epoc::fs_msg_delete, "Fs::Delete");
@@ -166,6 +170,9 @@ namespace eka2l1 {
             return;
         }
 
+        server<fs_server>()->notify(target, NOTIFY_FILE_ENTRY_CHANGE);
+        server<fs_server>()->notify(dest, NOTIFY_FILE_ENTRY_CHANGE);
+
         // A new app list may be created
         ctx->set_request_status(epoc::error_none);
     }
@@ -189,6 +196,9 @@ namespace eka2l1 {
             return;
         }
 
+        std::optional<entry_info> target_info = io->get_entry_info(target);
+        const bool is_dir = target_info && (target_info->type == io_component_type::dir);
+
         bool res = io->rename(target, dest);
 
         if (!res) {
@@ -196,6 +206,11 @@ namespace eka2l1 {
             return;
         }
 
+        const std::uint32_t change = is_dir ? NOTIFY_DIR_ENTRY_CHANGE : NOTIFY_FILE_ENTRY_CHANGE;
+
+        server<fs_server>()->notify(target, change);
+        server<fs_server>()->notify(dest, change);
+
         // A new app list may be created
         ctx->set_request_status(epoc::error_none);
     }
@@ -218,6 +233,7 @@ namespace eka2l1 {
             return;
         }
 
+        server<fs_server>()->notify(path, NOTIFY_FILE_ENTRY_CHANGE);
         ctx->set_request_status(epoc::error_none);
     }
 
@@ -231,6 +247,8 @@ namespace eka2l1 {
     }
 
     void fs_server::disconnect(service::ipc_context &ctx) {
+        // Nobody left to receive these
+        cancel_notify(ctx.msg->msg_session->unique_id(), 0, 0);
         typical_server::disconnect(ctx);
     }
 
@@ -290,6 +308,7 @@ namespace eka2l1 {
             return;
         }
 
+        server<fs_server>()->notify(private_path, NOTIFY_DIR_ENTRY_CHANGE);
         ctx->set_request_status(epoc::error_none);
     }
 
@@ -322,15 +341,31 @@ namespace eka2l1 {
         ctx->set_request_status(epoc::error_none);
     }
 
-    void fs_server_client::notify_change(service::ipc_context *ctx) {
-        notify_entry entry;
+    void fs_server_client::add_notify(service::ipc_context *ctx, const std::u16string &pattern) {
+        std::uint32_t type = static_cast<std::uint32_t>(*ctx->get_arg<std::int32_t>(0));
+
+        if (type & static_cast<std::uint32_t>(notify_type::all)) {
+            type = 0xFFFFFFFF;
+        }
 
-        entry.match_pattern = ".*";
-        entry.type = static_cast<notify_type>(*ctx->get_arg<std::int32_t>(0));
-        entry.request_status = ctx->msg->request_sts;
-        entry.request_thread = ctx->msg->own_thr;
+        epoc::fs::notify_entry entry;
+        entry.match_pattern = pattern;
+        entry.type_mask = type;
+        entry.info = epoc::notify_info(ctx->msg->request_sts, ctx->msg->own_thr);
+        entry.owner = client_ss_uid_;
 
-        notify_entries.push_back(entry);
+        fs_server *serv = server<fs_server>();
+        std::u16string node_path;
+
+        const std::lock_guard<std::mutex> guard(serv->notify_lock);
+
+        if (serv->notify_entries.add(std::move(entry), &node_path)) {
+            serv->watch_notify_directory(node_path);
+        }
+    }
+
+    void fs_server_client::notify_change(service::ipc_context *ctx) {
+        add_notify(ctx, u"*");
     }
 
     void fs_server_client::notify_change_ex(service::ipc_context *ctx) {
@@ -341,15 +376,200 @@ namespace eka2l1 {
             return;
         }
 
-        notify_entry entry;
-        entry.match_pattern = common::wildcard_to_regex_string(common::ucs2_to_utf8(*wildcard_match));
-        entry.type = static_cast<notify_type>(*ctx->get_arg<std::int32_t>(0));
-        entry.request_status = ctx->msg->request_sts;
-        entry.request_thread = ctx->msg->own_thr;
+        add_notify(ctx, *wildcard_match);
+        LOG_TRACE("Notify requested with wildcard: {}", common::ucs2_to_utf8(*wildcard_match));
+    }
+
+    void fs_server_client::notify_change_cancel(service::ipc_context *ctx) {
+        server<fs_server>()->cancel_notify(client_ss_uid_, 0, epoc::error_cancel);
+        ctx->set_request_status(epoc::error_none);
+    }
 
-        notify_entries.push_back(entry);
+    void fs_server_client::notify_change_cancel_ex(service::ipc_context *ctx) {
+        std::optional<eka2l1::address> sts_addr = ctx->get_arg<eka2l1::address>(0);
 
-        LOG_TRACE("Notify requested with wildcard: {}", common::ucs2_to_utf8(*wildcard_match));
+        if (!sts_addr) {
+            ctx->set_request_status(epoc::error_argument);
+            return;
+        }
+
+        server<fs_server>()->cancel_notify(client_ss_uid_, eka2l1::ptr<epoc::request_status>(*sts_addr), epoc::error_cancel);
+        ctx->set_request_status(epoc::error_none);
+    }
+
+    void fs_server::watch_notify_directory(const std::u16string &dir) {
+        // Root holds patterns with a wildcard drive, nothing on the host to watch for those
+        if (dir.empty()) {
+            return;
+        }
+
+        // The watch may be on its way out, keep it instead
+        auto stale_ite = std::find(notify_stale_watches.begin(), notify_stale_watches.end(), dir);
+
+        if (stale_ite != notify_stale_watches.end()) {
+            notify_stale_watches.erase(stale_ite);
+        }
+
+        if (notify_watches.find(dir) != notify_watches.end()) {
+            return;
+        }
+
+        io_system *io = sys->get_io_system();
+
+        if (!io->exist(dir + u'\\')) {
+            // Directory not there yet, only changes made by the emulator will be reported
+            notify_watches.emplace(dir, -1);
+            return;
+        }
+
+        const std::int64_t handle = io->watch_directory(
+            dir + u'\\', [this, dir](void *userdata, common::directory_changes &changes) {
+                on_host_directory_changes(dir, changes);
+            },
+            nullptr, common::directory_change_move | common::directory_change_last_write | common::directory_change_attrib);
+
+        notify_watches.emplace(dir, handle);
+    }
+
+    void fs_server::release_notify_watches(std::vector<std::u16string> &emptied, const bool from_host) {
+        if (from_host) {
+            // Removing a watch from inside its own callback is not allowed, let the server thread do it
+            notify_stale_watches.insert(notify_stale_watches.end(), emptied.begin(), emptied.end());
+            return;
+        }
+
+        emptied.insert(emptied.end(), notify_stale_watches.begin(), notify_stale_watches.end());
+        notify_stale_watches.clear();
+
+        for (const std::u16string &dir : emptied) {
+            auto watch_ite = notify_watches.find(dir);
+
+            if (watch_ite == notify_watches.end()) {
+                continue;
+            }
+
+            if (watch_ite->second != -1) {
+                sys->get_io_system()->unwatch_directory(watch_ite->second);
+            }
+
+            notify_watches.erase(watch_ite);
+        }
+    }
+
+    void fs_server::complete_notifies(std::vector<epoc::fs::notify_entry> &entries, const int err, const bool from_host) {
+        if (entries.empty()) {
+            return;
+        }
+
+        kernel_system *kern = sys->get_kernel_system();
+
+        if (from_host) {
+            kern->lock();
+        }
+
+        for (epoc::fs::notify_entry &entry : entries) {
+            entry.info.complete(err);
+        }
+
+        if (from_host) {
+            kern->unlock();
+        }
+    }
+
+    static std::uint64_t notify_time_now() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Host watches also see the changes the emulator makes itself. These are already reported,
+    // so host events on a path the emulator touched this recently are dropped.
+    static constexpr std::uint64_t NOTIFY_HOST_ECHO_WINDOW_MS = 2000;
+    static constexpr std::size_t MAX_NOTIFY_RECENT_CHANGES = 512;
+
+    void fs_server::notify(const std::u16string &path, const std::uint32_t change_mask, const bool from_host) {
+        if (notify_entries.size() == 0) {
+            return;
+        }
+
+        std::vector<epoc::fs::notify_entry> matched;
+
+        {
+            const std::lock_guard<std::mutex> guard(notify_lock);
+            const std::uint64_t now = notify_time_now();
+
+            if (from_host) {
+                auto recent_ite = notify_recent_changes.find(epoc::fs::notify_trie::fold(path));
+
+                if ((recent_ite != notify_recent_changes.end()) && (now - recent_ite->second < NOTIFY_HOST_ECHO_WINDOW_MS)) {
+                    return;
+                }
+            } else if (!notify_watches.empty()) {
+                if (notify_recent_changes.size() >= MAX_NOTIFY_RECENT_CHANGES) {
+                    for (auto ite = notify_recent_changes.begin(); ite != notify_recent_changes.end();) {
+                        if (now - ite->second >= NOTIFY_HOST_ECHO_WINDOW_MS) {
+                            ite = notify_recent_changes.erase(ite);
+                        } else {
+                            ite++;
+                        }
+                    }
+                }
+
+                notify_recent_changes[epoc::fs::notify_trie::fold(path)] = now;
+            }
+
+            std::vector<std::u16string> emptied;
+            notify_entries.collect(path, change_mask, matched, &emptied);
+
+            release_notify_watches(emptied, from_host);
+        }
+
+        complete_notifies(matched, epoc::error_none, from_host);
+    }
+
+    void fs_server::cancel_notify(const kernel::uid owner, const eka2l1::ptr<epoc::request_status> sts, const int err) {
+        std::vector<epoc::fs::notify_entry> removed;
+
+        {
+            const std::lock_guard<std::mutex> guard(notify_lock);
+            std::vector<std::u16string> emptied;
+
+            notify_entries.remove(owner, sts, removed, &emptied);
+            release_notify_watches(emptied, false);
+        }
+
+        if (err != 0) {
+            complete_notifies(removed, err, false);
+        }
+    }
+
+    void fs_server::on_host_directory_changes(const std::u16string &dir, common::directory_changes &changes) {
+        io_system *io = sys->get_io_system();
+
+        for (common::directory_change &change : changes) {
+            const std::u16string path = dir + u'\\' + common::utf8_to_ucs2(change.filename_);
+            std::uint32_t change_mask = 0;
+
+            if (change.change_ & (common::directory_change_action_created | common::directory_change_action_moved_to)) {
+                std::optional<entry_info> info = io->get_entry_info(path);
+
+                change_mask |= (info && (info->type == io_component_type::dir)) ? fs_server_client::NOTIFY_DIR_ENTRY_CHANGE
+                                                                                 : fs_server_client::NOTIFY_FILE_ENTRY_CHANGE;
+            }
+
+            if (change.change_ & (common::directory_change_action_delete | common::directory_change_action_moved_from)) {
+                // Whatever it was is gone, can't tell a file from a directory anymore
+                change_mask |= fs_server_client::NOTIFY_FILE_ENTRY_CHANGE | fs_server_client::NOTIFY_DIR_ENTRY_CHANGE;
+            }
+
+            if (change.change_ & common::directory_change_action_modified) {
+                change_mask |= fs_server_client::NOTIFY_WRITE_CHANGE | fs_server_client::NOTIFY_ATTRIB_CHANGE;
+            }
+
+            if (change_mask != 0) {
+                notify(path, change_mask, true);
+            }
+        }
     }
 
     bool is_e32img(symfile f) {
@@ -388,6 +608,7 @@ namespace eka2l1 {
             return;
         }
 
+        server<fs_server>()->notify(eka2l1::absolute_path(eka2l1::file_directory(*dir), ss_path, true), NOTIFY_DIR_ENTRY_CHANGE);
         ctx->set_request_status(epoc::error_none);
     }
 
@@ -400,7 +621,10 @@ namespace eka2l1 {
         }
 
         io_system *io = ctx->sys->get_io_system();
-        io->delete_entry(dir.value());
+
+        if (io->delete_entry(dir.value())) {
+            server<fs_server>()->notify(eka2l1::absolute_path(*dir, ss_path, true), NOTIFY_DIR_ENTRY_CHANGE);
+        }
 
         ctx->set_request_status(epoc::error_none);
     }
@@ -490,6 +714,7 @@ namespace eka2l1 {
             return;
         }
 
+        server<fs_server>()->notify(fname, NOTIFY_ATTRIB_CHANGE);
         ctx->set_request_status(epoc::error_none);
     }
 
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <epoc/services/fs/notify.h>
+
+#include <common/algorithm.h>
+#include <common/wildcard.h>
+
+#include <algorithm>
+
+namespace eka2l1::epoc::fs {
+    static constexpr char16_t NOTIFY_PATH_SEPARATOR = u'\\';
+
+    static bool has_wildcard(const std::u16string &component) {
+        return component.find_first_of(u"*?") != std::u16string::npos;
+    }
+
+    notify_trie::notify_trie()
+        : root_(nullptr, u"")
+        , count_(0) {
+    }
+
+    std::u16string notify_trie::fold(const std::u16string &path) {
+        std::u16string folded = common::lowercase_ucs2_string(path);
+
+        if (!folded.empty() && (folded.back() == NOTIFY_PATH_SEPARATOR)) {
+            folded += u'*';
+        }
+
+        return folded;
+    }
+
+    bool notify_trie::add(notify_entry entry, std::u16string *node_path) {
+        entry.match_pattern = fold(entry.match_pattern);
+
+        const std::lock_guard<std::mutex> guard(lock_);
+        node *target = &root_;
+
+        std::size_t start = 0;
+        std::size_t end = entry.match_pattern.find(NOTIFY_PATH_SEPARATOR);
+
+        // Only directory components are walked, the last component is the entry name itself
+        while (end != std::u16string::npos) {
+            std::u16string component = entry.match_pattern.substr(start, end - start);
+
+            if (has_wildcard(component)) {
+                break;
+            }
+
+            auto &child = target->children[component];
+
+            if (!child) {
+                child = std::make_unique<node>(target, entry.match_pattern.substr(0, end));
+            }
+
+            target = child.get();
+            start = end + 1;
+            end = entry.match_pattern.find(NOTIFY_PATH_SEPARATOR, start);
+        }
+
+        const bool first = target->entries.empty();
+        target->entries.push_back(std::move(entry));
+        count_++;
+
+        if (node_path) {
+            *node_path = target->path;
+        }
+
+        return first;
+    }
+
+    void notify_trie::prune(node *n) {
+        while (n->parent && n->entries.empty() && n->children.empty()) {
+            node *parent = n->parent;
+
+            // The key of a node in its parent is the last component of its path
+            const std::size_t last_sep = n->path.find_last_of(NOTIFY_PATH_SEPARATOR);
+            parent->children.erase((last_sep == std::u16string::npos) ? n->path : n->path.substr(last_sep + 1));
+
+            n = parent;
+        }
+    }
+
+    void notify_trie::collect(const std::u16string &path, const std::uint32_t change_mask, std::vector<notify_entry> &matched,
+        std::vector<std::u16string> *emptied) {
+        std::u16string folded = common::lowercase_ucs2_string(path);
+
+        while (!folded.empty() && (folded.back() == NOTIFY_PATH_SEPARATOR)) {
+            folded.pop_back();
+        }
+
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (count_ == 0) {
+            return;
+        }
+
+        // Gather the nodes along the path first, matching may prune them
+        std::vector<node *> visit;
+        visit.push_back(&root_);
+
+        std::size_t start = 0;
+        std::size_t end = folded.find(NOTIFY_PATH_SEPARATOR);
+
+        while (end != std::u16string::npos) {
+            auto child = visit.back()->children.find(folded.substr(start, end - start));
+
+            if (child == visit.back()->children.end()) {
+                break;
+            }
+
+            visit.push_back(child->second.get());
+
+            start = end + 1;
+            end = folded.find(NOTIFY_PATH_SEPARATOR, start);
+        }
+
+        std::vector<node *> touched;
+
+        for (node *n : visit) {
+            const std::size_t matched_before = matched.size();
+
+            auto new_end = std::remove_if(n->entries.begin(), n->entries.end(), [&](notify_entry &entry) {
+                if (!(entry.type_mask & change_mask) || !common::match_wildcard(folded, entry.match_pattern, false)) {
+                    return false;
+                }
+
+                matched.push_back(std::move(entry));
+                return true;
+            });
+
+            n->entries.erase(new_end, n->entries.end());
+
+            if (matched.size() != matched_before) {
+                count_ -= matched.size() - matched_before;
+                touched.push_back(n);
+            }
+        }
+
+        if (touched.empty()) {
+            return;
+        }
+
+        if (emptied) {
+            for (node *n : touched) {
+                if (n->entries.empty()) {
+                    emptied->push_back(n->path);
+                }
+            }
+        }
+
+        // All touched nodes lie on one path, pruning from the deepest one covers the rest
+        prune(touched.back());
+    }
+
+    void notify_trie::remove_from(node *n, const std::uint32_t owner, const eka2l1::ptr<epoc::request_status> sts,
+        std::vector<notify_entry> &removed, std::vector<std::u16string> *emptied) {
+        for (auto ite = n->children.begin(); ite != n->children.end();) {
+            node *child = ite->second.get();
+            remove_from(child, owner, sts, removed, emptied);
+
+            if (child->entries.empty() && child->children.empty()) {
+                ite = n->children.erase(ite);
+            } else {
+                ite++;
+            }
+        }
+
+        if (n->entries.empty()) {
+            return;
+        }
+
+        const std::size_t removed_before = removed.size();
+
+        auto new_end = std::remove_if(n->entries.begin(), n->entries.end(), [&](notify_entry &entry) {
+            if ((entry.owner != owner) || (sts && !(entry.info.sts == sts))) {
+                return false;
+            }
+
+            removed.push_back(std::move(entry));
+            return true;
+        });
+
+        n->entries.erase(new_end, n->entries.end());
+        count_ -= removed.size() - removed_before;
+
+        if (emptied && (removed.size() != removed_before) && n->entries.empty()) {
+            emptied->push_back(n->path);
+        }
+    }
+
+    void notify_trie::remove(const std::uint32_t owner, const eka2l1::ptr<epoc::request_status> sts, std::vector<notify_entry> &removed,
+        std::vector<std::u16string> *emptied) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (count_ != 0) {
+            remove_from(&root_, owner, sts, removed, emptied);
+        }
+    }
+
+    std::size_t notify_trie::size() const {
+        const std::lock_guard<std::mutex> guard(lock_);
+        return count_;
+    }
+}
@@ -174,20 +174,21 @@ namespace eka2l1::epoc {
 
                 const std::uint32_t compressed_size = bmp->header_.bitmap_size - bmp->header_.header_len;
 
-                common::wo_buf_stream dest_stream(&decompressed[0], raw_size);
-                common::ro_buf_stream source_stream(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size);
+                const std::uint8_t *source = reinterpret_cast<const std::uint8_t *>(data_pointer);
+                std::size_t source_size = compressed_size;
+                std::size_t dest_size = raw_size;
 
                 switch (bmp->header_.compression) {
                 case bitmap_file_byte_rle_compression:
-                    eka2l1::decompress_rle<8>(&source_stream, &dest_stream);
+                    eka2l1::decompress_rle<8>(source, source_size, &decompressed[0], dest_size);
                     break;
 
                 case bitmap_file_sixteen_bit_rle_compression:
-                    eka2l1::decompress_rle<16>(&source_stream, &dest_stream);
+                    eka2l1::decompress_rle<16>(source, source_size, &decompressed[0], dest_size);
                     break;
 
                 case bitmap_file_twenty_four_bit_rle_compression:
-                    eka2l1::decompress_rle<24>(&source_stream, &dest_stream);
+                    eka2l1::decompress_rle<24>(source, source_size, &decompressed[0], dest_size);
                     break;
 
                 default:
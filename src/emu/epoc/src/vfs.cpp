@@ -32,15 +32,25 @@
 #include <epoc/vfs.h>
 
 #include <array>
+#include <cstring>
 #include <cwctype>
 #include <iostream>
 #include <map>
 #include <mutex>
-#include <regex>
+#include <shared_mutex>
 #include <thread>
+#include <unordered_map>
 
 #include <string.h>
 
+#if EKA2L1_PLATFORM(POSIX)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace eka2l1 {
     file::file(io_attrib attrib)
         : io_component(io_component_type::file, attrib) {
@@ -54,10 +64,51 @@ namespace eka2l1 {
         : io_component(io_component_type::dir, attrib) {
     }
 
+    void entry_batch::add(const packed_entry_info &info, const std::u16string &name) {
+        packed_entry_info &added = entries.emplace_back(info);
+
+        added.name_offset = static_cast<std::uint32_t>(names.length());
+        added.name_length = static_cast<std::uint32_t>(name.length());
+
+        names += name;
+    }
+
+    static void add_entry_info_to_batch(entry_batch &batch, const entry_info &info) {
+        packed_entry_info packed;
+        packed.size = info.size;
+        packed.last_write = info.last_write;
+        packed.attribute = info.attribute;
+        packed.type = info.type;
+        packed.raw_attribute = info.raw_attribute;
+        packed.has_raw_attribute = info.has_raw_attribute;
+
+        batch.add(packed, common::utf8_to_ucs2(info.name));
+    }
+
+    std::size_t directory::get_next_entries(entry_batch &batch, const std::size_t max_count) {
+        batch.clear();
+
+        while (batch.entries.size() < max_count) {
+            std::optional<entry_info> info = get_next_entry();
+
+            if (!info) {
+                break;
+            }
+
+            add_entry_info_to_batch(batch, *info);
+        }
+
+        return batch.entries.size();
+    }
+
     bool file::flush() {
         return true;
     }
 
+    const std::uint8_t *file::direct_view() const {
+        return nullptr;
+    }
+
     std::size_t file::read_file(const std::uint64_t offset, void *buf, std::uint32_t size,
         std::uint32_t count) {
         const std::uint64_t last_offset = tell();
@@ -103,12 +154,26 @@ namespace eka2l1 {
         }
 
         size_t read_file(void *data, uint32_t size, uint32_t count) override {
-            auto will_read = std::min((uint64_t)count * size, file.size - crr_pos);
-            memcpy(data, &file_ptr[crr_pos], will_read);
-
+            const std::size_t will_read = read_file(crr_pos, data, size, count);
             crr_pos += will_read;
 
-            return static_cast<int>(will_read);
+            return will_read;
+        }
+
+        std::size_t read_file(const std::uint64_t offset, void *buf, std::uint32_t size,
+            std::uint32_t count) override {
+            if (offset >= file.size) {
+                return 0;
+            }
+
+            const std::uint64_t will_read = std::min(static_cast<std::uint64_t>(count) * size, file.size - offset);
+            std::memcpy(buf, file_ptr + offset, will_read);
+
+            return static_cast<std::size_t>(will_read);
+        }
+
+        const std::uint8_t *direct_view() const override {
+            return file_ptr;
         }
 
         int file_mode() const override {
@@ -191,6 +256,7 @@ namespace eka2l1 {
         std::u16string physical_path;
 
         int fmode;
+        std::uint64_t size_;
 
         bool closed;
 
@@ -293,6 +359,10 @@ namespace eka2l1 {
 
             input_name = vfs_path;
             fmode = mode;
+
+            fseek(file, 0, SEEK_END);
+            size_ = static_cast<std::uint64_t>(ftell(file));
+            fseek(file, 0, SEEK_SET);
         }
 
         void shutdown() {
@@ -304,7 +374,10 @@ namespace eka2l1 {
         size_t write_file(const void *data, uint32_t size, uint32_t count) override {
             WARN_CLOSE
 
-            return fwrite(data, size, count, file) * size;
+            const std::size_t wrote = fwrite(data, size, count, file) * size;
+            size_ = common::max<std::uint64_t>(size_, ftell(file));
+
+            return wrote;
         }
 
         size_t read_file(void *data, uint32_t size, uint32_t count) override {
@@ -316,13 +389,7 @@ namespace eka2l1 {
         std::uint64_t size() const override {
             WARN_CLOSE
 
-            auto crr_pos = ftell(file);
-            fseek(file, 0, SEEK_END);
-
-            const std::uint64_t file_size = ftell(file);
-            fseek(file, crr_pos, SEEK_SET);
-
-            return file_size;
+            return size_;
         }
 
         bool close() override {
@@ -380,8 +447,310 @@ namespace eka2l1 {
                 return false;
             }
 
+            fflush(file);
+
             int err_code = common::resize(common::ucs2_to_utf8(physical_path), new_size);
-            return (err_code != 0) ? false : true;
+
+            if (err_code != 0) {
+                return false;
+            }
+
+            size_ = new_size;
+            return true;
+        }
+
+        std::uint64_t last_modify_since_1ad() override {
+            return common::get_last_modifiy_since_ad(physical_path);
+        }
+
+        std::string get_error_descriptor() override {
+            return "no";
+        }
+
+        bool is_in_rom() const override {
+            return false;
+        }
+
+        address rom_address() const override {
+            return 0;
+        }
+    };
+
+#if EKA2L1_PLATFORM(POSIX)
+    static constexpr std::uint64_t PHYSICAL_FILE_MAP_THRESHOLD = 1024 * 1024;
+
+    /**
+     * \brief Physical file backed by a POSIX file descriptor.
+     *
+     * The seek cursor and the size are kept on our side, and every transfer is a single
+     * pread/pwrite at an explicit offset, so seeking, telling and asking for the size never
+     * reach the host. Large files opened read-only on a read-only drive may be mapped
+     * instead, in which case reads are plain copies from the mapping.
+     */
+    struct posix_physical_file : public file {
+        int fd_;
+
+        std::uint8_t *map_; ///< Read-only view of the whole file, if mapped.
+        bool allow_map_;
+
+        std::u16string input_name;
+        std::u16string physical_path;
+
+        int fmode;
+
+        std::uint64_t size_;
+        std::uint64_t pos_;
+
+        bool eof_;
+        bool closed;
+
+        static int translate_mode(const int mode) {
+            if (mode & READ_MODE) {
+                return (mode & WRITE_MODE) ? O_RDWR : O_RDONLY;
+            }
+
+            if (mode & WRITE_MODE) {
+                return ((mode & BIN_MODE) ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC;
+            }
+
+            return -1;
+        }
+
+        posix_physical_file(const utf16_str &vfs_path, const utf16_str &real_path, const int mode, const bool allow_map)
+            : file(io_attrib::none)
+            , fd_(-1)
+            , map_(nullptr)
+            , allow_map_(allow_map)
+            , input_name(vfs_path)
+            , physical_path(real_path)
+            , fmode(mode)
+            , size_(0)
+            , pos_(0)
+            , eof_(false)
+            , closed(false) {
+            const int flags = translate_mode(mode);
+
+            if (flags != -1) {
+                fd_ = ::open(common::ucs2_to_utf8(real_path).c_str(), flags | O_CLOEXEC, 0666);
+            }
+
+            if (fd_ < 0) {
+                LOG_ERROR("Can't open file: {}", common::ucs2_to_utf8(real_path));
+                return;
+            }
+
+            struct stat st;
+
+            if (fstat(fd_, &st) == 0) {
+                size_ = static_cast<std::uint64_t>(st.st_size);
+            }
+        }
+
+        ~posix_physical_file() override {
+            shutdown();
+        }
+
+        void shutdown() {
+            if (map_) {
+                munmap(map_, static_cast<std::size_t>(size_));
+                map_ = nullptr;
+            }
+
+            if (fd_ >= 0) {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+
+        bool is_open() const {
+            return fd_ >= 0;
+        }
+
+        bool valid() override {
+            return (fd_ >= 0) && !eof_;
+        }
+
+        int file_mode() const override {
+            return fmode;
+        }
+
+        bool try_map() {
+            if (map_ || !allow_map_ || (fmode & WRITE_MODE) || (size_ < PHYSICAL_FILE_MAP_THRESHOLD)) {
+                return map_ != nullptr;
+            }
+
+            // Don't try again whatever the result is
+            allow_map_ = false;
+
+            void *result = mmap(nullptr, static_cast<std::size_t>(size_), PROT_READ, MAP_PRIVATE, fd_, 0);
+
+            if (result == MAP_FAILED) {
+                return false;
+            }
+
+            map_ = reinterpret_cast<std::uint8_t *>(result);
+            return true;
+        }
+
+        std::size_t read_at(const std::uint64_t offset, void *data, const std::size_t total) {
+            if (offset >= size_) {
+                return 0;
+            }
+
+            if (try_map()) {
+                const std::size_t to_read = static_cast<std::size_t>(common::min<std::uint64_t>(total, size_ - offset));
+                std::memcpy(data, map_ + offset, to_read);
+
+                return to_read;
+            }
+
+            std::size_t readed = 0;
+
+            while (readed < total) {
+                const ssize_t result = pread(fd_, reinterpret_cast<std::uint8_t *>(data) + readed, total - readed,
+                    static_cast<off_t>(offset + readed));
+
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+
+                    break;
+                }
+
+                if (result == 0) {
+                    break;
+                }
+
+                readed += static_cast<std::size_t>(result);
+            }
+
+            return readed;
+        }
+
+        size_t read_file(void *data, uint32_t size, uint32_t count) override {
+            WARN_CLOSE
+
+            const std::size_t total = static_cast<std::size_t>(size) * count;
+            const std::size_t readed = read_at(pos_, data, total);
+
+            if (readed < total) {
+                eof_ = true;
+            }
+
+            // Only whole elements count, like fread
+            const std::size_t readed_aligned = (size == 0) ? 0 : (readed / size * size);
+            pos_ += readed_aligned;
+
+            return readed_aligned;
+        }
+
+        std::size_t read_file(const std::uint64_t offset, void *buf, std::uint32_t size,
+            std::uint32_t count) override {
+            WARN_CLOSE
+
+            const std::size_t readed = read_at(offset, buf, static_cast<std::size_t>(size) * count);
+            return (size == 0) ? 0 : (readed / size * size);
+        }
+
+        size_t write_file(const void *data, uint32_t size, uint32_t count) override {
+            WARN_CLOSE
+
+            const std::size_t total = static_cast<std::size_t>(size) * count;
+            std::size_t wrote = 0;
+
+            while (wrote < total) {
+                const ssize_t result = pwrite(fd_, reinterpret_cast<const std::uint8_t *>(data) + wrote, total - wrote,
+                    static_cast<off_t>(pos_ + wrote));
+
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+
+                    break;
+                }
+
+                wrote += static_cast<std::size_t>(result);
+            }
+
+            pos_ += wrote;
+            size_ = common::max(size_, pos_);
+
+            return (size == 0) ? 0 : (wrote / size * size);
+        }
+
+        std::uint64_t size() const override {
+            WARN_CLOSE
+
+            return size_;
+        }
+
+        bool close() override {
+            WARN_CLOSE
+
+            shutdown();
+            closed = true;
+
+            return true;
+        }
+
+        uint64_t tell() override {
+            WARN_CLOSE
+
+            return pos_;
+        }
+
+        std::uint64_t seek(std::int64_t seek_off, file_seek_mode where) override {
+            WARN_CLOSE
+
+            if (where == file_seek_mode::address) {
+                return 0xFFFFFFFFFFFFFFFF;
+            }
+
+            std::int64_t new_pos = seek_off;
+
+            if (where == file_seek_mode::crr) {
+                new_pos += static_cast<std::int64_t>(pos_);
+            } else if (where == file_seek_mode::end) {
+                new_pos += static_cast<std::int64_t>(size_);
+            }
+
+            if (new_pos < 0) {
+                LOG_ERROR("Attempting to seek with offset that makes file pointer negative ({})", seek_off);
+                return 0xFFFFFFFFFFFFFFFF;
+            }
+
+            pos_ = static_cast<std::uint64_t>(new_pos);
+            eof_ = false;
+
+            return pos_;
+        }
+
+        std::u16string file_name() const override {
+            WARN_CLOSE
+
+            return input_name;
+        }
+
+        bool flush() override {
+            WARN_CLOSE
+
+            // Nothing is buffered on our side
+            return true;
+        }
+
+        bool resize(const std::size_t new_size) override {
+            if (fmode & READ_MODE) {
+                return false;
+            }
+
+            if (ftruncate(fd_, static_cast<off_t>(new_size)) != 0) {
+                return false;
+            }
+
+            size_ = new_size;
+            return true;
         }
 
         std::uint64_t last_modify_since_1ad() override {
@@ -400,10 +769,38 @@ namespace eka2l1 {
             return 0;
         }
     };
+#endif
+
+    /**
+     * \brief Open a file on the host.
+     *
+     * \param allow_map Allow large files opened read-only to be memory mapped. Only pass true
+     *                  when nothing can truncate the file while it's open.
+     *
+     * \returns Null if the file can't be opened with the given mode.
+     */
+    static std::unique_ptr<file> open_physical_file(const std::u16string &vfs_path, const std::u16string &real_path,
+        const int mode, const bool allow_map) {
+#if EKA2L1_PLATFORM(POSIX)
+        auto f = std::make_unique<posix_physical_file>(vfs_path, real_path, mode, allow_map);
+
+        if (!f->is_open()) {
+            return nullptr;
+        }
+#else
+        auto f = std::make_unique<physical_file>(vfs_path, real_path, mode);
+
+        if (!f->file) {
+            return nullptr;
+        }
+#endif
+
+        return f;
+    }
 
     /* DIRECTORY VFS */
     class physical_directory : public directory {
-        std::regex filter;
+        std::string filter;
         std::string vir_path;
 
         common::dir_iterator iterator;
@@ -413,41 +810,24 @@ namespace eka2l1 {
         bool peeking;
 
         io_attrib attrib;
+        io_attrib drive_attrib;
 
         abstract_file_system *inst;
 
-    public:
-        physical_directory(abstract_file_system *inst, const std::string &phys_path,
-            const std::string &vir_path, const std::string &filter, const io_attrib attrib)
-            : filter(common::wildcard_to_regex_string(common::lowercase_string(filter)))
-            , iterator(phys_path)
-            , vir_path(vir_path)
-            , attrib(attrib)
-            , inst(inst)
-            , peeking(false) {
-            iterator.detail = true;
-        }
-
-        std::optional<entry_info> get_next_entry() override {
-            if (peeking) {
-                peeking = false;
-                return peek_info;
-            }
-
-            while (true) {
-                if (!iterator.is_valid()) {
-                    return std::optional<entry_info>{};
-                }
-
-                std::string name = "";
-                int error_code = iterator.next_entry(entry);
-
-                if (error_code != 0) {
-                    return std::optional<entry_info>{};
+        // Ask the filesystem to describe each entry, instead of using what the host listing gives.
+        // ROM drives need it for the raw attributes of ROM files.
+        bool query_inst;
+
+        /**
+         * \brief Advance the iterator to the next entry passing the attribute and name filters.
+         * \returns False if there is no entry left.
+         */
+        bool next_matching_entry() {
+            while (iterator.is_valid()) {
+                if (iterator.next_entry(entry) != 0) {
+                    return false;
                 }
 
-                name = entry.name;
-
                 if (!static_cast<int>(attrib & io_attrib::include_dir) && entry.type == common::FILE_DIRECTORY) {
                     continue;
                 }
@@ -456,18 +836,24 @@ namespace eka2l1 {
                     continue;
                 }
 
-                // Quick hack: Regex dumb with null-terminated string
-                if (name.back() == '\0') {
-                    name.erase(name.length() - 1);
+                // Quick hack: Names may come with a null terminator
+                if (!entry.name.empty() && entry.name.back() == '\0') {
+                    entry.name.pop_back();
                 }
 
                 // If it doesn't meet the filter, continue until find one or there is no one
-                if (!std::regex_match(common::lowercase_string(name), filter)) {
-                    continue;
+                if (common::match_wildcard(entry.name, filter)) {
+                    return true;
                 }
+            }
 
+            return false;
+        }
+
+        entry_info make_entry_info() {
+            if (query_inst) {
                 entry_info info = *(inst->get_entry_info(common::utf8_to_ucs2(
-                    eka2l1::add_path(vir_path, name))));
+                    eka2l1::add_path(vir_path, entry.name))));
 
                 // Symbian usually sensitive about null terminator.
                 // It's best not include them.
@@ -482,7 +868,46 @@ namespace eka2l1 {
                 return info;
             }
 
-            return std::optional<entry_info>{};
+            // The listing already carries everything, no need to go to the host again
+            entry_info info;
+            info.name = entry.name;
+            info.full_path = eka2l1::add_path(vir_path, entry.name);
+            info.type = (entry.type == common::FILE_DIRECTORY) ? io_component_type::dir : io_component_type::file;
+            info.size = (info.type == io_component_type::dir) ? 0 : entry.size;
+            info.last_write = entry.last_write;
+            info.attribute = drive_attrib;
+            info.raw_attribute = 0;
+            info.has_raw_attribute = false;
+
+            return info;
+        }
+
+    public:
+        physical_directory(abstract_file_system *inst, const std::string &phys_path,
+            const std::string &vir_path, const std::string &filter, const io_attrib attrib,
+            const io_attrib drive_attrib, const bool query_inst)
+            : filter(filter)
+            , vir_path(vir_path)
+            , iterator(phys_path)
+            , peeking(false)
+            , attrib(attrib)
+            , drive_attrib(drive_attrib)
+            , inst(inst)
+            , query_inst(query_inst) {
+            iterator.detail = true;
+        }
+
+        std::optional<entry_info> get_next_entry() override {
+            if (peeking) {
+                peeking = false;
+                return peek_info;
+            }
+
+            if (!next_matching_entry()) {
+                return std::optional<entry_info>{};
+            }
+
+            return make_entry_info();
         }
 
         std::optional<entry_info> peek_next_entry() override {
@@ -493,12 +918,196 @@ namespace eka2l1 {
 
             return peek_info;
         }
+
+        std::size_t get_next_entries(entry_batch &batch, const std::size_t max_count) override {
+            batch.clear();
+
+            if (peeking) {
+                peeking = false;
+
+                if (!peek_info) {
+                    return 0;
+                }
+
+                add_entry_info_to_batch(batch, *peek_info);
+            }
+
+            while ((batch.entries.size() < max_count) && next_matching_entry()) {
+                if (query_inst) {
+                    add_entry_info_to_batch(batch, make_entry_info());
+                    continue;
+                }
+
+                packed_entry_info packed;
+                packed.type = (entry.type == common::FILE_DIRECTORY) ? io_component_type::dir : io_component_type::file;
+                packed.size = (packed.type == io_component_type::dir) ? 0 : entry.size;
+                packed.last_write = entry.last_write;
+                packed.attribute = drive_attrib;
+                packed.raw_attribute = 0;
+                packed.has_raw_attribute = false;
+
+                batch.add(packed, common::utf8_to_ucs2(entry.name));
+            }
+
+            return batch.entries.size();
+        }
+    };
+
+    /**
+     * \brief An entry of a host directory, as remembered by the path cache.
+     */
+    struct host_entry_cache {
+        std::string name; ///< Name of the entry, with the casing it has on the host.
+        common::file_type type; ///< Type of the entry. FILE_UNKN until it is first needed.
+    };
+
+    /**
+     * \brief Entries of a host directory, keyed by their case-folded name.
+     */
+    using host_directory_index = std::unordered_map<std::u16string, host_entry_cache>;
+
+    /**
+     * \brief Result of resolving a guest path to its host counterpart.
+     */
+    struct resolved_host_path {
+        std::u16string real_path;
+        std::string real_path_utf8;
+
+        common::file_type type; ///< FILE_INVALID if the entry does not exist on the host.
     };
 
+    static constexpr std::size_t MAX_RESOLVED_PATH_CACHE_COUNT = 8192;
+
     class physical_file_system : public abstract_file_system {
         std::mutex fs_mutex;
         std::unique_ptr<common::directory_watcher> watcher_;
 
+        std::mutex cache_lock_;
+
+        // Lazily built listings of host directories a lookup went through, keyed by
+        // the host path of the directory (without a trailing separator).
+        std::unordered_map<std::string, host_directory_index> dir_indexes_;
+
+        // Paths that resolved to an existing host entry, keyed by the lowercased guest path.
+        std::unordered_map<std::u16string, resolved_host_path> resolved_paths_;
+
+        host_directory_index &get_directory_index(const std::string &host_dir) {
+            auto index_ite = dir_indexes_.find(host_dir);
+
+            if (index_ite != dir_indexes_.end()) {
+                return index_ite->second;
+            }
+
+            host_directory_index &index = dir_indexes_[host_dir];
+
+            common::dir_iterator iterator(host_dir);
+            common::dir_entry entry;
+
+            while (iterator.is_valid() && (iterator.next_entry(entry) == 0)) {
+                if (!entry.name.empty() && entry.name.back() == '\0') {
+                    entry.name.pop_back();
+                }
+
+                index.emplace(common::lowercase_ucs2_string(common::utf8_to_ucs2(entry.name)),
+                    host_entry_cache{ entry.name, common::FILE_UNKN });
+            }
+
+            return index;
+        }
+
+        /**
+         * \brief Walk the guest path through the host directory indexes.
+         *
+         * Each component is matched case-insensitively against the listing of its parent, so the
+         * result carries the real casing of entries on disk. A component missing from the listing
+         * is probed once on the host, since it may have been created outside of the emulator; if
+         * it's still not there, the rest of the path is appended as given (lowercased on
+         * case-sensitive hosts, which is how new entries are named).
+         */
+        resolved_host_path walk_host_path(const std::u16string &map_path, const std::u16string &vert_path_no_root) {
+            const bool case_insensitive = common::is_system_case_insensitive();
+            const char host_sep = eka2l1::get_separator();
+
+            std::u16string resolved_rel;
+            std::string current_dir = common::ucs2_to_utf8(eka2l1::add_path(map_path, u""));
+
+            while (!current_dir.empty() && eka2l1::is_separator(current_dir.back())) {
+                current_dir.pop_back();
+            }
+
+            host_entry_cache *last_entry = nullptr;
+            bool exists = true;
+
+            std::size_t comp_start = 0;
+
+            while (comp_start < vert_path_no_root.length()) {
+                std::size_t comp_end = comp_start;
+
+                while ((comp_end < vert_path_no_root.length()) && !eka2l1::is_separator(vert_path_no_root[comp_end])) {
+                    comp_end++;
+                }
+
+                if (comp_end != comp_start) {
+                    const std::u16string comp = vert_path_no_root.substr(comp_start, comp_end - comp_start);
+                    const std::u16string folded = common::lowercase_ucs2_string(comp);
+
+                    std::u16string host_name = case_insensitive ? comp : folded;
+
+                    if (exists) {
+                        host_directory_index &index = get_directory_index(current_dir);
+                        auto entry_ite = index.find(folded);
+
+                        if (entry_ite == index.end()) {
+                            const std::string host_name_utf8 = common::ucs2_to_utf8(host_name);
+                            const common::file_type type = common::get_file_type(current_dir + host_sep + host_name_utf8);
+
+                            if (type != common::FILE_INVALID) {
+                                entry_ite = index.emplace(folded, host_entry_cache{ host_name_utf8, type }).first;
+                            } else {
+                                exists = false;
+                                last_entry = nullptr;
+                            }
+                        }
+
+                        if (exists) {
+                            last_entry = &entry_ite->second;
+                            current_dir += host_sep + last_entry->name;
+                            host_name = common::utf8_to_ucs2(last_entry->name);
+                        }
+                    }
+
+                    resolved_rel += static_cast<char16_t>(host_sep);
+                    resolved_rel += host_name;
+                }
+
+                comp_start = comp_end + 1;
+            }
+
+            if (!vert_path_no_root.empty() && eka2l1::is_separator(vert_path_no_root.back())) {
+                resolved_rel += static_cast<char16_t>(host_sep);
+            }
+
+            resolved_host_path result;
+            result.real_path = eka2l1::add_path(map_path, resolved_rel);
+            result.real_path_utf8 = common::ucs2_to_utf8(result.real_path);
+            result.type = common::FILE_INVALID;
+
+            if (exists) {
+                if (!last_entry) {
+                    // Drive root
+                    result.type = common::get_file_type(current_dir);
+                } else {
+                    if (last_entry->type == common::FILE_UNKN) {
+                        last_entry->type = common::get_file_type(current_dir);
+                    }
+
+                    result.type = last_entry->type;
+                }
+            }
+
+            return result;
+        }
+
     protected:
         std::string firmcode;
         epocver ver;
@@ -533,10 +1142,54 @@ namespace eka2l1 {
             // Mark as mapped
             mappings[static_cast<int>(drv)].second = true;
 
+            invalidate_path_cache();
             return true;
         }
 
-        std::optional<std::u16string> get_real_physical_path(const std::u16string &vert_path) {
+        /**
+         * \brief Drop every resolved guest path.
+         *
+         * Used when the guest to host mapping changes (mount, product code, ...).
+         */
+        void invalidate_path_cache() {
+            const std::lock_guard<std::mutex> guard(cache_lock_);
+            resolved_paths_.clear();
+        }
+
+        /**
+         * \brief Forget what the cache knows about a host entry and everything under it.
+         *
+         * Must be called after an entry is removed or renamed. New entries don't need this,
+         * since a lookup that misses the index always probes the host.
+         */
+        void invalidate_host_path(std::string real_path) {
+            while (!real_path.empty() && eka2l1::is_separator(real_path.back())) {
+                real_path.pop_back();
+            }
+
+            const std::lock_guard<std::mutex> guard(cache_lock_);
+            resolved_paths_.clear();
+
+            for (auto index_ite = dir_indexes_.begin(); index_ite != dir_indexes_.end();) {
+                const std::string &dir = index_ite->first;
+
+                // Either the parent listing, the entry itself or a directory under it
+                const bool is_parent = (dir.length() < real_path.length()) && (real_path.compare(0, dir.length(), dir) == 0)
+                    && eka2l1::is_separator(real_path[dir.length()])
+                    && (real_path.find_first_of("\\/", dir.length() + 1) == std::string::npos);
+
+                const bool is_under = (dir.compare(0, real_path.length(), real_path) == 0)
+                    && ((dir.length() == real_path.length()) || eka2l1::is_separator(dir[real_path.length()]));
+
+                if (is_parent || is_under) {
+                    index_ite = dir_indexes_.erase(index_ite);
+                } else {
+                    index_ite++;
+                }
+            }
+        }
+
+        std::optional<resolved_host_path> resolve_physical_path(const std::u16string &vert_path) {
             std::string path_ucs8 = common::ucs2_to_utf8(vert_path);
             const std::string root = eka2l1::root_name(path_ucs8);
             std::u16string vert_path_copy = vert_path;
@@ -555,7 +1208,7 @@ namespace eka2l1 {
             if (drv.media_type == drive_media::rom) {
                 if (firmcode.empty()) {
                     LOG_ERROR("IO error: No device has been set for the emulator.");
-                    return u"";
+                    return resolved_host_path{ u"", "", common::FILE_INVALID };
                 }
 
                 map_path += common::utf8_to_ucs2(common::lowercase_string(firmcode));
@@ -569,13 +1222,36 @@ namespace eka2l1 {
                 }
             }
 
-            std::u16string vert_path_no_root = vert_path_copy.substr(root.size());
+            const std::u16string cache_key = common::lowercase_ucs2_string(vert_path_copy);
+            const std::lock_guard<std::mutex> guard(cache_lock_);
 
-            if (!common::is_system_case_insensitive()) {
-                vert_path_no_root = common::lowercase_ucs2_string(vert_path_no_root);
+            auto cached = resolved_paths_.find(cache_key);
+
+            if (cached != resolved_paths_.end()) {
+                return cached->second;
             }
 
-            return eka2l1::add_path(map_path, vert_path_no_root);
+            resolved_host_path result = walk_host_path(map_path, vert_path_copy.substr(root.size()));
+
+            if (result.type != common::FILE_INVALID) {
+                if (resolved_paths_.size() >= MAX_RESOLVED_PATH_CACHE_COUNT) {
+                    resolved_paths_.clear();
+                }
+
+                resolved_paths_.emplace(cache_key, result);
+            }
+
+            return result;
+        }
+
+        std::optional<std::u16string> get_real_physical_path(const std::u16string &vert_path) {
+            std::optional<resolved_host_path> resolved = resolve_physical_path(vert_path);
+
+            if (!resolved) {
+                return std::nullopt;
+            }
+
+            return resolved->real_path;
         }
 
     public:
@@ -590,6 +1266,7 @@ namespace eka2l1 {
 
         void set_epoc_ver(const epocver ever) override {
             ver = ever;
+            invalidate_path_cache();
         }
 
         std::optional<std::u16string> get_raw_path(const std::u16string &path) override {
@@ -597,34 +1274,42 @@ namespace eka2l1 {
         }
 
         bool delete_entry(const std::u16string &path) override {
-            std::optional<std::u16string> path_real = get_real_physical_path(path);
+            std::optional<resolved_host_path> path_real = resolve_physical_path(path);
 
             if (!path_real) {
                 return false;
             }
 
-            return common::remove(common::ucs2_to_utf8(*path_real));
+            const bool result = common::remove(path_real->real_path_utf8);
+            invalidate_host_path(path_real->real_path_utf8);
+
+            return result;
         }
 
         void set_product_code(const std::string &pc) override {
             firmcode = pc;
+            invalidate_path_cache();
         }
 
         bool exists(const std::u16string &path) override {
-            std::optional<std::u16string> real_path = get_real_physical_path(path);
-            return real_path ? eka2l1::exists(common::ucs2_to_utf8(*real_path)) : false;
+            std::optional<resolved_host_path> real_path = resolve_physical_path(path);
+            return real_path ? (real_path->type != common::FILE_INVALID) : false;
         }
 
         bool replace(const std::u16string &old_path, const std::u16string &new_path) override {
-            std::optional<std::u16string> old_path_real = get_real_physical_path(old_path);
-            std::optional<std::u16string> new_path_real = get_real_physical_path(new_path);
+            std::optional<resolved_host_path> old_path_real = resolve_physical_path(old_path);
+            std::optional<resolved_host_path> new_path_real = resolve_physical_path(new_path);
 
             if (!old_path_real || !new_path_real) {
                 return false;
             }
 
-            return common::move_file(common::ucs2_to_utf8(*old_path_real),
-                common::ucs2_to_utf8(*new_path_real));
+            const bool result = common::move_file(old_path_real->real_path_utf8, new_path_real->real_path_utf8);
+
+            invalidate_host_path(old_path_real->real_path_utf8);
+            invalidate_host_path(new_path_real->real_path_utf8);
+
+            return result;
         }
 
         bool create_directories(const std::u16string &path) override {
@@ -662,6 +1347,7 @@ namespace eka2l1 {
         bool unmount(const drive_number drv) override {
             if (mappings[static_cast<int>(drv)].second) {
                 mappings[static_cast<int>(drv)].second = true;
+                invalidate_path_cache();
                 return true;
             }
 
@@ -701,43 +1387,41 @@ namespace eka2l1 {
                 vir_path.erase(vir_path.begin() + pos_check + 1, vir_path.end());
             }
 
-            auto new_path = get_real_physical_path(vir_path);
+            auto new_path = resolve_physical_path(vir_path);
 
-            if (!new_path) {
+            if (!new_path || (new_path->type == common::FILE_INVALID)) {
                 return std::unique_ptr<directory>(nullptr);
             }
 
-            std::string new_path_utf8 = common::ucs2_to_utf8(*new_path);
+            const drive &drv = mappings[ascii_to_drive_number(static_cast<char>(std::towlower(vir_path[0])))].first;
 
-            if (!eka2l1::exists(new_path_utf8)) {
-                return std::unique_ptr<directory>(nullptr);
-            }
-
-            return std::make_unique<physical_directory>(this, new_path_utf8,
-                common::ucs2_to_utf8(vir_path), filter, attrib);
+            return std::make_unique<physical_directory>(this, new_path->real_path_utf8,
+                common::ucs2_to_utf8(vir_path), filter, attrib, drv.attribute, drv.media_type == drive_media::rom);
         }
 
         std::optional<entry_info> get_entry_info(const std::u16string &path) override {
-            std::optional<std::u16string> real_path = get_real_physical_path(path);
+            std::optional<resolved_host_path> real_path = resolve_physical_path(path);
 
-            if (!real_path) {
-                return std::nullopt;
-            }
-
-            std::string real_path_utf8 = common::ucs2_to_utf8(*real_path);
-
-            if (!eka2l1::exists(real_path_utf8)) {
+            if (!real_path || (real_path->type == common::FILE_INVALID)) {
                 return std::nullopt;
             }
 
             entry_info info;
 
-            if (common::is_file(real_path_utf8, common::FILE_DIRECTORY)) {
+            if (real_path->type == common::FILE_DIRECTORY) {
                 info.type = io_component_type::dir;
                 info.size = 0;
             } else {
+                const std::int64_t file_size = common::file_size(real_path->real_path_utf8);
+
+                if (file_size < 0) {
+                    // Removed outside of the emulator since it was cached
+                    invalidate_host_path(real_path->real_path_utf8);
+                    return std::nullopt;
+                }
+
                 info.type = io_component_type::file;
-                info.size = common::file_size(real_path_utf8);
+                info.size = static_cast<std::size_t>(file_size);
             }
 
             /* TODO: Recover this code with new EKA2L1's common code.
@@ -759,19 +1443,26 @@ namespace eka2l1 {
         }
 
         std::unique_ptr<file> open_file(const std::u16string &path, const int mode) override {
-            std::optional<std::u16string> real_path = get_real_physical_path(path);
+            std::optional<resolved_host_path> real_path = resolve_physical_path(path);
 
             if (!real_path) {
                 return nullptr;
             }
 
-            std::string real_path_utf8 = common::ucs2_to_utf8(*real_path);
+            if (!(mode & WRITE_MODE) && ((real_path->type == common::FILE_INVALID) || (real_path->type == common::FILE_DIRECTORY))) {
+                return nullptr;
+            }
+
+            const drive &drv = mappings[ascii_to_drive_number(static_cast<char>(std::towlower(path[0])))].first;
+            std::unique_ptr<file> f = open_physical_file(path, real_path->real_path, mode, drv.media_type == drive_media::rom);
 
-            if (!(mode & WRITE_MODE) && (!eka2l1::exists(real_path_utf8) || common::is_file(real_path_utf8, common::FILE_DIRECTORY))) {
+            if (!f) {
+                // Stale cache entry: the file was removed outside of the emulator
+                invalidate_host_path(real_path->real_path_utf8);
                 return nullptr;
             }
 
-            return std::make_unique<physical_file>(path, *real_path, mode);
+            return f;
         }
 
         std::int64_t watch_directory(const std::u16string &path, common::directory_watcher_callback callback,
@@ -786,7 +1477,8 @@ namespace eka2l1 {
                 watcher_ = std::make_unique<common::directory_watcher>();
             }
 
-            return watcher_->watch(common::ucs2_to_utf8(real_path.value()), callback, callback_userdata, filters);
+            const std::int32_t handle = watcher_->watch(common::ucs2_to_utf8(real_path.value()), callback, callback_userdata, filters);
+            return (handle <= 0) ? -1 : handle;
         }
 
         bool unwatch_directory(const std::int64_t handle) override {
@@ -802,49 +1494,74 @@ namespace eka2l1 {
         loader::rom *rom_cache;
         memory_system *mem;
 
-        std::optional<loader::rom_entry> burn_tree_find_entry(const std::string &vir_path) {
-            auto ite = path_iterator(vir_path);
-
-            loader::rom_dir *last_dir_found = &(rom_cache->root.root_dirs[0].dir);
+        /**
+         * \brief Every file burnt in the ROM, keyed by its case-folded path without the drive.
+         *
+         * Built once at mount, so that a lookup is one hash of the path, rather than a binary search
+         * with a case-insensitive compare on each level of the tree.
+         */
+        std::unordered_map<std::u16string, const loader::rom_entry *> rom_index;
+
+        /**
+         * \brief Fold a guest path into a key of the ROM index.
+         *
+         * The drive is dropped, characters are lowercased, both kinds of separator are accepted and
+         * repeated or trailing separators are ignored, all in one pass.
+         */
+        static std::u16string make_rom_index_key(const std::u16string &path) {
+            std::size_t start = 0;
+
+            if ((path.length() >= 2) && (path[1] == u':')) {
+                start = 2;
+            }
+
+            std::u16string key;
+            key.reserve(path.length() - start + 1);
+
+            for (std::size_t i = start; i < path.length(); i++) {
+                if (eka2l1::is_separator(path[i])) {
+                    if (key.empty() || (key.back() != u'\\')) {
+                        key += u'\\';
+                    }
 
-            // Skip through the drive
-            ite++;
+                    continue;
+                }
 
-            std::vector<std::string> components;
+                if (key.empty()) {
+                    key += u'\\';
+                }
 
-            for (; ite; ite++) {
-                components.push_back(*ite);
+                key += static_cast<char16_t>(std::towlower(path[i]));
             }
 
-            if (components.size() == 0) {
-                return std::nullopt;
+            if ((key.length() > 1) && (key.back() == u'\\')) {
+                key.pop_back();
             }
 
-            for (std::size_t i = 0; i < components.size() - 1; i++) {
-                loader::rom_dir temp;
-                temp.name = common::utf8_to_ucs2(components[i]);
+            return key;
+        }
 
-                auto res1 = std::lower_bound(last_dir_found->subdirs.begin(), last_dir_found->subdirs.end(), temp,
-                    [](const loader::rom_dir &lhs, const loader::rom_dir &rhs) { return common::compare_ignore_case(lhs.name, rhs.name) == -1; });
+        void build_rom_index(const loader::rom_dir &dir, const std::u16string &dir_key) {
+            for (const loader::rom_entry &entry : dir.entries) {
+                const std::u16string key = dir_key + u'\\' + common::lowercase_ucs2_string(entry.name);
 
-                if (res1 != last_dir_found->subdirs.end() && (common::compare_ignore_case(res1->name, temp.name) == 0)) {
-                    last_dir_found = &(last_dir_found->subdirs[std::distance(last_dir_found->subdirs.begin(), res1)]);
-                } else {
-                    return std::optional<loader::rom_entry>{};
+                if (entry.dir) {
+                    build_rom_index(entry.dir.value(), key);
+                    continue;
                 }
-            }
 
-            loader::rom_entry temp_entry;
-            temp_entry.name = common::utf8_to_ucs2(components[components.size() - 1]);
+                rom_index.emplace(key, &entry);
+            }
+        }
 
-            auto res2 = std::lower_bound(last_dir_found->entries.begin(), last_dir_found->entries.end(), temp_entry,
-                [](const loader::rom_entry &lhs, const loader::rom_entry &rhs) { return common::compare_ignore_case(lhs.name, rhs.name) == -1; });
+        const loader::rom_entry *burn_tree_find_entry(const std::u16string &vir_path) {
+            auto entry_ite = rom_index.find(make_rom_index_key(vir_path));
 
-            if (res2 != last_dir_found->entries.end() && !res2->dir && (common::compare_ignore_case(temp_entry.name, res2->name) == 0)) {
-                return *res2;
+            if (entry_ite == rom_index.end()) {
+                return nullptr;
             }
 
-            return std::nullopt;
+            return entry_ite->second;
         }
 
     public:
@@ -852,6 +1569,9 @@ namespace eka2l1 {
             : physical_file_system(ver, product_code)
             , rom_cache(cache)
             , mem(mem) {
+            if (rom_cache && !rom_cache->root.root_dirs.empty()) {
+                build_rom_index(rom_cache->root.root_dirs[0].dir, u"");
+            }
         }
 
         bool delete_entry(const std::u16string &path) override {
@@ -885,7 +1605,7 @@ namespace eka2l1 {
                 return abstract_file_system_err_code::no;
             }
 
-            if (burn_tree_find_entry(common::ucs2_to_utf8(path))) {
+            if (burn_tree_find_entry(path)) {
                 return abstract_file_system_err_code::ok;
             }
 
@@ -913,7 +1633,7 @@ namespace eka2l1 {
                 }
             }
 
-            auto entry = burn_tree_find_entry(common::ucs2_to_utf8(new_path));
+            const loader::rom_entry *entry = burn_tree_find_entry(new_path);
 
             if (!entry) {
                 return physical_file_system::open_file(new_path, mode);
@@ -928,7 +1648,7 @@ namespace eka2l1 {
                 return std::nullopt;
             }
 
-            auto entry = burn_tree_find_entry(common::ucs2_to_utf8(path));
+            const loader::rom_entry *entry = burn_tree_find_entry(path);
 
             if (!entry) {
                 return physical_file_system::get_entry_info(path);
@@ -968,7 +1688,7 @@ namespace eka2l1 {
     }
 
     std::optional<filesystem_id> io_system::add_filesystem(file_system_inst &inst) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::lock_guard<std::shared_mutex> guard(access_lock);
 
         ++id_counter;
 
@@ -979,7 +1699,7 @@ namespace eka2l1 {
     /*! \brief Remove the filesystem from the IO system
     */
     bool io_system::remove_filesystem(const filesystem_id id) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::lock_guard<std::shared_mutex> guard(access_lock);
 
         if (id > id_counter) {
             return false;
@@ -991,7 +1711,7 @@ namespace eka2l1 {
 
     bool io_system::mount_physical_path(const drive_number drv, const drive_media media, const io_attrib attrib,
         const std::u16string &real_path) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::lock_guard<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, file_system] : filesystems) {
             if (file_system->mount_volume_from_path(drv, media, attrib, real_path)) {
@@ -1003,7 +1723,7 @@ namespace eka2l1 {
     }
 
     bool io_system::unmount(const drive_number drv) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::lock_guard<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, file_system] : filesystems) {
             if (file_system->unmount(drv)) {
@@ -1015,7 +1735,7 @@ namespace eka2l1 {
     }
 
     std::optional<drive> io_system::get_drive_entry(const drive_number drv) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::shared_lock<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             if (auto entry = fs->get_drive_entry(drv)) {
@@ -1027,7 +1747,7 @@ namespace eka2l1 {
     }
 
     std::unique_ptr<file> io_system::open_file(utf16_str vir_path, int mode) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::shared_lock<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             if (auto f = fs->open_file(vir_path, mode)) {
@@ -1039,7 +1759,7 @@ namespace eka2l1 {
     }
 
     std::unique_ptr<directory> io_system::open_dir(std::u16string vir_path, const io_attrib attrib) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::shared_lock<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             if (auto dir = fs->open_directory(vir_path, attrib)) {
@@ -1051,7 +1771,7 @@ namespace eka2l1 {
     }
 
     bool io_system::exist(const std::u16string &path) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::shared_lock<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             if (fs->exists(path)) {
@@ -1063,7 +1783,7 @@ namespace eka2l1 {
     }
 
     bool io_system::rename(const std::u16string &old_path, const std::u16string &new_path) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::shared_lock<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             if (fs->replace(old_path, new_path)) {
@@ -1075,7 +1795,7 @@ namespace eka2l1 {
     }
 
     bool io_system::delete_entry(const std::u16string &path) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::shared_lock<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             if (fs->delete_entry(path)) {
@@ -1087,7 +1807,7 @@ namespace eka2l1 {
     }
 
     bool io_system::is_entry_in_rom(const std::u16string &path) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::shared_lock<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             if (fs->is_entry_in_rom(path) == abstract_file_system_err_code::ok) {
@@ -1099,7 +1819,7 @@ namespace eka2l1 {
     }
 
     bool io_system::create_directories(const std::u16string &path) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::shared_lock<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             if (fs->create_directories(path)) {
@@ -1111,7 +1831,7 @@ namespace eka2l1 {
     }
 
     bool io_system::create_directory(const std::u16string &path) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::shared_lock<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             if (fs->create_directory(path)) {
@@ -1123,7 +1843,7 @@ namespace eka2l1 {
     }
 
     std::optional<entry_info> io_system::get_entry_info(const std::u16string &path) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::shared_lock<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             if (auto e = fs->get_entry_info(path)) {
@@ -1135,7 +1855,7 @@ namespace eka2l1 {
     }
 
     std::optional<std::u16string> io_system::get_raw_path(const std::u16string &path) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::shared_lock<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             if (auto p = fs->get_raw_path(path)) {
@@ -1157,7 +1877,7 @@ namespace eka2l1 {
     }
 
     void io_system::set_product_code(const std::string &pc) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::lock_guard<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             fs->set_product_code(pc);
@@ -1165,7 +1885,7 @@ namespace eka2l1 {
     }
 
     void io_system::set_epoc_ver(const epocver ver) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::lock_guard<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             fs->set_epoc_ver(ver);
@@ -1174,7 +1894,7 @@ namespace eka2l1 {
 
     std::int64_t io_system::watch_directory(const std::u16string &path, common::directory_watcher_callback callback,
         void *callback_userdata, const std::uint32_t filters) {
-        const std::lock_guard<std::mutex> guard(access_lock);
+        const std::lock_guard<std::shared_mutex> guard(access_lock);
 
         for (auto &[id, fs] : filesystems) {
             const std::int64_t result = fs->watch_directory(path, callback, callback_userdata, filters);
@@ -1199,7 +1919,8 @@ namespace eka2l1 {
     }
 
     symfile physical_file_proxy(const std::string &path, int mode) {
-        return std::make_unique<physical_file>(common::utf8_to_ucs2(path), common::utf8_to_ucs2(path), mode);
+        const std::u16string path_ucs2 = common::utf8_to_ucs2(path);
+        return open_physical_file(path_ucs2, path_ucs2, mode, false);
     }
 
     void ro_file_stream::seek(const std::int64_t amount, common::seek_where wh) {
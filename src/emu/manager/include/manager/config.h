@@ -80,6 +80,13 @@ namespace eka2l1::manager {
         bool accurate_ipc_timing{ false };
         bool enable_btrace{ false };
 
+        std::string e32img_cache_dir; ///< Where parsed E32 images are cached. Empty disables the cache.
+
+        bool share_code_pages{ true }; ///< Back identical relocated code pages with the same host memory.
+        std::string code_page_share_dir; ///< Where code is exchanged with other emulators. Empty keeps sharing in this one.
+
+        std::string centrep_cache_dir; ///< Where compiled central repository INIs are cached. Empty disables the cache.
+
         void serialize();
         void deserialize();
 
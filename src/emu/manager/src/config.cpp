@@ -90,6 +90,10 @@ namespace eka2l1::manager {
         config_file_emit_single(emitter, "fbs-enable-compression-queue", fbs_enable_compression_queue);
         config_file_emit_single(emitter, "accurate-ipc-timing", accurate_ipc_timing);
         config_file_emit_single(emitter, "enable-btrace", enable_btrace);
+        config_file_emit_single(emitter, "e32img-cache-dir", e32img_cache_dir);
+        config_file_emit_single(emitter, "share-code-pages", share_code_pages);
+        config_file_emit_single(emitter, "code-page-share-dir", code_page_share_dir);
+        config_file_emit_single(emitter, "centrep-cache-dir", centrep_cache_dir);
 
         emitter << YAML::EndMap;
 
@@ -142,6 +146,10 @@ namespace eka2l1::manager {
         get_yaml_value(node, "fbs-enable-compression-queue", &fbs_enable_compression_queue, false);
         get_yaml_value(node, "accurate-ipc-timing", &accurate_ipc_timing, false);
         get_yaml_value(node, "enable-btrace", &enable_btrace, false);
+        get_yaml_value(node, "e32img-cache-dir", &e32img_cache_dir, "");
+        get_yaml_value(node, "share-code-pages", &share_code_pages, true);
+        get_yaml_value(node, "code-page-share-dir", &code_page_share_dir, "");
+        get_yaml_value(node, "centrep-cache-dir", &centrep_cache_dir, "");
 
         try {
             YAML::Node force_loads_node = node["force-load"];
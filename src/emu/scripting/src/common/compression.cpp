@@ -57,9 +57,9 @@ namespace eka2l1::scripting {
         }
 
         std::vector<char> result;
-        result.resize(tab.page_size[index]);
+        result.resize(common::BYTEPAIR_PAGE_SIZE);
 
-        bytepair_stream.read_page(&result[0], index, result.size());
+        result.resize(bytepair_stream.read_page(&result[0], index, result.size()));
 
         return result;
     }
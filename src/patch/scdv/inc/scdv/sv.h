@@ -35,9 +35,49 @@ struct TFastBlitInfo {
     TRect iSrcRect;
 };
 
+// Operation applied on a 32bpp pixel, resolved from the draw mode
+enum TScdvPixelOp {
+    EScdvPixelOpWrite = 0,
+    EScdvPixelOpAND = 1,
+    EScdvPixelOpOR = 2,
+    EScdvPixelOpXOR = 3,
+    EScdvPixelOpNOTSCREEN = 4,
+    EScdvPixelOpANDNOT = 5,
+    EScdvPixelOpBlend = 6
+};
+
+struct TScdvFillInfo {
+    TUint8 *iDestBase;
+    TUint32 iDestStride;
+    TSize iSize;
+    TUint32 iColor;
+    TUint32 iOp;
+};
+
+struct TScdvLineInfo {
+    TUint8 *iDest;
+    const TUint8 *iSource;
+    const TUint8 *iMask;
+    TUint32 iLength;
+    TUint32 iColor;
+    TUint32 iOp;
+};
+
+struct TScdvMapColorsInfo {
+    TUint8 *iDestBase;
+    TUint32 iDestStride;
+    TSize iSize;
+    const TUint32 *iPairs;
+    TUint32 iNumPairs;
+};
+
 extern "C" {
     HLE_DISPATCH_FUNC(void, UpdateScreen, 1, const TUint32 aScreenNumber, const TUint32 aNumberOfRect, const TRect *aRectangles);
     HLE_DISPATCH_FUNC(void, FastBlit, 2, const TFastBlitInfo *aInfo);
+    HLE_DISPATCH_FUNC(void, ScdvFillRect, 3, const TScdvFillInfo *aInfo);
+    HLE_DISPATCH_FUNC(void, ScdvWriteLine, 4, const TScdvLineInfo *aInfo);
+    HLE_DISPATCH_FUNC(void, ScdvBlendLine, 5, const TScdvLineInfo *aInfo);
+    HLE_DISPATCH_FUNC(void, ScdvMapColors, 6, const TScdvMapColorsInfo *aInfo);
 }
 
 #endif
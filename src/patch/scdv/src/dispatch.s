@@ -21,9 +21,25 @@
 
 .global UpdateScreen
 .global FastBlit
+.global ScdvFillRect
+.global ScdvWriteLine
+.global ScdvBlendLine
+.global ScdvMapColors
 
 UpdateScreen:
     CallHleDispatch 0x1
 
 FastBlit:
-    CallHleDispatch 0x2
\ No newline at end of file
+    CallHleDispatch 0x2
+
+ScdvFillRect:
+    CallHleDispatch 0x3
+
+ScdvWriteLine:
+    CallHleDispatch 0x4
+
+ScdvBlendLine:
+    CallHleDispatch 0x5
+
+ScdvMapColors:
+    CallHleDispatch 0x6
\ No newline at end of file
@@ -122,6 +122,33 @@ static void WriteRgb32ToAddressBlend(TUint8 *aAddress, TUint8 aRed, TUint8 aGree
     *colorWord |= ((rb & 0xff00ff) | (g & 0xff00)) | (0x01000000);
 }
 
+// Same as the native blend of masked lines: zero mask keeps the pixel, full mask replaces it
+static void BlendRgb32ToAddressMask(TUint8 *aAddress, TUint32 aColor, TUint8 aMask) {
+    TUint32 *colorWord = reinterpret_cast<TUint32 *>(aAddress);
+
+    if (aMask == 0) {
+        return;
+    }
+
+    if (aMask == 255) {
+        *colorWord = aColor | 0xFF000000;
+        return;
+    }
+
+    TUint32 rb = (*colorWord & 0xFF00FF);
+    TUint32 g = (*colorWord & 0x00FF00);
+
+    rb += ((aColor & 0xff00ff) - rb) * aMask >> 8;
+    g += ((aColor & 0x00ff00) - g) * aMask >> 8;
+
+    *colorWord = (rb & 0xff00ff) | (g & 0xff00) | 0xFF000000;
+}
+
+static TUint32 GetRawColor(const TRgb &aColor) {
+    // Byte order of the write functions
+    return (TUint8)aColor.Red() | ((TUint8)aColor.Green() << 8) | ((TUint8)aColor.Blue() << 16) | ((TUint32)(TUint8)aColor.Alpha() << 24);
+}
+
 static void WriteRgb32ToAddressUNIMPL(TUint8 *aAddress, TUint8 aRed, TUint8 aGreen, TUint8 aBlue, TUint8 aAlpha) {
     // Empty
 }
@@ -157,6 +184,37 @@ CFbsThirtyTwoBitsDrawDevice::PWriteRgbToAddressFunc CFbsThirtyTwoBitsDrawDevice:
     return WriteRgb32ToAddressUNIMPL;
 }
 
+TInt CFbsThirtyTwoBitsDrawDevice::GetPixelOp(CGraphicsContext::TDrawMode aDrawMode) {
+    // Must resolve the same as GetRgbWriteFunc
+    switch (aDrawMode) {
+    case CGraphicsContext::EDrawModeWriteAlpha:
+        return EScdvPixelOpWrite;
+
+    case CGraphicsContext::EDrawModeAND:
+        return EScdvPixelOpAND;
+
+    case CGraphicsContext::EDrawModeOR:
+        return EScdvPixelOpOR;
+
+    case CGraphicsContext::EDrawModeXOR:
+        return EScdvPixelOpXOR;
+
+    case CGraphicsContext::EDrawModeNOTSCREEN:
+        return EScdvPixelOpNOTSCREEN;
+
+    case CGraphicsContext::EDrawModeANDNOT:
+        return EScdvPixelOpANDNOT;
+
+    case CGraphicsContext::EDrawModePEN:
+        return (DisplayMode() == EColor16MA) ? EScdvPixelOpBlend : EScdvPixelOpWrite;
+
+    default:
+        break;
+    }
+
+    return -1;
+}
+
 void CFbsThirtyTwoBitsDrawDevice::WriteRgb(TInt aX, TInt aY, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode) {
     TUint8 *pixelStart = GetPixelStartAddress(aX, aY);
     PWriteRgbToAddressFunc writeFunc = GetRgbWriteFunc(aDrawMode);
@@ -201,6 +259,21 @@ void CFbsThirtyTwoBitsDrawDevice::WriteRgbMulti(TInt aX, TInt aY, TInt aLength,
     if (aX + aLength > LongWidth())
         PanicAtTheEndOfTheWorld();
 
+    const TInt op = GetPixelOp(aDrawMode);
+
+    if ((iOrientation == EOrientationNormal) && (op >= 0)) {
+        // Rows are continuous, let the emulator fill the whole rectangle
+        TScdvFillInfo info;
+        info.iDestBase = GetPixelStartAddress(aX, aY);
+        info.iDestStride = PhysicalScanLineBytes();
+        info.iSize = TSize(aLength, aHeight);
+        info.iColor = GetRawColor(aColor);
+        info.iOp = op;
+
+        ScdvFillRect(3, &info);
+        return;
+    }
+
     const TUint8 red = (TUint8)aColor.Red();
     const TUint8 green = (TUint8)aColor.Green();
     const TUint8 blue = (TUint8)aColor.Blue();
@@ -218,7 +291,87 @@ void CFbsThirtyTwoBitsDrawDevice::WriteRgbMulti(TInt aX, TInt aY, TInt aLength,
 }
 
 void CFbsThirtyTwoBitsDrawDevice::WriteRgbAlphaMulti(TInt aX, TInt aY, TInt aLength, TRgb aColor, const TUint8 *aMaskBuffer) {
-    Scdv::Log("Write rgb alpha multi for 16bit mode todo!");
+    if (aX + aLength > LongWidth())
+        PanicAtTheEndOfTheWorld();
+
+    const TUint32 color = GetRawColor(aColor);
+
+    if (iOrientation == EOrientationNormal) {
+        TScdvLineInfo info;
+        info.iDest = GetPixelStartAddress(aX, aY);
+        info.iSource = NULL;
+        info.iMask = aMaskBuffer;
+        info.iLength = aLength;
+        info.iColor = color;
+        info.iOp = EScdvPixelOpBlend;
+
+        ScdvBlendLine(5, &info);
+        return;
+    }
+
+    TUint8 *pixelAddress = GetPixelStartAddress(aX, aY);
+    TInt increment = GetPixelIncrementUnit() * 4;
+
+    for (TInt x = 0; x < aLength; x++) {
+        BlendRgb32ToAddressMask(pixelAddress, color, aMaskBuffer[x]);
+        pixelAddress += increment;
+    }
+}
+
+void CFbsThirtyTwoBitsDrawDevice::WriteRgbAlphaLine(TInt aX, TInt aY, TInt aLength, TUint8 *aRgbBuffer, TUint8 *aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode) {
+    if (aX + aLength > LongWidth())
+        PanicAtTheEndOfTheWorld();
+
+    if (iOrientation == EOrientationNormal) {
+        TScdvLineInfo info;
+        info.iDest = GetPixelStartAddress(aX, aY);
+        info.iSource = aRgbBuffer;
+        info.iMask = aMaskBuffer;
+        info.iLength = aLength;
+        info.iColor = 0;
+        info.iOp = EScdvPixelOpBlend;
+
+        ScdvBlendLine(5, &info);
+        return;
+    }
+
+    TUint8 *pixelAddress = GetPixelStartAddress(aX, aY);
+    TInt increment = GetPixelIncrementUnit() * 4;
+
+    const TUint32 *source = reinterpret_cast<const TUint32 *>(aRgbBuffer);
+
+    for (TInt x = 0; x < aLength; x++) {
+        BlendRgb32ToAddressMask(pixelAddress, source[x], aMaskBuffer[x]);
+        pixelAddress += increment;
+    }
+}
+
+void CFbsThirtyTwoBitsDrawDevice::MapColors(const TRect &aRect, const TRgb *aColors, TInt aNumPairs, TBool aMapForwards) {
+    // The bottom right corner is included, like the generic loop does
+    const TBool inBounds = (aRect.iTl.iX >= 0) && (aRect.iTl.iY >= 0) && (aRect.iBr.iX < iSize.iWidth)
+        && (aRect.iBr.iY < iSize.iHeight);
+
+    if ((iOrientation != EOrientationNormal) || !inBounds || (aNumPairs > KMaxMapColorPairs) || aRect.IsEmpty()) {
+        CFbsDrawDeviceAlgorithm::MapColors(aRect, aColors, aNumPairs, aMapForwards);
+        return;
+    }
+
+    const TInt targetToSwapIndex = static_cast<TInt>(aMapForwards);
+    TUint32 pairs[KMaxMapColorPairs * 2];
+
+    for (TInt pairIte = 0; pairIte < aNumPairs; pairIte++) {
+        pairs[pairIte << 1] = GetRawColor(aColors[(pairIte << 1) + targetToSwapIndex]);
+        pairs[(pairIte << 1) + 1] = GetRawColor(aColors[(pairIte << 1) + (1 - targetToSwapIndex)]);
+    }
+
+    TScdvMapColorsInfo info;
+    info.iDestBase = GetPixelStartAddress(aRect.iTl.iX, aRect.iTl.iY);
+    info.iDestStride = PhysicalScanLineBytes();
+    info.iSize = TSize(aRect.iBr.iX - aRect.iTl.iX + 1, aRect.iBr.iY - aRect.iTl.iY + 1);
+    info.iPairs = pairs;
+    info.iNumPairs = aNumPairs;
+
+    ScdvMapColors(6, &info);
 }
 
 void CFbsThirtyTwoBitsDrawDevice::WriteLine(TInt aX, TInt aY, TInt aLength, TUint32 *aBuffer, CGraphicsContext::TDrawMode aDrawMode) {
@@ -231,6 +384,21 @@ void CFbsThirtyTwoBitsDrawDevice::WriteLine(TInt aX, TInt aY, TInt aLength, TUin
     if (aX + aLength > LongWidth())
         PanicAtTheEndOfTheWorld();
 
+    const TInt op = GetPixelOp(aDrawMode);
+
+    if ((iOrientation == EOrientationNormal) && (op >= 0)) {
+        TScdvLineInfo info;
+        info.iDest = pixelAddress;
+        info.iSource = buffer8;
+        info.iMask = NULL;
+        info.iLength = aLength;
+        info.iColor = 0;
+        info.iOp = op;
+
+        ScdvWriteLine(4, &info);
+        return;
+    }
+
     for (TInt x = aX; x < aX + aLength; x++) {
         // Try to reduce if calls pls
         writeFunc(pixelAddress, buffer8[0], buffer8[1], buffer8[2], buffer8[3]);
@@ -26,6 +26,10 @@
 
 class CFbsThirtyTwoBitsDrawDevice : public CFbsDrawDeviceBuffer, public Scdv::MScalingSettings {
 public:
+    enum {
+        KMaxMapColorPairs = 16
+    };
+
     TInt ConstructInner(TSize aSize, TInt aDataStride);
     void SetSize(TSize aSize);
 
@@ -34,11 +38,16 @@ public:
     virtual void WriteBinary(TInt aX, TInt aY, TUint32 *aBuffer, TInt aLength, TInt aHeight, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode);
     virtual void WriteLine(TInt aX, TInt aY, TInt aLength, TUint32 *aBuffer, CGraphicsContext::TDrawMode aDrawMode);
     virtual void WriteRgbAlphaMulti(TInt aX, TInt aY, TInt aLength, TRgb aColor, const TUint8 *aMaskBuffer);
+    virtual void WriteRgbAlphaLine(TInt aX, TInt aY, TInt aLength, TUint8 *aRgbBuffer, TUint8 *aMaskBuffer, CGraphicsContext::TDrawMode aDrawMode);
+    virtual void MapColors(const TRect &aRect, const TRgb *aColors, TInt aNumPairs, TBool aMapForwards);
 
     typedef void (*PWriteRgbToAddressFunc)(TUint8 *aAddress, TUint8 aRed, TUint8 aGreen, TUint8 aBlue, TUint8 aAlpha);
 
     PWriteRgbToAddressFunc GetRgbWriteFunc(CGraphicsContext::TDrawMode aDrawMode);
 
+    // Operation the emulator applies for the draw mode, -1 if it's not supported
+    TInt GetPixelOp(CGraphicsContext::TDrawMode aDrawMode);
+
     virtual TRgb ReadPixel(TInt aX, TInt aY) const;
     virtual void WriteRgb(TInt aX, TInt aY, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode);
     virtual void WriteRgbMulti(TInt aX, TInt aY, TInt aLength, TInt aHeight, TRgb aColor, CGraphicsContext::TDrawMode aDrawMode);
@@ -20,8 +20,13 @@
 #include <catch2/catch.hpp>
 #include <common/allocator.h>
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
 
 using namespace eka2l1;
 
@@ -80,3 +85,276 @@ TEST_CASE("bitmap_alloc_best_fit_multiple_fit", "bitmap_allocator") {
     // After allocate:      1000 0111 1001 0001 0101 0001 00[00 0]001
     REQUIRE(alloc.get_word(0) == 0b10000111100100010101000100000001);
 }
+
+TEST_CASE("tlsf_alloc_no_power_of_two_rounding", "tlsf_allocator") {
+    std::vector<std::uint64_t> space(1024 / 8);
+    common::tlsf_allocator alloc(reinterpret_cast<std::uint8_t *>(space.data()), 1024);
+
+    // Rounding each of these to 512 would only fit two
+    std::uint8_t *first = reinterpret_cast<std::uint8_t *>(alloc.allocate(300));
+    std::uint8_t *second = reinterpret_cast<std::uint8_t *>(alloc.allocate(300));
+    std::uint8_t *third = reinterpret_cast<std::uint8_t *>(alloc.allocate(300));
+
+    REQUIRE(first);
+    REQUIRE(second);
+    REQUIRE(third);
+
+    REQUIRE(second - first >= 300);
+    REQUIRE(third - second >= 300);
+    REQUIRE(third + 300 <= reinterpret_cast<std::uint8_t *>(space.data()) + 1024);
+
+    // Nothing left for this, and the space can't grow
+    REQUIRE(!alloc.allocate(300));
+
+    const common::allocator_stats stats = alloc.get_stats();
+    REQUIRE(stats.used_block_count == 3);
+    REQUIRE(stats.used_size == 3 * 304);
+}
+
+TEST_CASE("tlsf_free_coalesces_neighbours", "tlsf_allocator") {
+    std::vector<std::uint64_t> space(4096 / 8);
+    common::tlsf_allocator alloc(reinterpret_cast<std::uint8_t *>(space.data()), 4096);
+
+    void *a = alloc.allocate(1000);
+    void *b = alloc.allocate(1000);
+    void *c = alloc.allocate(1000);
+    void *d = alloc.allocate(1000);
+
+    REQUIRE(a);
+    REQUIRE(b);
+    REQUIRE(c);
+    REQUIRE(d);
+
+    REQUIRE(alloc.free(a));
+    REQUIRE(alloc.free(c));
+
+    // Two holes that can't hold 2000 bytes together
+    common::allocator_stats stats = alloc.get_stats();
+    REQUIRE(stats.free_block_count == 3);
+    REQUIRE(stats.largest_free_block < 2000);
+    REQUIRE(stats.fragmentation() > 0.0);
+    REQUIRE(!alloc.allocate(2000));
+
+    // Freeing the middle one merges all three
+    REQUIRE(alloc.free(b));
+
+    stats = alloc.get_stats();
+    REQUIRE(stats.free_block_count == 2);
+    REQUIRE(stats.largest_free_block >= 3000);
+
+    void *big = alloc.allocate(3000);
+    REQUIRE(big == a);
+
+    REQUIRE(alloc.free(big));
+    REQUIRE(alloc.free(d));
+
+    stats = alloc.get_stats();
+    REQUIRE(stats.free_block_count == 1);
+    REQUIRE(stats.used_size == 0);
+    REQUIRE(stats.fragmentation() == 0.0);
+    REQUIRE(alloc.allocate(4096) == space.data());
+}
+
+TEST_CASE("tlsf_free_unknown_pointer", "tlsf_allocator") {
+    std::vector<std::uint64_t> space(256 / 8);
+    common::tlsf_allocator alloc(reinterpret_cast<std::uint8_t *>(space.data()), 256);
+
+    std::uint8_t *a = reinterpret_cast<std::uint8_t *>(alloc.allocate(16));
+
+    REQUIRE(a);
+    REQUIRE(!alloc.free(a + 8));
+    REQUIRE(alloc.free(a));
+    REQUIRE(!alloc.free(a));
+}
+
+namespace {
+    class growable_tlsf_allocator : public common::tlsf_allocator {
+        std::size_t capacity_;
+
+    public:
+        explicit growable_tlsf_allocator(std::uint8_t *sptr, const std::size_t initial_size, const std::size_t capacity)
+            : common::tlsf_allocator(sptr, initial_size)
+            , capacity_(capacity) {
+        }
+
+        bool expand(std::size_t target) override {
+            return target <= capacity_;
+        }
+    };
+}
+
+TEST_CASE("tlsf_expand_when_full", "tlsf_allocator") {
+    std::vector<std::uint64_t> space(8192 / 8);
+    growable_tlsf_allocator alloc(reinterpret_cast<std::uint8_t *>(space.data()), 1024, 8192);
+
+    void *a = alloc.allocate(1000);
+    REQUIRE(a);
+
+    // Grows the space and keeps using it from where the old space ended
+    std::uint8_t *b = reinterpret_cast<std::uint8_t *>(alloc.allocate(3000));
+    REQUIRE(b);
+    REQUIRE(alloc.get_max_size() == 4000);
+    REQUIRE(b == reinterpret_cast<std::uint8_t *>(space.data()) + 1000);
+
+    REQUIRE(alloc.allocate(4000));
+    REQUIRE(alloc.get_max_size() == 8000);
+
+    // Neither doubling nor growing by what is needed fits in the chunk anymore
+    REQUIRE(!alloc.allocate(1000));
+}
+
+TEST_CASE("tlsf_random_no_overlap", "tlsf_allocator") {
+    static constexpr std::size_t SPACE_SIZE = 1 << 20;
+
+    std::vector<std::uint64_t> space(SPACE_SIZE / 8);
+    common::tlsf_allocator alloc(reinterpret_cast<std::uint8_t *>(space.data()), SPACE_SIZE);
+
+    std::mt19937 rng(2020);
+    std::map<std::uint8_t *, std::size_t> live;
+
+    for (int i = 0; i < 20000; i++) {
+        if (!live.empty() && (rng() % 100 < 45)) {
+            auto ite = live.begin();
+            std::advance(ite, rng() % live.size());
+
+            REQUIRE(alloc.free(ite->first));
+            live.erase(ite);
+
+            continue;
+        }
+
+        const std::size_t size = 1 + rng() % ((rng() % 10 == 0) ? 65536 : 512);
+        std::uint8_t *result = reinterpret_cast<std::uint8_t *>(alloc.allocate(size));
+
+        if (!result) {
+            continue;
+        }
+
+        REQUIRE(reinterpret_cast<std::uint64_t>(result) % common::tlsf_allocator::ALIGN_SIZE == 0);
+        REQUIRE(result + size <= reinterpret_cast<std::uint8_t *>(space.data()) + SPACE_SIZE);
+
+        auto next = live.lower_bound(result);
+
+        if (next != live.end()) {
+            REQUIRE(result + size <= next->first);
+        }
+
+        if (next != live.begin()) {
+            auto prev = std::prev(next);
+            REQUIRE(prev->first + prev->second <= result);
+        }
+
+        live.emplace(result, size);
+    }
+
+    for (auto &[block, size] : live) {
+        REQUIRE(alloc.free(block));
+    }
+
+    const common::allocator_stats stats = alloc.get_stats();
+    REQUIRE(stats.free_block_count == 1);
+    REQUIRE(stats.largest_free_block == SPACE_SIZE);
+}
+
+struct fbs_trace_op {
+    bool alloc;
+    std::size_t size;
+    std::size_t slot;
+};
+
+// Bitmap sizes seen in FBS: icons and their masks, with screen sized skins and backgrounds now and then
+static std::vector<fbs_trace_op> make_fbs_allocation_trace(const std::size_t op_count) {
+    static const int ICON_SIDES[] = { 16, 24, 29, 32, 42, 44, 46, 48, 55, 64, 88 };
+    static const int BYTES_PER_PIXELS[] = { 1, 2, 4 };
+
+    std::mt19937 rng(0xFB5);
+    std::vector<fbs_trace_op> trace;
+    std::size_t live = 0;
+
+    for (std::size_t i = 0; i < op_count; i++) {
+        if ((live != 0) && (rng() % 100 < 48)) {
+            trace.push_back({ false, 0, rng() % live });
+            live--;
+
+            continue;
+        }
+
+        std::size_t size = 0;
+
+        if (rng() % 50 == 0) {
+            // Skin background, 240x320 up to 360x640
+            size = (240 + rng() % 121) * (320 + rng() % 321) * ((rng() % 2) ? 2 : 4);
+        } else {
+            const int side = ICON_SIDES[rng() % (sizeof(ICON_SIDES) / sizeof(int))];
+            size = side * side * BYTES_PER_PIXELS[rng() % 3];
+        }
+
+        trace.push_back({ true, (size + 3) & ~3, 0 });
+        live++;
+    }
+
+    return trace;
+}
+
+template <typename T>
+static void replay_fbs_allocation_trace(T &alloc, const std::vector<fbs_trace_op> &trace, std::size_t &failures) {
+    std::vector<void *> live;
+
+    for (const fbs_trace_op &op : trace) {
+        if (op.alloc) {
+            void *result = alloc.allocate(op.size);
+
+            if (!result) {
+                failures++;
+                continue;
+            }
+
+            live.push_back(result);
+        } else if (!live.empty()) {
+            const std::size_t slot = op.slot % live.size();
+            alloc.free(live[slot]);
+
+            live[slot] = live.back();
+            live.pop_back();
+        }
+    }
+}
+
+TEST_CASE("fbs_allocation_trace_benchmark", "[.benchmark]") {
+    static constexpr std::size_t SPACE_SIZE = 32 * 1024 * 1024;
+    static constexpr std::size_t OP_COUNT = 200000;
+
+    const std::vector<fbs_trace_op> trace = make_fbs_allocation_trace(OP_COUNT);
+    std::vector<std::uint64_t> space(SPACE_SIZE / 8);
+
+    std::size_t block_failures = 0;
+    std::size_t tlsf_failures = 0;
+
+    const auto block_start = std::chrono::steady_clock::now();
+
+    {
+        common::block_allocator alloc(reinterpret_cast<std::uint8_t *>(space.data()), SPACE_SIZE);
+        replay_fbs_allocation_trace(alloc, trace, block_failures);
+    }
+
+    const auto block_end = std::chrono::steady_clock::now();
+    common::allocator_stats stats;
+
+    {
+        common::tlsf_allocator alloc(reinterpret_cast<std::uint8_t *>(space.data()), SPACE_SIZE);
+        replay_fbs_allocation_trace(alloc, trace, tlsf_failures);
+
+        stats = alloc.get_stats();
+    }
+
+    const auto tlsf_end = std::chrono::steady_clock::now();
+
+    REQUIRE(tlsf_failures <= block_failures);
+
+    std::cout << "Replaying " << OP_COUNT << " FBS allocations in " << SPACE_SIZE / (1024 * 1024) << " MB: block allocator "
+              << std::chrono::duration<double, std::milli>(block_end - block_start).count() << " ms, "
+              << block_failures << " failed; TLSF "
+              << std::chrono::duration<double, std::milli>(tlsf_end - block_end).count() << " ms, "
+              << tlsf_failures << " failed, " << stats.used_block_count << " live, fragmentation "
+              << stats.fragmentation() << std::endl;
+}
@@ -0,0 +1,512 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <common/buffer.h>
+#include <common/bytepair.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stack>
+#include <vector>
+
+using namespace eka2l1;
+
+namespace {
+    // Compress a page the way the Symbian tools do: bytes that are rare in the page become tokens for the most
+    // frequent pairs, and any of them really present in the data gets escaped with the marker.
+    std::vector<std::uint8_t> bytepair_compress_page(const std::uint8_t *data, const std::size_t size) {
+        static constexpr std::size_t MIN_TOKENS = 16;
+        static constexpr std::uint16_t ESCAPED = 0x100;
+
+        std::array<std::size_t, 256> freq{};
+
+        for (std::size_t i = 0; i < size; i++) {
+            freq[data[i]]++;
+        }
+
+        std::array<std::uint8_t, 256> order;
+
+        for (int i = 0; i < 256; i++) {
+            order[i] = static_cast<std::uint8_t>(i);
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&](const std::uint8_t lhs, const std::uint8_t rhs) {
+            return freq[lhs] < freq[rhs];
+        });
+
+        const std::uint8_t marker = order[0];
+        std::vector<std::uint8_t> tokens;
+
+        for (int i = 1; i < 256; i++) {
+            if (freq[order[i]] && (tokens.size() >= MIN_TOKENS)) {
+                break;
+            }
+
+            tokens.push_back(order[i]);
+        }
+
+        std::array<bool, 256> reserved{};
+        reserved[marker] = true;
+
+        for (const std::uint8_t token : tokens) {
+            reserved[token] = true;
+        }
+
+        std::vector<std::uint16_t> symbols(data, data + size);
+
+        for (std::uint16_t &symbol : symbols) {
+            if (reserved[symbol]) {
+                symbol |= ESCAPED;
+            }
+        }
+
+        std::vector<std::array<std::uint8_t, 3>> pairs;
+        std::vector<std::uint32_t> counts(0x10000);
+
+        while (pairs.size() < tokens.size()) {
+            std::fill(counts.begin(), counts.end(), 0);
+
+            std::uint32_t best = 0;
+            std::uint32_t best_count = 0;
+
+            for (std::size_t i = 0; i + 1 < symbols.size(); i++) {
+                if ((symbols[i] | symbols[i + 1]) & ESCAPED) {
+                    continue;
+                }
+
+                const std::uint32_t pair = (symbols[i] << 8) | symbols[i + 1];
+
+                if ((++counts[pair] > best_count) || ((counts[pair] == best_count) && (pair < best))) {
+                    best = pair;
+                    best_count = counts[pair];
+                }
+
+                // Don't count overlapping runs twice
+                if ((symbols[i] == symbols[i + 1]) && (i + 2 < symbols.size()) && (symbols[i + 2] == symbols[i])) {
+                    i++;
+                }
+            }
+
+            if (best_count < 3) {
+                break;
+            }
+
+            const std::uint8_t token = tokens[pairs.size()];
+            pairs.push_back({ token, static_cast<std::uint8_t>(best >> 8), static_cast<std::uint8_t>(best) });
+
+            std::vector<std::uint16_t> replaced;
+            replaced.reserve(symbols.size());
+
+            for (std::size_t i = 0; i < symbols.size(); i++) {
+                if ((i + 1 < symbols.size()) && (symbols[i] == (best >> 8)) && (symbols[i + 1] == (best & 0xFF))) {
+                    replaced.push_back(token);
+                    i++;
+                } else {
+                    replaced.push_back(symbols[i]);
+                }
+            }
+
+            symbols = std::move(replaced);
+        }
+
+        std::vector<std::uint8_t> result;
+        result.push_back(static_cast<std::uint8_t>(pairs.size()));
+
+        if (pairs.empty()) {
+            result.insert(result.end(), data, data + size);
+            return result;
+        }
+
+        result.push_back(marker);
+
+        if (pairs.size() < 32) {
+            for (const auto &pair : pairs) {
+                result.insert(result.end(), pair.begin(), pair.end());
+            }
+        } else {
+            std::array<std::uint8_t, 32> mask{};
+            std::array<const std::array<std::uint8_t, 3> *, 256> by_token{};
+
+            for (const auto &pair : pairs) {
+                mask[pair[0] >> 3] |= 1 << (pair[0] & 7);
+                by_token[pair[0]] = &pair;
+            }
+
+            result.insert(result.end(), mask.begin(), mask.end());
+
+            for (const auto *pair : by_token) {
+                if (pair) {
+                    result.push_back((*pair)[1]);
+                    result.push_back((*pair)[2]);
+                }
+            }
+        }
+
+        for (const std::uint16_t symbol : symbols) {
+            if (symbol & ESCAPED) {
+                result.push_back(marker);
+            }
+
+            result.push_back(static_cast<std::uint8_t>(symbol));
+        }
+
+        return result;
+    }
+
+    // Build a whole stream: index table, then the pages back to back
+    std::vector<std::uint8_t> make_bytepair_stream(const std::vector<std::uint8_t> &data) {
+        std::vector<std::vector<std::uint8_t>> pages;
+
+        for (std::size_t off = 0; off < data.size(); off += common::BYTEPAIR_PAGE_SIZE) {
+            pages.push_back(bytepair_compress_page(data.data() + off,
+                std::min<std::size_t>(common::BYTEPAIR_PAGE_SIZE, data.size() - off)));
+        }
+
+        std::vector<std::uint8_t> result(10 + pages.size() * 2);
+
+        for (std::size_t i = 0; i < pages.size(); i++) {
+            const std::uint16_t page_size = static_cast<std::uint16_t>(pages[i].size());
+            std::memcpy(&result[10 + i * 2], &page_size, 2);
+
+            result.insert(result.end(), pages[i].begin(), pages[i].end());
+        }
+
+        const std::int32_t size_of_data = static_cast<std::int32_t>(result.size());
+        const std::int32_t decompressed_size = static_cast<std::int32_t>(data.size());
+        const std::uint16_t page_count = static_cast<std::uint16_t>(pages.size());
+
+        std::memcpy(&result[0], &size_of_data, 4);
+        std::memcpy(&result[4], &decompressed_size, 4);
+        std::memcpy(&result[8], &page_count, 2);
+
+        return result;
+    }
+
+    // The decompressor as it was before the expansion tables, kept to check against and to compare speed with
+    int legacy_bytepair_decompress(void *destination, unsigned int dest_size, void *buffer, unsigned int buf_size) {
+        std::uint8_t *data8 = reinterpret_cast<std::uint8_t *>(buffer);
+        std::uint8_t lookup_table_first[256];
+        std::uint8_t lookup_table_second[256];
+
+        for (int i = 0; i < 256; i++) {
+            lookup_table_first[i] = static_cast<std::uint8_t>(i);
+            lookup_table_second[i] = static_cast<std::uint8_t>(i);
+        }
+
+        std::uint32_t marker = ~0u;
+        std::uint32_t b = 0;
+        std::uint8_t p1, p2;
+
+        std::stack<std::uint8_t> sec_stack;
+
+        std::uint8_t *buf_end = data8 + buf_size;
+        std::uint8_t *dest = reinterpret_cast<std::uint8_t *>(destination);
+        std::uint8_t *dest_end = dest + dest_size;
+
+        std::uint8_t total_pair = *data8++;
+
+        if (total_pair) {
+            marker = *data8++;
+            lookup_table_first[marker] = static_cast<std::uint8_t>(~marker);
+
+            if (total_pair < 32) {
+                std::uint8_t *pair_end = data8 + 3 * total_pair;
+
+                do {
+                    b = *data8++;
+                    lookup_table_first[b] = *data8++;
+                    lookup_table_second[b] = *data8++;
+                } while (data8 < pair_end);
+            } else {
+                std::uint8_t *mask_st = data8;
+                data8 += 32;
+
+                for (b = 0; b < 0x100; b++) {
+                    if (mask_st[b >> 3] & (1 << (b & 7))) {
+                        lookup_table_first[b] = *data8++;
+                        lookup_table_second[b] = *data8++;
+                    }
+                }
+            }
+        }
+
+        while (data8 < buf_end) {
+            b = *data8++;
+
+            if (b == marker) {
+                *dest++ = *data8++;
+            } else {
+                sec_stack.push(static_cast<std::uint8_t>(b));
+
+                while (!sec_stack.empty()) {
+                    b = sec_stack.top();
+                    sec_stack.pop();
+
+                    p1 = lookup_table_first[b];
+
+                    if (p1 == b) {
+                        *dest++ = p1;
+
+                        if (dest >= dest_end) {
+                            break;
+                        }
+
+                        continue;
+                    }
+
+                    p2 = lookup_table_second[b];
+
+                    sec_stack.push(p2);
+                    sec_stack.push(p1);
+                }
+            }
+
+            if (dest >= dest_end) {
+                break;
+            }
+        }
+
+        return static_cast<int>(dest - static_cast<std::uint8_t *>(destination));
+    }
+
+    std::vector<std::uint8_t> make_code_like_data(const std::size_t size, const std::uint32_t seed) {
+        static const std::uint32_t OPCODES[] = {
+            0xE92D4000, 0xE8BD8000, 0xE59F0000, 0xE1A00000, 0xE3A00000, 0xEB000000, 0xE2800000, 0xE5900000,
+            0xE5800000, 0xE3500000, 0x0A000000, 0x1A000000, 0xE12FFF1E, 0xE0800000
+        };
+
+        std::mt19937 rng(seed);
+        std::vector<std::uint8_t> data;
+
+        while (data.size() < size) {
+            std::uint32_t word = OPCODES[rng() % (sizeof(OPCODES) / sizeof(OPCODES[0]))];
+
+            if ((word & 0x0E000000) == 0x0A000000) {
+                word |= rng() & 0x3FF;
+            } else {
+                word |= ((rng() % 8) << 12) | ((rng() % 8) << 16) | (rng() % 0x20);
+            }
+
+            for (int i = 0; i < 4; i++) {
+                data.push_back(static_cast<std::uint8_t>(word >> (i * 8)));
+            }
+        }
+
+        data.resize(size);
+        return data;
+    }
+
+    std::vector<std::uint8_t> make_text_data(const std::size_t size, const std::uint32_t seed) {
+        static const char *WORDS[] = {
+            "the ", "symbian ", "kernel ", "process ", "thread ", "chunk ", "server ", "session ", "message ",
+            "request ", "complete ", "handle ", "library ", "resource ", "\n", ", ", "EKA2L1 ", "of ", "and "
+        };
+
+        std::mt19937 rng(seed);
+        std::vector<std::uint8_t> data;
+
+        while (data.size() < size) {
+            const char *word = WORDS[rng() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+            data.insert(data.end(), word, word + std::strlen(word));
+        }
+
+        data.resize(size);
+        return data;
+    }
+
+    std::vector<std::uint8_t> make_random_data(const std::size_t size, const std::uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<std::uint8_t> data(size);
+
+        for (std::uint8_t &byte : data) {
+            byte = static_cast<std::uint8_t>(rng());
+        }
+
+        return data;
+    }
+
+    std::vector<std::uint8_t> make_run_data(const std::size_t size, const std::uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<std::uint8_t> data;
+
+        while (data.size() < size) {
+            data.insert(data.end(), 1 + rng() % 600, static_cast<std::uint8_t>(rng() % 4));
+        }
+
+        data.resize(size);
+        return data;
+    }
+
+    void check_page_conformance(const std::vector<std::uint8_t> &original) {
+        for (std::size_t off = 0; off < original.size(); off += common::BYTEPAIR_PAGE_SIZE) {
+            const std::size_t size = std::min<std::size_t>(common::BYTEPAIR_PAGE_SIZE, original.size() - off);
+            std::vector<std::uint8_t> page = bytepair_compress_page(original.data() + off, size);
+
+            std::vector<std::uint8_t> legacy(common::BYTEPAIR_PAGE_SIZE);
+            std::vector<std::uint8_t> decompressed(common::BYTEPAIR_PAGE_SIZE);
+
+            REQUIRE(legacy_bytepair_decompress(legacy.data(), static_cast<unsigned int>(legacy.size()), page.data(),
+                        static_cast<unsigned int>(page.size()))
+                == size);
+            REQUIRE(common::bytepair_decompress(decompressed.data(), static_cast<unsigned int>(decompressed.size()),
+                        page.data(), static_cast<unsigned int>(page.size()))
+                == size);
+
+            REQUIRE(std::equal(original.begin() + off, original.begin() + off + size, legacy.begin()));
+            REQUIRE(std::equal(original.begin() + off, original.begin() + off + size, decompressed.begin()));
+
+            // A smaller destination gets exactly the start of the page
+            for (const std::size_t limit : { std::size_t(1), std::size_t(7), size / 3, size - 1 }) {
+                std::vector<std::uint8_t> partial(limit + 16, 0xCD);
+
+                REQUIRE(common::bytepair_decompress(partial.data(), static_cast<unsigned int>(limit), page.data(),
+                            static_cast<unsigned int>(page.size()))
+                    == limit);
+                REQUIRE(std::equal(original.begin() + off, original.begin() + off + limit, partial.begin()));
+                REQUIRE(std::all_of(partial.begin() + limit, partial.end(), [](const std::uint8_t b) { return b == 0xCD; }));
+            }
+        }
+    }
+}
+
+TEST_CASE("bytepair_code_like_pages", "bytepair") {
+    check_page_conformance(make_code_like_data(32 * 1024, 1));
+}
+
+TEST_CASE("bytepair_text_pages", "bytepair") {
+    check_page_conformance(make_text_data(32 * 1024, 2));
+}
+
+TEST_CASE("bytepair_random_pages", "bytepair") {
+    check_page_conformance(make_random_data(16 * 1024, 3));
+}
+
+TEST_CASE("bytepair_run_pages", "bytepair") {
+    check_page_conformance(make_run_data(32 * 1024, 4));
+}
+
+TEST_CASE("bytepair_stream_random_access", "bytepair") {
+    const std::vector<std::uint8_t> original = make_code_like_data(10 * common::BYTEPAIR_PAGE_SIZE + 123, 5);
+    std::vector<std::uint8_t> compressed = make_bytepair_stream(original);
+
+    // Something else following the block
+    compressed.push_back(0x42);
+
+    common::ro_buf_stream raw_stream(compressed.data(), compressed.size());
+    common::ibytepair_stream stream(&raw_stream);
+
+    std::vector<char> all(original.size());
+
+    REQUIRE(stream.read_pages(all.data(), all.size()) == original.size());
+    REQUIRE(std::equal(original.begin(), original.end(), reinterpret_cast<std::uint8_t *>(all.data())));
+
+    std::uint8_t after = 0;
+    REQUIRE(raw_stream.read(&after, 1) == 1);
+    REQUIRE(after == 0x42);
+
+    // Pages in any order
+    std::vector<char> page(common::BYTEPAIR_PAGE_SIZE);
+
+    for (const std::uint32_t index : { 7, 0, 10, 3 }) {
+        const std::uint32_t expected_size = std::min<std::uint32_t>(common::BYTEPAIR_PAGE_SIZE,
+            static_cast<std::uint32_t>(original.size() - index * common::BYTEPAIR_PAGE_SIZE));
+
+        REQUIRE(stream.read_page(page.data(), index, page.size()) == expected_size);
+        REQUIRE(std::equal(original.begin() + index * common::BYTEPAIR_PAGE_SIZE,
+            original.begin() + index * common::BYTEPAIR_PAGE_SIZE + expected_size,
+            reinterpret_cast<std::uint8_t *>(page.data())));
+    }
+
+    // Ranges inside a page, across pages and past the end
+    const std::pair<std::uint32_t, std::uint32_t> ranges[] = {
+        { 100, 200 }, { 4000, 300 }, { 8192, 4096 }, { 5000, 12000 }, { 40000, 10000 }
+    };
+
+    for (const auto &range : ranges) {
+        std::vector<char> part(range.second);
+        const std::uint32_t expected_size = std::min<std::uint32_t>(range.second,
+            static_cast<std::uint32_t>(original.size() - range.first));
+
+        REQUIRE(stream.read_range(part.data(), range.first, range.second) == expected_size);
+        REQUIRE(std::equal(original.begin() + range.first, original.begin() + range.first + expected_size,
+            reinterpret_cast<std::uint8_t *>(part.data())));
+    }
+
+    const std::vector<std::uint32_t> offsets = stream.page_offsets(0);
+    REQUIRE(offsets.size() == 12);
+    REQUIRE(offsets.front() == 10 + 11 * 2);
+    REQUIRE(offsets.back() == compressed.size() - 1);
+}
+
+TEST_CASE("bytepair_decompress_benchmark", "[.benchmark]") {
+    static constexpr std::size_t IMAGE_SIZE = 1024 * 1024;
+    static constexpr int ROUNDS = 20;
+
+    const std::vector<std::uint8_t> original = make_code_like_data(IMAGE_SIZE, 6);
+    std::vector<std::vector<std::uint8_t>> pages;
+    std::size_t compressed_size = 0;
+
+    for (std::size_t off = 0; off < original.size(); off += common::BYTEPAIR_PAGE_SIZE) {
+        pages.push_back(bytepair_compress_page(original.data() + off, common::BYTEPAIR_PAGE_SIZE));
+        compressed_size += pages.back().size();
+    }
+
+    std::vector<std::uint8_t> output(IMAGE_SIZE);
+
+    const auto legacy_start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < ROUNDS; i++) {
+        for (std::size_t p = 0; p < pages.size(); p++) {
+            legacy_bytepair_decompress(&output[p * common::BYTEPAIR_PAGE_SIZE], common::BYTEPAIR_PAGE_SIZE,
+                pages[p].data(), static_cast<unsigned int>(pages[p].size()));
+        }
+    }
+
+    const auto legacy_end = std::chrono::steady_clock::now();
+    REQUIRE(output == original);
+
+    std::fill(output.begin(), output.end(), 0);
+    const auto table_start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < ROUNDS; i++) {
+        for (std::size_t p = 0; p < pages.size(); p++) {
+            common::bytepair_decompress(&output[p * common::BYTEPAIR_PAGE_SIZE], common::BYTEPAIR_PAGE_SIZE,
+                pages[p].data(), static_cast<unsigned int>(pages[p].size()));
+        }
+    }
+
+    const auto table_end = std::chrono::steady_clock::now();
+    REQUIRE(output == original);
+
+    const double legacy_ms = std::chrono::duration<double, std::milli>(legacy_end - legacy_start).count();
+    const double table_ms = std::chrono::duration<double, std::milli>(table_end - table_start).count();
+    const double total_mb = static_cast<double>(IMAGE_SIZE) * ROUNDS / (1024 * 1024);
+
+    std::cout << "Bytepair decompressing " << ROUNDS << " x " << IMAGE_SIZE / 1024 << " KB of code ("
+              << compressed_size / 1024 << " KB compressed): stack walk " << legacy_ms << " ms ("
+              << total_mb * 1000 / legacy_ms << " MB/s), expansion tables " << table_ms << " ms ("
+              << total_mb * 1000 / table_ms << " MB/s)" << std::endl;
+}
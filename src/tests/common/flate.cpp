@@ -0,0 +1,592 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <common/flate.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+using namespace eka2l1;
+
+// Symbian's deflate variant, encoder side. The emulator only ever inflates, so this is kept to the tests.
+namespace {
+    // Code lengths of the meta code, as in the encoder table of flate.cpp
+    static const std::uint32_t META_CODES[] = {
+        0x10000000, 0x1c000000, 0x12000000, 0x1d000000, 0x26000000, 0x26800000, 0x2f000000, 0x37400000,
+        0x37600000, 0x37800000, 0x3fa00000, 0x3fb00000, 0x3fc00000, 0x3fd00000, 0x47e00000, 0x47e80000,
+        0x47f00000, 0x4ff80000, 0x57fc0000, 0x5ffe0000, 0x67ff0000, 0x77ff8000, 0x7fffa000, 0x7fffb000,
+        0x7fffc000, 0x7fffd000, 0x7fffe000, 0x87fff000, 0x87fff800
+    };
+
+    struct test_bit_writer {
+        std::vector<std::uint8_t> data;
+        std::uint32_t acc = 0;
+        int count = 0;
+
+        void write(const std::uint32_t val, const int len) {
+            for (int i = len - 1; i >= 0; i--) {
+                acc = (acc << 1) | ((val >> i) & 1);
+
+                if (++count == 8) {
+                    data.push_back(static_cast<std::uint8_t>(acc));
+                    acc = 0;
+                    count = 0;
+                }
+            }
+        }
+
+        void meta(const std::uint32_t code) {
+            const int len = static_cast<int>(code >> flate::HUFFMAN_MAX_CODELENGTH);
+            write((code & ((1 << flate::HUFFMAN_MAX_CODELENGTH) - 1)) >> (flate::HUFFMAN_MAX_CODELENGTH - len), len);
+        }
+
+        std::vector<std::uint8_t> finish() {
+            if (count) {
+                write(0, 8 - count);
+            }
+
+            return data;
+        }
+    };
+
+    std::vector<std::uint32_t> make_code_lengths(const std::vector<std::uint32_t> &freqs) {
+        std::vector<std::uint32_t> lengths(freqs.size(), 0);
+        std::vector<int> parent;
+        std::vector<int> leaf_node(freqs.size(), -1);
+
+        using queue_entry = std::pair<std::uint64_t, int>;
+        std::priority_queue<queue_entry, std::vector<queue_entry>, std::greater<queue_entry>> queue;
+
+        for (std::size_t i = 0; i < freqs.size(); i++) {
+            if (freqs[i]) {
+                leaf_node[i] = static_cast<int>(parent.size());
+                queue.emplace(freqs[i], static_cast<int>(parent.size()));
+                parent.push_back(-1);
+            }
+        }
+
+        if (parent.size() == 1) {
+            lengths[std::find_if(leaf_node.begin(), leaf_node.end(), [](const int n) { return n >= 0; }) - leaf_node.begin()] = 1;
+            return lengths;
+        }
+
+        while (queue.size() > 1) {
+            const queue_entry first = queue.top();
+            queue.pop();
+            const queue_entry second = queue.top();
+            queue.pop();
+
+            parent[first.second] = static_cast<int>(parent.size());
+            parent[second.second] = static_cast<int>(parent.size());
+
+            queue.emplace(first.first + second.first, static_cast<int>(parent.size()));
+            parent.push_back(-1);
+        }
+
+        for (std::size_t i = 0; i < freqs.size(); i++) {
+            for (int node = leaf_node[i]; (node >= 0) && (parent[node] >= 0); node = parent[node]) {
+                lengths[i]++;
+            }
+
+            REQUIRE(lengths[i] <= flate::HUFFMAN_MAX_CODELENGTH);
+        }
+
+        return lengths;
+    }
+
+    std::vector<std::uint32_t> make_codes(const std::vector<std::uint32_t> &lengths) {
+        std::array<std::uint32_t, flate::HUFFMAN_MAX_CODELENGTH + 1> count{};
+        std::array<std::uint32_t, flate::HUFFMAN_MAX_CODELENGTH + 1> next{};
+
+        for (const std::uint32_t len : lengths) {
+            count[len]++;
+        }
+
+        count[0] = 0;
+
+        for (int i = 1, code = 0; i <= flate::HUFFMAN_MAX_CODELENGTH; i++) {
+            code = (code + count[i - 1]) << 1;
+            next[i] = code;
+        }
+
+        std::vector<std::uint32_t> codes(lengths.size(), 0);
+
+        for (std::size_t i = 0; i < lengths.size(); i++) {
+            if (lengths[i]) {
+                codes[i] = next[lengths[i]]++;
+            }
+        }
+
+        return codes;
+    }
+
+    void write_run_length(test_bit_writer &writer, const int len) {
+        if (len > 0) {
+            write_run_length(writer, (len - 1) >> 1);
+            writer.meta(META_CODES[1 - (len & 1)]);
+        }
+    }
+
+    void write_code_lengths(test_bit_writer &writer, const std::vector<std::uint32_t> &lengths) {
+        std::array<std::uint32_t, flate::HUFFMAN_METACODE> list;
+
+        for (std::size_t i = 0; i < list.size(); i++) {
+            list[i] = static_cast<std::uint32_t>(i);
+        }
+
+        std::uint32_t last = 0;
+        int run = 0;
+
+        for (const std::uint32_t len : lengths) {
+            if (len == last) {
+                run++;
+                continue;
+            }
+
+            write_run_length(writer, run);
+            run = 0;
+
+            int j = 1;
+
+            while (list[j] != len) {
+                j++;
+            }
+
+            writer.meta(META_CODES[j + 1]);
+
+            for (; j > 1; j--) {
+                list[j] = list[j - 1];
+            }
+
+            list[1] = last;
+            last = len;
+        }
+
+        write_run_length(writer, run);
+    }
+
+    // Split a length or distance value into its code and extra bits
+    void split_value(const std::uint32_t value, std::uint32_t &code, int &xtra) {
+        if (value < 8) {
+            code = value;
+            xtra = 0;
+
+            return;
+        }
+
+        int log = 0;
+
+        while ((value >> (log + 1)) != 0) {
+            log++;
+        }
+
+        xtra = log - 2;
+        code = (value >> xtra) + (xtra << 2);
+    }
+
+    struct lz_token {
+        std::uint32_t length; ///< 0 for a literal.
+        std::uint32_t value; ///< The literal or the distance.
+    };
+
+    std::vector<std::uint8_t> symbian_deflate(const std::vector<std::uint8_t> &input) {
+        static constexpr int HASH_BITS = 15;
+        static constexpr int MAX_CHAIN = 64;
+
+        std::vector<int> head(1 << HASH_BITS, -1);
+        std::vector<int> prev(input.size(), -1);
+        std::vector<lz_token> tokens;
+
+        const auto hash_at = [&](const std::size_t pos) {
+            return ((input[pos] << 10) ^ (input[pos + 1] << 5) ^ input[pos + 2]) & ((1 << HASH_BITS) - 1);
+        };
+
+        const auto insert = [&](const std::size_t pos) {
+            if (pos + 2 < input.size()) {
+                const int hash = hash_at(pos);
+                prev[pos] = head[hash];
+                head[hash] = static_cast<int>(pos);
+            }
+        };
+
+        for (std::size_t pos = 0; pos < input.size();) {
+            std::size_t best_len = 0;
+            std::size_t best_dist = 0;
+
+            if (pos + 2 < input.size()) {
+                const std::size_t max_len = std::min<std::size_t>(flate::DEFLATE_MAX_LENGTH, input.size() - pos);
+                int candidate = head[hash_at(pos)];
+
+                for (int chain = 0; (candidate >= 0) && (chain < MAX_CHAIN); chain++, candidate = prev[candidate]) {
+                    if (pos - candidate > flate::DEFLATE_MAX_DIST) {
+                        break;
+                    }
+
+                    std::size_t len = 0;
+
+                    while ((len < max_len) && (input[candidate + len] == input[pos + len])) {
+                        len++;
+                    }
+
+                    if (len > best_len) {
+                        best_len = len;
+                        best_dist = pos - candidate;
+                    }
+                }
+            }
+
+            if (best_len >= flate::DEFLATE_MIN_LENGTH) {
+                tokens.push_back({ static_cast<std::uint32_t>(best_len), static_cast<std::uint32_t>(best_dist) });
+
+                for (std::size_t i = 0; i < best_len; i++) {
+                    insert(pos++);
+                }
+            } else {
+                tokens.push_back({ 0, input[pos] });
+                insert(pos++);
+            }
+        }
+
+        std::vector<std::uint32_t> lit_len_freqs(flate::ENCODING_LITERAL_LEN, 0);
+        std::vector<std::uint32_t> dist_freqs(flate::ENCODING_DISTS, 0);
+
+        for (const lz_token &token : tokens) {
+            std::uint32_t code = 0;
+            int xtra = 0;
+
+            if (token.length == 0) {
+                lit_len_freqs[token.value]++;
+                continue;
+            }
+
+            split_value(token.length - flate::DEFLATE_MIN_LENGTH, code, xtra);
+            lit_len_freqs[flate::ENCODING_LITERALS + code]++;
+
+            split_value(token.value - 1, code, xtra);
+            dist_freqs[code]++;
+        }
+
+        lit_len_freqs[flate::ENCODING_EOS]++;
+
+        const std::vector<std::uint32_t> lit_len_lengths = make_code_lengths(lit_len_freqs);
+        const std::vector<std::uint32_t> dist_lengths = make_code_lengths(dist_freqs);
+        const std::vector<std::uint32_t> lit_len_codes = make_codes(lit_len_lengths);
+        const std::vector<std::uint32_t> dist_codes = make_codes(dist_lengths);
+
+        std::vector<std::uint32_t> all_lengths = lit_len_lengths;
+        all_lengths.insert(all_lengths.end(), dist_lengths.begin(), dist_lengths.end());
+
+        test_bit_writer writer;
+        write_code_lengths(writer, all_lengths);
+
+        for (const lz_token &token : tokens) {
+            if (token.length == 0) {
+                writer.write(lit_len_codes[token.value], lit_len_lengths[token.value]);
+                continue;
+            }
+
+            std::uint32_t code = 0;
+            int xtra = 0;
+
+            const std::uint32_t len_value = token.length - flate::DEFLATE_MIN_LENGTH;
+            split_value(len_value, code, xtra);
+
+            writer.write(lit_len_codes[flate::ENCODING_LITERALS + code], lit_len_lengths[flate::ENCODING_LITERALS + code]);
+            writer.write(len_value & ((1 << xtra) - 1), xtra);
+
+            const std::uint32_t dist_value = token.value - 1;
+            split_value(dist_value, code, xtra);
+
+            writer.write(dist_codes[code], dist_lengths[code]);
+            writer.write(dist_value & ((1 << xtra) - 1), xtra);
+        }
+
+        writer.write(lit_len_codes[flate::ENCODING_EOS], lit_len_lengths[flate::ENCODING_EOS]);
+        return writer.finish();
+    }
+
+    // The inflate loop as it was before table decoding, walking the decode trees bit by bit
+    std::vector<std::uint8_t> reference_inflate(const std::vector<std::uint8_t> &compressed, const std::size_t size) {
+        flate::bit_input input(compressed.data(), static_cast<int>(compressed.size() * 8));
+        flate::encoding encode;
+
+        flate::huffman::internalize(input, encode.lit_len, flate::DEFLATE_CODES);
+        flate::huffman::decoding(reinterpret_cast<int *>(encode.lit_len), flate::ENCODING_LITERAL_LEN, encode.lit_len);
+        flate::huffman::decoding(reinterpret_cast<int *>(encode.dist), flate::ENCODING_DISTS, encode.dist, flate::DEFLATE_DIST_CODE_BASE);
+
+        std::vector<std::uint8_t> output;
+        output.reserve(size);
+
+        while (output.size() < size) {
+            const int val = static_cast<int>(input.huffman(encode.lit_len)) - flate::ENCODING_LITERALS;
+
+            if (val < 0) {
+                output.push_back(static_cast<std::uint8_t>(val));
+                continue;
+            }
+
+            if (val == flate::ENCODING_EOS - flate::ENCODING_LITERALS) {
+                break;
+            }
+
+            const auto read_value = [&](int code) {
+                if (code >= 8) {
+                    const int xtra = (code >> 2) - 1;
+                    code -= xtra << 2;
+                    code <<= xtra;
+                    code |= input.read(xtra);
+                }
+
+                return code;
+            };
+
+            const int len = read_value(val & 0xFF) + flate::DEFLATE_MIN_LENGTH;
+            const int dist = read_value((static_cast<int>(input.huffman(encode.dist)) - flate::ENCODING_LITERALS) & 0xFF) + 1;
+
+            for (int i = 0; i < len; i++) {
+                output.push_back(output[output.size() - dist]);
+            }
+        }
+
+        return output;
+    }
+
+    std::vector<std::uint8_t> table_inflate(const std::vector<std::uint8_t> &compressed, const std::size_t size,
+        const std::size_t step) {
+        flate::bit_input input(compressed.data(), static_cast<int>(compressed.size() * 8));
+        flate::inflater inflater(input);
+        inflater.init();
+
+        std::vector<std::uint8_t> output(size + 1);
+        std::size_t total = 0;
+
+        while (total < size + 1) {
+            const int read = inflater.read(output.data() + total, std::min(step, size + 1 - total));
+
+            if (read <= 0) {
+                break;
+            }
+
+            total += read;
+        }
+
+        output.resize(total);
+        return output;
+    }
+
+    // Words looking like Thumb and ARM code: few opcodes with varying registers and branch offsets
+    std::vector<std::uint8_t> make_code_like_data(const std::size_t size, const std::uint32_t seed) {
+        static const std::uint32_t OPCODES[] = {
+            0xE92D4000, 0xE8BD8000, 0xE59F0000, 0xE1A00000, 0xE3A00000, 0xEB000000, 0xE2800000, 0xE5900000,
+            0xE5800000, 0xE3500000, 0x0A000000, 0x1A000000, 0xE12FFF1E, 0xE0800000
+        };
+
+        std::mt19937 rng(seed);
+        std::vector<std::uint8_t> data;
+
+        while (data.size() < size) {
+            std::uint32_t word = OPCODES[rng() % (sizeof(OPCODES) / sizeof(OPCODES[0]))];
+
+            if ((word & 0x0F000000) == 0x0A000000 || (word & 0x0F000000) == 0x0B000000) {
+                word |= rng() & 0x3FF;
+            } else {
+                word |= ((rng() % 8) << 12) | ((rng() % 8) << 16) | (rng() % 0x20);
+            }
+
+            for (int i = 0; i < 4; i++) {
+                data.push_back(static_cast<std::uint8_t>(word >> (i * 8)));
+            }
+        }
+
+        data.resize(size);
+        return data;
+    }
+
+    std::vector<std::uint8_t> make_text_data(const std::size_t size, const std::uint32_t seed) {
+        static const char *WORDS[] = {
+            "the ", "symbian ", "kernel ", "process ", "thread ", "chunk ", "server ", "session ", "message ",
+            "request ", "complete ", "handle ", "library ", "resource ", "\n", ", ", "EKA2L1 ", "of ", "and "
+        };
+
+        std::mt19937 rng(seed);
+        std::vector<std::uint8_t> data;
+
+        while (data.size() < size) {
+            const char *word = WORDS[rng() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+            data.insert(data.end(), word, word + std::strlen(word));
+        }
+
+        data.resize(size);
+        return data;
+    }
+
+    std::vector<std::uint8_t> make_random_data(const std::size_t size, const std::uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<std::uint8_t> data(size);
+
+        for (std::uint8_t &byte : data) {
+            byte = static_cast<std::uint8_t>(rng());
+        }
+
+        return data;
+    }
+
+    std::vector<std::uint8_t> make_run_data(const std::size_t size, const std::uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<std::uint8_t> data;
+
+        while (data.size() < size) {
+            data.insert(data.end(), 1 + rng() % 600, static_cast<std::uint8_t>(rng() % 4));
+        }
+
+        data.resize(size);
+        return data;
+    }
+
+    void check_inflate_conformance(const std::vector<std::uint8_t> &original) {
+        const std::vector<std::uint8_t> compressed = symbian_deflate(original);
+
+        REQUIRE(reference_inflate(compressed, original.size()) == original);
+
+        // Odd step sizes make the inflater stop in the middle of back references
+        REQUIRE(table_inflate(compressed, original.size(), original.size() + 1) == original);
+        REQUIRE(table_inflate(compressed, original.size(), 777) == original);
+        REQUIRE(table_inflate(compressed, original.size(), 1) == original);
+    }
+}
+
+TEST_CASE("bit_input_offset_reads", "flate") {
+    static const std::array<std::uint8_t, 12> source = {
+        0xA5, 0x3C, 0xFF, 0x00, 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0
+    };
+
+    for (int off = 0; off < 16; off++) {
+        flate::bit_input input(source.data(), static_cast<int>(source.size() * 8) - off, off);
+
+        for (int bit = off; bit < static_cast<int>(source.size() * 8); bit++) {
+            const std::uint32_t expected = (source[bit >> 3] >> (7 - (bit & 7))) & 1;
+            REQUIRE(input.read() == expected);
+        }
+
+        // Nothing left, padded with zeros
+        REQUIRE(input.peek(3) == 0);
+    }
+
+    flate::bit_input input(source.data(), static_cast<int>(source.size() * 8) - 4, 4);
+
+    REQUIRE(input.read(12) == 0x53C);
+    REQUIRE(input.peek(16) == 0xFF00);
+    REQUIRE(input.read(32) == 0xFF001234);
+    REQUIRE(input.read(27) == (0x56789ABC >> 5));
+    REQUIRE(input.read(21) == (0xBCDEF0 & 0x1FFFFF));
+}
+
+TEST_CASE("huffman_table_long_codes", "flate") {
+    // Lengths 1, 2, ..., 26, 27, 27 make a complete code reaching the maximum length
+    std::vector<std::uint32_t> lengths;
+
+    for (std::uint32_t i = 1; i <= flate::HUFFMAN_MAX_CODELENGTH; i++) {
+        lengths.push_back(i);
+    }
+
+    lengths.push_back(flate::HUFFMAN_MAX_CODELENGTH);
+    REQUIRE(flate::huffman::valid(lengths.data(), static_cast<int>(lengths.size())));
+
+    const std::vector<std::uint32_t> codes = make_codes(lengths);
+    test_bit_writer writer;
+
+    for (std::size_t i = 0; i < lengths.size(); i++) {
+        writer.write(codes[lengths.size() - 1 - i], lengths[lengths.size() - 1 - i]);
+        writer.write(codes[i], lengths[i]);
+    }
+
+    const std::vector<std::uint8_t> stream = writer.finish();
+
+    flate::huffman_table table;
+    REQUIRE(table.build(lengths.data(), static_cast<int>(lengths.size()), static_cast<int>(lengths.size())));
+
+    flate::bit_input input(stream.data(), static_cast<int>(stream.size() * 8));
+
+    for (std::size_t i = 0; i < lengths.size(); i++) {
+        REQUIRE(table.decode(input) == static_cast<int>(lengths.size() - 1 - i));
+        REQUIRE(table.decode(input) == static_cast<int>(i));
+    }
+}
+
+TEST_CASE("inflate_code_like_data", "flate") {
+    check_inflate_conformance(make_code_like_data(64 * 1024, 1));
+    check_inflate_conformance(make_code_like_data(5000, 2));
+}
+
+TEST_CASE("inflate_text_data", "flate") {
+    check_inflate_conformance(make_text_data(64 * 1024, 3));
+}
+
+TEST_CASE("inflate_random_data", "flate") {
+    check_inflate_conformance(make_random_data(16 * 1024, 4));
+}
+
+TEST_CASE("inflate_runs", "flate") {
+    check_inflate_conformance(make_run_data(64 * 1024, 5));
+}
+
+TEST_CASE("inflate_tiny_streams", "flate") {
+    check_inflate_conformance({});
+    check_inflate_conformance({ 0x42 });
+    check_inflate_conformance(std::vector<std::uint8_t>(300, 0x42));
+}
+
+TEST_CASE("inflate_throughput_benchmark", "[.benchmark]") {
+    static constexpr std::size_t IMAGE_SIZE = 1024 * 1024;
+    static constexpr int ROUNDS = 20;
+
+    const std::vector<std::uint8_t> original = make_code_like_data(IMAGE_SIZE, 6);
+    const std::vector<std::uint8_t> compressed = symbian_deflate(original);
+
+    const auto tree_start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < ROUNDS; i++) {
+        REQUIRE(reference_inflate(compressed, IMAGE_SIZE).size() == IMAGE_SIZE);
+    }
+
+    const auto tree_end = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < ROUNDS; i++) {
+        REQUIRE(table_inflate(compressed, IMAGE_SIZE, IMAGE_SIZE).size() == IMAGE_SIZE);
+    }
+
+    const auto table_end = std::chrono::steady_clock::now();
+
+    const double tree_ms = std::chrono::duration<double, std::milli>(tree_end - tree_start).count();
+    const double table_ms = std::chrono::duration<double, std::milli>(table_end - tree_end).count();
+    const double total_mb = static_cast<double>(IMAGE_SIZE) * ROUNDS / (1024 * 1024);
+
+    std::cout << "Inflating " << ROUNDS << " x " << IMAGE_SIZE / 1024 << " KB of code (" << compressed.size() / 1024
+              << " KB compressed): tree walk " << tree_ms << " ms (" << total_mb * 1000 / tree_ms << " MB/s), table "
+              << table_ms << " ms (" << total_mb * 1000 / table_ms << " MB/s)" << std::endl;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <common/pagededup.h>
+#include <common/virtualmem.h>
+
+#include <cstdint>
+#include <cstring>
+
+using namespace eka2l1;
+
+static void fill_dedup_test_region(std::uint8_t *region, const std::size_t page_size) {
+    // Pages: A, A, B, A
+    for (int i = 0; i < 4; i++) {
+        std::memset(region + i * page_size, (i == 2) ? 0xB0 : 0xA0, page_size);
+        region[i * page_size] = static_cast<std::uint8_t>(i == 2);
+    }
+}
+
+TEST_CASE("identical_pages_shared_copy_on_write", "page_dedup_pool") {
+    const std::size_t page_size = static_cast<std::size_t>(common::get_host_page_size());
+    const std::size_t region_size = page_size * 4;
+
+    std::uint8_t *region1 = reinterpret_cast<std::uint8_t *>(common::map_memory(region_size));
+    std::uint8_t *region2 = reinterpret_cast<std::uint8_t *>(common::map_memory(region_size));
+
+    REQUIRE(region1);
+    REQUIRE(region2);
+
+    REQUIRE(common::commit(region1, region_size, prot::read_write));
+    REQUIRE(common::commit(region2, region_size, prot::read_write));
+
+    fill_dedup_test_region(region1, page_size);
+    fill_dedup_test_region(region2, page_size);
+
+    std::uint8_t expected[4][2];
+
+    for (int i = 0; i < 4; i++) {
+        expected[i][0] = region1[i * page_size];
+        expected[i][1] = region1[i * page_size + page_size - 1];
+    }
+
+    common::page_dedup_pool pool;
+
+    const std::size_t saved1 = pool.share(region1, region_size, prot::read_write);
+    const std::size_t saved2 = pool.share(region2, region_size, prot::read_write);
+
+#if defined(__linux__) && !defined(__ANDROID__)
+    // Two pages of the first region repeat an earlier one, the second region is all repeats
+    REQUIRE(saved1 == page_size * 2);
+    REQUIRE(saved2 == region_size);
+    REQUIRE(pool.bytes_saved() == page_size * 6);
+    REQUIRE(pool.bytes_pooled() == page_size * 2);
+#else
+    REQUIRE(saved1 == 0);
+    REQUIRE(saved2 == 0);
+#endif
+
+    for (int i = 0; i < 4; i++) {
+        REQUIRE(region1[i * page_size] == expected[i][0]);
+        REQUIRE(region1[i * page_size + page_size - 1] == expected[i][1]);
+        REQUIRE(region2[i * page_size] == expected[i][0]);
+    }
+
+    // Writing one page must not leak into the others sharing it
+    region1[page_size + 5] = 0x55;
+
+    REQUIRE(region1[5] == 0xA0);
+    REQUIRE(region1[page_size * 3 + 5] == 0xA0);
+    REQUIRE(region2[page_size + 5] == 0xA0);
+    REQUIRE(region1[page_size + 5] == 0x55);
+
+    common::unmap_memory(region1, region_size);
+    common::unmap_memory(region2, region_size);
+}
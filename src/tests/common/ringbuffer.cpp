@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/ringbuffer.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+TEST_CASE("spsc_ring_buffer_wrap_around", "spsc_ring_buffer") {
+    common::spsc_ring_buffer<std::uint16_t> ring(6);
+    REQUIRE(ring.capacity() == 8);
+
+    const std::uint16_t first[6] = { 1, 2, 3, 4, 5, 6 };
+    REQUIRE(ring.write(first, 6) == 6);
+
+    std::uint16_t out[8] = {};
+    REQUIRE(ring.read(out, 4) == 4);
+    REQUIRE(out[3] == 4);
+
+    // Crosses the end of the storage, and only 6 slots are free
+    const std::uint16_t second[8] = { 7, 8, 9, 10, 11, 12, 13, 14 };
+    REQUIRE(ring.write(second, 8) == 6);
+    REQUIRE(ring.size() == 8);
+    REQUIRE(ring.free() == 0);
+
+    REQUIRE(ring.read(out, 8) == 8);
+
+    const std::uint16_t expected[8] = { 5, 6, 7, 8, 9, 10, 11, 12 };
+    REQUIRE(std::equal(out, out + 8, expected));
+    REQUIRE(ring.read(out, 1) == 0);
+}
+
+TEST_CASE("spsc_ring_buffer_threaded", "spsc_ring_buffer") {
+    static constexpr std::uint32_t TOTAL = 1 << 18;
+    common::spsc_ring_buffer<std::uint32_t> ring(1000);
+
+    std::thread producer([&]() {
+        std::uint32_t chunk[37];
+        std::uint32_t next = 0;
+
+        while (next < TOTAL) {
+            const std::uint32_t count = std::min<std::uint32_t>(37, TOTAL - next);
+
+            for (std::uint32_t i = 0; i < count; i++) {
+                chunk[i] = next + i;
+            }
+
+            next += static_cast<std::uint32_t>(ring.write(chunk, count));
+        }
+    });
+
+    std::uint32_t expected = 0;
+    bool in_order = true;
+    std::uint32_t chunk[53];
+
+    while (expected < TOTAL) {
+        const std::size_t count = ring.read(chunk, 53);
+
+        for (std::size_t i = 0; i < count; i++) {
+            in_order = in_order && (chunk[i] == expected++);
+        }
+    }
+
+    producer.join();
+    REQUIRE(in_order);
+}
@@ -20,10 +20,147 @@
 #include <catch2/catch.hpp>
 #include <common/runlen.h>
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <iostream>
+#include <random>
 
 using namespace eka2l1;
 
+namespace {
+    // Pixels in runs and noisy stretches, like icons with flat areas and gradients
+    std::vector<std::uint8_t> make_rle_test_image(const std::size_t pixel_size, const std::size_t pixel_count, const std::uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<std::uint8_t> data;
+
+        while (data.size() < pixel_size * pixel_count) {
+            std::uint8_t pixel[4];
+
+            for (std::size_t i = 0; i < pixel_size; i++) {
+                pixel[i] = static_cast<std::uint8_t>(rng() % 4);
+            }
+
+            const std::size_t span = 1 + rng() % ((rng() % 4 == 0) ? 400 : 6);
+
+            if (rng() % 2) {
+                for (std::size_t i = 0; i < span; i++) {
+                    data.insert(data.end(), pixel, pixel + pixel_size);
+                }
+            } else {
+                for (std::size_t i = 0; i < span * pixel_size; i++) {
+                    data.push_back(static_cast<std::uint8_t>(rng()));
+                }
+            }
+        }
+
+        data.resize(pixel_size * pixel_count);
+        return data;
+    }
+
+    template <std::size_t BIT>
+    void check_rle_round_trip(const std::vector<std::uint8_t> &original) {
+        std::size_t estimated_size = 0;
+        REQUIRE(compress_rle<BIT>(original.data(), original.size(), nullptr, estimated_size));
+
+        std::vector<std::uint8_t> compressed(estimated_size);
+        std::size_t compressed_size = compressed.size();
+
+        REQUIRE(compress_rle<BIT>(original.data(), original.size(), compressed.data(), compressed_size));
+        REQUIRE(compressed_size == estimated_size);
+
+        if (estimated_size) {
+            // One byte short is not enough
+            std::size_t short_size = estimated_size - 1;
+            REQUIRE(!compress_rle<BIT>(original.data(), original.size(), compressed.data(), short_size));
+        }
+
+        // The stream version gives the same result
+        {
+            std::vector<std::uint8_t> source_copy = original;
+            std::vector<std::uint8_t> stream_compressed(estimated_size + 1);
+
+            common::ro_buf_stream source_stream(source_copy.data(), source_copy.size());
+            common::wo_buf_stream dest_stream(stream_compressed.data(), stream_compressed.size());
+
+            std::size_t stream_size = 0;
+            REQUIRE(compress_rle<BIT>(&source_stream, &dest_stream, stream_size));
+            REQUIRE(stream_size == estimated_size);
+            REQUIRE(std::equal(compressed.begin(), compressed.end(), stream_compressed.begin()));
+        }
+
+        std::size_t source_size = compressed.size();
+        std::size_t dest_size = 0;
+
+        decompress_rle<BIT>(compressed.data(), source_size, nullptr, dest_size);
+        REQUIRE(dest_size == original.size());
+
+        std::vector<std::uint8_t> decompressed(original.size());
+        source_size = compressed.size();
+        dest_size = decompressed.size();
+
+        decompress_rle<BIT>(compressed.data(), source_size, decompressed.data(), dest_size);
+
+        REQUIRE(source_size == compressed.size());
+        REQUIRE(dest_size == original.size());
+        REQUIRE(decompressed == original);
+
+        // A smaller destination gets exactly its size, never more
+        for (const std::size_t limit : { std::size_t(0), std::size_t(1), original.size() / 3, original.size() - 1 }) {
+            std::vector<std::uint8_t> partial(limit + 8, 0xCD);
+
+            source_size = compressed.size();
+            dest_size = limit;
+
+            decompress_rle<BIT>(compressed.data(), source_size, partial.data(), dest_size);
+
+            REQUIRE(dest_size <= limit);
+            REQUIRE(limit - dest_size < BIT / 8);
+            REQUIRE(std::equal(partial.begin(), partial.begin() + dest_size, original.begin()));
+            REQUIRE(std::all_of(partial.begin() + limit, partial.end(), [](const std::uint8_t b) { return b == 0xCD; }));
+        }
+    }
+
+    // Decoder as it was before the span version, one byte per stream call. Only its one pixel overrun of the
+    // destination is fixed.
+    template <std::size_t BIT>
+    void legacy_decompress_rle(common::ro_stream *source, common::wo_stream *dest) {
+        constexpr int BYTE_COUNT = static_cast<int>(BIT) / 8;
+
+        while (source->valid() && dest->valid()) {
+            std::int8_t count8 = 0;
+            source->read(&count8, 1);
+
+            std::int32_t count = count8;
+
+            if (count >= 0) {
+                count = common::min(count, static_cast<std::int32_t>(dest->left() / BYTE_COUNT) - 1);
+                std::uint8_t comp[BYTE_COUNT];
+
+                for (std::size_t i = 0; i < BYTE_COUNT; i++) {
+                    source->read(&comp[i], 1);
+                }
+
+                while (count >= 0) {
+                    for (std::size_t i = 0; i < BYTE_COUNT; i++) {
+                        dest->write(&comp[i], 1);
+                    }
+
+                    count--;
+                }
+            } else {
+                std::uint32_t num_bytes_to_copy = static_cast<std::uint32_t>(count * -BYTE_COUNT);
+                num_bytes_to_copy = common::min(num_bytes_to_copy, static_cast<std::uint32_t>(dest->left()));
+
+                std::vector<std::uint8_t> temp_buf_holder(num_bytes_to_copy);
+
+                source->read(&temp_buf_holder[0], num_bytes_to_copy);
+                dest->write(temp_buf_holder.data(), num_bytes_to_copy);
+            }
+        }
+    }
+}
+
 TEST_CASE("eight_bit_compression_small", "rle_compression") {
     static std::array<std::int8_t, 27> source = {
         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -177,4 +314,85 @@ TEST_CASE("sixteen_bits_compression_small", "rle_compression") {
 
     REQUIRE(compressed_size == expected.size());
     REQUIRE(std::equal(expected.begin(), expected.end(), dest_buf.begin()));
-}
\ No newline at end of file
+}
+TEST_CASE("rle_round_trip", "rle_compression") {
+    for (std::uint32_t seed = 0; seed < 8; seed++) {
+        const std::size_t pixel_count = 1 + seed * 997;
+
+        check_rle_round_trip<8>(make_rle_test_image(1, pixel_count, seed));
+        check_rle_round_trip<16>(make_rle_test_image(2, pixel_count, seed));
+        check_rle_round_trip<24>(make_rle_test_image(3, pixel_count, seed));
+        check_rle_round_trip<32>(make_rle_test_image(4, pixel_count, seed));
+    }
+}
+
+TEST_CASE("rle_run_then_different_last_pixel", "rle_compression") {
+    static std::array<std::uint8_t, 3> source = { 0x41, 0x41, 0x42 };
+
+    std::array<std::uint8_t, 8> compressed;
+    std::size_t compressed_size = compressed.size();
+
+    REQUIRE(compress_rle<8>(source.data(), source.size(), compressed.data(), compressed_size));
+    REQUIRE(compressed_size == 4);
+
+    std::array<std::uint8_t, 3> decompressed;
+    std::size_t dest_size = decompressed.size();
+
+    decompress_rle<8>(compressed.data(), compressed_size, decompressed.data(), dest_size);
+
+    REQUIRE(dest_size == 3);
+    REQUIRE(decompressed == source);
+}
+
+TEST_CASE("rle_decompress_benchmark", "[.benchmark]") {
+    static constexpr std::size_t PIXEL_COUNT = 512 * 1024;
+    static constexpr int ROUNDS = 20;
+
+    std::vector<std::uint8_t> original = make_rle_test_image(3, PIXEL_COUNT, 42);
+
+    std::size_t compressed_size = 0;
+    compress_rle<24>(original.data(), original.size(), nullptr, compressed_size);
+
+    std::vector<std::uint8_t> compressed(compressed_size);
+
+    const auto compress_start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < ROUNDS; i++) {
+        compressed_size = compressed.size();
+        REQUIRE(compress_rle<24>(original.data(), original.size(), compressed.data(), compressed_size));
+    }
+
+    const auto compress_end = std::chrono::steady_clock::now();
+    std::vector<std::uint8_t> decompressed(original.size());
+
+    for (int i = 0; i < ROUNDS; i++) {
+        common::ro_buf_stream source_stream(compressed.data(), compressed.size());
+        common::wo_buf_stream dest_stream(decompressed.data(), decompressed.size());
+
+        legacy_decompress_rle<24>(&source_stream, &dest_stream);
+    }
+
+    const auto legacy_end = std::chrono::steady_clock::now();
+    REQUIRE(decompressed == original);
+
+    std::fill(decompressed.begin(), decompressed.end(), 0);
+
+    for (int i = 0; i < ROUNDS; i++) {
+        std::size_t source_size = compressed.size();
+        std::size_t dest_size = decompressed.size();
+
+        decompress_rle<24>(compressed.data(), source_size, decompressed.data(), dest_size);
+    }
+
+    const auto span_end = std::chrono::steady_clock::now();
+    REQUIRE(decompressed == original);
+
+    const double total_mb = static_cast<double>(original.size()) * ROUNDS / (1024 * 1024);
+    const double compress_ms = std::chrono::duration<double, std::milli>(compress_end - compress_start).count();
+    const double legacy_ms = std::chrono::duration<double, std::milli>(legacy_end - compress_end).count();
+    const double span_ms = std::chrono::duration<double, std::milli>(span_end - legacy_end).count();
+
+    std::cout << "RLE 24-bit, " << ROUNDS << " x " << original.size() / 1024 << " KB (" << compressed.size() / 1024
+              << " KB compressed): compress " << total_mb * 1000 / compress_ms << " MB/s, stream decompress "
+              << total_mb * 1000 / legacy_ms << " MB/s, span decompress " << total_mb * 1000 / span_ms << " MB/s" << std::endl;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/algorithm.h>
+#include <common/wildcard.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace eka2l1;
+
+TEST_CASE("wildcard_basic", "wildcard") {
+    REQUIRE(common::match_wildcard(std::string("app.rsc"), "*"));
+    REQUIRE(common::match_wildcard(std::string(""), "*"));
+    REQUIRE(common::match_wildcard(std::string(""), ""));
+    REQUIRE(!common::match_wildcard(std::string("a"), ""));
+
+    REQUIRE(common::match_wildcard(std::string("app.rsc"), "*.rsc"));
+    REQUIRE(common::match_wildcard(std::string("app_reg.r01"), "*.r*"));
+    REQUIRE(!common::match_wildcard(std::string("app.mbm"), "*.r*"));
+
+    REQUIRE(common::match_wildcard(std::string("a.b"), "?.?"));
+    REQUIRE(!common::match_wildcard(std::string("ab.b"), "?.?"));
+    REQUIRE(!common::match_wildcard(std::string("a"), "??"));
+}
+
+TEST_CASE("wildcard_symbian_edge_cases", "wildcard") {
+    // Names without extension don't match a pattern asking for a dot
+    REQUIRE(!common::match_wildcard(std::string("readme"), "*.*"));
+    REQUIRE(common::match_wildcard(std::string("readme."), "*.*"));
+
+    // Consecutive stars collapse
+    REQUIRE(common::match_wildcard(std::string("abc"), "a**c"));
+    REQUIRE(common::match_wildcard(std::string("abc"), "***"));
+
+    // The last star has to backtrack to find the right split
+    REQUIRE(common::match_wildcard(std::string("mississippi"), "*sip*"));
+    REQUIRE(common::match_wildcard(std::string("aaab"), "*a*ab"));
+    REQUIRE(!common::match_wildcard(std::string("aaa"), "*a*ab"));
+
+    // Case never matters for file names
+    REQUIRE(common::match_wildcard(std::string("EComPlugin.RSC"), "*plugin.rsc"));
+    REQUIRE(common::match_wildcard(std::u16string(u"SKIN.SKN"), u"skin.*"));
+
+    // Unless asked to
+    REQUIRE(!common::match_wildcard(std::string("Text/Plain"), "text/*", false));
+    REQUIRE(common::match_wildcard(std::string("text/plain"), "text/*", false));
+
+    // Characters a regex would choke on are plain characters
+    REQUIRE(common::match_wildcard(std::string("photo(1).jpg"), "photo(1).*"));
+    REQUIRE(common::match_wildcard(std::string("[cache]+.dat"), "[cache]+.dat"));
+    REQUIRE(!common::match_wildcard(std::string("axjpg"), "a?.jpg"));
+    REQUIRE(common::match_wildcard(std::string("c:\\data"), "c:\\*"));
+}
+
+TEST_CASE("wildcard_matches_regex_conversion", "wildcard") {
+    std::mt19937 rng(0x1234);
+    const char alphabet[] = { 'a', 'b', '.', 'A' };
+    const char pattern_alphabet[] = { 'a', 'b', '.', '*', '?' };
+
+    for (int i = 0; i < 2000; i++) {
+        std::string name;
+        std::string pattern;
+
+        for (std::uint32_t j = rng() % 8; j > 0; j--) {
+            name += alphabet[rng() % 4];
+        }
+
+        for (std::uint32_t j = rng() % 6; j > 0; j--) {
+            pattern += pattern_alphabet[rng() % 5];
+        }
+
+        const std::regex reference(common::wildcard_to_regex_string(pattern));
+        INFO(name << " ~ " << pattern);
+
+        REQUIRE(common::match_wildcard(name, pattern) == std::regex_match(common::lowercase_string(name), reference));
+    }
+}
+
+TEST_CASE("wildcard_directory_scan_benchmark", "[.benchmark]") {
+    static constexpr std::size_t ENTRY_COUNT = 5000;
+    static constexpr std::size_t SCAN_COUNT = 20;
+
+    std::vector<std::string> names;
+
+    for (std::size_t i = 0; i < ENTRY_COUNT; i++) {
+        names.push_back("Track_" + std::to_string(i) + ((i % 3 == 0) ? ".MP3" : ".jpg"));
+    }
+
+    const std::string pattern = "track_*.mp?";
+
+    std::size_t regex_matches = 0;
+    std::size_t wildcard_matches = 0;
+
+    // What directory opening and iterating used to do: build a regex, lowercase and match every name
+    const auto regex_start = std::chrono::steady_clock::now();
+
+    for (std::size_t scan = 0; scan < SCAN_COUNT; scan++) {
+        const std::regex filter(common::wildcard_to_regex_string(common::lowercase_string(pattern)));
+
+        for (const std::string &name : names) {
+            regex_matches += std::regex_match(common::lowercase_string(name), filter);
+        }
+    }
+
+    const auto regex_end = std::chrono::steady_clock::now();
+
+    for (std::size_t scan = 0; scan < SCAN_COUNT; scan++) {
+        for (const std::string &name : names) {
+            wildcard_matches += common::match_wildcard(name, pattern);
+        }
+    }
+
+    const auto wildcard_end = std::chrono::steady_clock::now();
+
+    REQUIRE(regex_matches == wildcard_matches);
+
+    std::cout << "Scanning " << ENTRY_COUNT << " names " << SCAN_COUNT << " times: regex "
+              << std::chrono::duration<double, std::milli>(regex_end - regex_start).count() << " ms, wildcard "
+              << std::chrono::duration<double, std::milli>(wildcard_end - regex_end).count() << " ms" << std::endl;
+}
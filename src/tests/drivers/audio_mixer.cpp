@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/audio/backend/null/audio_null.h>
+#include <drivers/audio/mixer.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+using namespace eka2l1;
+
+namespace {
+    // Source which produces a known sample for each frame and channel, and counts the frames pulled
+    struct ramp_source {
+        std::uint8_t channels;
+        std::size_t produced = 0;
+        std::size_t limit = static_cast<std::size_t>(-1);
+
+        explicit ramp_source(const std::uint8_t channels)
+            : channels(channels) {
+        }
+
+        static std::int16_t sample_at(const std::size_t frame, const std::uint8_t channel) {
+            return static_cast<std::int16_t>((frame * 97 + channel * 1000) % 20000);
+        }
+
+        std::size_t operator()(std::int16_t *buffer, const std::size_t frames) {
+            std::size_t i = 0;
+
+            for (; (i < frames) && (produced < limit); i++, produced++) {
+                for (std::uint8_t c = 0; c < channels; c++) {
+                    buffer[i * channels + c] = sample_at(produced, c);
+                }
+            }
+
+            return i;
+        }
+    };
+}
+
+TEST_CASE("audio_mixer_same_rate_volume_balance", "[audio_mixer]") {
+    drivers::null_audio_driver driver(48000);
+    ramp_source source(2);
+
+    auto stream = driver.new_output_stream(48000, 2, [&](std::int16_t *buffer, const std::size_t frames) {
+        return source(buffer, frames);
+    });
+
+    REQUIRE(stream);
+    REQUIRE(stream->set_volume(0.5f));
+    REQUIRE(stream->set_balance(0.5f));
+    REQUIRE(stream->start());
+
+    std::vector<std::int16_t> output(128 * 2);
+    REQUIRE(driver.get_mixer()->mix(output.data(), 128) == 128);
+
+    for (std::size_t i = 0; i < 128; i++) {
+        REQUIRE(output[i * 2] == static_cast<std::int16_t>(std::lrint(ramp_source::sample_at(i, 0) * 0.25f)));
+        REQUIRE(output[i * 2 + 1] == static_cast<std::int16_t>(std::lrint(ramp_source::sample_at(i, 1) * 0.5f)));
+    }
+
+    // One frame is read ahead, to interpolate against
+    REQUIRE(source.produced == 129);
+}
+
+TEST_CASE("audio_mixer_resample_mono_across_passes", "[audio_mixer]") {
+    drivers::null_audio_driver driver(48000);
+    ramp_source source(1);
+
+    auto stream = driver.new_output_stream(24000, 1, [&](std::int16_t *buffer, const std::size_t frames) {
+        return source(buffer, frames);
+    });
+
+    REQUIRE(stream);
+    REQUIRE(stream->start());
+
+    // Odd pass sizes, so the fractional position has to carry over between passes
+    std::vector<std::int16_t> output;
+    const std::size_t pass_sizes[] = { 7, 33, 1, 64, 15 };
+
+    for (const std::size_t pass_size : pass_sizes) {
+        std::vector<std::int16_t> pass(pass_size * 2);
+        driver.get_mixer()->mix(pass.data(), pass_size);
+        output.insert(output.end(), pass.begin(), pass.end());
+    }
+
+    const std::size_t total_frames = output.size() / 2;
+
+    for (std::size_t i = 0; i < total_frames; i++) {
+        // Odd output frames sit half way between two source frames
+        const float first = ramp_source::sample_at(i / 2, 0);
+        const float second = ramp_source::sample_at(i / 2 + 1, 0);
+        const float expected = (i & 1) ? (first + second) * 0.5f : first;
+
+        REQUIRE(output[i * 2] == static_cast<std::int16_t>(std::lrint(expected)));
+        REQUIRE(output[i * 2 + 1] == output[i * 2]);
+    }
+
+    // Never pull more than needed to interpolate the last frame
+    REQUIRE(source.produced <= total_frames / 2 + 2);
+}
+
+TEST_CASE("audio_mixer_drain_and_saturate", "[audio_mixer]") {
+    drivers::null_audio_driver driver(48000);
+
+    ramp_source short_source(2);
+    short_source.limit = 10;
+
+    std::size_t loud_calls = 0;
+
+    auto short_stream = driver.new_output_stream(48000, 2, [&](std::int16_t *buffer, const std::size_t frames) {
+        return short_source(buffer, frames);
+    });
+
+    auto loud_stream = driver.new_output_stream(48000, 2, [&](std::int16_t *buffer, const std::size_t frames) {
+        std::fill(buffer, buffer + frames * 2, static_cast<std::int16_t>(30000));
+        loud_calls++;
+        return frames;
+    });
+
+    auto loud_stream_2 = driver.new_output_stream(48000, 2, [&](std::int16_t *buffer, const std::size_t frames) {
+        std::fill(buffer, buffer + frames * 2, static_cast<std::int16_t>(30000));
+        return frames;
+    });
+
+    REQUIRE(short_stream->start());
+
+    std::vector<std::int16_t> output(32 * 2);
+    driver.get_mixer()->mix(output.data(), 32);
+
+    // Drained source is padded with silence and stops being pulled
+    REQUIRE(!short_stream->is_playing());
+    REQUIRE(output[9 * 2] == ramp_source::sample_at(9, 0));
+    REQUIRE(output[10 * 2] == 0);
+    REQUIRE(output[31 * 2 + 1] == 0);
+
+    // Two loud streams clip instead of wrapping around
+    REQUIRE(loud_stream->start());
+    REQUIRE(loud_stream_2->start());
+
+    driver.get_mixer()->mix(output.data(), 32);
+    REQUIRE(output[5 * 2] == 32767);
+
+    // A destroyed stream is never called again
+    loud_stream.reset();
+    driver.get_mixer()->mix(output.data(), 32);
+
+    REQUIRE(loud_calls == 1);
+    REQUIRE(output[5 * 2] == 30000);
+}
+
+TEST_CASE("audio_mixer_stop_from_callback", "[audio_mixer]") {
+    drivers::null_audio_driver driver(48000);
+    std::unique_ptr<drivers::audio_output_stream> stream;
+
+    stream = driver.new_output_stream(8000, 2, [&](std::int16_t *buffer, const std::size_t frames) {
+        std::fill(buffer, buffer + frames * 2, static_cast<std::int16_t>(100));
+        stream->stop();
+        return frames;
+    });
+
+    REQUIRE(stream->start());
+
+    std::vector<std::int16_t> output(64 * 2);
+    driver.get_mixer()->mix(output.data(), 64);
+
+    REQUIRE(!stream->is_playing());
+    REQUIRE(output[63 * 2] == 100);
+}
+
+TEST_CASE("audio_mixer_throughput", "[.benchmark]") {
+    static constexpr std::size_t STREAM_COUNT = 16;
+    static constexpr std::size_t PASS_FRAMES = 512;
+    static constexpr std::size_t SECONDS = 60;
+
+    drivers::null_audio_driver driver(48000);
+
+    std::vector<ramp_source> sources(STREAM_COUNT, ramp_source(2));
+    std::vector<std::unique_ptr<drivers::audio_output_stream>> streams;
+
+    for (std::size_t i = 0; i < STREAM_COUNT; i++) {
+        // Half of the streams need resampling, as most of the DSP streams do
+        const std::uint32_t rate = (i & 1) ? 44100 : 48000;
+
+        streams.push_back(driver.new_output_stream(rate, 2, [&sources, i](std::int16_t *buffer, const std::size_t frames) {
+            return sources[i](buffer, frames);
+        }));
+
+        streams.back()->set_volume(0.5f);
+        streams.back()->start();
+    }
+
+    std::vector<std::int16_t> output(PASS_FRAMES * 2);
+    const std::size_t pass_count = SECONDS * 48000 / PASS_FRAMES;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < pass_count; i++) {
+        driver.get_mixer()->mix(output.data(), PASS_FRAMES);
+    }
+
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Audio mixer: " << SECONDS << "s of " << STREAM_COUNT << " streams mixed in " << elapsed * 1000.0 << "ms" << std::endl;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/audio/backend/null/audio_null.h>
+#include <drivers/audio/backend/player_shared.h>
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+namespace {
+    // Player that "decodes" frames counting up from one, in chunks
+    struct counting_player : public drivers::player_shared {
+        static constexpr std::size_t CHUNK_FRAMES = 300;
+
+        std::size_t chunk_count;
+        std::size_t chunks_left;
+        std::int16_t next_value;
+
+        explicit counting_player(drivers::audio_driver *driver, const std::size_t chunk_count)
+            : drivers::player_shared(driver)
+            , chunk_count(chunk_count)
+            , chunks_left(chunk_count)
+            , next_value(1) {
+        }
+
+        ~counting_player() override {
+            stop_decode_worker();
+        }
+
+        void reset_request(drivers::player_request_instance &request) override {
+            chunks_left = chunk_count;
+            next_value = 1;
+        }
+
+        void get_more_data(drivers::player_request_instance &request) override {
+            if (chunks_left == 0) {
+                request->flags_ |= 1;
+                return;
+            }
+
+            chunks_left--;
+            request->data_.resize(CHUNK_FRAMES * request->channels_ * sizeof(std::int16_t));
+
+            std::int16_t *samples = reinterpret_cast<std::int16_t *>(request->data_.data());
+
+            for (std::size_t i = 0; i < CHUNK_FRAMES; i++, next_value++) {
+                for (std::uint32_t c = 0; c < request->channels_; c++) {
+                    samples[i * request->channels_ + c] = next_value;
+                }
+            }
+
+            request->data_pointer_ = 0;
+        }
+
+        bool queue_url(const std::string &url) override {
+            auto request = std::make_unique<drivers::player_request_base>();
+            request->type_ = drivers::player_request_format;
+            request->url_ = url;
+            request->freq_ = 48000;
+            request->channels_ = 1;
+
+            requests_.push(std::move(request));
+            return true;
+        }
+
+        bool queue_data(const char *raw_data, const std::size_t data_size,
+            const std::uint32_t encoding_type, const std::uint32_t frequency,
+            const std::uint32_t channels) override {
+            return false;
+        }
+    };
+}
+
+TEST_CASE("player_decode_ahead_plays_everything_in_order", "[player_shared]") {
+    static constexpr std::size_t CHUNK_COUNT = 20;
+
+    drivers::null_audio_driver driver(48000);
+    counting_player player(&driver, CHUNK_COUNT);
+
+    int done_count = 0;
+    std::uint8_t dummy = 0;
+
+    REQUIRE(player.queue_url("counting"));
+    REQUIRE(player.notify_any_done([&](std::uint8_t *) { done_count++; }, &dummy, 1));
+
+    // Full volume, so the mixer gives back exactly what was decoded
+    REQUIRE(player.set_volume(100));
+    player.set_decode_ahead_duration(20);
+    REQUIRE(player.play());
+
+    std::vector<std::int16_t> played;
+    std::vector<std::int16_t> pass(256 * 2);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    while ((done_count == 0) && (std::chrono::steady_clock::now() < deadline)) {
+        driver.get_mixer()->mix(pass.data(), 256);
+
+        // Drop silence from waiting on the worker, keep only the left channel
+        for (std::size_t i = 0; i < 256; i++) {
+            REQUIRE(pass[i * 2] == pass[i * 2 + 1]);
+
+            if (pass[i * 2] != 0) {
+                played.push_back(pass[i * 2]);
+            }
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    REQUIRE(done_count == 1);
+    REQUIRE(played.size() == CHUNK_COUNT * counting_player::CHUNK_FRAMES);
+
+    for (std::size_t i = 0; i < played.size(); i++) {
+        REQUIRE(played[i] == static_cast<std::int16_t>(i + 1));
+    }
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/driver.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+using namespace eka2l1;
+
+TEST_CASE("command_arguments_round_trip", "command_list") {
+    auto pool = std::make_shared<drivers::command_arena_pool>();
+    drivers::command_list list(pool);
+
+    const std::uint64_t handle = 0x100000005ULL;
+    const std::uint8_t payload[] = { 1, 2, 3, 4, 5 };
+    void *payload_copy = list.copy_data(payload, sizeof(payload));
+
+    list.add(drivers::make_command(list, 15, nullptr, handle, payload_copy, 32));
+    list.add(drivers::make_command(list, 16, nullptr));
+
+    drivers::command *cmd = list.first_;
+
+    REQUIRE(cmd->opcode_ == 15);
+    REQUIRE(cmd->size_ == sizeof(handle) + sizeof(void *) + sizeof(int));
+
+    drivers::command_helper helper(cmd);
+    std::uint64_t handle_popped = 0;
+    std::uint8_t *payload_popped = nullptr;
+    int bpp = 0;
+    std::uint64_t overflow = 0;
+
+    REQUIRE(helper.pop(handle_popped));
+    REQUIRE(helper.pop(payload_popped));
+    REQUIRE(helper.pop(bpp));
+    REQUIRE(!helper.pop(overflow));
+
+    REQUIRE(handle_popped == handle);
+    REQUIRE(bpp == 32);
+    REQUIRE(std::equal(payload, payload + sizeof(payload), payload_popped));
+
+    REQUIRE(cmd->next_->opcode_ == 16);
+    REQUIRE(cmd->next_->size_ == 0);
+    REQUIRE(cmd->next_->next_ == nullptr);
+
+    list.release();
+}
+
+TEST_CASE("command_arena_reuse_between_frames", "command_list") {
+    auto pool = std::make_shared<drivers::command_arena_pool>();
+    drivers::command_list list(pool);
+
+    for (int i = 0; i < 1000; i++) {
+        list.add(drivers::make_command(list, 0, nullptr, i, i * 2));
+    }
+
+    drivers::command_arena *first_arena = list.arena_;
+    const std::size_t first_capacity = first_arena->capacity();
+
+    drivers::command_list submitted = list.detach();
+    REQUIRE(list.first_ == nullptr);
+    REQUIRE(list.arena_ == nullptr);
+
+    submitted.release();
+
+    // Record the same amount again: arena should be recycled, without growing
+    for (int i = 0; i < 1000; i++) {
+        list.add(drivers::make_command(list, 0, nullptr, i, i * 2));
+    }
+
+    REQUIRE(list.arena_ == first_arena);
+    REQUIRE(list.arena_->capacity() == first_capacity);
+
+    list.release();
+}
+
+TEST_CASE("command_arena_big_payload", "command_list") {
+    drivers::command_arena arena;
+
+    void *small = arena.allocate(24);
+    REQUIRE(small != nullptr);
+
+    std::vector<std::uint8_t> big_data(drivers::COMMAND_ARENA_BLOCK_SIZE * 3, 0xCD);
+    std::uint8_t *copied = reinterpret_cast<std::uint8_t *>(arena.copy(big_data.data(), big_data.size()));
+
+    REQUIRE(std::equal(big_data.begin(), big_data.end(), copied));
+
+    void *small_after = arena.allocate(16);
+    REQUIRE(small_after != nullptr);
+    REQUIRE((reinterpret_cast<std::uintptr_t>(small_after) & (drivers::COMMAND_ARENA_ALIGNMENT - 1)) == 0);
+
+    // The dedicated block for the big payload should not be kept
+    arena.reset();
+    REQUIRE(arena.capacity() == drivers::COMMAND_ARENA_BLOCK_SIZE);
+}
+
+TEST_CASE("command_list_throughput", "[.benchmark]") {
+    static constexpr int FRAME_COUNT = 1000;
+    static constexpr int COMMAND_PER_FRAME = 4000;
+
+    auto pool = std::make_shared<drivers::command_arena_pool>();
+    std::uint64_t checksum = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        drivers::command_list list(pool);
+
+        for (int i = 0; i < COMMAND_PER_FRAME; i++) {
+            list.add(drivers::make_command(list, static_cast<std::uint16_t>(i & 0xF), nullptr,
+                static_cast<std::uint64_t>(i), frame, i, 0.5f));
+        }
+
+        for (drivers::command *cmd = list.first_; cmd; cmd = cmd->next_) {
+            checksum += cmd->opcode_;
+        }
+
+        list.release();
+    }
+
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Command list throughput: "
+              << static_cast<std::uint64_t>((FRAME_COUNT * static_cast<double>(COMMAND_PER_FRAME)) / elapsed)
+              << " commands/s (checksum " << checksum << ")" << std::endl;
+
+    REQUIRE(checksum != 0);
+}
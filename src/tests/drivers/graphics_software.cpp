@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/graphics/backend/software/graphics_software.h>
+#include <drivers/itc.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+using namespace eka2l1;
+
+namespace {
+    struct software_driver_runner {
+        std::unique_ptr<drivers::software_graphics_driver> driver;
+        std::thread runner;
+
+        explicit software_driver_runner(const int worker_count) {
+            driver = std::make_unique<drivers::software_graphics_driver>(worker_count);
+            runner = std::thread([this]() { driver->run(); });
+        }
+
+        ~software_driver_runner() {
+            driver->abort();
+            runner.join();
+        }
+
+        void submit_and_present(std::unique_ptr<drivers::graphics_command_list> &list,
+            std::unique_ptr<drivers::graphics_command_list_builder> &builder) {
+            int status = -100;
+            builder->present(&status);
+
+            driver->submit_command_list(*list);
+            driver->wait_for(&status);
+        }
+    };
+
+    std::uint32_t make_pixel(const std::uint32_t r, const std::uint32_t g, const std::uint32_t b, const std::uint32_t a) {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+}
+
+TEST_CASE("software_shade_span_matches_shader_math", "[drivers]") {
+    drivers::software_blend_state blend;
+    blend.enable = true;
+    blend.rgb_frag_out_factor = drivers::blend_factor::frag_out_alpha;
+    blend.rgb_current_factor = drivers::blend_factor::one_minus_frag_out_alpha;
+    blend.a_frag_out_factor = drivers::blend_factor::one;
+    blend.a_current_factor = drivers::blend_factor::one_minus_frag_out_alpha;
+
+    // Odd count so both the wide and the tail path are run
+    std::uint32_t source[7];
+    std::uint32_t mask[7];
+    std::uint32_t dest[7];
+
+    for (int i = 0; i < 7; i++) {
+        source[i] = make_pixel(255, 128, 0, 255);
+        mask[i] = (i & 1) ? 0xFFFFFFFF : 0;
+        dest[i] = make_pixel(0, 0, 255, 255);
+    }
+
+    drivers::software_shade_span(dest, source, mask, 7, 0xFFFFFFFF, false, blend);
+
+    for (int i = 0; i < 7; i++) {
+        // Masked out pixels turn into a fully transparent fragment, leaving the destination alone
+        REQUIRE(dest[i] == ((i & 1) ? make_pixel(255, 128, 0, 255) : make_pixel(0, 0, 255, 255)));
+    }
+
+    for (int i = 0; i < 7; i++) {
+        dest[i] = make_pixel(0, 0, 255, 255);
+    }
+
+    drivers::software_shade_span(dest, source, mask, 7, make_pixel(255, 255, 255, 128), true, blend);
+
+    for (int i = 0; i < 7; i++) {
+        // Inverted mask, half transparent brush: 128 * 255 + 127 * 0, 128 * 128 / 255, 127 * 255 / 255
+        REQUIRE(dest[i] == ((i & 1) ? make_pixel(0, 0, 255, 255) : make_pixel(128, 64, 127, 255)));
+    }
+}
+
+TEST_CASE("software_driver_golden_frame", "[drivers]") {
+    software_driver_runner runner(2);
+    drivers::graphics_driver *driver = runner.driver.get();
+
+    const drivers::handle bmp = drivers::create_bitmap(driver, { 2, 2 });
+    REQUIRE(bmp != 0);
+
+    // 32bpp bitmaps are uploaded as BGRA
+    const std::uint8_t texels[] = {
+        255, 0, 0, 255, 255, 255, 255, 128,
+        0, 0, 0, 255, 0, 0, 0, 0
+    };
+
+    auto list = driver->new_command_list();
+    auto builder = driver->new_command_builder(list.get());
+
+    builder->set_swapchain_size({ 8, 8 });
+    builder->update_bitmap(bmp, 32, reinterpret_cast<const char *>(texels), sizeof(texels), { 0, 0 }, { 2, 2 });
+    builder->clear({ 255, 0, 0, 255 }, drivers::clear_bit_color_buffer);
+    builder->set_brush_color_detail({ 0, 255, 0, 255 });
+    builder->draw_rectangle(eka2l1::rect({ 0, 0 }, { 4, 8 }));
+    builder->set_blend_mode(true);
+    builder->blend_formula(drivers::blend_equation::add, drivers::blend_equation::add, drivers::blend_factor::frag_out_alpha,
+        drivers::blend_factor::one_minus_frag_out_alpha, drivers::blend_factor::one, drivers::blend_factor::one_minus_frag_out_alpha);
+
+    // Scaled twice as big
+    builder->draw_bitmap(bmp, 0, eka2l1::rect({ 4, 0 }, { 4, 4 }), eka2l1::rect({ 0, 0 }, { 0, 0 }), 0);
+
+    eka2l1::rect clip({ 0, 6 }, { 8, 2 });
+    builder->set_invalidate(true);
+    builder->invalidate_rect(clip);
+    builder->clear({ 255, 255, 255, 255 }, drivers::clear_bit_color_buffer);
+
+    runner.submit_and_present(list, builder);
+
+    std::vector<std::uint32_t> frame;
+    eka2l1::vec2 frame_size;
+
+    REQUIRE(runner.driver->dump_presented_frame(frame, frame_size) == 1);
+    REQUIRE(frame_size == eka2l1::vec2(8, 8));
+
+    const auto pixel_at = [&](const int x, const int y) { return frame[y * 8 + x]; };
+
+    REQUIRE(pixel_at(0, 0) == make_pixel(0, 255, 0, 255));
+    REQUIRE(pixel_at(3, 5) == make_pixel(0, 255, 0, 255));
+    REQUIRE(pixel_at(4, 0) == make_pixel(0, 0, 255, 255));
+    REQUIRE(pixel_at(5, 1) == make_pixel(0, 0, 255, 255));
+    REQUIRE(pixel_at(6, 0) == make_pixel(255, 128, 128, 255));
+    REQUIRE(pixel_at(4, 2) == make_pixel(0, 0, 0, 255));
+    REQUIRE(pixel_at(7, 3) == make_pixel(255, 0, 0, 255));
+    REQUIRE(pixel_at(4, 4) == make_pixel(255, 0, 0, 255));
+    REQUIRE(pixel_at(0, 6) == make_pixel(255, 255, 255, 255));
+    REQUIRE(pixel_at(7, 7) == make_pixel(255, 255, 255, 255));
+}
+
+TEST_CASE("software_driver_ui_composite_throughput", "[.benchmark]") {
+    static constexpr int FRAME_COUNT = 500;
+    static constexpr int ICON_COUNT = 24;
+
+    const eka2l1::vec2 screen_size(640, 360);
+
+    // Everything on the driver thread, to see what one core can do
+    software_driver_runner runner(0);
+    drivers::graphics_driver *driver = runner.driver.get();
+
+    const drivers::handle wallpaper = drivers::create_bitmap(driver, screen_size);
+    const drivers::handle icon = drivers::create_bitmap(driver, { 48, 48 });
+    const drivers::handle icon_mask = drivers::create_bitmap(driver, { 48, 48 });
+
+    std::vector<std::uint32_t> wallpaper_data(screen_size.x * screen_size.y);
+    std::vector<std::uint32_t> icon_data(48 * 48);
+
+    for (std::size_t i = 0; i < wallpaper_data.size(); i++) {
+        wallpaper_data[i] = static_cast<std::uint32_t>(i * 2654435761U) | 0xFF000000;
+    }
+
+    for (std::size_t i = 0; i < icon_data.size(); i++) {
+        icon_data[i] = static_cast<std::uint32_t>(i * 40503U) | ((i & 1) ? 0x80000000 : 0xFF000000);
+    }
+
+    {
+        auto list = driver->new_command_list();
+        auto builder = driver->new_command_builder(list.get());
+
+        builder->set_swapchain_size(screen_size);
+        builder->update_bitmap(wallpaper, 32, reinterpret_cast<const char *>(wallpaper_data.data()), wallpaper_data.size() * 4,
+            { 0, 0 }, screen_size);
+        builder->update_bitmap(icon, 32, reinterpret_cast<const char *>(icon_data.data()), icon_data.size() * 4, { 0, 0 }, { 48, 48 });
+        builder->update_bitmap(icon_mask, 32, reinterpret_cast<const char *>(icon_data.data()), icon_data.size() * 4, { 0, 0 }, { 48, 48 });
+
+        runner.submit_and_present(list, builder);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        auto list = driver->new_command_list();
+        auto builder = driver->new_command_builder(list.get());
+
+        builder->set_blend_mode(false);
+        builder->draw_bitmap(wallpaper, 0, eka2l1::rect({ 0, 0 }, { 0, 0 }), eka2l1::rect({ 0, 0 }, { 0, 0 }), 0);
+
+        builder->set_blend_mode(true);
+        builder->blend_formula(drivers::blend_equation::add, drivers::blend_equation::add, drivers::blend_factor::frag_out_alpha,
+            drivers::blend_factor::one_minus_frag_out_alpha, drivers::blend_factor::one, drivers::blend_factor::one_minus_frag_out_alpha);
+
+        // Status pane, softkeys and a list highlight
+        builder->set_brush_color_detail({ 20, 40, 80, 200 });
+        builder->draw_rectangle(eka2l1::rect({ 0, 0 }, { 640, 40 }));
+        builder->draw_rectangle(eka2l1::rect({ 0, 320 }, { 640, 40 }));
+        builder->set_brush_color_detail({ 255, 255, 255, 96 });
+        builder->draw_rectangle(eka2l1::rect({ 8, 48 + (frame % 4) * 64 }, { 624, 60 }));
+
+        for (int i = 0; i < ICON_COUNT; i++) {
+            const eka2l1::vec2 pos(16 + (i % 8) * 78, 52 + (i / 8) * 88);
+
+            if (i & 1) {
+                builder->draw_bitmap(icon, icon_mask, eka2l1::rect(pos, { 64, 64 }), eka2l1::rect({ 0, 0 }, { 0, 0 }), 0);
+            } else {
+                builder->draw_bitmap(icon, 0, eka2l1::rect(pos, { 0, 0 }), eka2l1::rect({ 0, 0 }, { 0, 0 }), 0);
+            }
+        }
+
+        runner.submit_and_present(list, builder);
+    }
+
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Software rasterizer: " << static_cast<int>(FRAME_COUNT / elapsed) << " fps at 640x360 on one core" << std::endl;
+
+    std::vector<std::uint32_t> frame;
+    eka2l1::vec2 frame_size;
+
+    REQUIRE(runner.driver->dump_presented_frame(frame, frame_size) == FRAME_COUNT + 1);
+}
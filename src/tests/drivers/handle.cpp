@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/graphics/handle.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+TEST_CASE("reserve_handle_flags_and_reuse", "reserved_handle") {
+    drivers::reserved_handle_allocator allocator;
+
+    const drivers::handle bmp = allocator.reserve(true);
+    const drivers::handle tex = allocator.reserve(false);
+
+    REQUIRE(drivers::is_handle_reserved(bmp));
+    REQUIRE(drivers::is_handle_reserved(tex));
+    REQUIRE((bmp & drivers::HANDLE_BITMAP) != 0);
+    REQUIRE((tex & drivers::HANDLE_BITMAP) == 0);
+    REQUIRE(drivers::get_reserved_handle_index(bmp) != drivers::get_reserved_handle_index(tex));
+
+    allocator.free(bmp);
+
+    // The freed slot should be taken again
+    const drivers::handle again = allocator.reserve(false);
+    REQUIRE(drivers::get_reserved_handle_index(again) == drivers::get_reserved_handle_index(bmp));
+}
+
+TEST_CASE("reserve_handle_exhaust", "reserved_handle") {
+    drivers::reserved_handle_allocator allocator;
+
+    for (std::uint32_t i = 0; i < drivers::MAX_RESERVED_HANDLE; i++) {
+        REQUIRE(allocator.reserve(false) != 0);
+    }
+
+    REQUIRE(allocator.reserve(false) == 0);
+}
+
+TEST_CASE("reserve_handle_concurrent_unique", "reserved_handle") {
+    static constexpr int THREAD_COUNT = 4;
+    static constexpr int RESERVE_PER_THREAD = 2000;
+
+    drivers::reserved_handle_allocator allocator;
+    std::vector<drivers::handle> results[THREAD_COUNT];
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < RESERVE_PER_THREAD; j++) {
+                results[i].push_back(allocator.reserve(false));
+            }
+        });
+    }
+
+    for (auto &thr : threads) {
+        thr.join();
+    }
+
+    std::vector<drivers::handle> all;
+
+    for (auto &result : results) {
+        all.insert(all.end(), result.begin(), result.end());
+    }
+
+    std::sort(all.begin(), all.end());
+
+    REQUIRE(std::find(all.begin(), all.end(), 0) == all.end());
+    REQUIRE(std::adjacent_find(all.begin(), all.end()) == all.end());
+}
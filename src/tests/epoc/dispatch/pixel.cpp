@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <epoc/dispatch/pixel.h>
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace eka2l1;
+
+namespace {
+    // Ports of the screen driver loops (src/patch/scdv/src/drawdvc32.cpp), byte for byte
+    void guest_write_rgb(std::uint8_t *address, const std::uint8_t red, const std::uint8_t green, const std::uint8_t blue,
+        const std::uint8_t alpha, const dispatch::scdv_pixel_op op) {
+        switch (op) {
+        case dispatch::scdv_pixel_op_write:
+            address[0] = red;
+            address[1] = green;
+            address[2] = blue;
+            address[3] = alpha;
+            break;
+
+        case dispatch::scdv_pixel_op_and:
+            address[0] &= red;
+            address[1] &= green;
+            address[2] &= blue;
+            address[3] &= alpha;
+            break;
+
+        case dispatch::scdv_pixel_op_or:
+            address[0] |= red;
+            address[1] |= green;
+            address[2] |= blue;
+            address[3] |= alpha;
+            break;
+
+        case dispatch::scdv_pixel_op_xor:
+            address[0] ^= red;
+            address[1] ^= green;
+            address[2] ^= blue;
+            address[3] ^= alpha;
+            break;
+
+        case dispatch::scdv_pixel_op_not_screen:
+            for (int i = 0; i < 4; i++) {
+                address[i] = ~address[i];
+            }
+
+            break;
+
+        case dispatch::scdv_pixel_op_and_not:
+            address[0] = (~address[0]) & red;
+            address[1] = (~address[1]) & green;
+            address[2] = (~address[2]) & blue;
+            address[3] = (~address[3]) & alpha;
+            break;
+
+        case dispatch::scdv_pixel_op_blend: {
+            if (alpha == 255 || alpha == 0) {
+                guest_write_rgb(address, red, green, blue, 255, dispatch::scdv_pixel_op_write);
+                break;
+            }
+
+            std::uint32_t color_word = 0;
+            std::memcpy(&color_word, address, 4);
+
+            const std::uint32_t color24 = blue | (green << 8) | (red << 16);
+
+            std::uint32_t rb = (color_word & 0xFF00FF);
+            std::uint32_t g = (color_word & 0x00FF00);
+
+            rb += ((color24 & 0xff00ff) - rb) * alpha >> 8;
+            g += ((color24 & 0x00ff00) - g) * alpha >> 8;
+
+            color_word &= ~0xFFFFFF;
+            color_word |= ((rb & 0xff00ff) | (g & 0xff00)) | (0x01000000);
+
+            std::memcpy(address, &color_word, 4);
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    void guest_blend_mask(std::uint8_t *address, const std::uint32_t color, const std::uint8_t mask) {
+        std::uint32_t color_word = 0;
+        std::memcpy(&color_word, address, 4);
+
+        if (mask == 0) {
+            return;
+        }
+
+        if (mask == 255) {
+            color_word = color | 0xFF000000;
+        } else {
+            std::uint32_t rb = (color_word & 0xFF00FF);
+            std::uint32_t g = (color_word & 0x00FF00);
+
+            rb += ((color & 0xff00ff) - rb) * mask >> 8;
+            g += ((color & 0x00ff00) - g) * mask >> 8;
+
+            color_word = (rb & 0xff00ff) | (g & 0xff00) | 0xFF000000;
+        }
+
+        std::memcpy(address, &color_word, 4);
+    }
+
+    std::vector<std::uint32_t> make_random_pixels(std::mt19937 &rng, const std::size_t count) {
+        std::vector<std::uint32_t> pixels(count);
+
+        for (auto &pixel : pixels) {
+            pixel = static_cast<std::uint32_t>(rng());
+        }
+
+        // Make sure the special alphas come up
+        pixels[0] &= 0x00FFFFFF;
+        pixels[1] |= 0xFF000000;
+
+        return pixels;
+    }
+
+    // Odd length, so both the wide path and the tail are taken
+    constexpr std::size_t SPAN_LENGTH = 67;
+}
+
+TEST_CASE("scdv_fill_span_matches_guest", "[dispatch]") {
+    std::mt19937 rng(0x5CD7);
+
+    for (std::uint32_t op = dispatch::scdv_pixel_op_write; op <= dispatch::scdv_pixel_op_blend; op++) {
+        for (int round = 0; round < 16; round++) {
+            const std::vector<std::uint32_t> original = make_random_pixels(rng, SPAN_LENGTH);
+            std::uint32_t color = static_cast<std::uint32_t>(rng());
+
+            if (round == 0) {
+                color &= 0x00FFFFFF;
+            }
+
+            std::vector<std::uint32_t> expected = original;
+            std::vector<std::uint32_t> result = original;
+
+            for (auto &pixel : expected) {
+                guest_write_rgb(reinterpret_cast<std::uint8_t *>(&pixel), color & 0xFF, (color >> 8) & 0xFF,
+                    (color >> 16) & 0xFF, color >> 24, static_cast<dispatch::scdv_pixel_op>(op));
+            }
+
+            dispatch::scdv_fill_span(result.data(), SPAN_LENGTH, color, static_cast<dispatch::scdv_pixel_op>(op));
+            REQUIRE(result == expected);
+        }
+    }
+}
+
+TEST_CASE("scdv_write_span_matches_guest", "[dispatch]") {
+    std::mt19937 rng(0x11E);
+
+    for (std::uint32_t op = dispatch::scdv_pixel_op_write; op <= dispatch::scdv_pixel_op_blend; op++) {
+        const std::vector<std::uint32_t> original = make_random_pixels(rng, SPAN_LENGTH);
+        const std::vector<std::uint32_t> source = make_random_pixels(rng, SPAN_LENGTH);
+
+        std::vector<std::uint32_t> expected = original;
+        std::vector<std::uint32_t> result = original;
+
+        for (std::size_t i = 0; i < SPAN_LENGTH; i++) {
+            const std::uint8_t *source8 = reinterpret_cast<const std::uint8_t *>(&source[i]);
+            guest_write_rgb(reinterpret_cast<std::uint8_t *>(&expected[i]), source8[0], source8[1], source8[2], source8[3],
+                static_cast<dispatch::scdv_pixel_op>(op));
+        }
+
+        dispatch::scdv_write_span(result.data(), source.data(), SPAN_LENGTH, static_cast<dispatch::scdv_pixel_op>(op));
+        REQUIRE(result == expected);
+    }
+}
+
+TEST_CASE("scdv_blend_mask_span_matches_guest", "[dispatch]") {
+    std::mt19937 rng(0xB1E4D);
+
+    const std::vector<std::uint32_t> original = make_random_pixels(rng, SPAN_LENGTH);
+    const std::vector<std::uint32_t> source = make_random_pixels(rng, SPAN_LENGTH);
+    std::vector<std::uint8_t> mask(SPAN_LENGTH);
+
+    for (std::size_t i = 0; i < SPAN_LENGTH; i++) {
+        // Plenty of fully clear and fully set mask pixels, like anti-aliased glyphs have
+        const std::uint32_t value = rng() % 3;
+        mask[i] = (value == 0) ? 0 : ((value == 1) ? 0xFF : static_cast<std::uint8_t>(rng()));
+    }
+
+    const std::uint32_t color = 0x80C04020;
+
+    std::vector<std::uint32_t> expected_line = original;
+    std::vector<std::uint32_t> expected_multi = original;
+
+    for (std::size_t i = 0; i < SPAN_LENGTH; i++) {
+        guest_blend_mask(reinterpret_cast<std::uint8_t *>(&expected_line[i]), source[i], mask[i]);
+        guest_blend_mask(reinterpret_cast<std::uint8_t *>(&expected_multi[i]), color, mask[i]);
+    }
+
+    std::vector<std::uint32_t> result = original;
+    dispatch::scdv_blend_mask_span(result.data(), source.data(), 0, mask.data(), SPAN_LENGTH);
+    REQUIRE(result == expected_line);
+
+    result = original;
+    dispatch::scdv_blend_mask_span(result.data(), nullptr, color, mask.data(), SPAN_LENGTH);
+    REQUIRE(result == expected_multi);
+}
+
+TEST_CASE("scdv_map_colors_span_matches_guest", "[dispatch]") {
+    const std::uint32_t pairs[] = {
+        0xFF0000FF, 0xFF00FF00,
+        0xFFFFFFFF, 0x00000000,
+        0xFF0000FF, 0xFFFF0000
+    };
+
+    std::vector<std::uint32_t> original(SPAN_LENGTH);
+
+    for (std::size_t i = 0; i < SPAN_LENGTH; i++) {
+        const std::uint32_t choices[] = { 0xFF0000FF, 0xFFFFFFFF, 0x12345678 };
+        original[i] = choices[i % 3];
+    }
+
+    std::vector<std::uint32_t> expected = original;
+
+    for (auto &pixel : expected) {
+        // Every pair is checked against the pixel as it was read
+        const std::uint32_t read = pixel;
+
+        for (std::size_t pair = 0; pair < 3; pair++) {
+            if (read == pairs[pair * 2]) {
+                pixel &= pairs[pair * 2 + 1];
+            }
+        }
+    }
+
+    std::vector<std::uint32_t> result = original;
+    dispatch::scdv_map_colors_span(result.data(), SPAN_LENGTH, pairs, 3);
+
+    REQUIRE(result == expected);
+}
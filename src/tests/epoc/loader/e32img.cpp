@@ -18,7 +18,77 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <catch2/catch.hpp>
+
 #include <epoc/kernel/libmanager.h>
 #include <epoc/loader/e32img.h>
 
+#include <common/buffer.h>
 #include <epoc/vfs.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace eka2l1;
+
+static constexpr std::uint32_t E32IMG_SIGNATURE = 0x434F5045;
+
+TEST_CASE("header_only_probe_eka2", "e32img") {
+    loader::e32img_header header{};
+    header.uid1 = loader::e32_img_type::dll;
+    header.uid2 = 0x1000008D;
+    header.uid3 = 0x101F8774;
+    header.sig = E32IMG_SIGNATURE;
+    header.cpu = loader::e32_cpu::armv5;
+    header.code_size = 0x1200;
+    header.data_size = 0x40;
+    header.bss_size = 0x10;
+    header.code_base = 0x8000;
+    header.data_base = 0x400000;
+
+    // The rest would be compressed code, which the probe should never touch
+    std::vector<std::uint8_t> buf(sizeof(loader::e32img_header) + 64, 0xCD);
+    std::memcpy(buf.data(), &header, sizeof(loader::e32img_header));
+
+    common::ro_buf_stream stream(buf.data(), buf.size());
+
+    epocver ver = epocver::epoc6;
+    auto result = loader::parse_e32img_header(reinterpret_cast<common::ro_stream *>(&stream), &ver);
+
+    REQUIRE(result);
+    REQUIRE(ver == epocver::epoc94);
+    REQUIRE(result->uid1 == loader::e32_img_type::dll);
+    REQUIRE(result->uid3 == 0x101F8774);
+    REQUIRE(result->code_size == 0x1200);
+    REQUIRE(result->data_size == 0x40);
+    REQUIRE(result->bss_size == 0x10);
+    REQUIRE(result->data_base == 0x400000);
+}
+
+TEST_CASE("header_only_probe_eka1", "e32img") {
+    // uid1..3, check, signature, cpu, then two words skipped before the petran version
+    std::uint32_t words[32] = { 0x10000079, 0x1000008D, 0x100039CE, 0, E32IMG_SIGNATURE, 0x2000, 0, 0 };
+
+    // petran version, flags, code size
+    words[8] = 0;
+    words[9] = 1;
+    words[10] = 0x800;
+
+    common::ro_buf_stream stream(reinterpret_cast<std::uint8_t *>(words), sizeof(words));
+
+    epocver ver = epocver::epoc94;
+    auto result = loader::parse_e32img_header(reinterpret_cast<common::ro_stream *>(&stream), &ver);
+
+    REQUIRE(result);
+    REQUIRE(ver == epocver::epoc6);
+    REQUIRE(result->cpu == loader::e32_cpu::armv4);
+    REQUIRE(result->flags == 1);
+    REQUIRE(result->code_size == 0x800);
+}
+
+TEST_CASE("header_only_probe_not_e32img", "e32img") {
+    std::vector<std::uint8_t> buf(sizeof(loader::e32img_header), 0);
+    common::ro_buf_stream stream(buf.data(), buf.size());
+
+    REQUIRE(!loader::parse_e32img_header(reinterpret_cast<common::ro_stream *>(&stream)));
+}
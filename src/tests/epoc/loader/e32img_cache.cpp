@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <epoc/loader/e32img_cache.h>
+
+#include <common/fileutils.h>
+#include <common/path.h>
+
+#include <fstream>
+
+using namespace eka2l1;
+
+static loader::e32img make_cache_test_image() {
+    loader::e32img img{};
+
+    img.epoc_ver = epocver::epoc94;
+    img.header.uid1 = loader::e32_img_type::dll;
+    img.header.uid2 = 0x1000008D;
+    img.header.uid3 = 0x2000AFDE;
+    img.header.code_size = 0x40;
+    img.uncompressed_size = 0x80;
+
+    img.data.resize(0x80);
+
+    for (std::size_t i = 0; i < img.data.size(); i++) {
+        img.data[i] = static_cast<char>(i * 7);
+    }
+
+    img.ed.syms = { 0x8000, 0x8010, 0x8024 };
+
+    loader::e32img_import_block block;
+    block.dll_name_offset = 0x10;
+    block.number_of_imports = 2;
+    block.ordinals = { 5, 9 };
+    block.dll_name = "euser.dll";
+
+    img.import_section.size = 0x20;
+    img.import_section.imports.push_back(block);
+
+    loader::e32_reloc_entry reloc;
+    reloc.base = 0x1000;
+    reloc.size = 12;
+    reloc.rels_info = { 0x1004, 0x2008 };
+
+    img.code_reloc_section.size = 20;
+    img.code_reloc_section.num_relocs = 2;
+    img.code_reloc_section.entries.push_back(reloc);
+
+    img.dll_names = { "euser.dll" };
+    return img;
+}
+
+TEST_CASE("e32img_cache_round_trip", "e32img_cache") {
+    loader::e32img_cache cache("e32imgcache_round_trip");
+    loader::e32img img = make_cache_test_image();
+
+    REQUIRE(cache.store(u"C:\\sys\\bin\\round_trip.dll", 1234, img));
+
+    // Case of the path does not matter
+    auto result = cache.load(u"c:\\SYS\\bin\\ROUND_TRIP.dll", 1234, img.header);
+
+    REQUIRE(result);
+    REQUIRE(result->epoc_ver == epocver::epoc94);
+    REQUIRE(result->header.uid3 == 0x2000AFDE);
+    REQUIRE(result->header.code_size == 0x40);
+    REQUIRE(result->data == img.data);
+    REQUIRE(result->ed.syms == img.ed.syms);
+    REQUIRE(result->import_section.imports.size() == 1);
+    REQUIRE(result->import_section.imports[0].dll_name == "euser.dll");
+    REQUIRE(result->import_section.imports[0].ordinals == img.import_section.imports[0].ordinals);
+    REQUIRE(result->code_reloc_section.entries.size() == 1);
+    REQUIRE(result->code_reloc_section.entries[0].rels_info == img.code_reloc_section.entries[0].rels_info);
+    REQUIRE(result->data_reloc_section.entries.empty());
+    REQUIRE(result->dll_names == img.dll_names);
+}
+
+TEST_CASE("e32img_cache_stale_entry", "e32img_cache") {
+    loader::e32img_cache cache("e32imgcache_stale");
+    loader::e32img img = make_cache_test_image();
+
+    const std::u16string path = u"C:\\sys\\bin\\stale.dll";
+    REQUIRE(cache.store(path, 1234, img));
+
+    // Modified since
+    REQUIRE(!cache.load(path, 1235, img.header));
+
+    // Replaced by another image with the same name
+    loader::e32img_header other_header = img.header;
+    other_header.uid3 = 0x2000AFDF;
+
+    REQUIRE(!cache.load(path, 1234, other_header));
+    REQUIRE(!cache.load(u"C:\\sys\\bin\\never.dll", 1234, img.header));
+
+    // Rebuilt over the old entry
+    img.header.uid3 = 0x2000AFDF;
+    REQUIRE(cache.store(path, 1240, img));
+    REQUIRE(cache.load(path, 1240, other_header));
+}
+
+TEST_CASE("e32img_cache_corrupted_entry", "e32img_cache") {
+    const std::string cache_dir = "e32imgcache_corrupted";
+
+    loader::e32img_cache cache(cache_dir);
+    loader::e32img img = make_cache_test_image();
+
+    const std::u16string path = u"C:\\sys\\bin\\corrupted.dll";
+    REQUIRE(cache.store(path, 1234, img));
+
+    common::dir_iterator ite(cache_dir);
+    common::dir_entry entry;
+
+    std::string entry_path;
+
+    while (ite.next_entry(entry) == 0) {
+        if (eka2l1::path_extension(entry.name) == ".e32c") {
+            entry_path = eka2l1::add_path(cache_dir, eka2l1::filename(entry.name));
+        }
+    }
+
+    REQUIRE(!entry_path.empty());
+
+    {
+        // Flip a byte near the end, inside the parsed tables
+        std::fstream entry_file(entry_path, std::ios::in | std::ios::out | std::ios::binary);
+        entry_file.seekg(-48, std::ios::end);
+
+        char c = 0;
+        entry_file.read(&c, 1);
+
+        c ^= 0x5A;
+
+        entry_file.seekp(-48, std::ios::end);
+        entry_file.write(&c, 1);
+    }
+
+    REQUIRE(!cache.load(path, 1234, img.header));
+}
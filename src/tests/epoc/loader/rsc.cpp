@@ -24,8 +24,11 @@
 #include <common/buffer.h>
 #include <epoc/vfs.h>
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <sstream>
+#include <string>
 #include <vector>
 
 using namespace eka2l1;
@@ -146,3 +149,195 @@ TEST_CASE("no_compress_but_may_contain_unicode_3", "rsc_file") {
     REQUIRE(res_from_eka2l1.size() == res_size);
     REQUIRE(expected_res == res_from_eka2l1);
 }
+
+namespace {
+    // Writes bits from the least significant bit of each byte, like dictionary compressed streams
+    struct dictcomp_bit_writer {
+        std::vector<std::uint8_t> data;
+        int bits = 0;
+
+        void write(const std::uint32_t value, const int num_bits) {
+            for (int i = 0; i < num_bits; i++, bits++) {
+                if ((bits & 7) == 0) {
+                    data.push_back(0);
+                }
+
+                if (value & (1 << i)) {
+                    data.back() |= (1 << (bits & 7));
+                }
+            }
+        }
+
+        void write_dict_token(const int index, const int token_bits) {
+            write(1, 1);
+            write(index, token_bits);
+        }
+
+        void write_bytes(const std::string &bytes) {
+            for (std::size_t pos = 0; pos < bytes.size();) {
+                const int count = static_cast<int>(std::min<std::size_t>(bytes.size() - pos, 267));
+                const int following = count - 1;
+
+                write(0, 1);
+
+                if (following < 3) {
+                    write((1 << following) - 1, following + 1);
+                } else if (following < 11) {
+                    write(0b0111, 4);
+                    write(following - 3, 3);
+                } else {
+                    write(0b1111, 4);
+                    write(following - 11, 8);
+                }
+
+                for (int i = 0; i < count; i++) {
+                    write(static_cast<std::uint8_t>(bytes[pos + i]), 8);
+                }
+
+                pos += count;
+            }
+        }
+    };
+
+    struct dictcomp_entry {
+        std::vector<int> tokens; ///< Dictionary index, or -1 to write the next literal.
+        std::vector<std::string> literals;
+    };
+
+    void write_dictcomp_section(const std::vector<dictcomp_entry> &entries, const int token_bits,
+        dictcomp_bit_writer &writer, std::vector<std::uint16_t> &index) {
+        for (const dictcomp_entry &entry : entries) {
+            std::size_t literal = 0;
+
+            for (const int token : entry.tokens) {
+                if (token < 0) {
+                    writer.write_bytes(entry.literals[literal++]);
+                } else {
+                    writer.write_dict_token(token, token_bits);
+                }
+            }
+
+            index.push_back(static_cast<std::uint16_t>(writer.bits));
+        }
+    }
+
+    std::vector<std::uint8_t> make_dictcomp_rsc(const std::vector<dictcomp_entry> &dict, const std::vector<dictcomp_entry> &resources,
+        const int token_bits, const std::uint16_t largest_size) {
+        dictcomp_bit_writer dict_writer;
+        dictcomp_bit_writer res_writer;
+
+        std::vector<std::uint16_t> dict_index;
+        std::vector<std::uint16_t> res_index;
+
+        write_dictcomp_section(dict, token_bits, dict_writer, dict_index);
+        write_dictcomp_section(resources, token_bits, res_writer, res_index);
+
+        std::vector<std::uint8_t> file(21, 0);
+        auto append_u16 = [&](const std::uint16_t value) {
+            file.push_back(static_cast<std::uint8_t>(value & 0xFF));
+            file.push_back(static_cast<std::uint8_t>(value >> 8));
+        };
+
+        const std::uint32_t uid1 = 0x101F5010;
+        std::memcpy(&file[0], &uid1, sizeof(uid1));
+
+        file[16] = static_cast<std::uint8_t>(token_bits - 3);
+        std::memcpy(&file[17], &largest_size, sizeof(largest_size));
+
+        // No resource has compressed unicode
+        file.resize(file.size() + (resources.size() + 7) / 8, 0);
+        file.insert(file.end(), dict_writer.data.begin(), dict_writer.data.end());
+
+        for (const std::uint16_t end_bits : dict_index) {
+            append_u16(end_bits);
+        }
+
+        const std::uint16_t res_offset = static_cast<std::uint16_t>(file.size());
+        std::memcpy(&file[19], &res_offset, sizeof(res_offset));
+
+        file.insert(file.end(), res_writer.data.begin(), res_writer.data.end());
+
+        for (const std::uint16_t end_bits : res_index) {
+            append_u16(end_bits);
+        }
+
+        return file;
+    }
+
+    struct dictcomp_sample {
+        std::vector<std::uint8_t> file;
+        std::vector<std::string> expected;
+    };
+
+    dictcomp_sample make_dictcomp_sample() {
+        std::string long_text;
+
+        for (int i = 0; i < 300; i++) {
+            long_text += static_cast<char>('A' + (i * 7) % 26);
+        }
+
+        const std::string twenty = "twenty bytes of text";
+
+        // Entry 2 expands to other entries
+        const std::vector<dictcomp_entry> dict = {
+            { { -1 }, { "Hello" } },
+            { { -1 }, { " world" } },
+            { { 0, 1 }, {} },
+            { { -1 }, { twenty } },
+            { { -1 }, { "four" } }
+        };
+
+        const std::vector<dictcomp_entry> resources = {
+            { { 2, -1 }, { "!" } },
+            { { -1 }, { long_text } },
+            { { 3, 4, 0 }, {} },
+            { { -1, 2, -1, 1 }, { "a", "xy" } }
+        };
+
+        dictcomp_sample sample;
+        sample.expected = { "Hello world!", long_text, twenty + "fourHello", "aHello worldxy world" };
+        sample.file = make_dictcomp_rsc(dict, resources, 5, 300);
+
+        return sample;
+    }
+}
+
+TEST_CASE("dictionary_compressed", "rsc_file") {
+    dictcomp_sample sample = make_dictcomp_sample();
+
+    common::ro_buf_stream stream(&sample.file[0], sample.file.size());
+    loader::rsc_file test_rsc(reinterpret_cast<common::ro_stream *>(&stream));
+
+    REQUIRE(test_rsc.get_total_resources() == sample.expected.size());
+
+    for (int i = 1; i <= static_cast<int>(sample.expected.size()); i++) {
+        const std::vector<std::uint8_t> res = test_rsc.read(i);
+        REQUIRE(std::string(res.begin(), res.end()) == sample.expected[i - 1]);
+    }
+}
+
+TEST_CASE("cached_resources_stay_in_budget", "rsc_file") {
+    dictcomp_sample sample = make_dictcomp_sample();
+
+    common::ro_buf_stream stream(&sample.file[0], sample.file.size());
+    loader::rsc_file test_rsc(reinterpret_cast<common::ro_stream *>(&stream), 32);
+
+    // The long resource does not fit, the rest are kept until they exceed the budget
+    for (int round = 0; round < 2; round++) {
+        for (int i = 1; i <= static_cast<int>(sample.expected.size()); i++) {
+            const std::vector<std::uint8_t> res = test_rsc.read(i);
+
+            REQUIRE(std::string(res.begin(), res.end()) == sample.expected[i - 1]);
+            REQUIRE(test_rsc.get_cache_size() <= 32);
+        }
+    }
+
+    REQUIRE(test_rsc.get_cache_size() > 0);
+
+    test_rsc.set_cache_budget(0);
+    REQUIRE(test_rsc.get_cache_size() == 0);
+
+    const std::vector<std::uint8_t> res = test_rsc.read(3);
+    REQUIRE(std::string(res.begin(), res.end()) == sample.expected[2]);
+    REQUIRE(test_rsc.get_cache_size() == 0);
+}
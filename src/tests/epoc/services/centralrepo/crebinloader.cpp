@@ -52,4 +52,45 @@ TEST_CASE("generic_cre_loading", "centralrepo") {
     REQUIRE(repo.uid == 0x101F876F);
     REQUIRE(repo.entries.size() == 19);
     REQUIRE(repo.single_policies.size() == 19);
-}
\ No newline at end of file
+}
+TEST_CASE("cre_journal_replay", "centralrepo") {
+    central_repo repo;
+    repo.default_meta = 0;
+
+    central_repo_entry_variant var;
+    var.etype = central_repo_entry_type::integer;
+
+    for (std::uint32_t key = 30; key > 0; key -= 3) {
+        var.intd = key;
+        REQUIRE(repo.add_new_entry(key, var));
+    }
+
+    std::vector<std::uint8_t> journal;
+
+    central_repo_entry changed = *repo.find_entry(12);
+    changed.data.intd = 1200;
+    append_cre_journal_record(journal, changed);
+
+    central_repo_entry added;
+    added.key = 50;
+    added.metadata_val = 7;
+    added.data.etype = central_repo_entry_type::string;
+    added.data.strd = "Hello";
+    append_cre_journal_record(journal, added);
+
+    // Interrupted write of another change
+    std::vector<std::uint8_t> torn;
+    append_cre_journal_record(torn, changed);
+    journal.insert(journal.end(), torn.begin(), torn.begin() + torn.size() / 2);
+
+    REQUIRE(apply_cre_journal(journal.data(), journal.size(), repo) == 2);
+    REQUIRE(repo.find_entry(12)->data.intd == 1200);
+    REQUIRE(repo.find_entry(50));
+    REQUIRE(repo.find_entry(50)->data.strd == "Hello");
+    REQUIRE(repo.find_entry(50)->metadata_val == 7);
+
+    // Lookups stay sorted
+    for (std::size_t i = 1; i < repo.entries.size(); i++) {
+        REQUIRE(repo.entries[i - 1].key < repo.entries[i].key);
+    }
+}
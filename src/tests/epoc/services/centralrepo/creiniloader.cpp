@@ -20,6 +20,7 @@
 
 #include <catch2/catch.hpp>
 #include <epoc/services/centralrepo/centralrepo.h>
+#include <epoc/services/centralrepo/compiled.h>
 
 #include <iostream>
 
@@ -60,4 +61,34 @@ TEST_CASE("ini_loader_meta_default_and_range", "centralrepo") {
 
     REQUIRE(e1->metadata_val == 10);
     REQUIRE(e2->metadata_val == 12);
-}
\ No newline at end of file
+}
+TEST_CASE("ini_compiled_cache_round_trip", "centralrepo") {
+    central_repo repo;
+    repo.uid = 0xEFFF0001;
+
+    REQUIRE(parse_new_centrep_ini("centralrepoassets/EFFF0001.ini", repo));
+
+    compiled_repo_cache cache("centralrepocompiled");
+    REQUIRE(cache.store(u"centralrepoassets/EFFF0001.ini", repo));
+
+    central_repo loaded;
+    REQUIRE(cache.load(u"centralrepoassets/EFFF0001.ini", loaded));
+    REQUIRE(loaded.entries.size() == repo.entries.size());
+    REQUIRE(loaded.meta_range.size() == repo.meta_range.size());
+    REQUIRE(loaded.default_meta == repo.default_meta);
+
+    for (std::size_t i = 0; i < repo.entries.size(); i++) {
+        REQUIRE(loaded.entries[i].key == repo.entries[i].key);
+        REQUIRE(loaded.entries[i].metadata_val == repo.entries[i].metadata_val);
+        REQUIRE(loaded.entries[i].data.etype == repo.entries[i].data.etype);
+    }
+
+    central_repo_entry *e2 = loaded.find_entry(0x42);
+
+    REQUIRE(e2);
+    REQUIRE(e2->metadata_val == 12);
+
+    // Another INI must not pick up this entry
+    central_repo other;
+    REQUIRE_FALSE(cache.load(u"centralrepoassets/EFFF0000.ini", other));
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <epoc/services/centralrepo/repo.h>
+
+#include <catch2/catch.hpp>
+
+using namespace eka2l1;
+
+static epoc::notify_info make_notify_info(const eka2l1::address sts) {
+    epoc::notify_info info;
+    info.sts = sts;
+    info.requester = nullptr;
+
+    return info;
+}
+
+TEST_CASE("find_entries_masked_range", "centralrepo") {
+    central_repo repo;
+    repo.default_meta = 0;
+
+    central_repo_entry_variant var;
+    var.etype = central_repo_entry_type::integer;
+    var.intd = 0;
+
+    const std::uint32_t keys[] = { 0x07B10B52, 0x02B30B11, 0x03B10001, 0x07B20B52, 0x00000005, 0xFFB10000 };
+
+    for (const std::uint32_t key : keys) {
+        REQUIRE(repo.add_new_entry(key, var));
+    }
+
+    std::vector<central_repo_entry *> matched;
+    repo.find_entries(0x07B10000, 0xFFFF0000, matched);
+
+    REQUIRE(matched.size() == 1);
+    REQUIRE(matched[0]->key == 0x07B10B52);
+
+    // Mask with a hole in it, the range only narrows on the leading bits
+    matched.clear();
+    repo.find_entries(0x03B10000, 0xF0FF0000, matched);
+
+    REQUIRE(matched.size() == 2);
+    REQUIRE(matched[0]->key == 0x03B10001);
+    REQUIRE(matched[1]->key == 0x07B10B52);
+
+    // No leading bits, every key is walked
+    matched.clear();
+    repo.find_entries(0x00B10000, 0x00FF0000, matched);
+
+    REQUIRE(matched.size() == 3);
+    REQUIRE(matched[2]->key == 0xFFB10000);
+
+    matched.clear();
+    repo.find_entries(0, 0, matched);
+
+    REQUIRE(matched.size() == 6);
+}
+
+TEST_CASE("notify_index_collects_matching_requests_only", "centralrepo") {
+    central_repo_notify_index index;
+
+    auto *client1 = reinterpret_cast<central_repo_client_subsession *>(0x1000);
+    auto *client2 = reinterpret_cast<central_repo_client_subsession *>(0x2000);
+
+    epoc::notify_info info1 = make_notify_info(0x100);
+    epoc::notify_info info2 = make_notify_info(0x200);
+    epoc::notify_info info3 = make_notify_info(0x300);
+
+    index.add(client1, info1, 0xFFFFFFFF, 0x12);
+    index.add(client2, info2, 0xFFFFFF00, 0x1234);
+    index.add(client2, info3, 0xFFFFFFFF, 0x13);
+
+    REQUIRE(index.exists(client1, 0xFFFFFFFF, 0x12));
+    REQUIRE_FALSE(index.exists(client2, 0xFFFFFFFF, 0x12));
+
+    std::vector<central_repo_notify_request> matched;
+    index.collect(0x1255, matched);
+
+    REQUIRE(matched.size() == 1);
+    REQUIRE(matched[0].owner == client2);
+    REQUIRE(matched[0].sts.sts.ptr_address() == 0x200);
+
+    // Requests complete only once
+    matched.clear();
+    index.collect(0x1255, matched);
+
+    REQUIRE(matched.empty());
+
+    std::vector<central_repo_notify_request> removed;
+    index.remove(client2, 0, 0, removed);
+
+    REQUIRE(removed.size() == 1);
+    REQUIRE(removed[0].sts.sts.ptr_address() == 0x300);
+
+    index.collect(0x12, matched);
+
+    REQUIRE(matched.size() == 1);
+    REQUIRE(matched[0].owner == client1);
+    REQUIRE(index.empty());
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <epoc/services/fs/notify.h>
+
+#include <catch2/catch.hpp>
+
+using namespace eka2l1;
+
+static constexpr std::uint32_t NOTIFY_ENTRY = 1;
+static constexpr std::uint32_t NOTIFY_WRITE = 0x20;
+
+static epoc::fs::notify_entry make_notify_entry(const std::u16string &pattern, const std::uint32_t type, const std::uint32_t owner,
+    const eka2l1::address sts) {
+    epoc::fs::notify_entry entry;
+    entry.match_pattern = pattern;
+    entry.type_mask = type;
+    entry.info.sts = sts;
+    entry.info.requester = nullptr;
+    entry.owner = owner;
+
+    return entry;
+}
+
+TEST_CASE("notify_trie_match_by_path_prefix", "[fs_notify]") {
+    epoc::fs::notify_trie trie;
+    std::u16string node_path;
+
+    REQUIRE(trie.add(make_notify_entry(u"C:\\Data\\Images\\", NOTIFY_ENTRY, 1, 0x100), &node_path));
+    REQUIRE(node_path == u"c:\\data\\images");
+
+    // Second request under the same directory does not need a new watch
+    REQUIRE(!trie.add(make_notify_entry(u"c:\\DATA\\images\\*.jpg", NOTIFY_ENTRY, 1, 0x104)));
+    REQUIRE(trie.add(make_notify_entry(u"c:\\Data\\Sounds\\*.mp3", NOTIFY_ENTRY | NOTIFY_WRITE, 2, 0x108)));
+    REQUIRE(trie.add(make_notify_entry(u"*", NOTIFY_WRITE, 3, 0x10C), &node_path));
+    REQUIRE(node_path.empty());
+    REQUIRE(trie.size() == 4);
+
+    std::vector<epoc::fs::notify_entry> matched;
+    std::vector<std::u16string> emptied;
+
+    // Wrong type, nothing changes
+    trie.collect(u"C:\\Data\\Images\\cat.png", NOTIFY_WRITE << 1, matched, &emptied);
+    REQUIRE(matched.empty());
+
+    trie.collect(u"C:\\Data\\Images\\cat.png", NOTIFY_ENTRY, matched, &emptied);
+    REQUIRE(matched.size() == 1);
+    REQUIRE(matched[0].info.sts.ptr_address() == 0x100);
+    REQUIRE(emptied.empty());
+
+    // Subdirectories are under the trailing separator too
+    matched.clear();
+    trie.collect(u"C:\\Data\\Images\\Trip\\dog.JPG", NOTIFY_ENTRY, matched, &emptied);
+    REQUIRE(matched.size() == 1);
+    REQUIRE(matched[0].info.sts.ptr_address() == 0x104);
+    REQUIRE(emptied.size() == 1);
+    REQUIRE(emptied[0] == u"c:\\data\\images");
+
+    matched.clear();
+    emptied.clear();
+    trie.collect(u"C:\\Data\\Sounds\\beep.mp3", NOTIFY_WRITE, matched, &emptied);
+    REQUIRE(matched.size() == 2);
+    REQUIRE(emptied.size() == 2);
+    REQUIRE(trie.size() == 0);
+}
+
+TEST_CASE("notify_trie_remove_by_session", "[fs_notify]") {
+    epoc::fs::notify_trie trie;
+
+    trie.add(make_notify_entry(u"c:\\private\\", NOTIFY_ENTRY, 1, 0x100));
+    trie.add(make_notify_entry(u"c:\\private\\1000\\", NOTIFY_ENTRY, 1, 0x104));
+    trie.add(make_notify_entry(u"c:\\private\\1000\\", NOTIFY_ENTRY, 2, 0x108));
+    trie.add(make_notify_entry(u"e:\\", NOTIFY_ENTRY, 1, 0x10C));
+
+    std::vector<epoc::fs::notify_entry> removed;
+    std::vector<std::u16string> emptied;
+
+    trie.remove(1, 0x104, removed, &emptied);
+    REQUIRE(removed.size() == 1);
+    REQUIRE(emptied.empty());
+
+    removed.clear();
+    trie.remove(1, 0, removed, &emptied);
+    REQUIRE(removed.size() == 2);
+    REQUIRE(emptied.size() == 2);
+    REQUIRE(trie.size() == 1);
+
+    // What is left is still reachable after pruning
+    std::vector<epoc::fs::notify_entry> matched;
+    trie.collect(u"c:\\private\\1000\\settings.ini", NOTIFY_ENTRY, matched);
+    REQUIRE(matched.size() == 1);
+    REQUIRE(matched[0].owner == 2);
+    REQUIRE(trie.size() == 0);
+}
@@ -1,9 +1,17 @@
 #include <catch2/catch.hpp>
 #include <common/algorithm.h>
+#include <common/cvt.h>
+#include <common/fileutils.h>
 #include <common/path.h>
 #include <common/types.h>
+#include <epoc/loader/rom.h>
 #include <epoc/vfs.h>
 
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
 struct io_scope_guard {
     eka2l1::io_system *io;
 
@@ -40,3 +48,283 @@ TEST_CASE("get_physical", "vfs") {
 
     REQUIRE(eka2l1::common::compare_ignore_case(*actual_path_b, std::u16string(u"drive_b") + static_cast<char16_t>(eka2l1::get_separator()) + u"despacito3leak") == 0);
 }
+
+static void create_host_file(const std::string &path) {
+    FILE *f = fopen(path.c_str(), "wb");
+    REQUIRE(f);
+    fclose(f);
+}
+
+TEST_CASE("resolve_cached_host_path", "vfs") {
+    eka2l1::io_system io;
+    io_scope_guard guard(io);
+
+    eka2l1::create_directories("drive_cache/Sys/Bin");
+    create_host_file("drive_cache/Sys/Bin/MyApp.exe");
+
+    io.mount_physical_path(drive_number::drive_c, drive_media::physical, io_attrib::internal,
+        u"drive_cache");
+
+    // Guest lookups ignore case, the host path keeps the casing on disk
+    REQUIRE(io.exist(u"C:\\sys\\bin\\myapp.EXE"));
+    REQUIRE(io.is_directory(u"C:\\SYS\\BIN\\"));
+    REQUIRE(!io.exist(u"C:\\sys\\bin\\other.exe"));
+
+    const auto raw_path = io.get_raw_path(u"C:\\sys\\bin\\myapp.exe");
+
+    REQUIRE(raw_path);
+    const char16_t sep = static_cast<char16_t>(eka2l1::get_separator());
+    REQUIRE(raw_path->find(std::u16string(u"Sys") + sep + u"Bin" + sep + u"MyApp.exe") != std::u16string::npos);
+
+    // Entries made on the host after the directory got indexed are still found
+    create_host_file("drive_cache/Sys/Bin/other.exe");
+    REQUIRE(io.exist(u"C:\\sys\\bin\\other.exe"));
+
+    // Our own renames and deletes are seen right away
+    REQUIRE(io.rename(u"C:\\sys\\bin\\myapp.exe", u"C:\\sys\\bin\\renamed.exe"));
+    REQUIRE(!io.exist(u"C:\\sys\\bin\\myapp.exe"));
+    REQUIRE(io.exist(u"C:\\sys\\bin\\renamed.exe"));
+
+    REQUIRE(io.delete_entry(u"C:\\sys\\bin\\renamed.exe"));
+    REQUIRE(io.delete_entry(u"C:\\sys\\bin\\other.exe"));
+    REQUIRE(!io.exist(u"C:\\sys\\bin\\renamed.exe"));
+    REQUIRE(!io.get_entry_info(u"C:\\sys\\bin\\other.exe"));
+
+    REQUIRE(io.delete_entry(u"C:\\sys\\bin\\"));
+    REQUIRE(io.delete_entry(u"C:\\sys\\"));
+    REQUIRE(!io.exist(u"C:\\sys\\bin\\"));
+
+    eka2l1::common::remove("drive_cache/");
+}
+
+TEST_CASE("physical_file_read_write_at_offset", "vfs") {
+    eka2l1::io_system io;
+    io_scope_guard guard(io);
+
+    eka2l1::create_directories("drive_rw");
+    io.mount_physical_path(drive_number::drive_c, drive_media::physical, io_attrib::internal,
+        u"drive_rw");
+
+    std::vector<std::uint8_t> data(5000);
+
+    for (std::size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<std::uint8_t>(i * 7);
+    }
+
+    {
+        eka2l1::symfile f = io.open_file(u"C:\\data.bin", WRITE_MODE | BIN_MODE);
+        REQUIRE(f);
+
+        REQUIRE(f->write_file(data.data(), 1, 3000) == 3000);
+        REQUIRE(f->size() == 3000);
+
+        // Overwrite part of the tail and grow the file
+        f->seek(2000, eka2l1::file_seek_mode::beg);
+        REQUIRE(f->write_file(data.data() + 2000, 1, 3000) == 3000);
+        REQUIRE(f->size() == 5000);
+        REQUIRE(f->tell() == 5000);
+
+        f->close();
+    }
+
+    eka2l1::symfile f = io.open_file(u"C:\\data.bin", READ_MODE | BIN_MODE);
+    REQUIRE(f);
+    REQUIRE(f->size() == 5000);
+
+    std::vector<std::uint8_t> readback(5000);
+
+    // Reading at an offset leaves the cursor alone
+    REQUIRE(f->read_file(1000, readback.data(), 1, 500) == 500);
+    REQUIRE(std::equal(readback.begin(), readback.begin() + 500, data.begin() + 1000));
+    REQUIRE(f->tell() == 0);
+
+    f->seek(-100, eka2l1::file_seek_mode::end);
+    REQUIRE(f->read_file(readback.data(), 1, 1000) == 100);
+    REQUIRE(std::equal(readback.begin(), readback.begin() + 100, data.end() - 100));
+    REQUIRE(!f->valid());
+
+    f->close();
+
+    REQUIRE(io.delete_entry(u"C:\\data.bin"));
+    eka2l1::common::remove("drive_rw/");
+}
+
+TEST_CASE("physical_file_sequential_read_benchmark", "[.benchmark]") {
+    eka2l1::io_system io;
+    io_scope_guard guard(io);
+
+    eka2l1::create_directories("drive_bench");
+    io.mount_physical_path(drive_number::drive_c, drive_media::physical, io_attrib::internal,
+        u"drive_bench");
+
+    static constexpr std::size_t FILE_SIZE = 64 * 1024 * 1024;
+    static constexpr std::size_t CHUNK_SIZE = 16 * 1024;
+
+    {
+        std::vector<std::uint8_t> junk(1024 * 1024, 0x5A);
+        eka2l1::symfile f = io.open_file(u"C:\\stream.bin", WRITE_MODE | BIN_MODE);
+        REQUIRE(f);
+
+        for (std::size_t i = 0; i < FILE_SIZE / junk.size(); i++) {
+            f->write_file(junk.data(), 1, static_cast<std::uint32_t>(junk.size()));
+        }
+
+        f->close();
+    }
+
+    eka2l1::symfile f = io.open_file(u"C:\\stream.bin", READ_MODE | BIN_MODE);
+    REQUIRE(f);
+
+    std::vector<std::uint8_t> chunk(CHUNK_SIZE);
+    std::uint64_t total = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Same pattern as the file server's read: seek to the position, clamp to the size, read.
+    for (std::uint64_t pos = 0; pos < FILE_SIZE; pos += CHUNK_SIZE) {
+        f->seek(pos, eka2l1::file_seek_mode::beg);
+
+        const std::uint64_t left = f->size() - pos;
+        total += f->read_file(chunk.data(), 1, static_cast<std::uint32_t>(std::min<std::uint64_t>(left, CHUNK_SIZE)));
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    const double secs = std::chrono::duration<double>(end - start).count();
+
+    REQUIRE(total == FILE_SIZE);
+    std::cout << "Sequential read of " << (FILE_SIZE >> 20) << " MiB in " << CHUNK_SIZE << " byte chunks: "
+              << (static_cast<double>(FILE_SIZE) / (1024.0 * 1024.0)) / secs << " MiB/s" << std::endl;
+
+    f->close();
+
+    REQUIRE(io.delete_entry(u"C:\\stream.bin"));
+    eka2l1::common::remove("drive_bench/");
+}
+
+TEST_CASE("directory_bulk_enumeration", "vfs") {
+    eka2l1::io_system io;
+    io_scope_guard guard(io);
+
+    eka2l1::create_directories("drive_list/photos/album");
+
+    for (int i = 0; i < 10; i++) {
+        FILE *f = fopen(("drive_list/photos/IMG_" + std::to_string(i) + ".jpg").c_str(), "wb");
+        REQUIRE(f);
+        fwrite("abcdefgh", 1, i, f);
+        fclose(f);
+    }
+
+    create_host_file("drive_list/photos/notes.txt");
+
+    io.mount_physical_path(drive_number::drive_c, drive_media::physical, io_attrib::internal,
+        u"drive_list");
+
+    auto dir = io.open_dir(u"C:\\photos\\img_*.JPG", io_attrib::include_file | io_attrib::include_dir);
+    REQUIRE(dir);
+
+    // A peeked entry must still come out first
+    const auto peeked = dir->peek_next_entry();
+    REQUIRE(peeked);
+
+    eka2l1::entry_batch batch;
+    std::size_t total = 0;
+    bool found_peeked = false;
+
+    while (dir->get_next_entries(batch, 4) != 0) {
+        REQUIRE(batch.entries.size() <= 4);
+
+        for (const eka2l1::packed_entry_info &info : batch.entries) {
+            const std::u16string name(batch.name_of(info), info.name_length);
+            const std::size_t number = std::stoi(eka2l1::common::ucs2_to_utf8(name.substr(4)));
+
+            REQUIRE(info.type == eka2l1::io_component_type::file);
+            REQUIRE(info.size == number);
+
+            if (total == 0) {
+                found_peeked = (eka2l1::common::ucs2_to_utf8(name) == peeked->name);
+            }
+
+            total++;
+        }
+    }
+
+    REQUIRE(found_peeked);
+    REQUIRE(total == 10);
+
+    for (int i = 0; i < 10; i++) {
+        REQUIRE(io.delete_entry(u"C:\\photos\\img_" + eka2l1::common::utf8_to_ucs2(std::to_string(i)) + u".jpg"));
+    }
+
+    REQUIRE(io.delete_entry(u"C:\\photos\\notes.txt"));
+    REQUIRE(io.delete_entry(u"C:\\photos\\album\\"));
+    REQUIRE(io.delete_entry(u"C:\\photos\\"));
+
+    eka2l1::common::remove("drive_list/");
+}
+
+static eka2l1::loader::rom_entry make_rom_entry(const std::u16string &name, const std::uint32_t size, const std::uint8_t attrib) {
+    eka2l1::loader::rom_entry entry;
+    entry.name = name;
+    entry.name_len = static_cast<std::uint8_t>(name.length());
+    entry.size = size;
+    entry.address_lin = 0;
+    entry.attrib = attrib;
+
+    return entry;
+}
+
+TEST_CASE("rom_path_index_lookup", "vfs") {
+    // A tiny ROM with \Sys\Bin\EUser.dll burnt in
+    eka2l1::loader::rom_dir bin_dir;
+    bin_dir.name = u"Bin";
+    bin_dir.entries.push_back(make_rom_entry(u"EUser.dll", 1234, 0x01));
+
+    eka2l1::loader::rom_entry bin_entry = make_rom_entry(u"Bin", 0, 0x10);
+    bin_entry.dir = bin_dir;
+
+    eka2l1::loader::rom_dir sys_dir;
+    sys_dir.name = u"Sys";
+    sys_dir.entries.push_back(bin_entry);
+
+    eka2l1::loader::rom_entry sys_entry = make_rom_entry(u"Sys", 0, 0x10);
+    sys_entry.dir = sys_dir;
+
+    eka2l1::loader::rom romf;
+    romf.root.num_root_dirs = 1;
+    romf.root.root_dirs.resize(1);
+    romf.root.root_dirs[0].dir.entries.push_back(sys_entry);
+
+    eka2l1::io_system io;
+    io.init();
+
+    auto rom_fs = eka2l1::create_rom_filesystem(&romf, nullptr, epocver::epoc94, "RM000");
+    io.add_filesystem(rom_fs);
+
+    // ROM files are also extracted on the host, under the product code
+    eka2l1::create_directories("drive_rom/rm000/sys/bin");
+    create_host_file("drive_rom/rm000/sys/bin/euser.dll");
+    create_host_file("drive_rom/rm000/sys/bin/hostonly.dll");
+
+    io.mount_physical_path(drive_number::drive_z, drive_media::rom, io_attrib::internal, u"drive_rom");
+
+    REQUIRE(io.is_entry_in_rom(u"Z:\\sys\\bin\\euser.dll"));
+    REQUIRE(io.is_entry_in_rom(u"z:\\SYS\\BIN\\EUSER.DLL"));
+    REQUIRE(!io.is_entry_in_rom(u"Z:\\sys\\bin\\hostonly.dll"));
+    REQUIRE(!io.is_entry_in_rom(u"Z:\\sys\\bin\\"));
+
+    const auto info = io.get_entry_info(u"Z:\\Sys\\Bin\\EUSER.dll");
+
+    REQUIRE(info);
+    REQUIRE(info->has_raw_attribute);
+    REQUIRE(info->raw_attribute == 0x01);
+    REQUIRE(info->size == 1234);
+
+    // Files only on the host fall back to the host entry
+    const auto host_info = io.get_entry_info(u"Z:\\sys\\bin\\hostonly.dll");
+
+    REQUIRE(host_info);
+    REQUIRE(!host_info->has_raw_attribute);
+
+    io.shutdown();
+    eka2l1::common::remove("drive_rom/");
+}